@@ -23,16 +23,250 @@
 #include "gui/EventRecorder.h"
 
 #include "common/util.h"
+#include "common/array.h"
+#include "common/debug.h"
+#include "common/system.h"
 #include "common/textconsole.h"
+#include "common/timer.h"
 
 #include "audio/mixer_intern.h"
 #include "audio/rate.h"
 #include "audio/audiostream.h"
 #include "audio/timestamp.h"
 
+#ifdef USE_CXX11
+#include <atomic>
+#endif
+
 
 namespace Audio {
 
+#ifdef USE_CXX11
+
+#pragma mark -
+#pragma mark --- Decode ahead ---
+#pragma mark -
+
+/**
+ * Stream which plays the samples decoded ahead from another stream.
+ *
+ * The samples are stored in a ring buffer with a single producer, the
+ * decode ahead timer callback, and a single consumer, the mixer callback,
+ * so neither of them needs to lock. The mixer never deletes the stream
+ * itself: it releases it, and the timer callback deletes it on its next
+ * run, when it is sure not to use it any more.
+ */
+class DecodeAheadStream : public AudioStream {
+public:
+	enum {
+		/** Size of the ring buffer in samples, a power of two. */
+		kBufferSize = 16384
+	};
+
+	DecodeAheadStream(AudioStream *source)
+		: _source(source), _isStereo(source->isStereo()), _rate(source->getRate()),
+		  _readPos(0), _writePos(0), _sourceEndOfData(false), _sourceEndOfStream(false),
+		  _released(false), _underruns(0) {
+	}
+
+	~DecodeAheadStream() {
+		delete _source;
+	}
+
+	// Consumer side
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		// The flags are read first, so that all the samples decoded before
+		// they were set are visible
+		const bool sourceEndOfData = _sourceEndOfData.load(std::memory_order_acquire);
+		const uint32 writePos = _writePos.load(std::memory_order_acquire);
+		const uint32 readPos = _readPos.load(std::memory_order_relaxed);
+
+		const uint32 samples = MIN<uint32>(writePos - readPos, numSamples);
+		const uint32 offset = readPos & (kBufferSize - 1);
+		const uint32 firstPart = MIN<uint32>(samples, kBufferSize - offset);
+		memcpy(buffer, _buffer + offset, firstPart * sizeof(int16));
+		memcpy(buffer + firstPart, _buffer, (samples - firstPart) * sizeof(int16));
+
+		_readPos.store(readPos + samples, std::memory_order_release);
+
+		if (samples < (uint32)numSamples && !sourceEndOfData)
+			++_underruns;
+
+		return samples;
+	}
+
+	bool isStereo() const { return _isStereo; }
+	int getRate() const { return _rate; }
+
+	bool endOfData() const {
+		return _sourceEndOfData.load(std::memory_order_acquire) && isEmpty();
+	}
+
+	bool endOfStream() const {
+		return _sourceEndOfStream.load(std::memory_order_acquire) && isEmpty();
+	}
+
+	/** Return the number of underruns since the last call. */
+	uint32 takeUnderruns() {
+		const uint32 underruns = _underruns;
+		_underruns = 0;
+		return underruns;
+	}
+
+	/** Hand the stream over to the producer, for deletion. */
+	void release() { _released.store(true, std::memory_order_release); }
+
+	// Producer side
+
+	bool isReleased() const { return _released.load(std::memory_order_acquire); }
+
+	/** Decode samples until the buffer is full or the source has no more data. */
+	void fill() {
+		const uint32 readPos = _readPos.load(std::memory_order_acquire);
+		uint32 writePos = _writePos.load(std::memory_order_relaxed);
+
+		// Keep whole frames, so that stereo samples stay in pairs
+		uint32 space = kBufferSize - (writePos - readPos);
+		if (_isStereo)
+			space &= ~1;
+
+		while (space > 0) {
+			const uint32 offset = writePos & (kBufferSize - 1);
+			const uint32 len = MIN<uint32>(space, kBufferSize - offset);
+			const int samples = _source->readBuffer(_buffer + offset, len);
+			if (samples <= 0)
+				break;
+
+			writePos += samples;
+			space -= samples;
+			_writePos.store(writePos, std::memory_order_release);
+
+			if ((uint32)samples < len)
+				break;
+		}
+
+		_sourceEndOfData.store(_source->endOfData(), std::memory_order_release);
+		_sourceEndOfStream.store(_source->endOfStream(), std::memory_order_release);
+	}
+
+private:
+	bool isEmpty() const {
+		return _readPos.load(std::memory_order_relaxed) == _writePos.load(std::memory_order_acquire);
+	}
+
+	AudioStream *const _source;
+	const bool _isStereo;
+	const int _rate;
+
+	int16 _buffer[kBufferSize];
+	std::atomic<uint32> _readPos;
+	std::atomic<uint32> _writePos;
+	std::atomic<bool> _sourceEndOfData;
+	std::atomic<bool> _sourceEndOfStream;
+	std::atomic<bool> _released;
+
+	/** Only used by the consumer. */
+	uint32 _underruns;
+};
+
+/**
+ * Bounded queue of channel commands, which any thread can push without
+ * locking. The commands are popped by the mixer, with its mutex held.
+ *
+ * This is the bounded multiple producer queue by Dmitry Vyukov: each cell
+ * carries a sequence number which tells whether it is free to be written
+ * or ready to be read for the current position.
+ */
+class MixerCommandQueue {
+public:
+	enum Type {
+		kSetVolume,
+		kSetBalance
+	};
+
+	struct Command {
+		Type type;
+		uint32 handle;
+		int value;
+	};
+
+	MixerCommandQueue() : _pushPos(0), _popPos(0) {
+		for (uint32 i = 0; i < kSize; ++i)
+			_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	/** Push a command, or return false if the queue is full. */
+	bool push(const Command &command) {
+		uint32 pos = _pushPos.load(std::memory_order_relaxed);
+		Cell *cell;
+		while (true) {
+			cell = &_cells[pos & (kSize - 1)];
+			const int32 diff = (int32)(cell->sequence.load(std::memory_order_acquire) - pos);
+			if (diff == 0) {
+				if (_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = _pushPos.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->command = command;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Pop a command, or return false if the queue is empty. Only one thread may pop at a time. */
+	bool pop(Command &command) {
+		Cell &cell = _cells[_popPos & (kSize - 1)];
+		if ((int32)(cell.sequence.load(std::memory_order_acquire) - (_popPos + 1)) < 0)
+			return false;
+
+		command = cell.command;
+		cell.sequence.store(_popPos + kSize, std::memory_order_release);
+		++_popPos;
+		return true;
+	}
+
+private:
+	enum {
+		kSize = 256
+	};
+
+	struct Cell {
+		std::atomic<uint32> sequence;
+		Command command;
+	};
+
+	Cell _cells[kSize];
+	std::atomic<uint32> _pushPos;
+	uint32 _popPos;
+};
+
+struct MixerImpl::DecodeAhead {
+	/** Held by the decoding, and when adding streams. Never by the mixer callback. */
+	Common::Mutex mutex;
+	Common::Array<DecodeAheadStream *> streams;
+	bool timerInstalled;
+
+	MixerCommandQueue commands;
+
+	DecodeAhead() : timerInstalled(false) {}
+};
+
+#else
+
+/** Decoding ahead needs the C++11 atomics, so it is never enabled. */
+class DecodeAheadStream {
+public:
+	void release() {}
+	uint32 takeUnderruns() { return 0; }
+};
+
+#endif // USE_CXX11
+
 #pragma mark -
 #pragma mark --- Channel classes ---
 #pragma mark -
@@ -143,6 +377,18 @@ public:
 	 */
 	SoundHandle getHandle() const { return _handle; }
 
+	/**
+	 * Sets the stream decoding ahead for the channel, which the channel
+	 * releases when it is deleted.
+	 */
+	void setDecodeAheadStream(DecodeAheadStream *stream) { _decodeAheadStream = stream; }
+
+	/**
+	 * Returns the number of times the channel ran out of samples decoded
+	 * ahead since the last call.
+	 */
+	uint32 takeUnderruns();
+
 private:
 	const Mixer::SoundType _type;
 	SoundHandle _handle;
@@ -166,14 +412,21 @@ private:
 
 	RateConverter *_converter;
 	Common::DisposablePtr<AudioStream> _stream;
+	DecodeAheadStream *_decodeAheadStream;
 };
 
 #pragma mark -
 #pragma mark --- Mixer ---
 #pragma mark -
 
+MixerImpl::Statistics::Statistics() : callbacks(0), lateCallbacks(0), decodeUnderruns(0) {
+	for (int i = 0; i < kDurationBuckets; ++i)
+		durations[i] = 0;
+}
+
 MixerImpl::MixerImpl(uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _decodeAhead(nullptr), _statisticsEnabled(false) {
 
 	assert(sampleRate > 0);
 
@@ -182,8 +435,107 @@ MixerImpl::MixerImpl(uint sampleRate)
 }
 
 MixerImpl::~MixerImpl() {
+	if (_decodeAhead || _statisticsEnabled) {
+		const uint32 *durations = _statistics.durations;
+		debug(1, "MixerImpl: %u callbacks, %u late, %u decode underruns, durations %u/%u/%u/%u/%u/%u/%u (<1/1/2-3/4-7/8-15/16-31/32+ ms)",
+		      _statistics.callbacks, _statistics.lateCallbacks, _statistics.decodeUnderruns,
+		      durations[0], durations[1], durations[2], durations[3], durations[4], durations[5], durations[6]);
+	}
+
+#ifdef USE_CXX11
+	if (_decodeAhead && _decodeAhead->timerInstalled)
+		g_system->getTimerManager()->removeTimerProc(&decodeAheadProc);
+#endif
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
+
+#ifdef USE_CXX11
+	if (_decodeAhead) {
+		for (uint i = 0; i < _decodeAhead->streams.size(); ++i)
+			delete _decodeAhead->streams[i];
+		delete _decodeAhead;
+	}
+#endif
+}
+
+bool MixerImpl::setDecodeAhead(bool enable) {
+	assert(!_mixerReady);
+
+#ifdef USE_CXX11
+	if (enable && !_decodeAhead) {
+		// The timer callback is installed with the first stream, as the
+		// backends usually set up the timer manager after the mixer
+		_decodeAhead = new DecodeAhead();
+	} else if (!enable && _decodeAhead) {
+		if (_decodeAhead->timerInstalled)
+			g_system->getTimerManager()->removeTimerProc(&decodeAheadProc);
+		delete _decodeAhead;
+		_decodeAhead = nullptr;
+	}
+
+	return _decodeAhead != nullptr;
+#else
+	return false;
+#endif
+}
+
+void MixerImpl::decodeAheadProc(void *refCon) {
+	((MixerImpl *)refCon)->decodeAhead();
+}
+
+void MixerImpl::decodeAhead() {
+#ifdef USE_CXX11
+	if (!_decodeAhead)
+		return;
+
+	Common::StackLock lock(_decodeAhead->mutex);
+
+	Common::Array<DecodeAheadStream *> &streams = _decodeAhead->streams;
+	for (uint i = 0; i < streams.size();) {
+		if (streams[i]->isReleased()) {
+			delete streams[i];
+			streams.remove_at(i);
+		} else {
+			streams[i]->fill();
+			++i;
+		}
+	}
+#endif
+}
+
+void MixerImpl::applyCommands() {
+#ifdef USE_CXX11
+	if (!_decodeAhead)
+		return;
+
+	MixerCommandQueue::Command command;
+	while (_decodeAhead->commands.pop(command)) {
+		const int index = command.handle % NUM_CHANNELS;
+		if (!_channels[index] || _channels[index]->getHandle()._val != command.handle)
+			continue;
+
+		if (command.type == MixerCommandQueue::kSetVolume)
+			_channels[index]->setVolume(command.value);
+		else
+			_channels[index]->setBalance(command.value);
+	}
+#endif
+}
+
+MixerImpl::Statistics MixerImpl::getStatistics() const {
+	Common::StackLock lock(_mutex);
+	return _statistics;
+}
+
+void MixerImpl::resetStatistics() {
+	Common::StackLock lock(_mutex);
+	_statistics = Statistics();
+}
+
+void MixerImpl::setStatisticsEnabled(bool enable) {
+	Common::StackLock lock(_mutex);
+	_statisticsEnabled = enable;
 }
 
 void MixerImpl::setReady(bool ready) {
@@ -229,13 +581,39 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
-	Common::StackLock lock(_mutex);
-
 	if (stream == 0) {
 		warning("stream is 0");
 		return;
 	}
 
+	DecodeAheadStream *decodeAheadStream = nullptr;
+#ifdef USE_CXX11
+	// Only the streams which nobody else uses can be decoded from another
+	// thread. The first samples are decoded right away, and the stream is
+	// registered for decoding before locking the mixer, so that the mixer
+	// callback does not need to wait.
+	if (_decodeAhead && autofreeStream == DisposeAfterUse::YES &&
+	    (type == kMusicSoundType || type == kSpeechSoundType)) {
+		Common::StackLock decodeLock(_decodeAhead->mutex);
+
+		if (!_decodeAhead->timerInstalled && g_system->getTimerManager()) {
+			_decodeAhead->timerInstalled = g_system->getTimerManager()->installTimerProc(
+				&decodeAheadProc, kDecodeAheadInterval, this, "MixerImpl decode ahead");
+		}
+
+		if (_decodeAhead->timerInstalled) {
+			decodeAheadStream = new DecodeAheadStream(stream);
+			decodeAheadStream->fill();
+			_decodeAhead->streams.push_back(decodeAheadStream);
+
+			stream = decodeAheadStream;
+			autofreeStream = DisposeAfterUse::NO;
+		}
+	}
+#endif
+
+	Common::StackLock lock(_mutex);
+
 
 	assert(_mixerReady);
 
@@ -249,7 +627,9 @@ void MixerImpl::playStream(
 				// keep in mind here is QueuingAudioStream.
 				// Thus, as a quick rule of thumb, you should never, ever,
 				// try to play QueuingAudioStreams with a sound id.
-				if (autofreeStream == DisposeAfterUse::YES)
+				if (decodeAheadStream)
+					decodeAheadStream->release();
+				else if (autofreeStream == DisposeAfterUse::YES)
 					delete stream;
 				return;
 			}
@@ -261,6 +641,7 @@ void MixerImpl::playStream(
 
 	// Create the channel
 	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	chan->setDecodeAheadStream(decodeAheadStream);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
 	insertChannel(handle, chan);
@@ -279,6 +660,12 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
+	// The callbacks are only timed when someone is interested
+	const bool timed = _decodeAhead || _statisticsEnabled;
+	const uint32 start = timed ? g_system->getMillis(true) : 0;
+
+	applyCommands();
+
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
@@ -291,12 +678,24 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 				_channels[i] = 0;
 			} else if (!_channels[i]->isPaused()) {
 				tmp = _channels[i]->mix(buf, len);
+				_statistics.decodeUnderruns += _channels[i]->takeUnderruns();
 
 				if (tmp > res)
 					res = tmp;
 			}
 		}
 
+	_statistics.callbacks++;
+	if (timed) {
+		const uint32 duration = g_system->getMillis(true) - start;
+		int bucket = 0;
+		while (bucket < kDurationBuckets - 1 && duration >= (1u << bucket))
+			++bucket;
+		_statistics.durations[bucket]++;
+		if (duration * _sampleRate > len * 1000)
+			_statistics.lateCallbacks++;
+	}
+
 	return res;
 }
 
@@ -348,7 +747,16 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
+#ifdef USE_CXX11
+	if (_decodeAhead) {
+		const MixerCommandQueue::Command command = { MixerCommandQueue::kSetVolume, handle._val, volume };
+		if (_decodeAhead->commands.push(command))
+			return;
+	}
+#endif
+
 	Common::StackLock lock(_mutex);
+	applyCommands();
 
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
@@ -358,6 +766,12 @@ void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
+	// Queued changes must be visible
+	if (_decodeAhead) {
+		Common::StackLock lock(_mutex);
+		applyCommands();
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -366,7 +780,16 @@ byte MixerImpl::getChannelVolume(SoundHandle handle) {
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
+#ifdef USE_CXX11
+	if (_decodeAhead) {
+		const MixerCommandQueue::Command command = { MixerCommandQueue::kSetBalance, handle._val, balance };
+		if (_decodeAhead->commands.push(command))
+			return;
+	}
+#endif
+
 	Common::StackLock lock(_mutex);
+	applyCommands();
 
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
@@ -376,6 +799,12 @@ void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
+	// Queued changes must be visible
+	if (_decodeAhead) {
+		Common::StackLock lock(_mutex);
+		applyCommands();
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -501,7 +930,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
       _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0),
-      _stream(stream, autofreeStream) {
+      _stream(stream, autofreeStream), _decodeAheadStream(nullptr) {
 	assert(mixer);
 	assert(stream);
 
@@ -511,6 +940,15 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 
 Channel::~Channel() {
 	delete _converter;
+
+	if (_decodeAheadStream)
+		_decodeAheadStream->release();
+}
+
+uint32 Channel::takeUnderruns() {
+	if (_decodeAheadStream)
+		return _decodeAheadStream->takeUnderruns();
+	return 0;
 }
 
 void Channel::setVolume(const byte volume) {
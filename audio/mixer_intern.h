@@ -54,14 +54,49 @@ namespace Audio {
  * (partial) alternative implementations of the mixer, e.g. to make
  * better use of native sound mixing support on low-end devices.
  *
+ * Optionally, the mixer can decode music and speech ahead of time, from a
+ * timer callback, so that decoding does not happen in the mixer callback or
+ * while holding the mixer mutex; see setDecodeAhead().
+ *
  * @see OSystem::getMixer()
  */
 class MixerImpl : public Mixer {
+public:
+	enum {
+		/** Number of buckets of the callback duration histogram. */
+		kDurationBuckets = 7
+	};
+
+	/** Statistics about the mixer callback, see getStatistics(). */
+	struct Statistics {
+		Statistics();
+
+		/** Number of calls of mixCallback(). */
+		uint32 callbacks;
+		/**
+		 * Callbacks which took longer than the duration of the buffer they
+		 * filled. This and the durations are only measured while decoding
+		 * ahead or while the statistics are enabled.
+		 */
+		uint32 lateCallbacks;
+		/** Times a channel ran out of decoded samples before the end of its stream. */
+		uint32 decodeUnderruns;
+		/**
+		 * Histogram of the callback durations: under 1 ms, 1 ms, 2-3 ms,
+		 * 4-7 ms, 8-15 ms, 16-31 ms and 32 ms or more.
+		 */
+		uint32 durations[kDurationBuckets];
+	};
+
 private:
 	enum {
-		NUM_CHANNELS = 32
+		NUM_CHANNELS = 32,
+		/** Interval of the decode ahead timer callback, in microseconds. */
+		kDecodeAheadInterval = 10000
 	};
 
+	struct DecodeAhead;
+
 	Common::Mutex _mutex;
 
 	const uint _sampleRate;
@@ -78,6 +113,12 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	DecodeAhead *_decodeAhead;
+	Statistics _statistics;
+	bool _statisticsEnabled;
+
+	static void decodeAheadProc(void *refCon);
+	void applyCommands();
 
 public:
 
@@ -147,6 +188,36 @@ public:
 	 * their audio system has been completed.
 	 */
 	void setReady(bool ready);
+
+	/**
+	 * Enable decoding ahead. Music and speech streams which the mixer owns
+	 * are then decoded into a buffer from a timer callback, and the mixer
+	 * callback only converts and mixes the buffered samples. Channel volume
+	 * and balance changes are queued without locking the mixer, and applied
+	 * by the next mixer callback.
+	 *
+	 * This must be called before the mixer is ready, and is only available
+	 * in C++11 builds.
+	 *
+	 * @return whether decoding ahead is enabled
+	 */
+	bool setDecodeAhead(bool enable);
+
+	/**
+	 * Decode ahead the streams which need it. This is called regularly from
+	 * a timer callback when decoding ahead is enabled.
+	 */
+	void decodeAhead();
+
+	/** Get the statistics about the mixer callback since the last reset. */
+	Statistics getStatistics() const;
+	void resetStatistics();
+
+	/**
+	 * Time the mixer callbacks even when not decoding ahead. The statistics
+	 * are then printed at debug level 1 when the mixer is destroyed.
+	 */
+	void setStatisticsEnabled(bool enable);
 };
 
 /** @} */
@@ -30,11 +30,22 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_intern.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
+#if defined(OUTPUT_UNSIGNED_AUDIO)
+// The vectorized mixing only handles signed output
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RATE_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RATE_USE_NEON
+#endif
+
 namespace Audio {
 
 
@@ -57,6 +68,149 @@ enum {
 	FRAC_HALF_LOW = (1L << (FRAC_BITS_LOW-1))
 };
 
+/**
+ * Reference implementation of the mixing of converted samples into the
+ * output buffer, applying the volume of each channel. Mono samples are
+ * mixed into both channels.
+ */
+template<bool stereo, bool reverseStereo>
+static void mixSamplesGeneric(st_sample_t *obuf, const st_sample_t *ptr, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+	for (; frames > 0; --frames) {
+		st_sample_t out0, out1;
+		out0 = *ptr++;
+		out1 = (stereo ? *ptr++ : out0);
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
+#if defined(RATE_USE_SSE2) || defined(RATE_USE_NEON)
+
+/*
+ * The vectorized versions mix four frames at a time. They compute the same
+ * results as the reference implementation for volumes up to
+ * kMaxMixerVolume: the products are divided rounding towards zero, and the
+ * quotients fit in 16 bits, so saturating them before the saturating
+ * addition does not change anything.
+ */
+
+#ifdef RATE_USE_SSE2
+
+/** Divide by kMaxMixerVolume, rounding towards zero like the C division. */
+static inline __m128i divideByMaxVolume(__m128i value) {
+	const __m128i bias = _mm_and_si128(_mm_srai_epi32(value, 31), _mm_set1_epi32(Audio::Mixer::kMaxMixerVolume - 1));
+	return _mm_srai_epi32(_mm_add_epi32(value, bias), 8);
+}
+
+template<bool stereo, bool reverseStereo>
+static void mixSamplesSIMD(st_sample_t *obuf, const st_sample_t *ptr, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+	// The volumes by output position; reversed stereo swaps the samples
+	// of each frame, so that they end up in the right place
+	const __m128i volume = reverseStereo ?
+		_mm_set_epi16(vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r) :
+		_mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+	for (; frames >= 4; frames -= 4) {
+		__m128i samples;
+		if (stereo) {
+			samples = _mm_loadu_si128((const __m128i *)ptr);
+			if (reverseStereo)
+				samples = _mm_shufflehi_epi16(_mm_shufflelo_epi16(samples, 0xB1), 0xB1);
+			ptr += 8;
+		} else {
+			samples = _mm_loadl_epi64((const __m128i *)ptr);
+			samples = _mm_unpacklo_epi16(samples, samples);
+			ptr += 4;
+		}
+
+		const __m128i lo = _mm_mullo_epi16(samples, volume);
+		const __m128i hi = _mm_mulhi_epi16(samples, volume);
+		const __m128i out = _mm_packs_epi32(divideByMaxVolume(_mm_unpacklo_epi16(lo, hi)),
+		                                    divideByMaxVolume(_mm_unpackhi_epi16(lo, hi)));
+
+		_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(_mm_loadu_si128((const __m128i *)obuf), out));
+		obuf += 8;
+	}
+
+	mixSamplesGeneric<stereo, reverseStereo>(obuf, ptr, frames, vol_l, vol_r);
+}
+
+#else // RATE_USE_NEON
+
+/** Divide by kMaxMixerVolume, rounding towards zero like the C division. */
+static inline int32x4_t divideByMaxVolume(int32x4_t value) {
+	const int32x4_t bias = vandq_s32(vshrq_n_s32(value, 31), vdupq_n_s32(Audio::Mixer::kMaxMixerVolume - 1));
+	return vshrq_n_s32(vaddq_s32(value, bias), 8);
+}
+
+template<bool stereo, bool reverseStereo>
+static void mixSamplesSIMD(st_sample_t *obuf, const st_sample_t *ptr, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+	// The volumes by output position; reversed stereo swaps the samples
+	// of each frame, so that they end up in the right place
+	const int16x4_t volume = vreinterpret_s16_u32(vdup_n_u32(reverseStereo ? (vol_r | (vol_l << 16)) : (vol_l | (vol_r << 16))));
+
+	for (; frames >= 4; frames -= 4) {
+		int16x8_t samples;
+		if (stereo) {
+			samples = vld1q_s16(ptr);
+			if (reverseStereo)
+				samples = vrev32q_s16(samples);
+			ptr += 8;
+		} else {
+			const int16x4_t mono = vld1_s16(ptr);
+			const int16x4x2_t zipped = vzip_s16(mono, mono);
+			samples = vcombine_s16(zipped.val[0], zipped.val[1]);
+			ptr += 4;
+		}
+
+		const int32x4_t lo = divideByMaxVolume(vmull_s16(vget_low_s16(samples), volume));
+		const int32x4_t hi = divideByMaxVolume(vmull_s16(vget_high_s16(samples), volume));
+		const int16x8_t out = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+
+		vst1q_s16(obuf, vqaddq_s16(vld1q_s16(obuf), out));
+		obuf += 8;
+	}
+
+	mixSamplesGeneric<stereo, reverseStereo>(obuf, ptr, frames, vol_l, vol_r);
+}
+
+#endif
+
+#endif // RATE_USE_SSE2 || RATE_USE_NEON
+
+static bool s_rateSIMDEnabled = true;
+
+bool setRateConverterSIMD(bool enable) {
+	s_rateSIMDEnabled = enable;
+#if defined(RATE_USE_SSE2) || defined(RATE_USE_NEON)
+	return enable;
+#else
+	return false;
+#endif
+}
+
+/**
+ * Mix converted samples, stored like in the input stream, into the output
+ * buffer.
+ */
+template<bool stereo, bool reverseStereo>
+static inline void mixSamples(st_sample_t *obuf, const st_sample_t *ptr, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+#if defined(RATE_USE_SSE2) || defined(RATE_USE_NEON)
+	if (s_rateSIMDEnabled && vol_l <= Audio::Mixer::kMaxMixerVolume && vol_r <= Audio::Mixer::kMaxMixerVolume) {
+		mixSamplesSIMD<stereo, reverseStereo>(obuf, ptr, frames, vol_l, vol_r);
+		return;
+	}
+#endif
+
+	mixSamplesGeneric<stereo, reverseStereo>(obuf, ptr, frames, vol_l, vol_r);
+}
+
 /**
  * Audio rate converter based on simple resampling. Used when no
  * interpolation is required.
@@ -118,38 +272,47 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
-	while (obuf < oend) {
-
-		// read enough input samples so that opos >= 0
-		do {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			opos--;
-			if (opos >= 0) {
-				inPtr += (stereo ? 2 : 1);
-			}
-		} while (opos >= 0);
-
-		st_sample_t out0, out1;
-		out0 = *inPtr++;
-		out1 = (stereo ? *inPtr++ : out0);
-
-		// Increment output position
-		opos += opos_inc;
-
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+	bool endOfInput = false;
+	while (obuf < oend && !endOfInput) {
+		// The samples are picked into an intermediate buffer first, and
+		// then mixed all at once
+		st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+		st_sample_t *outPtr = outBuf;
+		st_sample_t *outEnd = outBuf + MIN<st_size_t>((oend - obuf) / 2 * (stereo ? 2 : 1), ARRAYSIZE(outBuf));
+
+		while (outPtr < outEnd) {
+			// read enough input samples so that opos >= 0
+			do {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						endOfInput = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				opos--;
+				if (opos >= 0) {
+					inPtr += (stereo ? 2 : 1);
+				}
+			} while (opos >= 0);
+
+			if (endOfInput)
+				break;
+
+			*outPtr++ = *inPtr++;
+			if (stereo)
+				*outPtr++ = *inPtr++;
 
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			// Increment output position
+			opos += opos_inc;
+		}
 
-		obuf += 2;
+		const st_size_t frames = (outPtr - outBuf) / (stereo ? 2 : 1);
+		mixSamples<stereo, reverseStereo>(obuf, outBuf, frames, vol_l, vol_r);
+		obuf += frames * 2;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -227,48 +390,55 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
-	while (obuf < oend) {
-
-		// read enough input samples so that opos < 0
-		while ((frac_t)FRAC_ONE_LOW <= opos) {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			ilast0 = icur0;
-			icur0 = *inPtr++;
-			if (stereo) {
-				ilast1 = icur1;
-				icur1 = *inPtr++;
+	bool endOfInput = false;
+	while (obuf < oend && !endOfInput) {
+		// The samples are interpolated into an intermediate buffer first,
+		// and then mixed all at once
+		st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+		st_sample_t *outPtr = outBuf;
+		st_sample_t *outEnd = outBuf + MIN<st_size_t>((oend - obuf) / 2 * (stereo ? 2 : 1), ARRAYSIZE(outBuf));
+
+		while (outPtr < outEnd) {
+			// read enough input samples so that opos < 0
+			while ((frac_t)FRAC_ONE_LOW <= opos) {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						endOfInput = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				ilast0 = icur0;
+				icur0 = *inPtr++;
+				if (stereo) {
+					ilast1 = icur1;
+					icur1 = *inPtr++;
+				}
+				opos -= FRAC_ONE_LOW;
 			}
-			opos -= FRAC_ONE_LOW;
-		}
-
-		// Loop as long as the outpos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE_LOW && obuf < oend) {
-			// interpolate
-			st_sample_t out0, out1;
-			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
-			out1 = (stereo ?
-						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW)) :
-						  out0);
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+			if (endOfInput)
+				break;
 
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			// Loop as long as the outpos trails behind, and as long as there is
+			// still space in the output buffer.
+			while (opos < (frac_t)FRAC_ONE_LOW && outPtr < outEnd) {
+				// interpolate
+				*outPtr++ = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
+				if (stereo)
+					*outPtr++ = (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
 
-			obuf += 2;
-
-			// Increment output position
-			opos += opos_inc;
+				// Increment output position
+				opos += opos_inc;
+			}
 		}
+
+		const st_size_t frames = (outPtr - outBuf) / (stereo ? 2 : 1);
+		mixSamples<stereo, reverseStereo>(obuf, outBuf, frames, vol_l, vol_r);
+		obuf += frames * 2;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -293,11 +463,8 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
 		st_size_t len;
 
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -315,21 +482,9 @@ public:
 		len = input.readBuffer(_buffer, osamp);
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-		}
-		return (obuf - ostart) / 2;
+		const st_size_t frames = len / (stereo ? 2 : 1);
+		mixSamples<stereo, reverseStereo>(obuf, _buffer, frames, vol_l, vol_r);
+		return frames;
 	}
 
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
@@ -43,6 +43,7 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_intern.h"
 #include "audio/mixer.h"
 #include "common/util.h"
 #include "common/textconsole.h"
@@ -444,6 +445,13 @@ public:
 #pragma mark -
 
 
+/**
+ * The assembly converters have no separate SIMD code paths.
+ */
+bool setRateConverterSIMD(bool enable) {
+	return false;
+}
+
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
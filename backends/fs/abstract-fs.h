@@ -173,6 +173,17 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and the time of the last modification of the file
+	 * referred by this node, without opening it. The modification time is
+	 * only meant to be compared with an earlier value for the same file.
+	 *
+	 * @param size   receives the size of the file in bytes
+	 * @param mtime  receives the modification time, in a backend specific unit
+	 * @return bool true on success, false if not a file or not supported by the backend.
+	 */
+	virtual bool getFileStats(int64 &size, int64 &mtime) const { return false; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -192,6 +203,14 @@ public:
 	 */
 	virtual Common::WriteStream *createWriteStream() = 0;
 
+	/**
+	 * Creates a WriteStream instance which appends to the file referred by
+	 * this node, creating it if needed.
+	 *
+	 * @return pointer to the stream object, 0 in case of a failure or if not supported by the backend
+	 */
+	virtual Common::WriteStream *createAppendStream() { return nullptr; }
+
 	/**
 	* Creates a directory referred by this node.
 	*
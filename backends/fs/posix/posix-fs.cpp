@@ -71,6 +71,23 @@ bool POSIXFilesystemNode::isWritable() const {
 	return access(_path.c_str(), W_OK) == 0;
 }
 
+bool POSIXFilesystemNode::getFileStats(int64 &size, int64 &mtime) const {
+	struct stat st;
+	if (stat(_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+
+	size = st.st_size;
+#if defined(__APPLE__)
+	mtime = (int64)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined(st_mtime)
+	// The C libraries which provide st_mtim define st_mtime to its seconds
+	mtime = (int64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+	mtime = st.st_mtime;
+#endif
+	return true;
+}
+
 void POSIXFilesystemNode::setFlags() {
 	struct stat st;
 
@@ -287,13 +304,17 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 }
 
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
-	return PosixIoStream::makeFromPath(getPath(), false);
+	return PosixIoStream::makeReadStreamFromPath(getPath());
 }
 
 Common::WriteStream *POSIXFilesystemNode::createWriteStream() {
 	return PosixIoStream::makeFromPath(getPath(), true);
 }
 
+Common::WriteStream *POSIXFilesystemNode::createAppendStream() {
+	return PosixIoStream::makeAppendStreamFromPath(getPath());
+}
+
 bool POSIXFilesystemNode::createDirectory() {
 	if (mkdir(_path.c_str(), 0755) == 0)
 		setFlags();
@@ -23,14 +23,28 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "backends/fs/posix/posix-iostream.h"
+#include "common/config-manager.h"
 
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#include <sys/mman.h>
+#define POSIX_USE_MMAP
+#endif
 
 #if defined(ANDROID_PLAIN_PORT)
 #include "backends/platform/android/jni-android.h"
-#include <unistd.h>
 #endif
 
+enum {
+	/** Smaller files are not worth the cost of setting up a mapping. */
+	kMinMappedSize = 64 * 1024,
+	/** Larger files are not mapped, to spare the address space of 32-bit systems. */
+	kMaxMappedSize = (sizeof(void *) < 8) ? 64 * 1024 * 1024 : 0x7FFFFFFF
+};
+
 
 PosixIoStream *PosixIoStream::makeFromPath(const Common::String &path, bool writeMode) {
 	FILE *handle = fopen(path.c_str(), writeMode ? "wb" : "rb");
@@ -80,6 +94,44 @@ PosixIoStream *PosixIoStream::makeFromPath(const Common::String &path, bool writ
 }
 
 
+Common::SeekableReadStream *PosixIoStream::makeReadStreamFromPath(const Common::String &path) {
+#ifdef POSIX_USE_MMAP
+	// Reading a mapped file which another process truncates raises SIGBUS
+	// instead of failing, so mapping is only done on request
+	if (!ConfMan.hasKey("mmap_files") || !ConfMan.getBool("mmap_files"))
+		return makeFromPath(path, false);
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return nullptr;
+
+	// Pipes and special files cannot be mapped
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= kMinMappedSize && st.st_size <= kMaxMappedSize) {
+		void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			close(fd);
+			return new PosixMmapStream(data, st.st_size);
+		}
+	}
+
+	FILE *handle = fdopen(fd, "rb");
+	if (!handle) {
+		close(fd);
+		return nullptr;
+	}
+
+	return new PosixIoStream(handle);
+#else
+	return makeFromPath(path, false);
+#endif
+}
+
+PosixIoStream *PosixIoStream::makeAppendStreamFromPath(const Common::String &path) {
+	FILE *handle = fopen(path.c_str(), "ab");
+	return handle ? new PosixIoStream(handle) : nullptr;
+}
+
 #if defined(ANDROID_PLAIN_PORT)
 PosixIoStream::PosixIoStream(void *handle, bool bCreatedWithSAF, Common::String sHackyFilename) :
 		StdioStream(handle) {
@@ -121,3 +173,13 @@ int32 PosixIoStream::size() const {
 
 	return st.st_size;
 }
+
+PosixMmapStream::PosixMmapStream(void *data, uint32 size) :
+		Common::MemoryReadStream((const byte *)data, size), _data(data), _mappedSize(size) {
+}
+
+PosixMmapStream::~PosixMmapStream() {
+#ifdef POSIX_USE_MMAP
+	munmap(_data, _mappedSize);
+#endif
+}
@@ -24,6 +24,7 @@
 #define BACKENDS_FS_POSIX_POSIXIOSTREAM_H
 
 #include "backends/fs/stdiostream.h"
+#include "common/memstream.h"
 
 /**
  * A file input / output stream using POSIX interfaces
@@ -36,6 +37,18 @@ public:
 #endif
 
 	static PosixIoStream *makeFromPath(const Common::String &path, bool writeMode);
+
+	/**
+	 * Open a file for reading. If the "mmap_files" config key is set, large
+	 * regular files are memory mapped when the system supports it, see
+	 * PosixMmapStream. This is off by default, since the process then
+	 * crashes with SIGBUS if another one truncates a file being read.
+	 */
+	static Common::SeekableReadStream *makeReadStreamFromPath(const Common::String &path);
+
+	/** Open a file for appending, creating it if needed. */
+	static PosixIoStream *makeAppendStreamFromPath(const Common::String &path);
+
 	PosixIoStream(void *handle);
 #if defined(ANDROID_PLAIN_PORT)
 	PosixIoStream(void *handle, bool bCreatedWithSAF, Common::String sHackyFilename);
@@ -45,4 +58,19 @@ public:
 	int32 size() const override;
 };
 
+/**
+ * A read stream for a memory mapped file. Reads do not go through stdio, and
+ * the data can be used without copying it, see
+ * Common::SeekableReadStream::getDirectData().
+ */
+class PosixMmapStream : public Common::MemoryReadStream {
+public:
+	PosixMmapStream(void *data, uint32 size);
+	~PosixMmapStream() override;
+
+private:
+	void *_data;
+	uint32 _mappedSize;
+};
+
 #endif
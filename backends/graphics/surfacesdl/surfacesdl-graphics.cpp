@@ -24,6 +24,7 @@
 
 #if defined(SDL_BACKEND)
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
+#include "backends/graphics/surfacesdl/surfacesdl-scalerpool.h"
 #include "backends/events/sdl/sdl-events.h"
 #include "common/config-manager.h"
 #include "common/mutex.h"
@@ -156,7 +157,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_screenFormat(Graphics::PixelFormat::createFormatCLUT8()),
 	_cursorFormat(Graphics::PixelFormat::createFormatCLUT8()),
 	_overlayscreen(0), _tmpscreen2(0),
-	_scalerProc(0), _screenChangeCount(0),
+	_scalerProc(0), _scalerPool(nullptr), _scalerBenchmarkPending(false), _screenChangeCount(0),
 	_mouseData(nullptr), _mouseSurface(nullptr),
 	_mouseOrigSurface(nullptr), _cursorDontScale(false), _cursorPaletteDisabled(true),
 	_currentShakeXOffset(0), _currentShakeYOffset(0),
@@ -198,6 +199,19 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 	_videoMode.stretchMode = STRETCH_FIT;
 #endif
+
+	int scalerThreads = 1;
+	if (ConfMan.hasKey("scaler_threads"))
+		scalerThreads = ConfMan.getInt("scaler_threads");
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	if (scalerThreads == 0)
+		scalerThreads = SDL_GetCPUCount();
+#endif
+	if (scalerThreads > 1)
+		_scalerPool = new SdlScalerPool(scalerThreads);
+
+	if (ConfMan.hasKey("scaler_benchmark"))
+		_scalerBenchmarkPending = ConfMan.getBool("scaler_benchmark");
 }
 
 SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
@@ -214,6 +228,7 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	free(_currentPalette);
 	free(_cursorPalette);
 	delete[] _mouseData;
+	delete _scalerPool;
 }
 
 bool SurfaceSdlGraphicsManager::hasFeature(OSystem::Feature f) const {
@@ -642,7 +657,7 @@ bool SurfaceSdlGraphicsManager::setGraphicsMode(int mode, uint flags) {
 
 ScalerProc *SurfaceSdlGraphicsManager::getGraphicsScalerProc(int mode) const {
 	ScalerProc *newScalerProc = 0;
-	switch (_videoMode.mode) {
+	switch (mode) {
 	case GFX_NORMAL:
 		newScalerProc = Normal1x;
 		break;
@@ -1018,6 +1033,11 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 	else
 		InitScalers(565);
 
+	if (_scalerBenchmarkPending) {
+		_scalerBenchmarkPending = false;
+		benchmarkScalers();
+	}
+
 	return true;
 }
 
@@ -1250,6 +1270,14 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwScreen->pitch;
 
+		bool useScalerPool = (_scalerPool != nullptr);
+#if defined(USE_NASM) && defined(USE_HQ_SCALERS)
+		// The i386 assembly HQ scalers keep their state in static storage
+		// and cannot run on several threads at once.
+		if (scalerProc == HQ2x || scalerProc == HQ3x)
+			useScalerPool = false;
+#endif
+
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			int dst_x = r->x + _currentShakeXOffset;
 			int dst_y = r->y + _currentShakeYOffset;
@@ -1278,8 +1306,43 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwScreen->pixels + dst_x * 2 + dst_y * dstPitch, dstPitch, dst_w, dst_h);
+				if (useScalerPool) {
+					// The area of the screen this rect writes to, including
+					// the rows touched by the aspect ratio correction.
+					Common::Rect area(dst_x, dst_y, dst_x + dst_w * scale1, dst_y + dst_h * scale1);
+#ifdef USE_SCALERS
+					if (_videoMode.aspectRatioCorrection && !_overlayVisible) {
+						area.top--;
+						area.bottom = real2Aspect((orig_dst_y + dst_h) * scale1 - 1) + 2;
+					}
+#endif
+
+					// Rects which overlap an already queued one have to be
+					// drawn after it, exactly like in the serial code path.
+					for (uint i = 0; i < _pendingScalerRects.size(); ++i) {
+						if (_pendingScalerRects[i].area.intersects(area)) {
+							flushScalerPool();
+							break;
+						}
+					}
+
+					_scalerPool->addJob(scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+						(byte *)_hwScreen->pixels + dst_x * 2 + dst_y * dstPitch, dstPitch, dst_w, dst_h, scale1);
+
+					PendingScalerRect pending;
+					pending.rect = r;
+					pending.area = area;
+#ifdef USE_SCALERS
+					pending.origDstY = orig_dst_y * scale1;
+#else
+					pending.origDstY = 0;
+#endif
+					pending.stretch = false;
+					_pendingScalerRects.push_back(pending);
+				} else {
+					scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+						(byte *)_hwScreen->pixels + dst_x * 2 + dst_y * dstPitch, dstPitch, dst_w, dst_h);
+				}
 			}
 
 			r->x = dst_x;
@@ -1288,10 +1351,19 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 			r->h = dst_h * scale1;
 
 #ifdef USE_SCALERS
-			if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible)
-				r->h = stretch200To240((uint8 *) _hwScreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1, _videoMode.filtering);
+			if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible) {
+				// The stretch has to wait until the scaler output is there
+				if (useScalerPool && !_pendingScalerRects.empty() && _pendingScalerRects.back().rect == r)
+					_pendingScalerRects.back().stretch = true;
+				else
+					r->h = stretch200To240((uint8 *) _hwScreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1, _videoMode.filtering);
+			}
 #endif
 		}
+
+		if (useScalerPool)
+			flushScalerPool();
+
 		SDL_UnlockSurface(srcSurf);
 		SDL_UnlockSurface(_hwScreen);
 
@@ -1398,6 +1470,82 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	_cursorNeedsRedraw = false;
 }
 
+void SurfaceSdlGraphicsManager::flushScalerPool() {
+	_scalerPool->run();
+
+#ifdef USE_SCALERS
+	for (uint i = 0; i < _pendingScalerRects.size(); ++i) {
+		const PendingScalerRect &pending = _pendingScalerRects[i];
+		if (pending.stretch) {
+			SDL_Rect *r = pending.rect;
+			r->h = stretch200To240((uint8 *) _hwScreen->pixels, _hwScreen->pitch, r->w, r->h, r->x, r->y, pending.origDstY, _videoMode.filtering);
+		}
+	}
+#endif
+
+	_pendingScalerRects.clear();
+}
+
+void SurfaceSdlGraphicsManager::benchmarkScalers() {
+	enum {
+		kWidth = 320,
+		kHeight = 200,
+		kFrames = 100
+	};
+	static const uint threadCounts[] = { 1, 2, 4, 8 };
+
+	// Leave the same border around the source as _tmpscreen has
+	const uint32 srcPitch = (kWidth + 3) * 2;
+	const uint32 dstPitch = kWidth * MAX_SCALING * 2;
+	const uint32 dstSize = dstPitch * kHeight * MAX_SCALING;
+	byte *src = new byte[srcPitch * (kHeight + 3)];
+	byte *dst = new byte[dstSize];
+	byte *reference = new byte[dstSize];
+
+	// Noise makes the pattern based scalers go through all of their cases
+	uint32 seed = 1;
+	for (uint32 i = 0; i < srcPitch * (kHeight + 3); ++i) {
+		seed = seed * 1103515245 + 12345;
+		src[i] = (byte)(seed >> 16);
+	}
+
+	for (const OSystem::GraphicsMode *mode = getSupportedGraphicsModes(); mode->name; ++mode) {
+		ScalerProc *scalerProc = getGraphicsScalerProc(mode->id);
+		const int scaleFactor = getGraphicsModeScale(mode->id);
+		if (!scalerProc || scaleFactor < 1 || scaleFactor > MAX_SCALING)
+			continue;
+
+		for (uint i = 0; i < ARRAYSIZE(threadCounts); ++i) {
+#if defined(USE_NASM) && defined(USE_HQ_SCALERS)
+			if (threadCounts[i] > 1 && (scalerProc == HQ2x || scalerProc == HQ3x))
+				continue;
+#endif
+			SdlScalerPool pool(threadCounts[i]);
+			memset(dst, 0, dstSize);
+
+			const uint32 start = SDL_GetTicks();
+			for (int frame = 0; frame < kFrames; ++frame) {
+				pool.addJob(scalerProc, src + srcPitch + 2, srcPitch, dst, dstPitch, kWidth, kHeight, scaleFactor);
+				pool.run();
+			}
+			const uint32 elapsed = SDL_GetTicks() - start;
+
+			bool identical = true;
+			if (i == 0)
+				memcpy(reference, dst, dstSize);
+			else
+				identical = (memcmp(reference, dst, dstSize) == 0);
+
+			debug("Scaler %s, %d thread(s): %.3f ms/frame%s", mode->name, pool.getThreadCount(),
+			      (double)elapsed / kFrames, identical ? "" : " (output differs from 1 thread)");
+		}
+	}
+
+	delete[] reference;
+	delete[] dst;
+	delete[] src;
+}
+
 bool SurfaceSdlGraphicsManager::saveScreenshot(const Common::String &filename) const {
 	assert(_hwScreen != NULL);
 
@@ -27,8 +27,10 @@
 #include "backends/graphics/sdl/sdl-graphics.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
+#include "common/array.h"
 #include "common/events.h"
 #include "common/mutex.h"
+#include "common/rect.h"
 
 #include "backends/events/sdl/sdl-events.h"
 
@@ -39,6 +41,8 @@
 #define USE_SDL_DEBUG_FOCUSRECT
 #endif
 
+class SdlScalerPool;
+
 enum {
 	GFX_NORMAL = 0,
 	GFX_DOUBLESIZE = 1,
@@ -326,6 +330,35 @@ protected:
 	int _scalerType;
 	int _transactionMode;
 
+	/** Worker pool for the scalers, or nullptr when scaling on the main thread */
+	SdlScalerPool *_scalerPool;
+
+	/** A dirty rect whose scaler job is queued in _scalerPool */
+	struct PendingScalerRect {
+		SDL_Rect *rect;
+		/** The screen area touched by the scaler and the aspect ratio correction */
+		Common::Rect area;
+		int origDstY;
+		bool stretch;
+	};
+	Common::Array<PendingScalerRect> _pendingScalerRects;
+
+	/** Whether benchmarkScalers() still has to run once the scalers are set up */
+	bool _scalerBenchmarkPending;
+
+	/**
+	 * Run all queued scaler jobs and apply the aspect ratio correction to
+	 * the rects afterwards.
+	 */
+	void flushScalerPool();
+
+	/**
+	 * Time every supported scaler on a full 320x200 frame with 1, 2, 4 and
+	 * 8 threads and print the result in ms/frame. The multithreaded output
+	 * is checked against the single threaded one.
+	 */
+	void benchmarkScalers();
+
 	// Indicates whether it is needed to free _hwSurface in destructor
 	bool _displayDisabled;
 
@@ -0,0 +1,158 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/graphics/surfacesdl/surfacesdl-scalerpool.h"
+
+#include "common/textconsole.h"
+
+SdlScalerPool::SdlScalerPool(uint numThreads)
+	: _batchSize(0), _nextJob(0), _pendingJobs(0), _quit(false) {
+	_mutex = SDL_CreateMutex();
+	_workCond = SDL_CreateCond();
+	_doneCond = SDL_CreateCond();
+
+	for (uint i = 1; i < numThreads; ++i) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		SDL_Thread *thread = SDL_CreateThread(workerThread, "ScummVM scaler", this);
+#else
+		SDL_Thread *thread = SDL_CreateThread(workerThread, this);
+#endif
+		if (!thread) {
+			warning("Could not create scaler thread: %s", SDL_GetError());
+			break;
+		}
+		_threads.push_back(thread);
+	}
+}
+
+SdlScalerPool::~SdlScalerPool() {
+	SDL_LockMutex(_mutex);
+	_quit = true;
+	SDL_CondBroadcast(_workCond);
+	SDL_UnlockMutex(_mutex);
+
+	for (uint i = 0; i < _threads.size(); ++i)
+		SDL_WaitThread(_threads[i], nullptr);
+
+	SDL_DestroyCond(_doneCond);
+	SDL_DestroyCond(_workCond);
+	SDL_DestroyMutex(_mutex);
+}
+
+void SdlScalerPool::addJob(ScalerProc *scalerProc, const uint8 *srcPtr, uint32 srcPitch,
+                           uint8 *dstPtr, uint32 dstPitch, int width, int height, int scaleFactor) {
+	if (width <= 0 || height <= 0)
+		return;
+
+	// Split the rect into one band per thread, rounded up to a multiple of
+	// four rows.
+	const int numThreads = getThreadCount();
+	int bandHeight = (height + numThreads - 1) / numThreads;
+	bandHeight = MAX<int>((bandHeight + 3) & ~3, kMinBandHeight);
+
+	for (int y = 0; y < height; y += bandHeight) {
+		Job job;
+		job.scalerProc = scalerProc;
+		job.srcPtr = srcPtr + y * srcPitch;
+		job.srcPitch = srcPitch;
+		job.dstPtr = dstPtr + y * scaleFactor * dstPitch;
+		job.dstPitch = dstPitch;
+		job.width = width;
+		job.height = MIN(bandHeight, height - y);
+		_jobs.push_back(job);
+	}
+}
+
+void SdlScalerPool::run() {
+	if (_jobs.empty())
+		return;
+
+	if (_threads.empty()) {
+		for (uint i = 0; i < _jobs.size(); ++i) {
+			const Job &job = _jobs[i];
+			job.scalerProc(job.srcPtr, job.srcPitch, job.dstPtr, job.dstPitch, job.width, job.height);
+		}
+		_jobs.clear();
+		return;
+	}
+
+	SDL_LockMutex(_mutex);
+	_batchSize = _jobs.size();
+	_nextJob = 0;
+	_pendingJobs = _batchSize;
+	SDL_CondBroadcast(_workCond);
+	SDL_UnlockMutex(_mutex);
+
+	while (executeNextJob())
+		;
+
+	SDL_LockMutex(_mutex);
+	while (_pendingJobs > 0)
+		SDL_CondWait(_doneCond, _mutex);
+	_batchSize = 0;
+	SDL_UnlockMutex(_mutex);
+
+	_jobs.clear();
+}
+
+bool SdlScalerPool::executeNextJob() {
+	SDL_LockMutex(_mutex);
+	if (_nextJob >= _batchSize) {
+		SDL_UnlockMutex(_mutex);
+		return false;
+	}
+	const Job job = _jobs[_nextJob++];
+	SDL_UnlockMutex(_mutex);
+
+	job.scalerProc(job.srcPtr, job.srcPitch, job.dstPtr, job.dstPitch, job.width, job.height);
+
+	SDL_LockMutex(_mutex);
+	if (--_pendingJobs == 0)
+		SDL_CondSignal(_doneCond);
+	SDL_UnlockMutex(_mutex);
+	return true;
+}
+
+int SDLCALL SdlScalerPool::workerThread(void *data) {
+	SdlScalerPool *pool = (SdlScalerPool *)data;
+
+	SDL_LockMutex(pool->_mutex);
+	while (!pool->_quit) {
+		if (pool->_nextJob >= pool->_batchSize) {
+			SDL_CondWait(pool->_workCond, pool->_mutex);
+			continue;
+		}
+
+		SDL_UnlockMutex(pool->_mutex);
+		pool->executeNextJob();
+		SDL_LockMutex(pool->_mutex);
+	}
+	SDL_UnlockMutex(pool->_mutex);
+
+	return 0;
+}
+
+#endif
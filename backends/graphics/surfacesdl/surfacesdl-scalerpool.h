@@ -0,0 +1,109 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_GRAPHICS_SURFACESDL_SCALERPOOL_H
+#define BACKENDS_GRAPHICS_SURFACESDL_SCALERPOOL_H
+
+#include "backends/platform/sdl/sdl-sys.h"
+
+#include "common/array.h"
+#include "common/noncopyable.h"
+#include "graphics/scaler.h"
+
+/**
+ * Worker pool which runs scaler procs for several dirty rects in parallel.
+ *
+ * Jobs are queued with addJob() and executed by run(), which blocks until
+ * every queued job is done. The calling thread takes part in the work, so a
+ * pool with N threads only spawns N - 1 workers.
+ *
+ * Large rects are split into horizontal bands. The scalers read their
+ * one pixel border straight from the source surface, so a band produces
+ * exactly the same output as the corresponding rows of the whole rect.
+ * The band height is kept a multiple of 4 so that position dependent
+ * scalers (DotMatrix) see the same row pattern as well.
+ *
+ * The caller is responsible for never queueing jobs whose destination
+ * areas overlap in the same run() batch.
+ */
+class SdlScalerPool : Common::NonCopyable {
+public:
+	SdlScalerPool(uint numThreads);
+	~SdlScalerPool();
+
+	uint getThreadCount() const { return _threads.size() + 1; }
+
+	/**
+	 * Queue a scaler job. The parameters are the same as for a ScalerProc
+	 * call.
+	 */
+	void addJob(ScalerProc *scalerProc, const uint8 *srcPtr, uint32 srcPitch,
+	            uint8 *dstPtr, uint32 dstPitch, int width, int height, int scaleFactor);
+
+	/** Returns whether there are jobs waiting for run(). */
+	bool hasJobs() const { return !_jobs.empty(); }
+
+	/** Execute all queued jobs and wait for them to finish. */
+	void run();
+
+private:
+	enum {
+		/** Rects smaller than this are never split into bands. */
+		kMinBandHeight = 16
+	};
+
+	struct Job {
+		ScalerProc *scalerProc;
+		const uint8 *srcPtr;
+		uint32 srcPitch;
+		uint8 *dstPtr;
+		uint32 dstPitch;
+		int width;
+		int height;
+	};
+
+	static int SDLCALL workerThread(void *data);
+
+	/**
+	 * Take the next job of the current batch and execute it.
+	 *
+	 * @return false when no job was left
+	 */
+	bool executeNextJob();
+
+	Common::Array<Job> _jobs;
+	Common::Array<SDL_Thread *> _threads;
+
+	SDL_mutex *_mutex;
+	/** Signalled when a new batch is available or the pool shuts down. */
+	SDL_cond *_workCond;
+	/** Signalled when the last job of a batch is done. */
+	SDL_cond *_doneCond;
+
+	/** Number of jobs visible to the workers, zero outside of run(). */
+	uint _batchSize;
+	uint _nextJob;
+	uint _pendingJobs;
+	bool _quit;
+};
+
+#endif
@@ -113,6 +113,15 @@ void SdlMixerManager::init() {
 
 	_mixer = new Audio::MixerImpl(_obtained.freq);
 	assert(_mixer);
+
+	// Advanced users on slow systems may want music and speech to be
+	// decoded outside of the audio callback
+	if (ConfMan.hasKey("audio_decode_ahead", Common::ConfigManager::kApplicationDomain) &&
+	    ConfMan.getBool("audio_decode_ahead", Common::ConfigManager::kApplicationDomain)) {
+		if (!_mixer->setDecodeAhead(true))
+			warning("Decoding audio ahead is not supported by this build");
+	}
+
 	_mixer->setReady(true);
 
 	startAudio();
@@ -53,14 +53,16 @@ typedef void (*sighandler_t)(int);
 
 #ifndef NULL_DRIVER_USE_FOR_TEST
 #include "backends/saves/default/default-saves.h"
-#include "backends/timer/default/default-timer.h"
 #include "backends/events/default/default-events.h"
 #include "backends/mixer/null/null-mixer.h"
-#include "backends/mutex/null/null-mutex.h"
-#include "backends/graphics/null/null-graphics.h"
 #include "gui/debugger.h"
 #endif
 
+#include "backends/graphics/null/null-graphics.h"
+
+#include "backends/mutex/null/null-mutex.h"
+#include "backends/timer/default/default-timer.h"
+
 /*
  * Include header files needed for the getFilesystemFactory() method.
  */
@@ -83,6 +85,11 @@ public:
 
 	virtual void initBackend();
 
+#ifdef NULL_DRIVER_USE_FOR_TEST
+	/** Create the managers the tests need, which require g_system to be set. */
+	void initTestBackend();
+#endif
+
 	virtual bool pollEvent(Common::Event &event);
 
 	virtual uint32 getMillis(bool skipRecord = false);
@@ -117,6 +124,9 @@ OSystem_NULL::OSystem_NULL() {
 	#else
 		#error Unknown and unsupported FS backend
 	#endif
+
+	// Created here, so that the tests can use mutexes
+	_mutexManager = new NullMutexManager();
 }
 
 OSystem_NULL::~OSystem_NULL() {
@@ -145,7 +155,6 @@ void OSystem_NULL::initBackend() {
 	last_handler = signal(SIGINT, intHandler);
 #endif
 
-	_mutexManager = new NullMutexManager();
 	_timerManager = new DefaultTimerManager();
 	_eventManager = new DefaultEventManager(this);
 	_savefileManager = new DefaultSaveFileManager();
@@ -158,6 +167,13 @@ void OSystem_NULL::initBackend() {
 	BaseBackend::initBackend();
 }
 
+#ifdef NULL_DRIVER_USE_FOR_TEST
+void OSystem_NULL::initTestBackend() {
+	_timerManager = new DefaultTimerManager();
+	_graphicsManager = new NullGraphicsManager();
+}
+#endif
+
 bool OSystem_NULL::pollEvent(Common::Event &event) {
 #ifndef NULL_DRIVER_USE_FOR_TEST
 	((DefaultTimerManager *)getTimerManager())->checkTimers();
@@ -84,6 +84,7 @@ static const char HELP_STRING[] =
 	"  --auto-detect            Display a list of games from current or specified directory\n"
 	"                           and start the first one. Use --path=PATH to specify a directory.\n"
 	"  --recursive              In combination with --add or --detect recurse down all subdirectories\n"
+	"  --no-md5-cache           Do not use the cache of file checksums during game detection\n"
 #if defined(WIN32) && !defined(__SYMBIAN32__)
 	"  --console                Enable the console window (default:enabled)\n"
 #endif
@@ -266,6 +267,8 @@ void registerDefaults() {
 	ConfMan.registerDefault("cdrom", 0);
 
 	ConfMan.registerDefault("enable_unsupported_game_warning", true);
+	ConfMan.registerDefault("md5_cache", true);
+	ConfMan.registerDefault("mmap_files", false);
 
 	// Game specific
 	ConfMan.registerDefault("path", "");
@@ -752,6 +755,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION_BOOL("recursive")
 			END_OPTION
 
+			DO_LONG_OPTION_BOOL("md5-cache")
+			END_OPTION
+
 			DO_LONG_OPTION("themepath")
 				Common::FSNode path(option);
 				if (!path.exists()) {
@@ -1039,21 +1045,29 @@ static DetectedGames getGameList(const Common::FSNode &dir) {
 }
 
 static DetectedGames recListGames(const Common::FSNode &dir, const Common::String &engineId, const Common::String &gameId, bool recursive) {
-	DetectedGames list = getGameList(dir);
+	DetectedGames list;
 
-	if (recursive) {
-		Common::FSList files;
-		dir.getChildren(files, Common::FSNode::kListDirectoriesOnly);
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			DetectedGames rec = recListGames(*file, engineId, gameId, recursive);
-			for (DetectedGames::const_iterator game = rec.begin(); game != rec.end(); ++game) {
-				if ((game->engineId == engineId && game->gameId == gameId)
-				    || gameId.empty())
-					list.push_back(*game);
-			}
+	if (!dir.isDirectory()) {
+		printf("Path %s does not exist or is not a directory.\n", dir.getPath().c_str());
+		return list;
+	}
+
+	uint32 startTime = g_system->getMillis();
+
+	DetectionScan scan(dir, recursive);
+	Common::FSNode gameDir;
+	DetectedGames games;
+	while (scan.step(gameDir, games)) {
+		for (DetectedGames::const_iterator game = games.begin(); game != games.end(); ++game) {
+			// Games found in the starting directory are always listed
+			if ((game->engineId == engineId && game->gameId == gameId)
+			    || gameId.empty() || gameDir.getPath() == dir.getPath())
+				list.push_back(*game);
 		}
 	}
 
+	debug(1, "Scanned %d directories in %d ms", scan.getDirsScanned(), g_system->getMillis() - startTime);
+
 	return list;
 }
 
@@ -1353,6 +1367,11 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 		}
 	}
 
+	// The detection commands below run before the settings are copied into
+	// the config manager, so apply the MD5 cache setting early.
+	if (settings.contains("md5-cache"))
+		ConfMan.set("md5_cache", settings["md5-cache"], Common::ConfigManager::kTransientDomain);
+
 	// Handle commands passed via the command line (like --list-targets and
 	// --list-games). This must be done after the config file and the plugins
 	// have been loaded.
@@ -25,12 +25,14 @@
 #include "common/func.h"
 #include "common/debug.h"
 #include "common/config-manager.h"
+#include "common/system.h"
 
 #ifdef DYNAMIC_MODULES
 #include "common/fs.h"
 #endif
 
 #include "base/detection/detection.h"
+#include "engines/md5cache.h"
 
 // Plugin versioning
 
@@ -682,6 +684,18 @@ QualifiedGameList EngineManager::findGameInLoadedPlugins(const Common::String &g
 	return results;
 }
 
+/** Run the detector of a single engine and add the games it found to the candidates. */
+static void detectGamesWithPlugin(const Plugin *plugin, const Common::FSList &fslist, DetectedGames &candidates) {
+	const MetaEngineDetection &metaEngine = plugin->get<MetaEngineDetection>();
+	DetectedGames engineCandidates = metaEngine.detectGames(fslist);
+
+	for (uint i = 0; i < engineCandidates.size(); i++) {
+		engineCandidates[i].path = fslist.begin()->getParent().getPath();
+		engineCandidates[i].shortPath = fslist.begin()->getParent().getDisplayName();
+		candidates.push_back(engineCandidates[i]);
+	}
+}
+
 DetectionResults EngineManager::detectGames(const Common::FSList &fslist) const {
 	DetectedGames candidates;
 	PluginList plugins;
@@ -693,16 +707,12 @@ DetectionResults EngineManager::detectGames(const Common::FSList &fslist) const
 
 	// Iterate over all known games and for each check if it might be
 	// the game in the presented directory.
-	for (iter = plugins.begin(); iter != plugins.end(); ++iter) {
-		const MetaEngineDetection &metaEngine = (*iter)->get<MetaEngineDetection>();
-		DetectedGames engineCandidates = metaEngine.detectGames(fslist);
+	for (iter = plugins.begin(); iter != plugins.end(); ++iter)
+		detectGamesWithPlugin(*iter, fslist, candidates);
 
-		for (uint i = 0; i < engineCandidates.size(); i++) {
-			engineCandidates[i].path = fslist.begin()->getParent().getPath();
-			engineCandidates[i].shortPath = fslist.begin()->getParent().getDisplayName();
-			candidates.push_back(engineCandidates[i]);
-		}
-	}
+	MD5Cache &md5Cache = MD5Cache::instance();
+	md5Cache.flush();
+	debug(1, "MD5 cache: %d hits, %d misses", md5Cache.getHits(), md5Cache.getMisses());
 
 	return DetectionResults(candidates);
 }
@@ -931,6 +941,83 @@ void EngineManager::upgradeTargetForEngineId(const Common::String &target) const
 	ConfMan.flushToDisk();
 }
 
+// DetectionScan
+
+DetectionScan::DetectionScan(const Common::FSNode &startDir, bool recursive)
+	: _recursive(recursive), _nextPlugin(0), _dirsScanned(0), _dirsTotal(1) {
+	_scanStack.push(startDir);
+}
+
+DetectionScan::~DetectionScan() {
+	// Also save the checksums computed so far if the scan got cancelled
+	MD5Cache::instance().flush();
+}
+
+bool DetectionScan::nextDir() {
+	while (!_scanStack.empty()) {
+		_dir = _scanStack.pop();
+
+		if (!_dir.getChildren(_files, Common::FSNode::kListAll) || _files.empty()) {
+			_files.clear();
+			_dirsScanned++;
+			continue;
+		}
+
+		// Push the subdirectories in reverse order, so that they get
+		// scanned in the order they are listed
+		if (_recursive) {
+			for (int i = _files.size() - 1; i >= 0; i--) {
+				if (_files[i].isDirectory()) {
+					_scanStack.push(_files[i]);
+					_dirsTotal++;
+				}
+			}
+		}
+
+		_nextPlugin = 0;
+		return true;
+	}
+
+	return false;
+}
+
+void DetectionScan::finishDir() {
+	DetectionResults detectionResults(_dirCandidates);
+	if (detectionResults.foundUnknownGames()) {
+		Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
+		g_system->logMessage(LogMessageType::kInfo, report.encode().c_str());
+	}
+
+	_dirCandidates.clear();
+	_files.clear();
+	_dirsScanned++;
+}
+
+bool DetectionScan::step(Common::FSNode &dir, DetectedGames &games) {
+	games.clear();
+
+	if (_files.empty() && !nextDir())
+		return false;
+
+	dir = _dir;
+
+	const PluginList &plugins = EngineMan.getPlugins(PLUGIN_TYPE_ENGINE_DETECTION);
+	if (_nextPlugin < plugins.size()) {
+		DetectedGames candidates;
+		detectGamesWithPlugin(plugins[_nextPlugin++], _files, candidates);
+
+		for (uint i = 0; i < candidates.size(); i++)
+			_dirCandidates.push_back(candidates[i]);
+
+		games = DetectionResults(candidates).listRecognizedGames();
+	}
+
+	if (_nextPlugin >= plugins.size())
+		finishDir();
+
+	return true;
+}
+
 // Music plugins
 
 #include "audio/musicplugin.h"
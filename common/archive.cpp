@@ -21,6 +21,7 @@
  */
 
 #include "common/archive.h"
+#include "common/debug.h"
 #include "common/fs.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -85,19 +86,146 @@ SearchSet::ArchiveNodeList::const_iterator SearchSet::find(const String &name) c
     In case two or node nodes have the same priority, insertion
     order prevails.
 */
-void SearchSet::insert(const Node &node) {
+SearchSet::ArchiveNodeList::iterator SearchSet::insert(const Node &node) {
 	ArchiveNodeList::iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
 		if (it->_priority < node._priority)
 			break;
 	}
 	_list.insert(it, node);
+	--it;
+
+	uint order = 0;
+	for (ArchiveNodeList::iterator i = _list.begin(); i != _list.end(); ++i)
+		i->_order = order++;
+
+	return it;
+}
+
+bool SearchSet::addToIndex(const Node &node) const {
+	StringArray names;
+	if (!node._arc->getMemberNames(names))
+		return false;
+
+	node._indexed = true;
+	--_unindexedArchives;
+	++_indexedArchives;
+
+	for (StringArray::const_iterator name = names.begin(); name != names.end(); ++name) {
+		IndexEntry &entry = _index[*name];
+
+		// Keep the entry in search order, with each archive only once
+		uint pos = entry.size();
+		while (pos > 0 && entry[pos - 1]->_order > node._order)
+			--pos;
+		if (pos > 0 && entry[pos - 1] == &node)
+			continue;
+		entry.insert_at(pos, &node);
+	}
+
+	debug(2, "SearchSet: Indexed %d names of '%s', %d archives are not indexed", names.size(), node._name.c_str(), _unindexedArchives);
+	return true;
+}
+
+void SearchSet::removeFromIndex(const Node &node) {
+	if (!node._indexed) {
+		--_unindexedArchives;
+		return;
+	}
+
+	// The member names of the archive may have changed since it was
+	// indexed, so look for the node in all the entries instead of only
+	// in the ones of its current names.
+	for (NameIndex::iterator entry = _index.begin(); entry != _index.end(); ) {
+		NameIndex::iterator cur = entry++;
+
+		for (uint i = 0; i < cur->_value.size(); ++i) {
+			if (cur->_value[i] == &node) {
+				cur->_value.remove_at(i);
+				break;
+			}
+		}
+
+		if (cur->_value.empty())
+			_index.erase(cur);
+	}
+
+	node._indexed = false;
+}
+
+void SearchSet::resetIndex() {
+	_index.clear(true);
+	_unindexedArchives = 0;
+
+	for (ArchiveNodeList::iterator it = _list.begin(); it != _list.end(); ++it) {
+		it->_indexed = false;
+		++_unindexedArchives;
+	}
+}
+
+void SearchSet::setIndexEnabled(bool enable) {
+	_indexEnabled = enable;
+	if (!enable)
+		resetIndex();
+}
+
+void SearchSet::startLookup(const String &name, Lookup &lookup) const {
+	lookup.name = &name;
+	lookup.entry = nullptr;
+	lookup.next = 0;
+	lookup.node = _list.begin();
+
+	if (!_indexEnabled)
+		return;
+
+	++_indexLookups;
+
+	NameIndex::const_iterator it = _index.find(name);
+	if (it != _index.end()) {
+		lookup.entry = &it->_value;
+		++_indexHits;
+	}
+}
+
+Archive *SearchSet::nextArchive(Lookup &lookup) const {
+	// When all archives are indexed, only the ones in the entry need asking
+	if (_indexEnabled && _unindexedArchives == 0) {
+		if (!lookup.entry || lookup.next >= lookup.entry->size())
+			return nullptr;
+		return (*lookup.entry)[lookup.next++]->_arc;
+	}
+
+	// Otherwise, walk the list and skip the indexed archives not in the entry
+	for (; lookup.node != _list.end(); ++lookup.node) {
+		const Node &node = *lookup.node;
+
+		// An archive is indexed when a lookup first has to ask it. This
+		// only adds archives after the ones already walked to the entry, so
+		// lookup.next stays valid, but the entry may have moved.
+		if (_indexEnabled && !node._indexed && addToIndex(node)) {
+			NameIndex::const_iterator it = _index.find(*lookup.name);
+			lookup.entry = it != _index.end() ? &it->_value : nullptr;
+		}
+
+		if (node._indexed) {
+			if (!lookup.entry || lookup.next >= lookup.entry->size() || (*lookup.entry)[lookup.next] != &node)
+				continue;
+			++lookup.next;
+		}
+
+		Archive *archive = node._arc;
+		++lookup.node;
+		return archive;
+	}
+
+	return nullptr;
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
 	if (find(name) == _list.end()) {
 		Node node(priority, name, archive, autoFree);
 		insert(node);
+		++_unindexedArchives;
 	} else {
 		if (autoFree)
 			delete archive;
@@ -170,6 +298,7 @@ void SearchSet::addSubDirectoriesMatching(const FSNode &directory, String origPa
 void SearchSet::remove(const String &name) {
 	ArchiveNodeList::iterator it = find(name);
 	if (it != _list.end()) {
+		removeFromIndex(*it);
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
@@ -181,12 +310,15 @@ bool SearchSet::hasArchive(const String &name) const {
 }
 
 void SearchSet::clear() {
+	resetIndex();
+
 	for (ArchiveNodeList::iterator i = _list.begin(); i != _list.end(); ++i) {
 		if (i->_autoFree)
 			delete i->_arc;
 	}
 
 	_list.clear();
+	_unindexedArchives = 0;
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -200,18 +332,22 @@ void SearchSet::setPriority(const String &name, int priority) {
 		return;
 
 	Node node(*it);
+	removeFromIndex(*it);
 	_list.erase(it);
 	node._priority = priority;
+	node._indexed = false;
 	insert(node);
+	++_unindexedArchives;
 }
 
 bool SearchSet::hasFile(const String &name) const {
 	if (name.empty())
 		return false;
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for (; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
+	Lookup lookup;
+	startLookup(name, lookup);
+	for (Archive *archive = nextArchive(lookup); archive; archive = nextArchive(lookup)) {
+		if (archive->hasFile(name))
 			return true;
 	}
 
@@ -221,6 +357,16 @@ bool SearchSet::hasFile(const String &name) const {
 int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
 	int matches = 0;
 
+	// A plain name can be looked up in the index
+	if (!pattern.empty() && !strpbrk(pattern.c_str(), "*?#\\")) {
+		Lookup lookup;
+		startLookup(pattern, lookup);
+		for (Archive *archive = nextArchive(lookup); archive; archive = nextArchive(lookup))
+			matches += archive->listMatchingMembers(list, pattern);
+
+		return matches;
+	}
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it)
 		matches += it->_arc->listMatchingMembers(list, pattern);
@@ -242,10 +388,11 @@ const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for (; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return it->_arc->getMember(name);
+	Lookup lookup;
+	startLookup(name, lookup);
+	for (Archive *archive = nextArchive(lookup); archive; archive = nextArchive(lookup)) {
+		if (archive->hasFile(name))
+			return archive->getMember(name);
 	}
 
 	return ArchiveMemberPtr();
@@ -255,9 +402,10 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	if (name.empty())
 		return nullptr;
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for (; it != _list.end(); ++it) {
-		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
+	Lookup lookup;
+	startLookup(name, lookup);
+	for (Archive *archive = nextArchive(lookup); archive; archive = nextArchive(lookup)) {
+		SeekableReadStream *stream = archive->createReadStreamForMember(name);
 		if (stream)
 			return stream;
 	}
@@ -267,6 +415,7 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 
 
 SearchManager::SearchManager() {
+	setIndexEnabled(true);
 	clear(); // Force a reset
 }
 
@@ -24,9 +24,11 @@
 #define COMMON_ARCHIVE_H
 
 #include "common/str.h"
+#include "common/hash-str.h"
 #include "common/list.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
+#include "common/str-array.h"
 
 namespace Common {
 
@@ -137,6 +139,22 @@ public:
 	 * @return The newly created input stream.
 	 */
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const = 0;
+
+	/**
+	 * Add the names of the members to the list, so that a SearchSet can index
+	 * the Archive. The list must contain every name which hasFile() and
+	 * listMatchingMembers() accept without a pattern, ignoring case. Names
+	 * which do not exist any more are harmless. The names must not change
+	 * while the Archive is part of a SearchSet.
+	 *
+	 * This is only meant to hand out names which the Archive already holds.
+	 * If getting them would be costly, e.g. because a directory has to be
+	 * read first, return false: the SearchSet asks again on later lookups.
+	 *
+	 * @return False if the names are not at hand, which is the default.
+	 *         Such archives are searched one by one.
+	 */
+	virtual bool getMemberNames(StringArray &names) const { return false; }
 };
 
 
@@ -147,6 +165,12 @@ public:
  * contained Archives, hence the simplistic policy of always looking for the first
  * match. SearchSet does guarantee that searches are performed in DESCENDING
  * priority order. In case of conflicting priorities, insertion order prevails.
+ *
+ * Optionally, the SearchSet keeps an index of the names of the members of
+ * its archives which support Archive::getMemberNames(), so that a lookup only
+ * needs to ask the archives which actually contain the name. Each archive is
+ * added to the index when a lookup first has to ask it, so the archives
+ * which are never searched are never listed.
  */
 class SearchSet : public Archive {
 	struct Node {
@@ -154,22 +178,54 @@ class SearchSet : public Archive {
 		String	_name;
 		Archive	*_arc;
 		bool	_autoFree;
+		mutable bool	_indexed;	//!< The names of the archive are in the index.
+		uint	_order;				//!< Position in the list, used to sort index entries.
 		Node(int priority, const String &name, Archive *arc, bool autoFree)
-			: _priority(priority), _name(name), _arc(arc), _autoFree(autoFree) {
+			: _priority(priority), _name(name), _arc(arc), _autoFree(autoFree), _indexed(false), _order(0) {
 		}
 	};
 	typedef List<Node> ArchiveNodeList;
 	ArchiveNodeList _list;
 
+	/** The archives containing each name, in search order. */
+	typedef Array<const Node *> IndexEntry;
+	typedef HashMap<String, IndexEntry, IgnoreCase_Hash, IgnoreCase_EqualTo> NameIndex;
+
+	/** State of a lookup, see startLookup(). */
+	struct Lookup {
+		const String *name;
+		const IndexEntry *entry;
+		uint next;
+		ArchiveNodeList::const_iterator node;
+	};
+
 	ArchiveNodeList::iterator find(const String &name);
 	ArchiveNodeList::const_iterator find(const String &name) const;
 
-	void insert(const Node& node); //!< Add an archive while keeping the list sorted by descending priority.
+	//! Add an archive while keeping the list sorted by descending priority.
+	ArchiveNodeList::iterator insert(const Node& node);
+
+	bool addToIndex(const Node &node) const;
+	void removeFromIndex(const Node &node);
+	void resetIndex();
+
+	/** Prepare to iterate over the archives which may contain a name. */
+	void startLookup(const String &name, Lookup &lookup) const;
+	/** Return the next archive which may contain the name, or nullptr. */
+	Archive *nextArchive(Lookup &lookup) const;
 
 	bool _ignoreClashes;
 
+	bool _indexEnabled;
+	mutable NameIndex _index;
+	mutable uint _unindexedArchives;
+	mutable uint _indexedArchives;
+	mutable uint _indexLookups;
+	mutable uint _indexHits;
+
 public:
-	SearchSet() : _ignoreClashes(false) { }
+	SearchSet() : _ignoreClashes(false), _indexEnabled(false), _unindexedArchives(0),
+		_indexedArchives(0), _indexLookups(0), _indexHits(0) { }
 	virtual ~SearchSet() { clear(); }
 
 	/**
@@ -268,6 +324,19 @@ public:
 	 * in @ref FSDirectory documentation.
 	 */
 	void setIgnoreClashes(bool ignoreClashes) { _ignoreClashes = ignoreClashes; }
+
+	/**
+	 * Enable or disable the index of member names. It is disabled by default,
+	 * except in the SearchManager.
+	 */
+	void setIndexEnabled(bool enable);
+
+	/** Get how many times an archive has been added to the index. */
+	uint getIndexedArchives() const { return _indexedArchives; }
+	/** Get how many lookups went through the index. */
+	uint getIndexLookups() const { return _indexLookups; }
+	/** Get how many lookups found the name in the index. */
+	uint getIndexHits() const { return _indexHits; }
 };
 
 
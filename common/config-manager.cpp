@@ -98,6 +98,32 @@ void ConfigManager::loadDefaultConfigFile() {
 	}
 }
 
+String ConfigManager::getConfigFileName() const {
+	return _filename.empty() ? g_system->getDefaultConfigFileName() : _filename;
+}
+
+bool ConfigManager::getCacheFile(const String &fileName, FSNode &node) const {
+	String configFileName = getConfigFileName();
+	if (configFileName.empty())
+		return false;
+
+	FSNode configFile(configFileName);
+	FSNode dir = configFile.getParent();
+	if (dir.isDirectory()) {
+		node = dir.getChild(fileName);
+		return true;
+	}
+
+	// A bare file name is relative to the current directory, which some
+	// backends cannot report as a parent.
+	if (configFile.getName() == configFileName) {
+		node = FSNode(fileName);
+		return true;
+	}
+
+	return false;
+}
+
 void ConfigManager::loadConfigFile(const String &filename) {
 	_filename = filename;
 
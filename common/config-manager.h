@@ -41,6 +41,7 @@ namespace Common {
  * @{
  */
 
+class FSNode;
 class WriteStream;
 class SeekableReadStream;
 
@@ -123,6 +124,15 @@ public:
 
 	void                     loadDefaultConfigFile(); /*!< Load the default configuration file. */
 	void                     loadConfigFile(const String &filename); /*!< Load a specific configuration file. */
+	String                   getConfigFileName() const; /*!< Name of the configuration file in use, or of the default one. */
+
+	/**
+	 * Find the file with the given name in the directory of the configuration
+	 * file, where the caches are kept.
+	 *
+	 * @return false if that directory is not known.
+	 */
+	bool                     getCacheFile(const String &fileName, FSNode &node) const;
 
 	/**
 	 * Retrieve the config domain with the given name.
@@ -0,0 +1,649 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The layout and probing scheme of the hash map in this file follow the
+// "Swiss table" design: one control byte per slot, kept in a separate array
+// and probed a group of slots at a time.
+
+#ifndef COMMON_FLAT_HASHMAP_H
+#define COMMON_FLAT_HASHMAP_H
+
+#include "common/hashmap.h"
+#include "common/math.h"
+#include "common/textconsole.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_flat_hashmap Flat hash table (FlatHashMap)
+ * @ingroup common
+ *
+ * @brief API for operations on a flat hash table.
+ *
+ * @{
+ */
+
+/**
+ * FlatHashMap<Key,Val> is a drop-in replacement for HashMap<Key,Val> which
+ * stores its entries inline instead of allocating a node for every one of
+ * them.
+ *
+ * Next to the array of entries, the map keeps an array with one control byte
+ * per entry, recording whether the entry is empty, erased, or in use, and in
+ * the latter case seven bits of the hash of its key. Lookups scan the control
+ * bytes a group of 16 at a time (using SSE2 where available), and only
+ * compare the keys of the entries whose hash bits match. This avoids the
+ * pointer chase of HashMap for each probe and keeps lookups cache friendly.
+ *
+ * The interface is the same as the one of HashMap, with one difference:
+ * inserting into the map moves the entries around, so pointers, references
+ * and iterators into a FlatHashMap are invalidated by any insertion of a new
+ * key. Erasing does not move the other entries. For the same reason, the
+ * key and value passed to setVal() must not live in the map itself.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+
+	struct Node {
+		Val _value;
+		const Key _key;
+		explicit Node(const Key &key) : _value(), _key(key) {}
+		Node(const Key &key, const Val &value) : _value(value), _key(key) {}
+	};
+
+	enum {
+		/** Number of control bytes looked at in one go. */
+		HASHMAP_GROUP_SIZE = 16,
+		HASHMAP_MIN_CAPACITY = 16,
+
+		// Same meaning as in HashMap. The control bytes make it cheap to
+		// skip over used slots, so the map may fill up a lot more.
+		HASHMAP_LOADFACTOR_NUMERATOR = 7,
+		HASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	enum {
+		/** Control byte of a slot which has never been used. */
+		kCtrlEmpty = 0x80,
+		/** Control byte of an erased slot, which must not stop a probe. */
+		kCtrlDeleted = 0xFE
+		// Used slots have a control byte between 0 and 0x7F
+	};
+
+	/** Default value, returned by the const getVal. */
+	Val _defaultVal;
+
+	/**
+	 * Control bytes. The first HASHMAP_GROUP_SIZE - 1 bytes are mirrored at
+	 * the end of the array, so that a group can be read from any position
+	 * without wrapping around.
+	 */
+	byte *_ctrl;
+	Node *_slots;		///< Uninitialized storage for _mask + 1 entries
+	size_type _mask;	///< Capacity of the map minus one; the capacity is a power of two
+	size_type _size;
+	size_type _deleted;	///< Number of erased slots
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/**
+	 * Scramble the result of the hash function. Many of our hash functions
+	 * return their key unchanged, and the low bits are used for the position
+	 * while the high bits are stored in the control byte.
+	 */
+	static uint32 mixHash(uint hash) {
+		const uint32 h = (uint32)hash * 0x9E3779B1U;
+		return h ^ (h >> 16);
+	}
+
+	static byte hashTag(uint32 hash) { return (byte)(hash >> 25); }
+
+	/** Returns a bit mask of the bytes in the group at ctrl which are equal to value. */
+	static uint32 matchGroup(const byte *ctrl, byte value) {
+#if defined(__SSE2__)
+		const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+		return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)value)));
+#else
+		uint32 mask = 0;
+		for (int i = 0; i < HASHMAP_GROUP_SIZE; ++i) {
+			if (ctrl[i] == value)
+				mask |= 1 << i;
+		}
+		return mask;
+#endif
+	}
+
+	/** Returns a bit mask of the bytes in the group at ctrl which are empty or erased. */
+	static uint32 matchFree(const byte *ctrl) {
+#if defined(__SSE2__)
+		return (uint32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+		uint32 mask = 0;
+		for (int i = 0; i < HASHMAP_GROUP_SIZE; ++i) {
+			if (ctrl[i] & 0x80)
+				mask |= 1 << i;
+		}
+		return mask;
+#endif
+	}
+
+	static int lowestBit(uint32 mask) { return intLog2(mask & (~mask + 1)); }
+
+	bool isUsed(size_type idx) const { return _ctrl[idx] < 0x80; }
+
+	void setCtrl(size_type idx, byte value) {
+		_ctrl[idx] = value;
+		if (idx < HASHMAP_GROUP_SIZE - 1)
+			_ctrl[_mask + 1 + idx] = value;
+	}
+
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void assign(const HM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type findFreeSlot(uint32 hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void resize(size_type newCapacity);
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != nullptr);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->isUsed(_idx));
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(nullptr) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && !_hashmap->isUsed(_idx));
+			if (_idx > _hashmap->_mask)
+				_idx = (size_type)-1;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const HM_t &map);
+	~FlatHashMap();
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getOrCreateVal(const Key &key);
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getValOrDefault(const Key &key) const;
+	const Val &getValOrDefault(const Key &key, const Val &defaultVal) const;
+	bool tryGetVal(const Key &key, Val &out) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isUsed(ctr))
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isUsed(ctr))
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const Key &key) const {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	/** Return true if hashmap is empty. */
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(HASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const HM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Internal method for allocating empty storage for the given number of
+ * entries. The previous storage is *not* deallocated.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	_mask = capacity - 1;
+	_size = 0;
+	_deleted = 0;
+
+	_ctrl = (byte *)malloc(capacity + HASHMAP_GROUP_SIZE - 1);
+	_slots = (Node *)malloc(capacity * sizeof(Node));
+	if (!_ctrl || !_slots)
+		::error("Common::FlatHashMap: failure to allocate %u entries", capacity);
+
+	memset(_ctrl, kCtrlEmpty, capacity + HASHMAP_GROUP_SIZE - 1);
+}
+
+/**
+ * Internal method for destroying all entries and freeing the storage.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isUsed(ctr))
+			_slots[ctr].~Node();
+	}
+
+	free(_slots);
+	free(_ctrl);
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note The previous storage here is *not* deallocated here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// Clone the map slot by slot, so that the probe sequences stay valid
+	memcpy(_ctrl, map._ctrl, _mask + HASHMAP_GROUP_SIZE);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isUsed(ctr))
+			new ((void *)&_slots[ctr]) Node(map._slots[ctr]._key, map._slots[ctr]._value);
+	}
+
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+/**
+ * Clear all values in the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= HASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(HASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isUsed(ctr))
+			_slots[ctr].~Node();
+	}
+
+	memset(_ctrl, kCtrlEmpty, _mask + HASHMAP_GROUP_SIZE);
+	_size = 0;
+	_deleted = 0;
+}
+
+/**
+ * Internal method for moving all entries into new storage of the given
+ * capacity. This also gets rid of all the erased slots.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::resize(size_type newCapacity) {
+	const size_type old_size = _size;
+	const size_type old_mask = _mask;
+	byte *old_ctrl = _ctrl;
+	Node *old_slots = _slots;
+
+	allocStorage(newCapacity);
+
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_ctrl[ctr] >= 0x80)
+			continue;
+
+		// Since we know that no key exists twice in the old table, we
+		// don't have to call _equal().
+		const uint32 hash = mixHash(_hash(old_slots[ctr]._key));
+		const size_type idx = findFreeSlot(hash);
+		setCtrl(idx, hashTag(hash));
+		new ((void *)&_slots[idx]) Node(old_slots[ctr]._key, old_slots[ctr]._value);
+		old_slots[ctr].~Node();
+		_size++;
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	assert(_size == old_size);
+
+	free(old_slots);
+	free(old_ctrl);
+}
+
+/**
+ * Internal method for finding the slot of a key.
+ *
+ * @return The index of the slot, or _mask + 1 if the key is not in the map.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const uint32 hash = mixHash(_hash(key));
+	const byte tag = hashTag(hash);
+	size_type pos = hash & _mask;
+
+	// Probe groups with growing steps. As the capacity is a power of two
+	// and at least one group, this visits every slot.
+	for (size_type step = HASHMAP_GROUP_SIZE; ; step += HASHMAP_GROUP_SIZE) {
+		for (uint32 match = matchGroup(_ctrl + pos, tag); match; match &= match - 1) {
+			const size_type idx = (pos + lowestBit(match)) & _mask;
+			if (_equal(_slots[idx]._key, key))
+				return idx;
+		}
+
+		// A key is never placed past an empty slot
+		if (matchGroup(_ctrl + pos, kCtrlEmpty))
+			return _mask + 1;
+
+		pos = (pos + step) & _mask;
+	}
+}
+
+/**
+ * Internal method for finding the first empty or erased slot on the probe
+ * sequence of a hash.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(uint32 hash) const {
+	size_type pos = hash & _mask;
+	for (size_type step = HASHMAP_GROUP_SIZE; ; step += HASHMAP_GROUP_SIZE) {
+		const uint32 match = matchFree(_ctrl + pos);
+		if (match)
+			return (pos + lowestBit(match)) & _mask;
+
+		pos = (pos + step) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return ctr;
+
+	// Keep the load factor below a certain threshold. Erased slots are also
+	// counted, since they lengthen the probe sequences just as much.
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted + 1) * HASHMAP_LOADFACTOR_DENOMINATOR > capacity * HASHMAP_LOADFACTOR_NUMERATOR) {
+		// Only grow if the map is really full, otherwise just get rid of
+		// the erased slots
+		if ((_size + 1) * 2 * HASHMAP_LOADFACTOR_DENOMINATOR > capacity * HASHMAP_LOADFACTOR_NUMERATOR)
+			capacity = capacity < 500 ? (capacity * 4) : (capacity * 2);
+		resize(capacity);
+	}
+
+	const uint32 hash = mixHash(_hash(key));
+	ctr = findFreeSlot(hash);
+	if (_ctrl[ctr] == kCtrlDeleted)
+		_deleted--;
+	setCtrl(ctr, hashTag(hash));
+	new ((void *)&_slots[ctr]) Node(key);
+	_size++;
+
+	return ctr;
+}
+
+/**
+ * Check whether the hashmap contains the given key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) <= _mask;
+}
+
+/**
+ * Get a value from the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getOrCreateVal(key);
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+/**
+ * Get a value from the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getOrCreateVal(const Key &key) {
+	// The lookup may reallocate _slots, so it has to happen first
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	return _slots[ctr]._value;
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _slots[ctr]._value;
+	else
+		unknownKeyError(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _slots[ctr]._value;
+	else
+		unknownKeyError(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key) const {
+	return getValOrDefault(key, _defaultVal);
+}
+
+/**
+ * Get a value from the hashmap. If the key is not present, then return @p defaultVal.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _slots[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::tryGetVal(const Key &key, Val &out) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask) {
+		out = _slots[ctr]._value;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+/**
+ * Assign an element specified by @p key to a value @p val.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	_slots[ctr]._value = val;
+}
+
+/**
+ * Erase an element referred to by an iterator.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	const size_type ctr = entry._idx;
+	assert(ctr <= _mask);
+	assert(isUsed(ctr));
+
+	_slots[ctr].~Node();
+	setCtrl(ctr, kCtrlDeleted);
+	_size--;
+	_deleted++;
+}
+
+/**
+ * Erase an element specified by a key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr > _mask)
+		return;
+
+	_slots[ctr].~Node();
+	setCtrl(ctr, kCtrlDeleted);
+	_size--;
+	_deleted++;
+}
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -125,6 +125,10 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+bool FSNode::getFileStats(int64 &size, int64 &mtime) const {
+	return _realNode && _realNode->getFileStats(size, mtime);
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == nullptr)
 		return nullptr;
@@ -152,6 +156,13 @@ WriteStream *FSNode::createWriteStream() const {
 	return _realNode->createWriteStream();
 }
 
+WriteStream *FSNode::createAppendStream() const {
+	if (_realNode == nullptr || _realNode->isDirectory())
+		return nullptr;
+
+	return _realNode->createAppendStream();
+}
+
 bool FSNode::createDirectory() const {
 	if (_realNode == nullptr)
 		return false;
@@ -359,6 +370,23 @@ int FSDirectory::listMatchingMembers(ArchiveMemberList &list, const String &patt
 	return matches;
 }
 
+bool FSDirectory::getMemberNames(StringArray &names) const {
+	// Only a directory which has already been read is indexed. The first
+	// lookup which asks it reads it, and the next one indexes it.
+	if (!_cached)
+		return false;
+
+	for (NodeCache::const_iterator it = _fileCache.begin(); it != _fileCache.end(); ++it)
+		names.push_back(it->_key);
+
+	if (_includeDirectories) {
+		for (NodeCache::const_iterator it = _subDirCache.begin(); it != _subDirCache.end(); ++it)
+			names.push_back(it->_key);
+	}
+
+	return true;
+}
+
 int FSDirectory::listMembers(ArchiveMemberList &list) const {
 	if (!_node.isDirectory())
 		return 0;
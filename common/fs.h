@@ -222,6 +222,19 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieve the size and the time of the last modification of the file
+	 * referred by this node, without opening it. The modification time is
+	 * only meant to be compared with an earlier value for the same file.
+	 *
+	 * @param size   Receives the size of the file in bytes.
+	 * @param mtime  Receives the modification time, in a backend-specific unit.
+	 *
+	 * @return True on success, false if the node is not a file or if the
+	 *         backend does not support this.
+	 */
+	bool getFileStats(int64 &size, int64 &mtime) const;
+
 	/**
 	 * Create a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -240,6 +253,15 @@ public:
 	 */
 	WriteStream *createWriteStream() const;
 
+	/**
+	 * Create a WriteStream instance which appends to the file referred by
+	 * this node, creating it if needed.
+	 *
+	 * @return Pointer to the stream object, 0 in case of a failure or if
+	 *         the backend does not support this.
+	 */
+	WriteStream *createAppendStream() const;
+
 	/**
 	 * Create a directory referred by this node. This assumes that this
 	 * node refers to a non-existing directory. If this is not the case,
@@ -392,6 +414,12 @@ public:
 	 * for success.
 	 */
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
+
+	/**
+	 * Add the relative paths of all the files in the cache to the list, as well as
+	 * the ones of the directories if they are included.
+	 */
+	virtual bool getMemberNames(StringArray &names) const;
 };
 
 /** @} */
@@ -96,8 +96,13 @@ private:
 	struct Node {
 		Val _value;
 		const Key _key;
-		explicit Node(const Key &key) : _key(key), _value() {}
-		Node() : _key(), _value() {}
+		/**
+		 * Hash of the key. Keeping it here spares hashing the keys again
+		 * when the storage grows, and comparing keys whose hash differs.
+		 */
+		const size_type _keyHash;
+		Node(const Key &key, size_type keyHash) : _key(key), _value(), _keyHash(keyHash) {}
+		Node() : _key(), _value(), _keyHash(0) {}
 	};
 
 	enum {
@@ -137,11 +142,11 @@ private:
 	mutable int _collisions, _lookups, _dummyHits;
 #endif
 
-	Node *allocNode(const Key &key) {
+	Node *allocNode(const Key &key, size_type keyHash) {
 #ifdef USE_HASHMAP_MEMORY_POOL
-		return new (_nodePool) Node(key);
+		return new (_nodePool) Node(key, keyHash);
 #else
-		return new Node(key);
+		return new Node(key, keyHash);
 #endif
 	}
 
@@ -155,7 +160,8 @@ private:
 	}
 
 	void assign(const HM_t &map);
-	size_type lookup(const Key &key) const;
+	size_type lookup(const Key &key) const { return lookup(key, _hash(key)); }
+	size_type lookup(const Key &key, size_type hash) const;
 	size_type lookupAndCreateIfMissing(const Key &key);
 	void expandStorage(size_type newCapacity);
 
@@ -414,7 +420,7 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
 			_storage[ctr] = HASHMAP_DUMMY_NODE;
 			_deleted++;
 		} else if (map._storage[ctr] != nullptr) {
-			_storage[ctr] = allocNode(map._storage[ctr]->_key);
+			_storage[ctr] = allocNode(map._storage[ctr]->_key, map._storage[ctr]->_keyHash);
 			_storage[ctr]->_value = map._storage[ctr]->_value;
 			_size++;
 		}
@@ -478,8 +484,8 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity
 		// Insert the element from the old table into the new table.
 		// Since we know that no key exists twice in the old table, we
 		// can do this slightly better than by calling lookup, since we
-		// don't have to call _equal().
-		const size_type hash = _hash(old_storage[ctr]->_key);
+		// don't have to call _equal() nor hash the key again.
+		const size_type hash = old_storage[ctr]->_keyHash;
 		size_type idx = hash & _mask;
 		for (size_type perturb = hash; _storage[idx] != nullptr && _storage[idx] != HASHMAP_DUMMY_NODE; perturb >>= HASHMAP_PERTURB_SHIFT) {
 			idx = (5 * idx + perturb + 1) & _mask;
@@ -499,8 +505,7 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity
 }
 
 template<class Key, class Val, class HashFunc, class EqualFunc>
-typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
-	const size_type hash = _hash(key);
+typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key, size_type hash) const {
 	size_type ctr = hash & _mask;
 	for (size_type perturb = hash; ; perturb >>= HASHMAP_PERTURB_SHIFT) {
 		if (_storage[ctr] == nullptr)
@@ -509,7 +514,7 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 #ifdef DEBUG_HASH_COLLISIONS
 			_dummyHits++;
 #endif
-		} else if (_equal(_storage[ctr]->_key, key))
+		} else if (_storage[ctr]->_keyHash == hash && _equal(_storage[ctr]->_key, key))
 			break;
 
 		ctr = (5 * ctr + perturb + 1) & _mask;
@@ -545,7 +550,7 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 #endif
 			if (first_free == NONE_FOUND)
 				first_free = ctr;
-		} else if (_equal(_storage[ctr]->_key, key)) {
+		} else if (_storage[ctr]->_keyHash == hash && _equal(_storage[ctr]->_key, key)) {
 			found = true;
 			break;
 		}
@@ -570,7 +575,7 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 	if (!found) {
 		if (_storage[ctr])
 			_deleted--;
-		_storage[ctr] = allocNode(key);
+		_storage[ctr] = allocNode(key, hash);
 		assert(_storage[ctr] != nullptr);
 		_size++;
 
@@ -581,7 +586,7 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 		        capacity * HASHMAP_LOADFACTOR_NUMERATOR) {
 			capacity = capacity < 500 ? (capacity * 4) : (capacity * 2);
 			expandStorage(capacity);
-			ctr = lookup(key);
+			ctr = lookup(key, hash);
 			assert(_storage[ctr] != nullptr);
 		}
 	}
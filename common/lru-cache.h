@@ -0,0 +1,216 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_LRU_CACHE_H
+#define COMMON_LRU_CACHE_H
+
+#include "common/hashmap.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_lru_cache LRU cache
+ * @ingroup common
+ *
+ * @brief API for a cache of the most recently used values.
+ *
+ * @{
+ */
+
+/**
+ * LRUCache<Key,Val> is a map with a limited capacity. When a value is added
+ * to a full cache, the least recently used values are removed to make room
+ * for it. Finding a value marks it as the most recently used one.
+ *
+ * The entries are kept in a doubly linked list in the order of their use,
+ * so all operations take constant time. The cache counts its hits and
+ * misses, so that callers can report how well it works.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class LRUCache : NonCopyable {
+	struct Entry {
+		Entry(const Key &k, const Val &v) : key(k), value(v), prev(nullptr), next(nullptr) {}
+
+		const Key key;
+		Val value;
+		Entry *prev, *next;
+	};
+
+	typedef HashMap<Key, Entry *, HashFunc, EqualFunc> EntryMap;
+
+	EntryMap _entries;
+	Entry *_newest, *_oldest;
+	uint _capacity;
+	uint32 _hits, _misses;
+
+	void detach(Entry *entry) {
+		if (entry->prev)
+			entry->prev->next = entry->next;
+		else
+			_newest = entry->next;
+		if (entry->next)
+			entry->next->prev = entry->prev;
+		else
+			_oldest = entry->prev;
+	}
+
+	void attachNewest(Entry *entry) {
+		entry->prev = nullptr;
+		entry->next = _newest;
+		if (_newest)
+			_newest->prev = entry;
+		else
+			_oldest = entry;
+		_newest = entry;
+	}
+
+	void shrink(uint size) {
+		while (_entries.size() > size) {
+			Entry *entry = _oldest;
+			detach(entry);
+			_entries.erase(entry->key);
+			delete entry;
+		}
+	}
+
+public:
+	/** Create a cache which holds up to @p capacity values. */
+	explicit LRUCache(uint capacity) : _newest(nullptr), _oldest(nullptr), _capacity(capacity), _hits(0), _misses(0) {
+		assert(capacity > 0);
+	}
+
+	~LRUCache() {
+		clear();
+	}
+
+	/**
+	 * Find the value of @p key and mark it as the most recently used one.
+	 *
+	 * @return The cached value, or nullptr if it is not in the cache. The
+	 *         pointer stays valid until the value is removed from the cache.
+	 */
+	Val *find(const Key &key) {
+		typename EntryMap::iterator i = _entries.find(key);
+		if (i == _entries.end()) {
+			++_misses;
+			return nullptr;
+		}
+
+		++_hits;
+		Entry *entry = i->_value;
+		if (entry != _newest) {
+			detach(entry);
+			attachNewest(entry);
+		}
+		return &entry->value;
+	}
+
+	/** Check whether @p key is in the cache, without marking it as used. */
+	bool contains(const Key &key) const {
+		return _entries.contains(key);
+	}
+
+	/**
+	 * Add a value to the cache, or replace the one which is cached for
+	 * @p key. If the cache is full, the least recently used value is removed.
+	 *
+	 * @return The cached copy of the value.
+	 */
+	Val &insert(const Key &key, const Val &value) {
+		typename EntryMap::iterator i = _entries.find(key);
+		if (i != _entries.end()) {
+			Entry *entry = i->_value;
+			entry->value = value;
+			if (entry != _newest) {
+				detach(entry);
+				attachNewest(entry);
+			}
+			return entry->value;
+		}
+
+		shrink(_capacity - 1);
+
+		Entry *entry = new Entry(key, value);
+		_entries[key] = entry;
+		attachNewest(entry);
+		return entry->value;
+	}
+
+	/** Remove the value of @p key from the cache, if it is cached. */
+	void erase(const Key &key) {
+		typename EntryMap::iterator i = _entries.find(key);
+		if (i == _entries.end())
+			return;
+
+		Entry *entry = i->_value;
+		detach(entry);
+		_entries.erase(i);
+		delete entry;
+	}
+
+	/** Return the least recently used value, or nullptr if the cache is empty. */
+	Val *getOldest() {
+		return _oldest ? &_oldest->value : nullptr;
+	}
+
+	/** Remove the least recently used value, if the cache is not empty. */
+	void eraseOldest() {
+		if (_oldest)
+			shrink(_entries.size() - 1);
+	}
+
+	/** Remove all values from the cache. The statistics are kept. */
+	void clear() {
+		shrink(0);
+	}
+
+	/** Return the number of cached values. */
+	uint size() const { return _entries.size(); }
+
+	/** Return the maximum number of cached values. */
+	uint getCapacity() const { return _capacity; }
+
+	/** Change the maximum number of cached values, removing the least recently used ones as needed. */
+	void setCapacity(uint capacity) {
+		assert(capacity > 0);
+		_capacity = capacity;
+		shrink(capacity);
+	}
+
+	/** Return the number of successful calls to find() since the last resetStatistics(). */
+	uint32 getHits() const { return _hits; }
+
+	/** Return the number of unsuccessful calls to find() since the last resetStatistics(). */
+	uint32 getMisses() const { return _misses; }
+
+	/** Reset the hit and miss counters. */
+	void resetStatistics() {
+		_hits = _misses = 0;
+	}
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -220,6 +220,12 @@ public:
 	};
 	static MacVers *parseVers(SeekableReadStream *vvers);
 
+	/**
+	 * Get the name of the AppleDouble file holding the resource fork of a file,
+	 * i.e. the file name with "._" prepended to its last path component.
+	 */
+	static String constructAppleDoubleName(String name);
+
 private:
 	SeekableReadStream *_stream;
 	String _baseFileName;
@@ -229,7 +235,6 @@ private:
 	bool loadFromRawFork(SeekableReadStream &stream);
 	bool loadFromAppleDouble(SeekableReadStream &stream);
 
-	static String constructAppleDoubleName(String name);
 	static String disassembleAppleDoubleName(String name, bool *isAppleDouble);
 
 	/**
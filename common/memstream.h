@@ -79,6 +79,12 @@ public:
 	int32 size() const { return _size; }
 
 	bool seek(int32 offs, int whence = SEEK_SET);
+
+	const byte *getDirectData(uint32 offset, uint32 len) const {
+		if (offset > _size || len > _size - offset)
+			return nullptr;
+		return _ptrOrig + offset;
+	}
 };
 
 
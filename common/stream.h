@@ -711,6 +711,21 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Get a pointer to a range of the data of the stream, for streams which
+	 * hold all their data in memory, so that it can be used without copying it.
+	 *
+	 * The data stays valid as long as the stream exists. The position
+	 * indicator of the stream is not changed.
+	 *
+	 * @param offset	Offset of the range from the start of the stream.
+	 * @param len		Length of the range in bytes.
+	 *
+	 * @return Pointer to the data, or nullptr if the stream does not support
+	 *         this or the range is out of bounds. The data must then be read().
+	 */
+	virtual const byte *getDirectData(uint32 offset, uint32 len) const { return nullptr; }
+
 	/**
 	 * Read at most one less than the number of characters specified
 	 * by @p bufSize from the stream and store them in the string buffer.
@@ -86,6 +86,12 @@ public:
 	virtual int32 size() const { return _end - _begin; }
 
 	virtual bool seek(int32 offset, int whence = SEEK_SET);
+
+	virtual const byte *getDirectData(uint32 offset, uint32 len) const {
+		if (offset > _end - _begin || len > _end - _begin - offset)
+			return nullptr;
+		return _parentStream->getDirectData(_begin + offset, len);
+	}
 };
 
 /**
@@ -106,6 +106,10 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/textconsole.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -1419,12 +1423,533 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 
 namespace Common {
 
+/**
+ * The data of a ZipArchive which its member streams need, and which lives as
+ * long as any of them: the stream of the archive itself, and a small cache of
+ * decompressed blocks. All accesses to the archive stream and the cache must
+ * hold the mutex.
+ */
+class ZipArchiveData {
+public:
+	enum {
+		/** Size of the blocks in which streamed members are decompressed. */
+		kBlockSize = 32 * 1024,
+		/** Number of blocks kept in the cache. */
+		kCacheBlocks = 32
+	};
+
+	struct Block {
+		byte data[kBlockSize];
+		uint32 size;
+	};
+
+	ZipArchiveData(SeekableReadStream *stream) : _stream(stream), _cacheClock(0) {}
+	~ZipArchiveData() { delete _stream; }
+
+	/** Find a block in the cache. Block indices are per member, identified by the offset of its data. */
+	SharedPtr<Block> findBlock(uint32 member, uint32 index) {
+		for (uint i = 0; i < _cache.size(); ++i) {
+			if (_cache[i].member == member && _cache[i].index == index) {
+				_cache[i].lastUse = ++_cacheClock;
+				return _cache[i].block;
+			}
+		}
+		return SharedPtr<Block>();
+	}
+
+	/** Add a block to the cache, replacing the least recently used one if it is full. */
+	void addBlock(uint32 member, uint32 index, const SharedPtr<Block> &block) {
+		uint slot = _cache.size();
+		if (slot >= kCacheBlocks) {
+			slot = 0;
+			for (uint i = 1; i < _cache.size(); ++i) {
+				if (_cache[i].lastUse < _cache[slot].lastUse)
+					slot = i;
+			}
+		} else {
+			_cache.push_back(CacheEntry());
+		}
+
+		_cache[slot].member = member;
+		_cache[slot].index = index;
+		_cache[slot].block = block;
+		_cache[slot].lastUse = ++_cacheClock;
+	}
+
+	SeekableReadStream *_stream;
+	Mutex _mutex;
+
+private:
+	struct CacheEntry {
+		uint32 member;
+		uint32 index;
+		SharedPtr<Block> block;
+		uint32 lastUse;
+	};
+
+	Array<CacheEntry> _cache;
+	uint32 _cacheClock;
+};
+
+typedef SharedPtr<ZipArchiveData> ZipArchiveDataPtr;
+
+/**
+ * Drop a reference to the archive data. The reference count of SharedPtr is
+ * not atomic, and member streams may be deleted on another thread, e.g. the
+ * mixer thread, so it is only changed while holding the mutex. The last
+ * reference is dropped after unlocking, since nobody else can copy it then.
+ */
+static void releaseZipArchiveData(ZipArchiveDataPtr &archive) {
+	{
+		StackLock lock(archive->_mutex);
+		if (!archive.unique()) {
+			archive.reset();
+			return;
+		}
+	}
+
+	archive.reset();
+}
+
+/**
+ * Checks the CRC of a member read by a stream, as unzCloseCurrentFile() does,
+ * for the data read in order from the start. Without zlib, there is no
+ * check.
+ */
+class ZipCrcCheck {
+	String _name;
+	uint32 _expected;
+	uint32 _crc;
+	uint32 _checked;	//!< Bytes from the start included in _crc
+
+public:
+	ZipCrcCheck(const String &name, uint32 expected) : _name(name), _expected(expected), _crc(0), _checked(0) {}
+
+	/**
+	 * Add the data read at pos to the CRC. Returns false if this completes
+	 * the member and the CRC does not match.
+	 */
+	bool update(uint32 pos, const void *data, uint32 len, uint32 size) {
+#ifdef USE_ZLIB
+		if (_checked == size || pos > _checked || pos + len <= _checked)
+			return true;
+
+		const uint32 skip = _checked - pos;
+		_crc = crc32(_crc, (const byte *)data + skip, len - skip);
+		_checked = pos + len;
+
+		if (_checked == size && _crc != _expected) {
+			warning("ZipArchive: CRC error in '%s'", _name.c_str());
+			return false;
+		}
+#endif
+		return true;
+	}
+};
+
+/**
+ * A stored member which cannot be accessed directly in memory. Each read
+ * seeks the archive stream, so that several members can be read at once.
+ */
+class ZipStoredReadStream : public SeekableReadStream {
+	ZipArchiveDataPtr _archive;
+	uint32 _begin;
+	uint32 _size;
+	uint32 _pos;
+	bool _eos;
+	bool _err;
+	ZipCrcCheck _crc;
+
+public:
+	ZipStoredReadStream(const ZipArchiveDataPtr &archive, uint32 begin, uint32 size, const ZipCrcCheck &crc)
+		: _archive(archive), _begin(begin), _size(size), _pos(0), _eos(false), _err(false), _crc(crc) {}
+
+	~ZipStoredReadStream() {
+		releaseZipArchiveData(_archive);
+	}
+
+	bool eos() const { return _eos; }
+	bool err() const { return _err; }
+	void clearErr() { _eos = false; _err = false; }
+
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		int32 newPos = offset;
+		if (whence == SEEK_CUR)
+			newPos += _pos;
+		else if (whence == SEEK_END)
+			newPos += _size;
+
+		if (newPos < 0 || newPos > (int32)_size)
+			return false;
+
+		_pos = newPos;
+		_eos = false;
+		return true;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		if (dataSize > _size - _pos) {
+			dataSize = _size - _pos;
+			_eos = true;
+		}
+
+		{
+			StackLock lock(_archive->_mutex);
+			_archive->_stream->seek(_begin + _pos, SEEK_SET);
+			dataSize = _archive->_stream->read(dataPtr, dataSize);
+			if (_archive->_stream->err())
+				_err = true;
+		}
+
+		if (!_crc.update(_pos, dataPtr, dataSize, _size))
+			_err = true;
+
+		_pos += dataSize;
+		return dataSize;
+	}
+};
+
+/**
+ * A stored member in an archive which is in memory, e.g. because its file
+ * is memory mapped. The data is used in place.
+ */
+class ZipDirectReadStream : public MemoryReadStream {
+	ZipArchiveDataPtr _archive;
+	bool _err;
+	ZipCrcCheck _crc;
+
+public:
+	ZipDirectReadStream(const ZipArchiveDataPtr &archive, const byte *data, uint32 size, const ZipCrcCheck &crc)
+		: MemoryReadStream(data, size), _archive(archive), _err(false), _crc(crc) {}
+
+	~ZipDirectReadStream() {
+		releaseZipArchiveData(_archive);
+	}
+
+	bool err() const { return _err; }
+	void clearErr() { MemoryReadStream::clearErr(); _err = false; }
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 start = pos();
+		dataSize = MemoryReadStream::read(dataPtr, dataSize);
+		if (!_crc.update(start, dataPtr, dataSize, size()))
+			_err = true;
+		return dataSize;
+	}
+};
+
+#if defined(USE_ZLIB) && ZLIB_VERNUM >= 0x1240
+
+#define ZIP_STREAM_DEFLATED_MEMBERS
+
+/**
+ * A deflated member which is decompressed on demand, one block at a time.
+ *
+ * While decompressing, the stream records checkpoints at deflate block
+ * boundaries, each with the last 32 KB of output as dictionary, so that
+ * decompression can later restart from there instead of from the start of
+ * the member. The decompressed blocks go to the cache of the archive, where
+ * other streams of the same member find them.
+ */
+class ZipInflateReadStream : public SeekableReadStream {
+	enum {
+		kWindowSize = 32 * 1024,
+		kInputSize = 16 * 1024,
+		/** Initial distance between checkpoints. */
+		kCheckpointInterval = 256 * 1024,
+		/** When there are more checkpoints, every other one is dropped. */
+		kMaxCheckpoints = 32
+	};
+
+	struct Checkpoint {
+		uint32 out;				//!< Offset in the decompressed data
+		uint32 in;				//!< Offset in the compressed data
+		int bits;				//!< Bits of the previous byte still to decompress
+		Array<byte> window;		//!< Dictionary, the output before this point
+	};
+
+	ZipArchiveDataPtr _archive;
+	uint32 _begin;
+	uint32 _compressedSize;
+	uint32 _size;
+	uint32 _pos;
+	bool _eos;
+	bool _err;
+
+	SharedPtr<ZipArchiveData::Block> _block;
+	uint32 _blockIndex;
+
+	z_stream _zStream;
+	bool _zInitialized;
+	uint32 _in;						//!< Compressed bytes fed to zlib so far
+	uint32 _out;					//!< Decompressed bytes so far
+	byte _inBuffer[kInputSize];
+	byte _window[kWindowSize];		//!< The last kWindowSize decompressed bytes, circular
+	uint32 _windowPos;
+
+	Array<Checkpoint> _checkpoints;
+	uint32 _checkpointInterval;
+
+	ZipCrcCheck _crc;
+
+public:
+	ZipInflateReadStream(const ZipArchiveDataPtr &archive, uint32 begin, uint32 compressedSize, uint32 size, const ZipCrcCheck &crc)
+		: _archive(archive), _begin(begin), _compressedSize(compressedSize), _size(size), _pos(0),
+		  _eos(false), _err(false), _blockIndex(0), _zStream(), _in(0), _out(0), _windowPos(0),
+		  _checkpointInterval(kCheckpointInterval), _crc(crc) {
+		_zInitialized = (inflateInit2(&_zStream, -MAX_WBITS) == Z_OK);
+	}
+
+	~ZipInflateReadStream() {
+		if (_zInitialized)
+			inflateEnd(&_zStream);
+
+		// The cache may share the block
+		{
+			StackLock lock(_archive->_mutex);
+			_block.reset();
+		}
+
+		releaseZipArchiveData(_archive);
+	}
+
+	bool eos() const { return _eos; }
+	bool err() const { return _err; }
+	void clearErr() { _eos = false; _err = false; }
+
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		int32 newPos = offset;
+		if (whence == SEEK_CUR)
+			newPos += _pos;
+		else if (whence == SEEK_END)
+			newPos += _size;
+
+		if (newPos < 0 || newPos > (int32)_size)
+			return false;
+
+		// Decompression happens on the next read
+		_pos = newPos;
+		_eos = false;
+		return true;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		byte *dst = (byte *)dataPtr;
+		uint32 total = 0;
+
+		while (total < dataSize && _pos < _size) {
+			const uint32 index = _pos / ZipArchiveData::kBlockSize;
+			if ((!_block || _blockIndex != index) && !loadBlock(index)) {
+				_err = true;
+				return total;
+			}
+
+			const uint32 offset = _pos % ZipArchiveData::kBlockSize;
+			const uint32 len = MIN(dataSize - total, _block->size - offset);
+			memcpy(dst + total, _block->data + offset, len);
+			if (!_crc.update(_pos, dst + total, len, _size))
+				_err = true;
+			total += len;
+			_pos += len;
+		}
+
+		if (total < dataSize)
+			_eos = true;
+
+		return total;
+	}
+
+private:
+	bool loadBlock(uint32 index) {
+		{
+			StackLock lock(_archive->_mutex);
+			_block = _archive->findBlock(_begin, index);
+			if (_block) {
+				_blockIndex = index;
+				return true;
+			}
+		}
+
+		ZipArchiveData::Block *block = new ZipArchiveData::Block();
+		const uint32 start = index * ZipArchiveData::kBlockSize;
+		block->size = MIN<uint32>(ZipArchiveData::kBlockSize, _size - start);
+		if (!decompress(start, block)) {
+			delete block;
+			return false;
+		}
+
+		StackLock lock(_archive->_mutex);
+		_block = SharedPtr<ZipArchiveData::Block>(block);
+		_blockIndex = index;
+		_archive->addBlock(_begin, index, _block);
+		return true;
+	}
+
+	/** Decompress block->size bytes starting at start into the block. */
+	bool decompress(uint32 start, ZipArchiveData::Block *block) {
+		if (!_zInitialized)
+			return false;
+
+		// Go back to the last checkpoint before the block, unless the
+		// decompression is already closer
+		const Checkpoint *checkpoint = nullptr;
+		for (uint i = 0; i < _checkpoints.size() && _checkpoints[i].out <= start; ++i)
+			checkpoint = &_checkpoints[i];
+
+		if (_out > start || (checkpoint && checkpoint->out > _out)) {
+			if (!restart(checkpoint))
+				return false;
+		}
+
+		const uint32 end = start + block->size;
+		while (_out < end) {
+			if (_zStream.avail_in == 0 && !fillInput())
+				return false;
+
+			if (_windowPos == kWindowSize)
+				_windowPos = 0;
+
+			// Never decompress past the block, so that the window stays
+			// in sync with _out
+			const uint32 avail = MIN<uint32>(kWindowSize - _windowPos, end - _out);
+			_zStream.next_out = _window + _windowPos;
+			_zStream.avail_out = avail;
+
+			const int ret = inflate(&_zStream, Z_BLOCK);
+			if (ret != Z_OK && ret != Z_STREAM_END)
+				return false;
+
+			const uint32 produced = avail - _zStream.avail_out;
+			if (_out + produced > start) {
+				const uint32 skip = (_out < start) ? start - _out : 0;
+				memcpy(block->data + _out + skip - start, _window + _windowPos + skip, produced - skip);
+			}
+			_out += produced;
+			_windowPos += produced;
+
+			if (ret == Z_STREAM_END) {
+				if (_out < end)
+					return false;
+				break;
+			}
+
+			// Bit 7 of data_type is set at the end of a deflate block, bit 6
+			// if it is the last one
+			if ((_zStream.data_type & 128) && !(_zStream.data_type & 64))
+				addCheckpoint();
+		}
+
+		return true;
+	}
+
+	bool fillInput() {
+		const uint32 len = MIN<uint32>(kInputSize, _compressedSize - _in);
+		if (len == 0)
+			return false;
+
+		StackLock lock(_archive->_mutex);
+		const byte *direct = _archive->_stream->getDirectData(_begin + _in, len);
+		if (direct) {
+			_zStream.next_in = const_cast<byte *>(direct);
+		} else {
+			_archive->_stream->seek(_begin + _in, SEEK_SET);
+			if (_archive->_stream->read(_inBuffer, len) != len)
+				return false;
+			_zStream.next_in = _inBuffer;
+		}
+
+		_zStream.avail_in = len;
+		_in += len;
+		return true;
+	}
+
+	void addCheckpoint() {
+		const uint32 last = _checkpoints.empty() ? 0 : _checkpoints.back().out;
+		if (_out < last + _checkpointInterval)
+			return;
+
+		if (_checkpoints.size() >= kMaxCheckpoints) {
+			for (uint i = 0; i < _checkpoints.size() / 2; ++i)
+				_checkpoints[i] = _checkpoints[i * 2 + 1];
+			_checkpoints.resize(_checkpoints.size() / 2);
+			_checkpointInterval *= 2;
+		}
+
+		_checkpoints.push_back(Checkpoint());
+		Checkpoint &checkpoint = _checkpoints.back();
+		checkpoint.out = _out;
+		checkpoint.in = _in - _zStream.avail_in;
+		checkpoint.bits = _zStream.data_type & 7;
+
+		// Store the window in order
+		if (_out >= kWindowSize) {
+			checkpoint.window.resize(kWindowSize);
+			const uint32 pos = _windowPos % kWindowSize;
+			memcpy(checkpoint.window.begin(), _window + pos, kWindowSize - pos);
+			memcpy(checkpoint.window.begin() + kWindowSize - pos, _window, pos);
+		} else {
+			checkpoint.window.resize(_out);
+			memcpy(checkpoint.window.begin(), _window, _out);
+		}
+	}
+
+	/** Restart the decompression at a checkpoint, or at the start if there is none. */
+	bool restart(const Checkpoint *checkpoint) {
+		if (inflateReset(&_zStream) != Z_OK)
+			return false;
+
+		_zStream.avail_in = 0;
+		_in = 0;
+		_out = 0;
+		_windowPos = 0;
+
+		if (!checkpoint)
+			return true;
+
+		_in = checkpoint->in;
+		if (checkpoint->bits) {
+			// The checkpoint is in the middle of the previous byte
+			_in--;
+			if (!fillInput())
+				return false;
+
+			const int value = *_zStream.next_in >> (8 - checkpoint->bits);
+			_zStream.next_in++;
+			_zStream.avail_in--;
+			if (inflatePrime(&_zStream, checkpoint->bits, value) != Z_OK)
+				return false;
+		}
+
+		const uint32 windowSize = checkpoint->window.size();
+		if (inflateSetDictionary(&_zStream, checkpoint->window.begin(), windowSize) != Z_OK)
+			return false;
+
+		memcpy(_window, checkpoint->window.begin(), windowSize);
+		_windowPos = windowSize;
+		_out = checkpoint->out;
+		return true;
+	}
+};
+
+#endif
 
 class ZipArchive : public Archive {
 	unzFile _zipFile;
+	ZipArchiveDataPtr _data;
+
+	enum {
+		/** Smaller deflated members are decompressed at once when opened. */
+		kMinStreamedSize = 256 * 1024
+	};
 
 public:
-	ZipArchive(unzFile zipFile);
+	ZipArchive(unzFile zipFile, const ZipArchiveDataPtr &data);
 
 
 	~ZipArchive();
@@ -1433,6 +1958,7 @@ public:
 	virtual int listMembers(ArchiveMemberList &list) const;
 	virtual const ArchiveMemberPtr getMember(const String &name) const;
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
+	virtual bool getMemberNames(StringArray &names) const;
 };
 
 /*
@@ -1453,16 +1979,28 @@ public:
 };
 */
 
-ZipArchive::ZipArchive(unzFile zipFile) : _zipFile(zipFile) {
+ZipArchive::ZipArchive(unzFile zipFile, const ZipArchiveDataPtr &data) : _zipFile(zipFile), _data(data) {
 	assert(_zipFile);
 }
 
 ZipArchive::~ZipArchive() {
 	unzClose(_zipFile);
+	releaseZipArchiveData(_data);
 }
 
 bool ZipArchive::hasFile(const String &name) const {
-	return (unzLocateFile(_zipFile, name.c_str(), 2) == UNZ_OK);
+	// Unlike unzLocateFile, this does not change the current file
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	return archive->_hash.contains(name);
+}
+
+bool ZipArchive::getMemberNames(StringArray &names) const {
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	for (ZipHash::const_iterator i = archive->_hash.begin(), end = archive->_hash.end();
+	     i != end; ++i)
+		names.push_back(i->_key);
+
+	return true;
 }
 
 int ZipArchive::listMembers(ArchiveMemberList &list) const {
@@ -1486,6 +2024,9 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 }
 
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
+	// The unz state and the archive stream are shared with the member streams
+	StackLock lock(_data->_mutex);
+
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return nullptr;
 
@@ -1493,8 +2034,33 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
 		return nullptr;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, nullptr, 0, nullptr, 0, nullptr, 0) != UNZ_OK)
+	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, nullptr, 0, nullptr, 0, nullptr, 0) != UNZ_OK) {
+		unzCloseCurrentFile(_zipFile);
 		return nullptr;
+	}
+
+	const file_in_zip_read_info_s *const member = ((const unz_s *)_zipFile)->pfile_in_zip_read;
+	const uint32 begin = member->pos_in_zipfile + member->byte_before_the_zipfile;
+	const ZipCrcCheck crc(name, fileInfo.crc);
+
+	// Stored members are read in place
+	if (fileInfo.compression_method == 0) {
+		unzCloseCurrentFile(_zipFile);
+
+		const byte *data = _data->_stream->getDirectData(begin, fileInfo.uncompressed_size);
+		if (data)
+			return new ZipDirectReadStream(_data, data, fileInfo.uncompressed_size, crc);
+
+		return new ZipStoredReadStream(_data, begin, fileInfo.uncompressed_size, crc);
+	}
+
+#ifdef ZIP_STREAM_DEFLATED_MEMBERS
+	// Large deflated members are decompressed on demand
+	if (fileInfo.uncompressed_size >= kMinStreamedSize) {
+		unzCloseCurrentFile(_zipFile);
+		return new ZipInflateReadStream(_data, begin, fileInfo.compressed_size, fileInfo.uncompressed_size, crc);
+	}
+#endif
 
 	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
 	assert(buffer);
@@ -1510,11 +2076,6 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	}
 
 	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
-
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
 }
 
 Archive *makeZipArchive(const String &name) {
@@ -1528,13 +2089,18 @@ Archive *makeZipArchive(const FSNode &node) {
 Archive *makeZipArchive(SeekableReadStream *stream) {
 	if (!stream)
 		return nullptr;
-	unzFile zipFile = unzOpen(stream);
+
+	// The unz functions get their own view of the stream, so that they
+	// cannot get in the way of the member streams, which share the stream
+	// and always seek before reading.
+	ZipArchiveDataPtr data(new ZipArchiveData(stream));
+	unzFile zipFile = unzOpen(new SeekableSubReadStream(stream, 0, stream->size(), DisposeAfterUse::NO));
 	if (!zipFile) {
-		// stream gets deleted by unzOpen() call if something
-		// goes wrong.
+		// the view gets deleted by unzOpen() call if something
+		// goes wrong, and the stream along with data.
 		return nullptr;
 	}
-	return new ZipArchive(zipFile);
+	return new ZipArchive(zipFile, data);
 }
 
 } // End of namespace Common
@@ -33,6 +33,7 @@
 #include "gui/gui-manager.h"
 #include "gui/message.h"
 #include "engines/advancedDetector.h"
+#include "engines/md5cache.h"
 #include "engines/obsolete.h"
 
 /**
@@ -360,6 +361,8 @@ Common::Error AdvancedMetaEngineDetection::createInstance(OSystem *syst, Engine
 		}
 	}
 
+	MD5Cache::instance().flush();
+
 	if (!agdDesc.desc)
 		return Common::kNoGameDataFoundError;
 
@@ -445,6 +448,73 @@ void AdvancedMetaEngineDetection::composeFileHashMap(FileMap &allFiles, const Co
 	}
 }
 
+/**
+ * Compute the checksum of the resource fork of a file, looking it up in the
+ * MD5 cache first. The cache entry is stamped with every file the fork might
+ * be read from.
+ */
+static bool getResForkProperties(FileMapArchive &archive, const Common::String &fname, uint md5Bytes, FileProperties &fileProps) {
+	const Common::String candidates[] = {
+		fname, fname + ".rsrc", Common::MacResManager::constructAppleDoubleName(fname), fname + ".bin"
+	};
+
+	Common::String cacheKey;
+	Common::String cacheStamp;
+	bool cacheable = true;
+	for (int i = 0; i < ARRAYSIZE(candidates) && cacheable; ++i) {
+		const Common::ArchiveMemberPtr member = archive.getMember(candidates[i]);
+		const Common::FSNode *node = dynamic_cast<const Common::FSNode *>(member.get());
+		if (!node) {
+			cacheStamp += "-;";
+			continue;
+		}
+
+		if (cacheKey.empty())
+			cacheKey = MD5Cache::makeKey(node->getPath(), md5Bytes, true);
+		cacheable = MD5Cache::addToStamp(*node, cacheStamp);
+	}
+	cacheable = cacheable && !cacheKey.empty();
+
+	if (cacheable && MD5Cache::instance().lookup(cacheKey, cacheStamp, fileProps.md5, fileProps.size))
+		return true;
+
+	Common::MacResManager macResMan;
+
+	if (!macResMan.open(fname, archive))
+		return false;
+
+	fileProps.md5 = macResMan.computeResForkMD5AsString(md5Bytes);
+	fileProps.size = macResMan.getResForkDataSize();
+
+	if (cacheable)
+		MD5Cache::instance().store(cacheKey, cacheStamp, fileProps.md5, fileProps.size);
+	return true;
+}
+
+/**
+ * Compute the checksum of a plain file, looking it up in the MD5 cache first.
+ */
+static bool getPlainFileProperties(const Common::FSNode &node, uint md5Bytes, FileProperties &fileProps) {
+	const Common::String cacheKey = MD5Cache::makeKey(node.getPath(), md5Bytes, false);
+	Common::String cacheStamp;
+	const bool cacheable = MD5Cache::addToStamp(node, cacheStamp);
+
+	if (cacheable && MD5Cache::instance().lookup(cacheKey, cacheStamp, fileProps.md5, fileProps.size))
+		return true;
+
+	Common::File testFile;
+
+	if (!testFile.open(node))
+		return false;
+
+	fileProps.size = (int32)testFile.size();
+	fileProps.md5 = Common::computeStreamMD5AsString(testFile, md5Bytes);
+
+	if (cacheable)
+		MD5Cache::instance().store(cacheKey, cacheStamp, fileProps.md5, fileProps.size);
+	return true;
+}
+
 bool AdvancedMetaEngineDetection::getFileProperties(const FileMap &allFiles, const ADGameDescription &game, const Common::String fname, FileProperties &fileProps) const {
 	// FIXME/TODO: We don't handle the case that a file is listed as a regular
 	// file and as one with resource fork.
@@ -452,14 +522,9 @@ bool AdvancedMetaEngineDetection::getFileProperties(const FileMap &allFiles, con
 	if (game.flags & ADGF_MACRESFORK) {
 		FileMapArchive fileMapArchive(allFiles);
 
-		Common::MacResManager macResMan;
-
-		if (!macResMan.open(fname, fileMapArchive))
+		if (!getResForkProperties(fileMapArchive, fname, _md5Bytes, fileProps))
 			return false;
 
-		fileProps.md5 = macResMan.computeResForkMD5AsString(_md5Bytes);
-		fileProps.size = macResMan.getResForkDataSize();
-
 		if (fileProps.size != 0)
 			return true;
 	}
@@ -467,14 +532,7 @@ bool AdvancedMetaEngineDetection::getFileProperties(const FileMap &allFiles, con
 	if (!allFiles.contains(fname))
 		return false;
 
-	Common::File testFile;
-
-	if (!testFile.open(allFiles[fname]))
-		return false;
-
-	fileProps.size = (int32)testFile.size();
-	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
-	return true;
+	return getPlainFileProperties(allFiles[fname], _md5Bytes, fileProps);
 }
 
 bool AdvancedMetaEngine::getFilePropertiesExtern(uint md5Bytes, const FileMap &allFiles, const ADGameDescription &game, const Common::String fname, FileProperties &fileProps) const {
@@ -484,14 +542,9 @@ bool AdvancedMetaEngine::getFilePropertiesExtern(uint md5Bytes, const FileMap &a
 	if (game.flags & ADGF_MACRESFORK) {
 		FileMapArchive fileMapArchive(allFiles);
 
-		Common::MacResManager macResMan;
-
-		if (!macResMan.open(fname, fileMapArchive))
+		if (!getResForkProperties(fileMapArchive, fname, md5Bytes, fileProps))
 			return false;
 
-		fileProps.md5 = macResMan.computeResForkMD5AsString(md5Bytes);
-		fileProps.size = macResMan.getResForkDataSize();
-
 		if (fileProps.size != 0)
 			return true;
 	}
@@ -499,14 +552,7 @@ bool AdvancedMetaEngine::getFilePropertiesExtern(uint md5Bytes, const FileMap &a
 	if (!allFiles.contains(fname))
 		return false;
 
-	Common::File testFile;
-
-	if (!testFile.open(allFiles[fname]))
-		return false;
-
-	fileProps.size = (int32)testFile.size();
-	fileProps.md5 = Common::computeStreamMD5AsString(testFile, md5Bytes);
-	return true;
+	return getPlainFileProperties(allFiles[fname], md5Bytes, fileProps);
 }
 
 ADDetectedGames AdvancedMetaEngineDetection::detectGame(const Common::FSNode &parent, const FileMap &allFiles, Common::Language language, Common::Platform platform, const Common::String &extra) const {
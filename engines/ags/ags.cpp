@@ -53,6 +53,7 @@
 #include "ags/engine/main/main.h"
 #include "ags/engine/platform/base/agsplatformdriver.h"
 #include "ags/engine/script/script.h"
+#include "ags/shared/script/cc_options.h"
 #include "ags/engine/ac/route_finder.h"
 #include "ags/shared/core/assetmanager.h"
 #include "ags/shared/util/directory.h"
@@ -366,6 +367,11 @@ Common::Error AGSEngine::run() {
 
 	_G(loadSaveGameOnStartup) = ConfMan.getInt("save_slot");
 
+	// The pre-decoded code is faster, but the scripts are run by the
+	// reference interpreter unless it is enabled
+	if (ConfMan.hasKey("predecode_scripts") && ConfMan.getBool("predecode_scripts"))
+		AGS3::ccSetOption(SCOPT_PREDECODE, 1);
+
 #ifdef USE_CUSTOM_EXCEPTION_HANDLER
 	if (_GP(usetup).disable_exception_handling)
 #endif
@@ -113,7 +113,7 @@ public:
 
 private:
 	bool TryAddItem(const char *item, size_t len) {
-		return _set.insert(String(item, len))._value;
+		return _set.insert(String(item, len)).second;
 	}
 	void DeleteItem(ConstIterator it) {
 		/* do nothing */
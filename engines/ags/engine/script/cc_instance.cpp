@@ -237,6 +237,8 @@ ccInstance::ccInstance() {
 	numimports = 0;
 	resolved_imports = nullptr;
 	code_fixups         = nullptr;
+	code_ops            = nullptr;
+	code_op_index       = nullptr;
 
 	memset(callStackLineNumber, 0, sizeof(callStackLineNumber));
 	memset(callStackAddr, 0, sizeof(callStackAddr));
@@ -426,7 +428,11 @@ int ccInstance::Run(int32_t curpc) {
 	current_instance = this;
 	ccInstance *codeInst = runningInst;
 	int write_debug_dump = ccGetOption(SCOPT_DEBUGRUN);
+	const bool use_decoded = ccGetOption(SCOPT_PREDECODE) != 0;
 	ScriptOperation codeOp;
+	ScriptOperation *op;
+	RuntimeScriptValue *reg1_ptr;
+	RuntimeScriptValue *reg2_ptr;
 
 	FunctionCallStack func_callstack;
 
@@ -434,101 +440,130 @@ int ccInstance::Run(int32_t curpc) {
 		if (_G(abort_engine))
 			return -1;
 
-		/*
-		if (!codeInst->ReadOperation(codeOp, pc))
-		{
-		    return -1;
-		}
-		*/
-		/* ReadOperation */
-		//=====================================================================
-		codeOp.Instruction.Code         = codeInst->code[pc];
-		codeOp.Instruction.InstanceId   = (codeOp.Instruction.Code >> INSTANCE_ID_SHIFT) & INSTANCE_ID_MASK;
-		codeOp.Instruction.Code        &= INSTANCE_ID_REMOVEMASK; // now this is pure instruction code
-
-		if (codeOp.Instruction.Code < 0 || codeOp.Instruction.Code >= CC_NUM_SCCMDS) {
-			cc_error("invalid instruction %d found in code stream", codeOp.Instruction.Code);
-			return -1;
-		}
+		const int32_t op_index = (use_decoded && codeInst->code_op_index) ? codeInst->code_op_index[pc] : -1;
+		if (op_index >= 0) {
+			ScriptDecodedOperation &decoded = codeInst->code_ops[op_index];
+			op = &decoded.Op;
+			if (decoded.HasRuntimeFixups) {
+				codeOp = decoded.Op;
+				op = &codeOp;
+				for (int i = 0; i < codeOp.ArgCount; ++i) {
+					const intptr_t code_value = codeInst->code[pc + 1 + i];
+					if (decoded.RuntimeFixups[i] == FIXUP_IMPORT) {
+						const ScriptImport *import = _GP(simp).getByIndex((int32_t)code_value);
+						if (!import) {
+							cc_error("cannot resolve import, key = %ld", code_value);
+							return -1;
+						}
+						codeOp.Args[i] = import->Value;
+					} else if (decoded.RuntimeFixups[i] == FIXUP_STACK) {
+						codeOp.Args[i] = GetStackPtrOffsetFw((int32_t)code_value);
+					}
+				}
+				reg1_ptr = &registers[codeOp.Args[0].IValue >= 0 && codeOp.Args[0].IValue < CC_NUM_REGISTERS ? codeOp.Args[0].IValue : 0];
+				reg2_ptr = &registers[codeOp.Args[1].IValue >= 0 && codeOp.Args[1].IValue < CC_NUM_REGISTERS ? codeOp.Args[1].IValue : 0];
+			} else {
+				reg1_ptr = &registers[decoded.Reg1];
+				reg2_ptr = &registers[decoded.Reg2];
+			}
+		} else {
+			op = &codeOp;
+			/*
+			if (!codeInst->ReadOperation(codeOp, pc))
+			{
+			    return -1;
+			}
+			*/
+			/* ReadOperation */
+			//=====================================================================
+			codeOp.Instruction.Code         = codeInst->code[pc];
+			codeOp.Instruction.InstanceId   = (codeOp.Instruction.Code >> INSTANCE_ID_SHIFT) & INSTANCE_ID_MASK;
+			codeOp.Instruction.Code        &= INSTANCE_ID_REMOVEMASK; // now this is pure instruction code
+
+			if (codeOp.Instruction.Code < 0 || codeOp.Instruction.Code >= CC_NUM_SCCMDS) {
+				cc_error("invalid instruction %d found in code stream", codeOp.Instruction.Code);
+				return -1;
+			}
 
-		codeOp.ArgCount = sccmd_info[codeOp.Instruction.Code].ArgCount;
-		if (pc + codeOp.ArgCount >= codeInst->codesize) {
-			cc_error("unexpected end of code data (%d; %d)", pc + codeOp.ArgCount, codeInst->codesize);
-			return -1;
-		}
+			codeOp.ArgCount = sccmd_info[codeOp.Instruction.Code].ArgCount;
+			if (pc + codeOp.ArgCount >= codeInst->codesize) {
+				cc_error("unexpected end of code data (%d; %d)", pc + codeOp.ArgCount, codeInst->codesize);
+				return -1;
+			}
 
-		int pc_at = pc + 1;
-		for (int i = 0; i < codeOp.ArgCount; ++i, ++pc_at) {
-			char fixup = codeInst->code_fixups[pc_at];
-			if (fixup > 0) {
-				// could be relative pointer or import address
-				/*
-				if (!FixupArgument(code[pc], fixup, codeOp.Args[i]))
-				{
-				    return -1;
-				}
-				*/
-				/* FixupArgument */
-				//=====================================================================
-				switch (fixup) {
-				case FIXUP_GLOBALDATA: {
-					ScriptVariable *gl_var = (ScriptVariable *)codeInst->code[pc_at];
-					codeOp.Args[i].SetGlobalVar(&gl_var->RValue);
-				}
-				break;
-				case FIXUP_FUNCTION:
-					// originally commented -- CHECKME: could this be used in very old versions of AGS?
-					//      code[fixup] += (long)&code[0];
-					// This is a program counter value, presumably will be used as SCMD_CALL argument
-					codeOp.Args[i].SetInt32((int32_t)codeInst->code[pc_at]);
+			int pc_at = pc + 1;
+			for (int i = 0; i < codeOp.ArgCount; ++i, ++pc_at) {
+				char fixup = codeInst->code_fixups[pc_at];
+				if (fixup > 0) {
+					// could be relative pointer or import address
+					/*
+					if (!FixupArgument(code[pc], fixup, codeOp.Args[i]))
+					{
+					    return -1;
+					}
+					*/
+					/* FixupArgument */
+					//=====================================================================
+					switch (fixup) {
+					case FIXUP_GLOBALDATA: {
+						ScriptVariable *gl_var = (ScriptVariable *)codeInst->code[pc_at];
+						codeOp.Args[i].SetGlobalVar(&gl_var->RValue);
+					}
 					break;
-				case FIXUP_STRING:
-					codeOp.Args[i].SetStringLiteral(&codeInst->strings[0] + codeInst->code[pc_at]);
+					case FIXUP_FUNCTION:
+						// originally commented -- CHECKME: could this be used in very old versions of AGS?
+						//      code[fixup] += (long)&code[0];
+						// This is a program counter value, presumably will be used as SCMD_CALL argument
+						codeOp.Args[i].SetInt32((int32_t)codeInst->code[pc_at]);
+						break;
+					case FIXUP_STRING:
+						codeOp.Args[i].SetStringLiteral(&codeInst->strings[0] + codeInst->code[pc_at]);
+						break;
+					case FIXUP_IMPORT: {
+						const ScriptImport *import = _GP(simp).getByIndex((int32_t)codeInst->code[pc_at]);
+						if (import) {
+							codeOp.Args[i] = import->Value;
+						} else {
+							cc_error("cannot resolve import, key = %ld", codeInst->code[pc_at]);
+							return -1;
+						}
+					}
 					break;
-				case FIXUP_IMPORT: {
-					const ScriptImport *import = _GP(simp).getByIndex((int32_t)codeInst->code[pc_at]);
-					if (import) {
-						codeOp.Args[i] = import->Value;
-					} else {
-						cc_error("cannot resolve import, key = %ld", codeInst->code[pc_at]);
+					case FIXUP_STACK:
+						codeOp.Args[i] = GetStackPtrOffsetFw((int32_t)codeInst->code[pc_at]);
+						break;
+					default:
+						cc_error("internal fixup type error: %d", fixup);
 						return -1;
 					}
+					/* End FixupArgument */
+					//=====================================================================
+				} else {
+					// should be a numeric literal (int32 or float)
+					codeOp.Args[i].SetInt32((int32_t)codeInst->code[pc_at]);
 				}
-				break;
-				case FIXUP_STACK:
-					codeOp.Args[i] = GetStackPtrOffsetFw((int32_t)codeInst->code[pc_at]);
-					break;
-				default:
-					cc_error("internal fixup type error: %d", fixup);
-					return -1;
-				}
-				/* End FixupArgument */
-				//=====================================================================
-			} else {
-				// should be a numeric literal (int32 or float)
-				codeOp.Args[i].SetInt32((int32_t)codeInst->code[pc_at]);
 			}
+			/* End ReadOperation */
+			//=====================================================================
+			reg1_ptr = &registers[codeOp.Args[0].IValue >= 0 && codeOp.Args[0].IValue < CC_NUM_REGISTERS ? codeOp.Args[0].IValue : 0];
+			reg2_ptr = &registers[codeOp.Args[1].IValue >= 0 && codeOp.Args[1].IValue < CC_NUM_REGISTERS ? codeOp.Args[1].IValue : 0];
 		}
-		/* End ReadOperation */
-		//=====================================================================
 
 		// save the arguments for quick access
-		RuntimeScriptValue &arg1 = codeOp.Args[0];
-		RuntimeScriptValue &arg2 = codeOp.Args[1];
-		RuntimeScriptValue &arg3 = codeOp.Args[2];
-		RuntimeScriptValue &reg1 =
-		    registers[arg1.IValue >= 0 && arg1.IValue < CC_NUM_REGISTERS ? arg1.IValue : 0];
-		RuntimeScriptValue &reg2 =
-		    registers[arg2.IValue >= 0 && arg2.IValue < CC_NUM_REGISTERS ? arg2.IValue : 0];
+		RuntimeScriptValue &arg1 = op->Args[0];
+		RuntimeScriptValue &arg2 = op->Args[1];
+		RuntimeScriptValue &arg3 = op->Args[2];
+		RuntimeScriptValue &reg1 = *reg1_ptr;
+		RuntimeScriptValue &reg2 = *reg2_ptr;
 
 		const char *direct_ptr1;
 		const char *direct_ptr2;
 
 		if (write_debug_dump) {
-			DumpInstruction(codeOp);
+			DumpInstruction(*op);
 		}
 
-		switch (codeOp.Instruction.Code) {
+		switch (op->Instruction.Code) {
 		case SCMD_LINENUM:
 			line_number = arg1.IValue;
 			_G(currentline) = arg1.IValue;
@@ -707,7 +742,7 @@ int ccInstance::Run(int32_t curpc) {
 			PUSH_CALL_STACK;
 
 			ASSERT_STACK_SPACE_AVAILABLE(1);
-			PushValueToStack(RuntimeScriptValue().SetInt32(pc + codeOp.ArgCount + 1));
+			PushValueToStack(RuntimeScriptValue().SetInt32(pc + op->ArgCount + 1));
 			if (_G(ccError)) {
 				return -1;
 			}
@@ -948,7 +983,7 @@ int ccInstance::Run(int32_t curpc) {
 			ccInstance *wasRunning = runningInst;
 
 			// extract the instance ID
-			int32_t instId = codeOp.Instruction.InstanceId;
+			int32_t instId = op->Instruction.InstanceId;
 			// determine the offset into the code of the instance we want
 			runningInst = loadedInstances[instId];
 			intptr_t callAddr = reg1.Ptr - (char *)&runningInst->code[0];
@@ -1203,14 +1238,14 @@ int ccInstance::Run(int32_t curpc) {
 				loopIterationCheckDisabled++;
 			break;
 		default:
-			cc_error("instruction %d is not implemented", codeOp.Instruction.Code);
+			cc_error("instruction %d is not implemented", op->Instruction.Code);
 			return -1;
 		}
 
 		if (flags & INSTF_ABORTED)
 			return 0;
 
-		pc += codeOp.ArgCount + 1;
+		pc += op->ArgCount + 1;
 	}
 }
 
@@ -1357,6 +1392,8 @@ bool ccInstance::_Create(PScript scri, ccInstance *joined) {
 	if (joined) {
 		resolved_imports = joined->resolved_imports;
 		code_fixups = joined->code_fixups;
+		code_ops = joined->code_ops;
+		code_op_index = joined->code_op_index;
 	} else {
 		if (!ResolveScriptImports(scri)) {
 			return false;
@@ -1367,6 +1404,9 @@ bool ccInstance::_Create(PScript scri, ccInstance *joined) {
 		if (!CreateRuntimeCodeFixups(scri)) {
 			return false;
 		}
+		if (ccGetOption(SCOPT_PREDECODE) && !CreateDecodedCode()) {
+			return false;
+		}
 	}
 
 	exports = new RuntimeScriptValue[scri->numexports];
@@ -1442,9 +1482,13 @@ void ccInstance::Free() {
 	if ((flags & INSTF_SHAREDATA) == 0) {
 		delete [] resolved_imports;
 		delete [] code_fixups;
+		delete [] code_ops;
+		delete [] code_op_index;
 	}
 	resolved_imports = nullptr;
 	code_fixups = nullptr;
+	code_ops = nullptr;
+	code_op_index = nullptr;
 }
 
 bool ccInstance::ResolveScriptImports(PScript scri) {
@@ -1615,6 +1659,69 @@ bool ccInstance::CreateRuntimeCodeFixups(PScript scri) {
 	return true;
 }
 
+bool ccInstance::CreateDecodedCode() {
+	if (codesize <= 0)
+		return true;
+
+	// The code is a sequence of instructions, so they are decoded from the
+	// start. If anything else is met, the following instructions are left
+	// to be decoded when run.
+	int32_t num_ops = 0;
+	int32_t end_pc = 0;
+	while (end_pc < codesize) {
+		int32_t op_code = code[end_pc] & INSTANCE_ID_REMOVEMASK;
+		if (op_code <= 0 || op_code >= CC_NUM_SCCMDS || end_pc + sccmd_info[op_code].ArgCount >= codesize)
+			break;
+		end_pc += sccmd_info[op_code].ArgCount + 1;
+		num_ops++;
+	}
+
+	code_ops = new ScriptDecodedOperation[num_ops];
+	code_op_index = new int32_t[codesize];
+	memset(code_op_index, 0xFF, codesize * sizeof(int32_t));
+
+	for (int32_t op_pc = 0, i = 0; op_pc < end_pc; ++i) {
+		ScriptDecodedOperation &decoded = code_ops[i];
+		ScriptOperation &op = decoded.Op;
+		op.Instruction.Code       = code[op_pc];
+		op.Instruction.InstanceId = (op.Instruction.Code >> INSTANCE_ID_SHIFT) & INSTANCE_ID_MASK;
+		op.Instruction.Code      &= INSTANCE_ID_REMOVEMASK;
+		op.ArgCount = sccmd_info[op.Instruction.Code].ArgCount;
+		code_op_index[op_pc] = i;
+
+		int32_t pc_at = op_pc + 1;
+		for (int arg = 0; arg < op.ArgCount; ++arg, ++pc_at) {
+			switch (code_fixups[pc_at]) {
+			case FIXUP_GLOBALDATA:
+				op.Args[arg].SetGlobalVar(&((ScriptVariable *)code[pc_at])->RValue);
+				break;
+			case FIXUP_STRING:
+				op.Args[arg].SetStringLiteral(&strings[0] + code[pc_at]);
+				break;
+			case FIXUP_IMPORT:
+			case FIXUP_STACK:
+				decoded.RuntimeFixups[arg] = code_fixups[pc_at];
+				decoded.HasRuntimeFixups = true;
+				break;
+			case FIXUP_FUNCTION:	// program counter value, used as SCMD_CALL argument
+			case 0:					// no fixup, numeric literal (int32 or float)
+				op.Args[arg].SetInt32((int32_t)code[pc_at]);
+				break;
+			default:
+				cc_error("internal fixup type error: %d", code_fixups[pc_at]);
+				return false;
+			}
+		}
+
+		const int32_t reg1 = op.Args[0].IValue;
+		const int32_t reg2 = op.Args[1].IValue;
+		decoded.Reg1 = reg1 >= 0 && reg1 < CC_NUM_REGISTERS ? reg1 : 0;
+		decoded.Reg2 = reg2 >= 0 && reg2 < CC_NUM_REGISTERS ? reg2 : 0;
+		op_pc = pc_at;
+	}
+	return true;
+}
+
 /*
 bool ccInstance::ReadOperation(ScriptOperation &op, int32_t at_pc)
 {
@@ -78,6 +78,21 @@ struct ScriptOperation {
 	int                 ArgCount;
 };
 
+// Operation of the pre-decoded code. The arguments which depend on the state
+// of execution (imports and stack offsets) are resolved when it is run.
+struct ScriptDecodedOperation {
+	ScriptDecodedOperation() {
+		memset(RuntimeFixups, 0, sizeof(RuntimeFixups));
+		HasRuntimeFixups = false;
+		Reg1 = Reg2 = 0;
+	}
+
+	ScriptOperation     Op;
+	char                RuntimeFixups[MAX_SCMD_ARGS]; // fixup type of the unresolved arguments
+	bool                HasRuntimeFixups;
+	int                 Reg1, Reg2; // registers selected by the first two arguments
+};
+
 struct ScriptVariable {
 	ScriptVariable() {
 		ScAddress = -1; // address = 0 is valid one, -1 means undefined
@@ -149,6 +164,11 @@ public:
 	int  numimports;
 
 	char *code_fixups;
+	// Pre-decoded code, which is shared by forked instances like the fixups;
+	// code_op_index holds the operation index for each pc, or -1 if the
+	// instruction at pc has to be decoded when run
+	ScriptDecodedOperation *code_ops;
+	int32_t *code_op_index;
 
 	// returns the currently executing instance, or NULL if none
 	static ccInstance *GetCurrentInstance(void);
@@ -191,6 +211,8 @@ protected:
 	bool    AddGlobalVar(const ScriptVariable &glvar);
 	ScriptVariable *FindGlobalVar(int32_t var_addr);
 	bool    CreateRuntimeCodeFixups(PScript scri);
+	// Decodes the operations and the arguments which don't change at runtime
+	bool    CreateDecodedCode();
 	//bool    ReadOperation(ScriptOperation &op, int32_t at_pc);
 
 	// Runtime fixups
@@ -25,6 +25,7 @@
 
 #include "common/hashmap.h"
 #include "ags/lib/std/utility.h"
+#include "ags/lib/std/xtree.h"
 
 namespace AGS3 {
 namespace std {
@@ -35,12 +36,17 @@ class map {
 		Key _key;
 		Val _value;
 	};
+	struct KeyOf {
+		const Key &operator()(const KeyValue &item) const {
+			return item._key;
+		}
+	};
+	typedef Tree<KeyValue, Key, KeyOf, CompFunc> ItemTree;
 private:
-	Common::Array<KeyValue> _items;
-	CompFunc _comp;
+	ItemTree _items;
 public:
-	using iterator = typename Common::Array<KeyValue>::iterator;
-	using const_iterator = typename Common::Array<KeyValue>::const_iterator;
+	using iterator = typename ItemTree::iterator;
+	using const_iterator = typename ItemTree::const_iterator;
 
 	/**
 	 * Clears the map
@@ -82,93 +88,68 @@ public:
 	 * not less than the given key
 	 */
 	const_iterator lower_bound(const Key &theKey) const {
-		const_iterator first = this->begin();
-		const_iterator it;
-		int count_ = _items.size(), step;
-
-		while (count_ > 0) {
-			it = first;
-			step = count_ / 2;
-			it += step;
-
-			if (_comp(it->_key, theKey)) {
-				first = ++it;
-				count_ -= step + 1;
-			} else {
-				count_ = step;
-			}
-		}
-
-		return first;
+		return _items.lower_bound(theKey);
 	}
 
 	iterator lower_bound(const Key &theKey) {
-		iterator first = this->begin();
-		iterator it;
-		int count_ = _items.size(), step;
-
-		while (count_ > 0) {
-			it = first;
-			step = count_ / 2;
-			it += step;
-
-			if (_comp(it->_key, theKey)) {
-				first = ++it;
-				count_ -= step + 1;
-			} else {
-				count_ = step;
-			}
-		}
+		return _items.lower_bound(theKey);
+	}
 
-		return first;
+	/**
+	 * Returns an iterator for the first element of the map that is
+	 * greater than the given key
+	 */
+	const_iterator upper_bound(const Key &theKey) const {
+		return _items.upper_bound(theKey);
+	}
+
+	iterator upper_bound(const Key &theKey) {
+		return _items.upper_bound(theKey);
 	}
 
 	/**
 	 * Find the entry with the given key
 	 */
 	iterator find(const Key &theKey) {
-		iterator it = this->lower_bound(theKey);
-
-		if (it != this->end() && it->_key == theKey)
-			return it;
-		return this->end();
+		return _items.find(theKey);
 	}
 
 	const_iterator find(const Key &theKey) const {
-		const_iterator it = this->lower_bound(theKey);
-
-		if (it != this->end() && it->_key == theKey)
-			return it;
-		return this->end();
+		return _items.find(theKey);
 	}
 
 	/**
 	 * Square brackets operator accesses items by key, creating if necessary
 	 */
 	Val &operator[](const Key &theKey) {
-		iterator it = this->lower_bound(theKey);
-		if (it == this->end() || it->_key != theKey) {
-			size_t idx = it - this->begin();
-			_items.insert_at(idx, KeyValue());
-			_items[idx]._key = theKey;
-			return _items[idx]._value;
-		} else {
-			return _items[it - this->begin()]._value;
+		iterator it = _items.find(theKey);
+		if (it == _items.end()) {
+			KeyValue item;
+			item._key = theKey;
+			it = _items.insert(item).first;
 		}
+		return it->_value;
+	}
+
+	/**
+	 * Inserts the key and value, unless the key is already present
+	 */
+	pair<iterator, bool> insert(const pair<Key, Val> &elem) {
+		KeyValue item;
+		item._key = elem.first;
+		item._value = elem.second;
+		return _items.insert(item);
 	}
 
 	/**
 	 * Erases an entry in the map
 	 */
-	iterator erase(iterator it) {
-		iterator next = it;
-		++next;
-		_items.remove_at(it - begin());
-		return next;
+	iterator erase(const_iterator it) {
+		return _items.erase(it);
 	}
 
-	iterator erase(const Key &theKey) {
-		return erase(find(theKey));
+	size_t erase(const Key &theKey) {
+		return _items.erase(theKey);
 	}
 
 	/**
@@ -179,16 +160,17 @@ public:
 	}
 
 	/**
-	 * Returns the number of elements with a matching key
+	 * Returns true if the map is empty
 	 */
-	size_t count(const Key &theKey) {
-		int count_ = 0;
-		for (iterator it = this->begin(); it != this->end(); ++it) {
-			if (it->_key == theKey)
-				++count_;
-		}
+	bool empty() const {
+		return _items.empty();
+	}
 
-		return count_;
+	/**
+	 * Returns the number of elements with a matching key
+	 */
+	size_t count(const Key &theKey) const {
+		return _items.find(theKey) != _items.end() ? 1 : 0;
 	}
 };
 
@@ -197,17 +179,20 @@ template<class Key, class Val, class HashFunc = Common::Hash<Key>,
 class unordered_map : public Common::HashMap<Key, Val, HashFunc, EqualFunc> {
 public:
 	pair<Key, Val> insert(pair<Key, Val> elem) {
-		// unordered_map doesn't replace already existing keys
-		if (this->contains(elem.first))
-			return pair<Key, Val>(elem.first, this->operator[](elem.first));
-
-		// Add item to map
-		this->operator[](elem.first) = elem.second;
+		// unordered_map doesn't replace already existing keys, so the
+		// value is only set when the lookup had to create the entry
+		size_t oldSize = this->size();
+		Val &value = this->getOrCreateVal(elem.first);
+		if (this->size() == oldSize)
+			return pair<Key, Val>(elem.first, value);
+
+		value = elem.second;
 		return elem;
 	}
 
 	void reserve(size_t size) {
-		// No implementation
+		// HashMap grows its storage geometrically, so the rehashing cost
+		// is amortized, and it doesn't allow presizing the storage
 	}
 };
 
@@ -23,68 +23,104 @@
 #ifndef AGS_STD_SET_H
 #define AGS_STD_SET_H
 
-#include "common/array.h"
+#include "common/func.h"
+#include "ags/lib/std/xtree.h"
 
 namespace AGS3 {
 namespace std {
 
 /**
- * Derives the ScummVM SortedArray to match the std::set class
+ * Set of unique items, ordered by the comparator
  */
 template<class T, class Comparitor = Common::Less<T> >
-class set : public Common::SortedArray<T, const T &> {
-private:
-	static int ComparatorFn(const T &a, const T &b) {
-		return Comparitor().operator()(a, b) ? -1 : 0;
-	}
-public:
-	struct Entry {
-		const T &_value;
-		Entry(const T &item) : _value(item) {
+class set {
+	struct KeyOf {
+		const T &operator()(const T &item) const {
+			return item;
 		}
 	};
+	typedef Tree<T, T, KeyOf, Comparitor> ItemTree;
+private:
+	ItemTree _items;
 public:
-	using iterator = typename Common::SortedArray<T, const T &>::iterator;
-	using const_iterator = typename Common::SortedArray<T, const T &>::const_iterator;
+	// Items of a set can't be modified, as that could change their order
+	using iterator = typename ItemTree::const_iterator;
+	using const_iterator = typename ItemTree::const_iterator;
+
+	/**
+	 * Clears the set
+	 */
+	void clear() {
+		_items.clear();
+	}
 
 	/**
-	 * Constructor
+	 * Get the iterator start
 	 */
-	set() : Common::SortedArray<T, const T &>(ComparatorFn) {}
+	const_iterator begin() const {
+		return _items.begin();
+	}
+
+	/**
+	 * Get the iterator end
+	 */
+	const_iterator end() const {
+		return _items.end();
+	}
 
 	/**
 	 * Locate an item in the set
 	 */
-	iterator find(const T &item) {
-		iterator it;
-		for (it = this->begin(); it != this->end() && *it != item; ++it) {
-		}
+	const_iterator find(const T &item) const {
+		return _items.find(item);
+	}
 
-		return it;
+	/**
+	 * Returns an iterator for the first item not less than the given one
+	 */
+	const_iterator lower_bound(const T &item) const {
+		return _items.lower_bound(item);
+	}
+
+	/**
+	 * Insert an element at the sorted position, unless it's already present.
+	 * Returns the element and whether it was inserted
+	 */
+	pair<iterator, bool> insert(const T &item) {
+		pair<typename ItemTree::iterator, bool> result = _items.insert(item);
+		return pair<iterator, bool>(result.first, result.second);
 	}
 
 	/**
-	 * Insert an element at the sorted position.
+	 * Erases an item, returning the iterator for the next one
 	 */
-	Entry insert(const T &item) {
-		Common::SortedArray<T, const T &>::insert(item);
-		return Entry(item);
+	iterator erase(const_iterator it) {
+		return _items.erase(it);
+	}
+
+	size_t erase(const T &item) {
+		return _items.erase(item);
 	}
 
 	/**
 	 * Returns the number of keys that match the specified key
 	 */
-	size_t count(const T item) const {
-		size_t total = 0;
-		for (const_iterator it = this->begin(); it != this->end(); ++it) {
-			if (*it == item)
-				++total;
-			else if (!ComparatorFn (item, *it))
-				// Passed beyond possibility of matches
-				break;
-		}
+	size_t count(const T &item) const {
+		return _items.find(item) != _items.end() ? 1 : 0;
+	}
 
-		return total;
+	/**
+	 * Returns the number of items in the set
+	 */
+	size_t size() const {
+		return _items.size();
+	}
+
+	/**
+	 * Returns true if the set is empty
+	 */
+	bool empty() const {
+		return _items.empty();
 	}
 };
 
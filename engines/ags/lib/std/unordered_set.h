@@ -24,6 +24,7 @@
 #define AGS_STD_UNORDERED_SET_H
 
 #include "common/array.h"
+#include "ags/lib/std/utility.h"
 //#include <unordered_set>
 
 namespace AGS3 {
@@ -38,11 +39,6 @@ class unordered_set : public Common::Array<T> {
 private:
 	Hash _hash;
 	Pred _comparitor;
-public:
-	struct Entry {
-		const T &_value;
-		Entry(const T &item) : _value(item) {}
-	};
 public:
 	using iterator = typename Common::Array<T>::iterator;
 	using const_iterator = typename Common::Array<T>::const_iterator;
@@ -61,11 +57,16 @@ public:
 	}
 
 	/**
-	 * Adds an item
+	 * Adds an item, unless it's already present. Returns the item and
+	 * whether it was added
 	 */
-	Entry insert(const T &item) {
+	pair<iterator, bool> insert(const T &item) {
+		iterator it = find(item);
+		if (it != this->end())
+			return pair<iterator, bool>(it, false);
+
 		this->push_back(item);
-		return Entry(item);
+		return pair<iterator, bool>(this->end() - 1, true);
 	}
 
 	/**
@@ -0,0 +1,512 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AGS_STD_XTREE_H
+#define AGS_STD_XTREE_H
+
+#include "ags/lib/std/utility.h"
+
+namespace AGS3 {
+namespace std {
+
+/**
+ * Red-black tree used as the storage of std::map and std::set. Elements
+ * are kept in separately allocated nodes, so that inserting or erasing
+ * elements doesn't invalidate iterators or references to the others.
+ */
+template<class Value, class Key, class KeyOf, class CompFunc>
+class Tree {
+	struct NodeBase {
+		NodeBase *_left;
+		NodeBase *_right;
+		NodeBase *_parent;
+		bool _red;
+	};
+
+	struct Node : public NodeBase {
+		Value _value;
+		Node(const Value &value) : _value(value) {}
+	};
+
+public:
+	template<class Ref, class Ptr>
+	class Iterator {
+		friend class Tree;
+		template<class R, class P> friend class Iterator;
+	private:
+		NodeBase *_node;
+		const Tree *_tree;
+
+		Iterator(NodeBase *node, const Tree *tree) : _node(node), _tree(tree) {}
+	public:
+		Iterator() : _node(nullptr), _tree(nullptr) {}
+
+		template<class R, class P>
+		Iterator(const Iterator<R, P> &it) : _node(it._node), _tree(it._tree) {}
+
+		Ref operator*() const {
+			return static_cast<Node *>(_node)->_value;
+		}
+		Ptr operator->() const {
+			return &static_cast<Node *>(_node)->_value;
+		}
+
+		Iterator &operator++() {
+			_node = _tree->successor(_node);
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator tmp = *this;
+			++*this;
+			return tmp;
+		}
+		Iterator &operator--() {
+			_node = _tree->predecessor(_node);
+			return *this;
+		}
+		Iterator operator--(int) {
+			Iterator tmp = *this;
+			--*this;
+			return tmp;
+		}
+
+		template<class R, class P>
+		bool operator==(const Iterator<R, P> &it) const {
+			return _node == it._node;
+		}
+		template<class R, class P>
+		bool operator!=(const Iterator<R, P> &it) const {
+			return _node != it._node;
+		}
+	};
+
+	typedef Iterator<Value &, Value *> iterator;
+	typedef Iterator<const Value &, const Value *> const_iterator;
+
+private:
+	NodeBase _nil;
+	NodeBase *_root;
+	size_t _size;
+	CompFunc _comp;
+	KeyOf _keyOf;
+
+	const Key &key(const NodeBase *node) const {
+		return _keyOf(static_cast<const Node *>(node)->_value);
+	}
+
+	NodeBase *minimum(NodeBase *node) const {
+		while (node->_left != &_nil)
+			node = node->_left;
+		return node;
+	}
+
+	NodeBase *maximum(NodeBase *node) const {
+		while (node->_right != &_nil)
+			node = node->_right;
+		return node;
+	}
+
+	NodeBase *successor(NodeBase *node) const {
+		if (node->_right != &_nil)
+			return minimum(node->_right);
+
+		NodeBase *parent = node->_parent;
+		while (parent != &_nil && node == parent->_right) {
+			node = parent;
+			parent = parent->_parent;
+		}
+		return parent;
+	}
+
+	/**
+	 * Returns the previous node; the last node for end(), and the end for the first node
+	 */
+	NodeBase *predecessor(NodeBase *node) const {
+		if (node == &_nil)
+			return _root == &_nil ? node : maximum(_root);
+		if (node->_left != &_nil)
+			return maximum(node->_left);
+
+		NodeBase *parent = node->_parent;
+		while (parent != &_nil && node == parent->_left) {
+			node = parent;
+			parent = parent->_parent;
+		}
+		return parent;
+	}
+
+	void rotateLeft(NodeBase *node) {
+		NodeBase *child = node->_right;
+		node->_right = child->_left;
+		if (child->_left != &_nil)
+			child->_left->_parent = node;
+		replaceChild(node, child);
+		child->_left = node;
+		node->_parent = child;
+	}
+
+	void rotateRight(NodeBase *node) {
+		NodeBase *child = node->_left;
+		node->_left = child->_right;
+		if (child->_right != &_nil)
+			child->_right->_parent = node;
+		replaceChild(node, child);
+		child->_right = node;
+		node->_parent = child;
+	}
+
+	/**
+	 * Puts the subtree of newNode in place of the one of node. The parent
+	 * of the sentinel may be set, which the erase fixup relies on
+	 */
+	void replaceChild(NodeBase *node, NodeBase *newNode) {
+		if (node->_parent == &_nil)
+			_root = newNode;
+		else if (node == node->_parent->_left)
+			node->_parent->_left = newNode;
+		else
+			node->_parent->_right = newNode;
+		newNode->_parent = node->_parent;
+	}
+
+	void insertFixup(NodeBase *node) {
+		while (node->_parent->_red) {
+			NodeBase *parent = node->_parent;
+			NodeBase *grandParent = parent->_parent;
+
+			if (parent == grandParent->_left) {
+				NodeBase *uncle = grandParent->_right;
+				if (uncle->_red) {
+					parent->_red = uncle->_red = false;
+					grandParent->_red = true;
+					node = grandParent;
+				} else {
+					if (node == parent->_right) {
+						node = parent;
+						rotateLeft(node);
+					}
+					node->_parent->_red = false;
+					grandParent->_red = true;
+					rotateRight(grandParent);
+				}
+			} else {
+				NodeBase *uncle = grandParent->_left;
+				if (uncle->_red) {
+					parent->_red = uncle->_red = false;
+					grandParent->_red = true;
+					node = grandParent;
+				} else {
+					if (node == parent->_left) {
+						node = parent;
+						rotateRight(node);
+					}
+					node->_parent->_red = false;
+					grandParent->_red = true;
+					rotateLeft(grandParent);
+				}
+			}
+		}
+
+		_root->_red = false;
+	}
+
+	void eraseFixup(NodeBase *node) {
+		while (node != _root && !node->_red) {
+			NodeBase *parent = node->_parent;
+
+			if (node == parent->_left) {
+				NodeBase *sibling = parent->_right;
+				if (sibling->_red) {
+					sibling->_red = false;
+					parent->_red = true;
+					rotateLeft(parent);
+					sibling = parent->_right;
+				}
+
+				if (!sibling->_left->_red && !sibling->_right->_red) {
+					sibling->_red = true;
+					node = parent;
+				} else {
+					if (!sibling->_right->_red) {
+						sibling->_left->_red = false;
+						sibling->_red = true;
+						rotateRight(sibling);
+						sibling = parent->_right;
+					}
+					sibling->_red = parent->_red;
+					parent->_red = false;
+					sibling->_right->_red = false;
+					rotateLeft(parent);
+					node = _root;
+				}
+			} else {
+				NodeBase *sibling = parent->_left;
+				if (sibling->_red) {
+					sibling->_red = false;
+					parent->_red = true;
+					rotateRight(parent);
+					sibling = parent->_left;
+				}
+
+				if (!sibling->_right->_red && !sibling->_left->_red) {
+					sibling->_red = true;
+					node = parent;
+				} else {
+					if (!sibling->_left->_red) {
+						sibling->_right->_red = false;
+						sibling->_red = true;
+						rotateLeft(sibling);
+						sibling = parent->_left;
+					}
+					sibling->_red = parent->_red;
+					parent->_red = false;
+					sibling->_left->_red = false;
+					rotateRight(parent);
+					node = _root;
+				}
+			}
+		}
+
+		node->_red = false;
+	}
+
+	NodeBase *copyNodes(const NodeBase *node, NodeBase *parent, const Tree &other) {
+		if (node == &other._nil)
+			return &_nil;
+
+		Node *copy = new Node(static_cast<const Node *>(node)->_value);
+		copy->_red = node->_red;
+		copy->_parent = parent;
+		copy->_left = copyNodes(node->_left, copy, other);
+		copy->_right = copyNodes(node->_right, copy, other);
+		return copy;
+	}
+
+	void destroyNodes(NodeBase *node) {
+		while (node != &_nil) {
+			destroyNodes(node->_right);
+			NodeBase *left = node->_left;
+			delete static_cast<Node *>(node);
+			node = left;
+		}
+	}
+
+	void init() {
+		_nil._left = _nil._right = _nil._parent = &_nil;
+		_nil._red = false;
+		_root = &_nil;
+		_size = 0;
+	}
+
+public:
+	Tree() {
+		init();
+	}
+
+	Tree(const Tree &other) : _comp(other._comp) {
+		init();
+		_root = copyNodes(other._root, &_nil, other);
+		_size = other._size;
+	}
+
+	~Tree() {
+		destroyNodes(_root);
+	}
+
+	Tree &operator=(const Tree &other) {
+		if (this != &other) {
+			clear();
+			_comp = other._comp;
+			_root = copyNodes(other._root, &_nil, other);
+			_size = other._size;
+		}
+		return *this;
+	}
+
+	/**
+	 * Clears the tree
+	 */
+	void clear() {
+		destroyNodes(_root);
+		init();
+	}
+
+	iterator begin() {
+		return iterator(minimum(_root), this);
+	}
+	iterator end() {
+		return iterator(&_nil, this);
+	}
+	const_iterator begin() const {
+		return const_iterator(minimum(_root), this);
+	}
+	const_iterator end() const {
+		return const_iterator(const_cast<NodeBase *>(&_nil), this);
+	}
+
+	size_t size() const {
+		return _size;
+	}
+	bool empty() const {
+		return _size == 0;
+	}
+
+	/**
+	 * Returns an iterator for the first element whose key is not less than the given key
+	 */
+	iterator lower_bound(const Key &theKey) const {
+		NodeBase *node = _root;
+		NodeBase *result = const_cast<NodeBase *>(&_nil);
+		while (node != &_nil) {
+			if (!_comp(key(node), theKey)) {
+				result = node;
+				node = node->_left;
+			} else {
+				node = node->_right;
+			}
+		}
+		return iterator(result, this);
+	}
+
+	/**
+	 * Returns an iterator for the first element whose key is greater than the given key
+	 */
+	iterator upper_bound(const Key &theKey) const {
+		NodeBase *node = _root;
+		NodeBase *result = const_cast<NodeBase *>(&_nil);
+		while (node != &_nil) {
+			if (_comp(theKey, key(node))) {
+				result = node;
+				node = node->_left;
+			} else {
+				node = node->_right;
+			}
+		}
+		return iterator(result, this);
+	}
+
+	/**
+	 * Finds the element with a key equivalent to the given one
+	 */
+	iterator find(const Key &theKey) const {
+		iterator it = lower_bound(theKey);
+		if (it._node != &_nil && !_comp(theKey, key(it._node)))
+			return it;
+		return iterator(const_cast<NodeBase *>(&_nil), this);
+	}
+
+	/**
+	 * Inserts the value, unless an element with an equivalent key is
+	 * already present. Returns the element with the key and whether the
+	 * value was inserted
+	 */
+	pair<iterator, bool> insert(const Value &value) {
+		const Key &theKey = _keyOf(value);
+		NodeBase *parent = &_nil;
+		NodeBase *node = _root;
+		bool less = true;
+		while (node != &_nil) {
+			parent = node;
+			less = _comp(theKey, key(node));
+			node = less ? node->_left : node->_right;
+		}
+
+		// The only candidate for an equivalent key is the closest node not greater
+		NodeBase *prev = less ? predecessor(parent) : parent;
+		if (parent != &_nil && prev != &_nil && !_comp(key(prev), theKey))
+			return pair<iterator, bool>(iterator(prev, this), false);
+
+		Node *newNode = new Node(value);
+		newNode->_left = newNode->_right = &_nil;
+		newNode->_parent = parent;
+		newNode->_red = true;
+		if (parent == &_nil)
+			_root = newNode;
+		else if (less)
+			parent->_left = newNode;
+		else
+			parent->_right = newNode;
+
+		insertFixup(newNode);
+		++_size;
+		return pair<iterator, bool>(iterator(newNode, this), true);
+	}
+
+	/**
+	 * Erases the element, returning an iterator for the next one
+	 */
+	iterator erase(const_iterator it) {
+		NodeBase *node = it._node;
+		iterator next(successor(node), this);
+
+		NodeBase *removed = node;
+		bool removedRed = removed->_red;
+		NodeBase *child;
+		if (node->_left == &_nil) {
+			child = node->_right;
+			replaceChild(node, child);
+		} else if (node->_right == &_nil) {
+			child = node->_left;
+			replaceChild(node, child);
+		} else {
+			// Put the successor in place of the node
+			removed = minimum(node->_right);
+			removedRed = removed->_red;
+			child = removed->_right;
+			if (removed->_parent == node) {
+				child->_parent = removed;
+			} else {
+				replaceChild(removed, child);
+				removed->_right = node->_right;
+				removed->_right->_parent = removed;
+			}
+			replaceChild(node, removed);
+			removed->_left = node->_left;
+			removed->_left->_parent = removed;
+			removed->_red = node->_red;
+		}
+
+		if (!removedRed)
+			eraseFixup(child);
+		_nil._parent = &_nil;
+
+		delete static_cast<Node *>(node);
+		--_size;
+		return next;
+	}
+
+	/**
+	 * Erases the element with the given key, returning the number of erased elements
+	 */
+	size_t erase(const Key &theKey) {
+		iterator it = find(theKey);
+		if (it._node == &_nil)
+			return 0;
+		erase(it);
+		return 1;
+	}
+};
+
+} // namespace std
+} // namespace AGS3
+
+#endif
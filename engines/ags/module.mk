@@ -322,6 +322,7 @@ MODULE_OBJS += \
 	tests/test_inifile.o \
 	tests/test_math.o \
 	tests/test_memory.o \
+	tests/test_script.o \
 	tests/test_sprintf.o \
 	tests/test_string.o \
 	tests/test_version.o
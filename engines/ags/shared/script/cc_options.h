@@ -39,6 +39,7 @@ namespace AGS3 {
 #define SCOPT_NOIMPORTOVERRIDE 0x20 // do not allow an import to be re-declared
 #define SCOPT_LEFTTORIGHT 0x40   // left-to-right operator precedance
 #define SCOPT_OLDSTRINGS  0x80   // allow old-style strings
+#define SCOPT_PREDECODE  0x100   // decode the instructions when creating an instance, instead of every time they are run
 
 extern void ccSetOption(int, int);
 extern int ccGetOption(int);
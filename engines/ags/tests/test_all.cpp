@@ -34,6 +34,7 @@ void Test_DoAllTests() {
 	Test_Version();
 	Test_File();
 	Test_IniFile();
+	Test_Script();
 
 	Test_Gfx();
 }
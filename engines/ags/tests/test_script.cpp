@@ -0,0 +1,193 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/debug.h"
+#include "common/system.h"
+#include "ags/shared/core/platform.h"
+#include "ags/shared/debugging/assert.h"
+#include "ags/shared/script/cc_options.h"
+#include "ags/shared/script/script_common.h"
+#include "ags/engine/script/cc_instance.h"
+#include "ags/engine/script/script_runtime.h"
+
+namespace AGS3 {
+
+#define SCRIPT_LOOP_COUNT 10000
+#define SCRIPT_FRAME_COUNT 200
+
+// Loop which sums up (i * 3), and returns the sum through a global variable
+static const int32_t script_code[] = {
+	SCMD_LOOPCHECKOFF,
+	SCMD_LITTOREG, SREG_DX, 0,
+	SCMD_LITTOREG, SREG_CX, 0,
+	// loop start, at 7
+	SCMD_LINENUM, 1,
+	SCMD_REGTOREG, SREG_CX, SREG_BX,
+	SCMD_MUL, SREG_BX, 3,
+	SCMD_ADDREG, SREG_DX, SREG_BX,
+	SCMD_ADD, SREG_CX, 1,
+	SCMD_REGTOREG, SREG_CX, SREG_AX,
+	SCMD_LITTOREG, SREG_BX, SCRIPT_LOOP_COUNT,
+	SCMD_LESSTHAN, SREG_AX, SREG_BX,
+	SCMD_JNZ, -25,
+	// loop end, at 32
+	SCMD_LITTOREG, SREG_MAR, 0, // global data fixup at 34
+	SCMD_MEMWRITE, SREG_DX,
+	SCMD_MEMREAD, SREG_AX,
+	SCMD_RET
+};
+
+static PScript CreateTestScript() {
+	ccScript *scri = new ccScript();
+	scri->globaldatasize = sizeof(int32_t);
+	scri->globaldata = (char *)calloc(1, scri->globaldatasize);
+	scri->codesize = ARRAYSIZE(script_code);
+	scri->code = (int32_t *)malloc(sizeof(script_code));
+	memcpy(scri->code, script_code, sizeof(script_code));
+	scri->numfixups = 1;
+	scri->fixups = (int32_t *)malloc(sizeof(int32_t));
+	scri->fixups[0] = 34;
+	scri->fixuptypes = (char *)malloc(1);
+	scri->fixuptypes[0] = FIXUP_GLOBALDATA;
+	scri->numexports = scri->exportsCapacity = 1;
+	scri->exports = (char **)malloc(sizeof(char *));
+	scri->exports[0] = scumm_strdup("bench$0");
+	scri->export_addr = (int32_t *)malloc(sizeof(int32_t));
+	scri->export_addr[0] = EXPORT_FUNCTION << 24;
+	return PScript(scri);
+}
+
+// Calls an imported function with 5, then adds the 7 pushed on the stack
+// before the call, read through the stack pointer, and multiplies the sum by
+// the same 7, read through a stack fixup. Returns (5 * 3 + 7) * 7.
+static const int32_t fixup_script_code[] = {
+	SCMD_LITTOREG, SREG_AX, 7,
+	SCMD_PUSHREG, SREG_AX,
+	SCMD_LITTOREG, SREG_AX, 5,
+	SCMD_PUSHREAL, SREG_AX,
+	SCMD_LITTOREG, SREG_BX, 0, // import fixup at 12
+	SCMD_CALLEXT, SREG_BX,
+	SCMD_SUBREALSTACK, 1,
+	SCMD_LOADSPOFFS, 4,
+	SCMD_MEMREAD, SREG_CX,
+	SCMD_ADDREG, SREG_AX, SREG_CX,
+	SCMD_LITTOREG, SREG_MAR, 4, // stack fixup at 26, after the return address
+	SCMD_MEMREAD, SREG_DX,
+	SCMD_MULREG, SREG_AX, SREG_DX,
+	SCMD_POPREG, SREG_CX,
+	SCMD_RET
+};
+
+static RuntimeScriptValue Sc_TestTriple(const RuntimeScriptValue *params, int32_t param_count) {
+	assert(param_count == 1);
+	return RuntimeScriptValue().SetInt32(params[0].IValue * 3);
+}
+
+static PScript CreateFixupTestScript() {
+	ccScript *scri = new ccScript();
+	scri->codesize = ARRAYSIZE(fixup_script_code);
+	scri->code = (int32_t *)malloc(sizeof(fixup_script_code));
+	memcpy(scri->code, fixup_script_code, sizeof(fixup_script_code));
+	scri->numfixups = 2;
+	scri->fixups = (int32_t *)malloc(2 * sizeof(int32_t));
+	scri->fixups[0] = 12;
+	scri->fixups[1] = 26;
+	scri->fixuptypes = (char *)malloc(2);
+	scri->fixuptypes[0] = FIXUP_IMPORT;
+	scri->fixuptypes[1] = FIXUP_STACK;
+	scri->numimports = scri->importsCapacity = 1;
+	scri->imports = (char **)malloc(sizeof(char *));
+	scri->imports[0] = scumm_strdup("TestTriple^1");
+	scri->numexports = scri->exportsCapacity = 1;
+	scri->exports = (char **)malloc(sizeof(char *));
+	scri->exports[0] = scumm_strdup("calc$0");
+	scri->export_addr = (int32_t *)malloc(sizeof(int32_t));
+	scri->export_addr[0] = EXPORT_FUNCTION << 24;
+	return PScript(scri);
+}
+
+static int32_t Test_RunFunction(ccInstance *inst, const char *name, bool predecode) {
+	ccSetOption(SCOPT_PREDECODE, predecode);
+	int result = inst->CallScriptFunction(name, 0, nullptr);
+	assert(result == 0);
+	(void)result;
+	return inst->returnValue;
+}
+
+static uint32 Test_RunScript(ccInstance *inst, bool predecode) {
+	uint32 start = g_system->getMillis();
+	for (int frame = 0; frame < SCRIPT_FRAME_COUNT; ++frame) {
+		int32_t result = Test_RunFunction(inst, "bench", predecode);
+		assert(result == 3 * (SCRIPT_LOOP_COUNT * (SCRIPT_LOOP_COUNT - 1) / 2));
+	}
+	return g_system->getMillis() - start;
+}
+
+// Run the function with both interpreters, in the instance and in a fork of
+// it, which shares its pre-decoded code
+static void Test_CompareInterpreters(ccInstance *inst, const char *name, int32_t expected) {
+	ccInstance *fork = inst->Fork();
+	assert(fork != nullptr);
+
+	const int32_t reference = Test_RunFunction(inst, name, false);
+	const int32_t predecoded = Test_RunFunction(inst, name, true);
+	const int32_t fork_predecoded = Test_RunFunction(fork, name, true);
+	const int32_t fork_reference = Test_RunFunction(fork, name, false);
+	assert(reference == expected);
+	assert(predecoded == reference);
+	assert(fork_predecoded == reference);
+	assert(fork_reference == reference);
+
+	delete fork;
+}
+
+void Test_Script() {
+	// The instructions are only pre-decoded when the option is set
+	ccSetOption(SCOPT_PREDECODE, 1);
+	PScript scri = CreateTestScript();
+	ccInstance *inst = ccInstance::CreateFromScript(scri);
+	assert(inst != nullptr);
+
+	Test_CompareInterpreters(inst, "bench", 3 * (SCRIPT_LOOP_COUNT * (SCRIPT_LOOP_COUNT - 1) / 2));
+
+	// Compare the pre-decoded code with the reference interpreter
+	uint32 reference_time = Test_RunScript(inst, false);
+	uint32 predecoded_time = Test_RunScript(inst, true);
+	debug("Script: %d frames of %d loops, reference %u ms, pre-decoded %u ms",
+		SCRIPT_FRAME_COUNT, SCRIPT_LOOP_COUNT, reference_time, predecoded_time);
+	delete inst;
+
+	// Imports and stack addresses are resolved when the code runs
+	ccAddExternalStaticFunction("TestTriple^1", Sc_TestTriple);
+	ccSetOption(SCOPT_PREDECODE, 1);
+	scri = CreateFixupTestScript();
+	inst = ccInstance::CreateFromScript(scri);
+	assert(inst != nullptr);
+
+	Test_CompareInterpreters(inst, "calc", (5 * 3 + 7) * 7);
+
+	delete inst;
+	ccRemoveExternalSymbol("TestTriple^1");
+	ccSetOption(SCOPT_PREDECODE, 0);
+}
+
+} // namespace AGS3
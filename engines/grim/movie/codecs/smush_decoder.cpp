@@ -63,9 +63,7 @@ SmushDecoder::SmushDecoder() {
 }
 
 SmushDecoder::~SmushDecoder() {
-	delete _videoTrack;
-	delete _audioTrack;
-	delete[] _frames;
+	close();
 }
 
 void SmushDecoder::init() {
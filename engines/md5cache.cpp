@@ -0,0 +1,208 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/md5cache.h"
+
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/fs.h"
+#include "common/stream.h"
+#include "common/system.h"
+#include "common/tokenizer.h"
+
+namespace Common {
+DECLARE_SINGLETON(MD5Cache);
+}
+
+/** First line of the cache file. Bump the version when the format changes. */
+static const char *const kMD5CacheHeader = "ScummVM MD5 cache 2";
+static const char *const kMD5CacheFileName = "scummvm-md5.cache";
+
+MD5Cache::MD5Cache() : _loaded(false), _rewrite(false), _hits(0), _misses(0) {
+}
+
+bool MD5Cache::isEnabled() const {
+	return !ConfMan.hasKey("md5_cache") || ConfMan.getBool("md5_cache");
+}
+
+void MD5Cache::load() {
+	_loaded = true;
+	// The new entries are appended to the file as long as it is valid
+	_rewrite = true;
+
+	Common::FSNode file;
+	if (!ConfMan.getCacheFile(kMD5CacheFileName, file) || !file.exists())
+		return;
+
+	Common::SeekableReadStream *stream = file.createReadStream();
+	if (!stream)
+		return;
+
+	if (stream->readLine() != kMD5CacheHeader) {
+		debug(1, "MD5Cache: Ignoring outdated cache file '%s'", file.getPath().c_str());
+		delete stream;
+		return;
+	}
+
+	_rewrite = false;
+	uint lines = 0;
+
+	while (!stream->eos() && !stream->err()) {
+		Common::String line = stream->readLine(false);
+		if (line.empty())
+			continue;
+
+		Common::StringTokenizer tokenizer(line, "\t");
+		Common::String key = tokenizer.nextToken();
+		Entry entry;
+		entry.stamp = tokenizer.nextToken();
+		entry.md5 = tokenizer.nextToken();
+		Common::String size = tokenizer.nextToken();
+
+		if (size.empty() || !tokenizer.empty()) {
+			warning("MD5Cache: Malformed line in '%s', discarding the cache", file.getPath().c_str());
+			_entries.clear();
+			_rewrite = true;
+			break;
+		}
+
+		// Replaced entries are appended, so the last line for a key wins
+		entry.size = atoi(size.c_str());
+		_entries[key] = entry;
+		++lines;
+	}
+
+	delete stream;
+
+	// Compact the file once most of its lines are replaced entries
+	if (lines > 2 * _entries.size())
+		_rewrite = true;
+
+	debug(2, "MD5Cache: Loaded %d entries from '%s'", _entries.size(), file.getPath().c_str());
+}
+
+bool MD5Cache::lookup(const Common::String &key, const Common::String &stamp, Common::String &md5, int32 &size) {
+	if (!isEnabled())
+		return false;
+
+	if (!_loaded)
+		load();
+
+	EntryMap::const_iterator it = _entries.find(key);
+	if (it == _entries.end() || it->_value.stamp != stamp) {
+		++_misses;
+		return false;
+	}
+
+	md5 = it->_value.md5;
+	size = it->_value.size;
+	++_hits;
+	return true;
+}
+
+void MD5Cache::store(const Common::String &key, const Common::String &stamp, const Common::String &md5, int32 size) {
+	if (!isEnabled())
+		return;
+
+	// Keys are paths, which could in theory contain our separators
+	if (key.contains('\t') || key.contains('\n') || key.contains('\r'))
+		return;
+
+	if (!_loaded)
+		load();
+
+	if (_entries.size() >= kMaxEntries && !_entries.contains(key)) {
+		debug(1, "MD5Cache: Too many entries, clearing the cache");
+		_entries.clear();
+		_newKeys.clear();
+		_rewrite = true;
+	}
+
+	Entry &entry = _entries[key];
+	entry.stamp = stamp;
+	entry.md5 = md5;
+	entry.size = size;
+	_newKeys.push_back(key);
+}
+
+void MD5Cache::writeEntry(Common::WriteStream &stream, const Common::String &key, const Entry &entry) {
+	stream.writeString(Common::String::format("%s\t%s\t%s\t%d\n", key.c_str(),
+		entry.stamp.c_str(), entry.md5.c_str(), entry.size));
+}
+
+void MD5Cache::flush() {
+	if (!_rewrite && _newKeys.empty())
+		return;
+
+	Common::FSNode file;
+	if (!ConfMan.getCacheFile(kMD5CacheFileName, file)) {
+		_rewrite = false;
+		_newKeys.clear();
+		return;
+	}
+
+	// The whole file is only written again when entries were dropped
+	Common::WriteStream *stream = 0;
+	if (!_rewrite)
+		stream = file.createAppendStream();
+
+	if (stream) {
+		for (uint i = 0; i < _newKeys.size(); i++)
+			writeEntry(*stream, _newKeys[i], _entries[_newKeys[i]]);
+	} else {
+		stream = file.createWriteStream();
+		if (!stream) {
+			warning("MD5Cache: Could not write '%s'", file.getPath().c_str());
+			_rewrite = false;
+			_newKeys.clear();
+			return;
+		}
+
+		stream->writeString(kMD5CacheHeader);
+		stream->writeByte('\n');
+
+		for (EntryMap::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
+			writeEntry(*stream, it->_key, it->_value);
+	}
+
+	_rewrite = false;
+	_newKeys.clear();
+
+	stream->finalize();
+	if (stream->err())
+		warning("MD5Cache: Error while writing '%s'", file.getPath().c_str());
+
+	delete stream;
+}
+
+Common::String MD5Cache::makeKey(const Common::String &path, uint md5Bytes, bool resFork) {
+	return Common::String::format("%s:%u:%c", path.c_str(), md5Bytes, resFork ? 'r' : 'd');
+}
+
+bool MD5Cache::addToStamp(const Common::FSNode &node, Common::String &stamp) {
+	int64 size, mtime;
+	if (!node.getFileStats(size, mtime))
+		return false;
+
+	stamp += Common::String::format("%lld/%lld;", (long long)size, (long long)mtime);
+	return true;
+}
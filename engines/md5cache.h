@@ -0,0 +1,128 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_MD5CACHE_H
+#define ENGINES_MD5CACHE_H
+
+#include "common/array.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+namespace Common {
+class FSNode;
+class WriteStream;
+}
+
+/**
+ * @defgroup engines_md5cache MD5 cache
+ * @ingroup engines
+ *
+ * @brief Persistent cache of the file checksums computed during game detection.
+ *
+ * @{
+ */
+
+/**
+ * Cache of the MD5 checksums and sizes computed by the advanced detector.
+ *
+ * Entries are keyed by the path of the file, the number of bytes hashed and
+ * whether the data or the resource fork was hashed. Each entry also records a
+ * stamp built from the size and modification time of the files it was
+ * computed from; an entry whose stamp does not match any more is ignored and
+ * replaced. Files whose stamp cannot be retrieved (see
+ * Common::FSNode::getFileStats) are never cached.
+ *
+ * The cache is stored next to the configuration file in use and can be
+ * disabled with the "md5_cache" config key. New and replaced entries are
+ * appended to it, and it is only written again from scratch when entries
+ * are dropped or when most of its lines are out of date.
+ */
+class MD5Cache : public Common::Singleton<MD5Cache> {
+public:
+	/**
+	 * Look up a checksum.
+	 *
+	 * @param key    Key of the entry, see makeKey().
+	 * @param stamp  Current stamp of the files, see addToStamp().
+	 * @param md5    Receives the cached checksum.
+	 * @param size   Receives the cached file size.
+	 *
+	 * @return True on a hit, false if the entry is missing or out of date.
+	 */
+	bool lookup(const Common::String &key, const Common::String &stamp, Common::String &md5, int32 &size);
+
+	/** Add or replace an entry. */
+	void store(const Common::String &key, const Common::String &stamp, const Common::String &md5, int32 size);
+
+	/** Write the entries added since the last flush to disk. */
+	void flush();
+
+	uint getHits() const { return _hits; }
+	uint getMisses() const { return _misses; }
+
+	/** Build the key for the checksum of the first md5Bytes bytes of a file. */
+	static Common::String makeKey(const Common::String &path, uint md5Bytes, bool resFork);
+
+	/**
+	 * Append the size and modification time of a file to a stamp.
+	 *
+	 * @return False if the backend cannot stat the file, in which case the
+	 *         checksum must not be cached.
+	 */
+	static bool addToStamp(const Common::FSNode &node, Common::String &stamp);
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	MD5Cache();
+
+	enum {
+		/** The whole cache is dropped when it grows past this size. */
+		kMaxEntries = 50000
+	};
+
+	struct Entry {
+		Common::String stamp;
+		Common::String md5;
+		int32 size;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	bool isEnabled() const;
+	void load();
+	static void writeEntry(Common::WriteStream &stream, const Common::String &key, const Entry &entry);
+
+	EntryMap _entries;
+	/** Keys stored since the last flush, which are appended to the file. */
+	Common::Array<Common::String> _newKeys;
+	bool _loaded;
+	/** Set when the file has to be written again from scratch. */
+	bool _rewrite;
+	uint _hits;
+	uint _misses;
+};
+
+/** @} */
+
+#endif
@@ -27,6 +27,8 @@
 #include "common/scummsys.h"
 #include "common/error.h"
 #include "common/array.h"
+#include "common/fs.h"
+#include "common/stack.h"
 
 #include "engines/game.h"
 #include "engines/savestate.h"
@@ -567,5 +569,60 @@ private:
 
 /** Convenience shortcut for accessing the engine manager. */
 #define EngineMan EngineManager::instance()
+
+/**
+ * Game detection over a whole directory tree, performed in small steps.
+ *
+ * Each step runs the detector of a single engine on a single directory, so
+ * that callers like the mass add dialog can interleave the scan with event
+ * handling, show the games as they are found, and cancel the scan at any
+ * point simply by dropping the object. Every directory is listed only once,
+ * and all the engine detectors share that listing.
+ */
+class DetectionScan {
+public:
+	DetectionScan(const Common::FSNode &startDir, bool recursive = true);
+	~DetectionScan();
+
+	/**
+	 * Run the detector of the next engine.
+	 *
+	 * @param dir    Receives the directory the detector was run on.
+	 * @param games  Receives the games recognized by the detector.
+	 *
+	 * @return False if there was nothing left to scan.
+	 */
+	bool step(Common::FSNode &dir, DetectedGames &games);
+
+	/** Returns whether the whole tree has been scanned. */
+	bool isDone() const { return _files.empty() && _scanStack.empty(); }
+
+	/** Number of directories fully scanned so far. */
+	uint getDirsScanned() const { return _dirsScanned; }
+
+	/** Number of directories found so far, including the ones still waiting to be scanned. */
+	uint getDirsTotal() const { return _dirsTotal; }
+
+private:
+	/** Fetch the listing of the next directory which has any files in it. */
+	bool nextDir();
+
+	/** Called once all the detectors have run on the current directory. */
+	void finishDir();
+
+	Common::Stack<Common::FSNode> _scanStack;
+	bool _recursive;
+
+	Common::FSNode _dir;
+	/** Listing of the current directory, empty between directories. */
+	Common::FSList _files;
+	/** Index of the next detection plugin to run on the current directory. */
+	uint _nextPlugin;
+	/** All the games the detectors found in the current directory. */
+	DetectedGames _dirCandidates;
+
+	uint _dirsScanned;
+	uint _dirsTotal;
+};
 /** @} */
 #endif
@@ -117,6 +117,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
 	registerCmd("list",				WRAP_METHOD(Console, cmdList));
 	registerCmd("alloc_list",				WRAP_METHOD(Console, cmdAllocList));
+	registerCmd("resource_cache",		WRAP_METHOD(Console, cmdResourceCache));
 	registerCmd("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	registerCmd("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
 	registerCmd("integrity_dump",	WRAP_METHOD(Console, cmdResourceIntegrityDump));
@@ -163,6 +164,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	registerCmd("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
 	registerCmd("gc_normalize",		WRAP_METHOD(Console, cmdGCNormalize));
+	registerCmd("gc_stats",			WRAP_METHOD(Console, cmdGCStatistics));
 	// Music/SFX
 	registerCmd("songlib",			WRAP_METHOD(Console, cmdSongLib));
 	registerCmd("songinfo",			WRAP_METHOD(Console, cmdSongInfo));
@@ -226,6 +228,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("bpe",				WRAP_METHOD(Console, cmdBreakpointFunction));		// alias
 	// VM
 	registerCmd("script_steps",		WRAP_METHOD(Console, cmdScriptSteps));
+	registerCmd("vm_fusion",			WRAP_METHOD(Console, cmdVMFusion));
 	registerCmd("script_objects",   WRAP_METHOD(Console, cmdScriptObjects));
 	registerCmd("scro",             WRAP_METHOD(Console, cmdScriptObjects));
 	registerCmd("script_strings",   WRAP_METHOD(Console, cmdScriptStrings));
@@ -257,6 +260,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	_debugState.breakpointWasHit = false;
 	_debugState._breakpoints.clear(); // No breakpoints defined
 	_debugState._activeBreakpointTypes = 0;
+	_debugState.fuseInstructions = true;
 }
 
 Console::~Console() {
@@ -347,6 +351,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" resource_types - Shows the valid resource types\n");
 	debugPrintf(" list - Lists all the resources of a given type\n");
 	debugPrintf(" alloc_list - Lists all allocated resources\n");
+	debugPrintf(" resource_cache - Shows the statistics of the resource cache, and optionally changes its size\n");
 	debugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	debugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
 	debugPrintf(" integrity_dump - Dumps integrity data about resources in the current game to disk\n");
@@ -388,6 +393,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	debugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
 	debugPrintf(" gc_normalize - Prints the \"normal\" address of a given address\n");
+	debugPrintf(" gc_stats - Shows the pause times of the garbage collector\n");
 	debugPrintf("\n");
 	debugPrintf("Music/SFX:\n");
 	debugPrintf(" songlib - Shows the song library\n");
@@ -433,6 +439,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf("\n");
 	debugPrintf("VM:\n");
 	debugPrintf(" script_steps - Shows the number of executed SCI operations\n");
+	debugPrintf(" vm_fusion - Shows the number of operations executed as part of the previous one, and optionally turns this on or off\n");
 	debugPrintf(" script_objects / scro - Shows all objects inside a specified script\n");
 	debugPrintf(" script_strings / scrs - Shows all strings inside a specified script\n");
 	debugPrintf(" script_said - Shows all said - strings inside a specified script\n");
@@ -1040,6 +1047,36 @@ bool Console::cmdAllocList(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceCache(int argc, const char **argv) {
+	ResourceManager *resMan = _engine->getResMan();
+
+	if (argc > 2) {
+		debugPrintf("Shows the statistics of the cache of unlocked resources, and optionally changes its size.\n");
+		debugPrintf("Usage: %s [<size in KiB>]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		const int size = atoi(argv[1]);
+		if (size <= 0) {
+			debugPrintf("Invalid size: '%s'\n", argv[1]);
+			return true;
+		}
+		if (size > ResourceManager::kMaxCacheBudgetKiB)
+			debugPrintf("The size is limited to %d KiB\n", ResourceManager::kMaxCacheBudgetKiB);
+		resMan->setCacheBudgetKiB(size);
+	}
+
+	const ResourceManager::CacheStatistics &stats = resMan->getCacheStatistics();
+	const uint32 requests = stats.hits + stats.misses;
+	debugPrintf("Unlocked resources: %u, using %d of %d KiB\n", resMan->getCacheSize(), resMan->getCacheMemory() / 1024, resMan->getCacheBudget() / 1024);
+	debugPrintf("Locked resources: %d KiB\n", resMan->getLockedMemory() / 1024);
+	debugPrintf("Hits: %u, misses: %u (%u%% hits)\n", stats.hits, stats.misses, requests ? stats.hits * 100 / requests : 0);
+	debugPrintf("Evictions: %u, time spent loading: %u ms\n", stats.evictions, stats.loadMillis);
+
+	return true;
+}
+
 bool Console::cmdDissectScript(int argc, const char **argv) {
 	if (argc != 2) {
 		debugPrintf("Examines a script\n");
@@ -2839,6 +2876,17 @@ bool Console::cmdGCNormalize(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdGCStatistics(int argc, const char **argv) {
+	const EngineState::GCStatistics &stats = _engine->_gamestate->gcStatistics;
+
+	debugPrintf("Searches for garbage: %u, runs with a deferred sweep: %u\n", stats.collections, stats.sweeps);
+	debugPrintf("Freed addresses: %u, pending: %u\n", stats.freed, _engine->_gamestate->_segMan->getPendingGarbage().size());
+	debugPrintf("Pauses: last %u ms, longest %u ms, total %u ms\n", stats.lastPause, stats.maxPause, stats.totalPause);
+	debugPrintf("Longest search for garbage: %u ms\n", stats.maxSearchPause);
+
+	return true;
+}
+
 bool Console::cmdVMVarlist(int argc, const char **argv) {
 	EngineState *s = _engine->_gamestate;
 	const char *varnames[] = {"global", "local", "temp", "param"};
@@ -3268,6 +3316,21 @@ bool Console::cmdScriptSteps(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdVMFusion(int argc, const char **argv) {
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "on") && strcmp(argv[1], "off"))) {
+		debugPrintf("Shows the number of operations executed as part of the previous one, and optionally turns this on or off.\n");
+		debugPrintf("Usage: %s [on|off]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2)
+		_debugState.fuseInstructions = !strcmp(argv[1], "on");
+
+	debugPrintf("Fusion of operations: %s\n", _debugState.fuseInstructions ? "on" : "off");
+	debugPrintf("Number of executed SCI operations: %d, fused: %d\n", _engine->_gamestate->scriptStepCounter, _engine->_gamestate->fusedStepCounter);
+	return true;
+}
+
 bool Console::cmdScriptObjects(int argc, const char **argv) {
 	int curScriptNr = -1;
 
@@ -22,6 +22,7 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 #ifdef ENABLE_SCI32
@@ -56,10 +57,11 @@ void WorklistManager::push(reg_t reg) {
 
 	debugC(kDebugLevelGC, "[GC] Adding %04x:%04x", PRINT_REG(reg));
 
-	if (_map.contains(reg))
+	bool &known = _map.getOrCreateVal(reg);
+	if (known)
 		return; // already dealt with it
 
-	_map.setVal(reg, true);
+	known = true;
 	_worklist.push_back(reg);
 }
 
@@ -179,17 +181,16 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	return normalizeAddresses(s->_segMan, wm._map);
 }
 
-void run_gc(EngineState *s) {
+/**
+ * Finds the addresses which are not referenced anymore and adds them to the
+ * pending garbage of the segment manager. Scripts are freed right away, as
+ * they may be instantiated again by number.
+ */
+static void findGarbage(EngineState *s) {
+	const uint32 startTime = g_system->getMillis();
 	SegManager *segMan = s->_segMan;
-
-	// Some debug stuff
-	debugC(kDebugLevelGC, "[GC] Running...");
-#ifdef GC_DEBUG_CODE
-	const char *segnames[SEG_TYPE_MAX + 1];
-	int segcount[SEG_TYPE_MAX + 1];
-	memset(segnames, 0, sizeof(segnames));
-	memset(segcount, 0, sizeof(segcount));
-#endif
+	Common::Array<reg_t> &pending = segMan->getPendingGarbage();
+	pending.clear();
 
 	// Compute the set of all segments references currently in use.
 	AddrSet *activeRefs = findAllActiveReferences(s);
@@ -201,30 +202,57 @@ void run_gc(EngineState *s) {
 		SegmentObj *mobj = heap[seg];
 
 		if (mobj != NULL) {
-#ifdef GC_DEBUG_CODE
-			const SegmentType type = mobj->getType();
-			segnames[type] = segmentTypeNames[type];
-#endif
-
 			// Get a list of all deallocatable objects in this segment,
-			// then free any which are not referenced from somewhere.
+			// and queue any which are not referenced from somewhere.
 			const Common::Array<reg_t> tmp = mobj->listAllDeallocatable(seg);
 			for (Common::Array<reg_t>::const_iterator it = tmp.begin(); it != tmp.end(); ++it) {
 				const reg_t addr = *it;
 				if (!activeRefs->contains(addr)) {
-					// Not found -> we can free it
-					mobj->freeAtAddress(segMan, addr);
-					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
-#ifdef GC_DEBUG_CODE
-					segcount[type]++;
-#endif
+					if (mobj->getType() == SEG_TYPE_SCRIPT) {
+						mobj->freeAtAddress(segMan, addr);
+						debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+					} else {
+						pending.push_back(addr);
+					}
 				}
 			}
-
 		}
 	}
 
 	delete activeRefs;
+	s->gcStatistics.collections++;
+	s->gcStatistics.maxSearchPause = MAX(s->gcStatistics.maxSearchPause, g_system->getMillis() - startTime);
+}
+
+/**
+ * Frees at most the given number of addresses of the pending garbage
+ */
+static void freeGarbage(EngineState *s, uint count) {
+	SegManager *segMan = s->_segMan;
+	Common::Array<reg_t> &pending = segMan->getPendingGarbage();
+
+#ifdef GC_DEBUG_CODE
+	const char *segnames[SEG_TYPE_MAX + 1];
+	int segcount[SEG_TYPE_MAX + 1];
+	memset(segnames, 0, sizeof(segnames));
+	memset(segcount, 0, sizeof(segcount));
+#endif
+
+	for (; count && !pending.empty(); count--) {
+		const reg_t addr = pending.back();
+		pending.pop_back();
+
+		// Not found -> we can free it
+		SegmentObj *mobj = segMan->getSegmentObj(addr.getSegment());
+		mobj->freeAtAddress(segMan, addr);
+		debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+		s->gcStatistics.freed++;
+#ifdef GC_DEBUG_CODE
+		const SegmentType type = mobj->getType();
+		segnames[type] = segmentTypeNames[type];
+		segcount[type]++;
+#endif
+	}
 
 #ifdef GC_DEBUG_CODE
 	// Output debug summary of garbage collection
@@ -235,4 +263,35 @@ void run_gc(EngineState *s) {
 #endif
 }
 
+static void updatePauseStatistics(EngineState *s, uint32 startTime) {
+	EngineState::GCStatistics &stats = s->gcStatistics;
+	stats.lastPause = g_system->getMillis() - startTime;
+	stats.maxPause = MAX(stats.maxPause, stats.lastPause);
+	stats.totalPause += stats.lastPause;
+}
+
+void run_gc(EngineState *s) {
+	const uint32 startTime = g_system->getMillis();
+
+	// Some debug stuff
+	debugC(kDebugLevelGC, "[GC] Running...");
+
+	findGarbage(s);
+	freeGarbage(s, s->_segMan->getPendingGarbage().size());
+	updatePauseStatistics(s, startTime);
+}
+
+void run_gc_deferred_sweep(EngineState *s) {
+	const uint32 startTime = g_system->getMillis();
+
+	if (s->_segMan->getPendingGarbage().empty()) {
+		debugC(kDebugLevelGC, "[GC] Running with a deferred sweep...");
+		findGarbage(s);
+	}
+
+	freeGarbage(s, kGCSweepSize);
+	s->gcStatistics.sweeps++;
+	updatePauseStatistics(s, startTime);
+}
+
 } // End of namespace Sci
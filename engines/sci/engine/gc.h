@@ -55,6 +55,20 @@ AddrSet *findAllActiveReferences(EngineState *s);
  */
 void run_gc(EngineState *s);
 
+/**
+ * Runs garbage collection with a deferred sweep. When there is no pending
+ * garbage, all unreachable addresses are searched for in one go, and queued
+ * in the segment manager. Each call then frees at most kGCSweepSize of them.
+ * Only the freeing is spread over several calls: the search still takes as
+ * long as with run_gc().
+ * @param s The state in which we should gc
+ */
+void run_gc_deferred_sweep(EngineState *s);
+
+enum {
+	kGCSweepSize = 256
+};
+
 struct WorklistManager {
 	Common::Array<reg_t> _worklist;
 	AddrSet _map;	// used for 2 contains() calls, inside push() and run_gc()
@@ -73,6 +73,9 @@ void Script::freeScript(const bool keepLocalsSegment) {
 	_offsetLookupObjectCount = 0;
 	_offsetLookupStringCount = 0;
 	_offsetLookupSaidCount = 0;
+
+	_decodedInstructions.clear();
+	_decodedIndex.clear();
 }
 
 enum {
@@ -929,6 +932,46 @@ SciSpan<const byte> Script::findBlockSCI0(ScriptObjectTypes type, bool findLastB
 	return foundBlock;
 }
 
+const DecodedInstruction &Script::decodeInstruction(uint32 offset) {
+	if (_decodedIndex.empty())
+		_decodedIndex.resize(_buf->size());
+
+	uint16 index = _decodedIndex[offset];
+	if (index != 0 && index != kInsideInstruction) {
+		const DecodedInstruction &cached = _decodedInstructions[index - 1];
+		if (!memcmp(cached.bytes, getBuf(offset), cached.size))
+			return cached;
+
+		// Other instructions may overlap the modified bytes now
+		_decodedInstructions.clear();
+		_decodedIndex.clear();
+		_decodedIndex.resize(_buf->size());
+		index = 0;
+	}
+
+	DecodedInstruction instruction;
+	instruction.size = readPMachineInstruction(getBuf(offset), instruction.extOpcode, instruction.params);
+	assert(instruction.size <= DecodedInstruction::kMaxSize);
+	memcpy(instruction.bytes, getBuf(offset), instruction.size);
+
+	// Jumps into the operands of another instruction (which Sierra's compiler
+	// never generates) and scripts with too many instructions are not cached
+	if (index == kInsideInstruction || offset + instruction.size > _decodedIndex.size() ||
+		_decodedInstructions.size() >= kInsideInstruction - 1) {
+		_uncachedInstruction = instruction;
+		return _uncachedInstruction;
+	}
+
+	_decodedInstructions.push_back(instruction);
+	_decodedIndex[offset] = _decodedInstructions.size();
+	for (uint32 i = offset + 1; i < offset + instruction.size; ++i) {
+		if (_decodedIndex[i] == 0)
+			_decodedIndex[i] = kInsideInstruction;
+	}
+
+	return _decodedInstructions.back();
+}
+
 // memory operations
 
 bool Script::isValidOffset(uint32 offset) const {
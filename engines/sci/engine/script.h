@@ -69,6 +69,18 @@ struct offsetLookupArrayEntry {
 
 typedef Common::Array<offsetLookupArrayEntry> offsetLookupArrayType;
 
+/** A script instruction, as returned by readPMachineInstruction() */
+struct DecodedInstruction {
+	enum {
+		kMaxSize = 8
+	};
+
+	int16 params[4];
+	uint16 size;
+	byte extOpcode;
+	byte bytes[kMaxSize]; /**< The bytes the instruction was decoded from */
+};
+
 class Script : public SegmentObj {
 private:
 	int _nr; /**< Script number */
@@ -102,6 +114,19 @@ private:
 	uint16 _offsetLookupStringCount;
 	uint16 _offsetLookupSaidCount;
 
+	/**
+	 * Instructions decoded by the VM, indexed by the entries of
+	 * _decodedIndex (one per byte of the script buffer, 0 for bytes which
+	 * have not been decoded yet and kInsideInstruction for the operands)
+	 */
+	Common::Array<DecodedInstruction> _decodedInstructions;
+	Common::Array<uint16> _decodedIndex;
+	DecodedInstruction _uncachedInstruction;
+
+	enum {
+		kInsideInstruction = 0xFFFF
+	};
+
 public:
 	int getLocalsOffset() const { return _localsOffset; }
 	uint16 getLocalsCount() const { return _localsCount; }
@@ -120,6 +145,15 @@ public:
 	const byte *getBuf(uint offset = 0) const { return _buf->getUnsafeDataAt(offset); }
 	SciSpan<const byte> getSpan(uint offset) const { return _buf->subspan(offset); }
 
+	/**
+	 * Decodes the instruction at the given offset of the script buffer.
+	 * Instructions are only decoded the first time they are executed, the
+	 * following calls return the cached result. The code may be written to
+	 * through dereference(), so the cache is dropped when the bytes of an
+	 * instruction have changed since it was decoded.
+	 */
+	const DecodedInstruction &decodeInstruction(uint32 offset);
+
 	int getScriptNumber() const { return _nr; }
 	SegmentId getLocalsSegment() const { return _localsSegment; }
 	reg_t *getLocalsBegin() { return _localsBlock ? _localsBlock->_locals.begin() : NULL; }
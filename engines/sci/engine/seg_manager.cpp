@@ -63,6 +63,7 @@ void SegManager::resetSegMan() {
 	}
 
 	_heap.clear();
+	_pendingGarbage.clear();
 
 	// And reinitialize
 	_heap.push_back(0);
@@ -164,6 +165,8 @@ void SegManager::deallocate(SegmentId seg) {
 	if (!mobj)
 		error("Attempt to deallocate an already freed segment");
 
+	cancelPendingGarbage(make_reg(actualSegment, 0), true);
+
 	if (mobj->getType() == SEG_TYPE_SCRIPT) {
 		Script *scr = (Script *)mobj;
 		_scriptSegMap.erase(scr->getScriptNumber());
@@ -184,6 +187,18 @@ void SegManager::deallocate(SegmentId seg) {
 	_heap[actualSegment] = NULL;
 }
 
+void SegManager::cancelPendingGarbage(reg_t addr, bool wholeSegment) {
+	for (uint i = 0; i < _pendingGarbage.size(); ) {
+		const reg_t &pending = _pendingGarbage[i];
+		if (pending.getSegment() == addr.getSegment() && (wholeSegment || pending.getOffset() == addr.getOffset())) {
+			_pendingGarbage[i] = _pendingGarbage.back();
+			_pendingGarbage.pop_back();
+		} else {
+			++i;
+		}
+	}
+}
+
 bool SegManager::isHeapObject(reg_t pos) const {
 	const Object *obj = getObject(pos);
 	if (obj == NULL || (obj && obj->isFreed()))
@@ -928,6 +943,7 @@ void SegManager::freeArray(reg_t addr) {
 	if (!arrayTable.isValidEntry(addr.getOffset()))
 		error("Attempt to use non-array %04x:%04x as array", PRINT_REG(addr));
 
+	cancelPendingGarbage(addr);
 	arrayTable.freeEntry(addr.getOffset());
 }
 
@@ -979,6 +995,7 @@ void SegManager::freeBitmap(const reg_t addr) {
 	if (!bitmapTable.isValidEntry(addr.getOffset()))
 		error("Attempt to free invalid entry %04x:%04x as bitmap", PRINT_REG(addr));
 
+	cancelPendingGarbage(addr);
 	bitmapTable.freeEntry(addr.getOffset());
 }
 
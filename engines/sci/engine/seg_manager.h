@@ -458,8 +458,16 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	/**
+	 * Returns the addresses which the garbage collector has found to be
+	 * unreachable, but has not freed yet. Addresses which are freed
+	 * explicitly in the meantime are removed from it.
+	 */
+	Common::Array<reg_t> &getPendingGarbage() { return _pendingGarbage; }
+
 private:
 	Common::Array<SegmentObj *> _heap;
+	Common::Array<reg_t> _pendingGarbage;
 	Common::Array<Class> _classTable; /**< Table of all classes */
 	/** Map script ids to segment ids. */
 	Common::HashMap<int, SegmentId> _scriptSegMap;
@@ -486,6 +494,13 @@ public:
 
 private:
 	void deallocate(SegmentId seg);
+
+	/**
+	 * Removes an address, or all the addresses in its segment, from the
+	 * pending garbage, so that an entry reallocated after being freed
+	 * explicitly does not get freed by the garbage collector
+	 */
+	void cancelPendingGarbage(reg_t addr, bool wholeSegment = false);
 	void createClassTable();
 
 	SegmentId findFreeSegment() const;
@@ -82,6 +82,7 @@ void EngineState::reset(bool isRestoring) {
 		_memorySegmentSize = 0;
 		_fileHandles.resize(5);
 		abortScriptProcessing = kAbortNone;
+		memset(&gcStatistics, 0, sizeof(gcStatistics));
 	} else {
 		g_sci->_guestAdditions->reset();
 	}
@@ -119,6 +120,7 @@ void EngineState::reset(bool isRestoring) {
 	_cursorWorkaroundActive = false;
 
 	scriptStepCounter = 0;
+	fusedStepCounter = 0;
 	scriptGCInterval = GC_INTERVAL;
 }
 
@@ -177,6 +177,7 @@ public:
 	int16 gameIsRestarting; // is set when restarting (=1) or restoring the game (=2)
 
 	int scriptStepCounter; // Counts the number of steps executed
+	int fusedStepCounter; // Counts the steps executed as part of the previous one
 	int scriptGCInterval; // Number of steps in between gcs
 
 	uint16 currentRoomNumber() const;
@@ -195,6 +196,17 @@ public:
 
 	int gcCountDown; /**< Number of kernel calls until next gc */
 
+	/** Statistics of the garbage collector */
+	struct GCStatistics {
+		uint32 collections; ///< Number of searches for unreachable addresses
+		uint32 sweeps; ///< Number of runs with a deferred sweep
+		uint32 freed; ///< Number of freed addresses
+		uint32 maxSearchPause; ///< Duration of the longest search, in milliseconds
+		uint32 lastPause; ///< Duration of the last run, in milliseconds
+		uint32 maxPause; ///< Duration of the longest run, in milliseconds
+		uint32 totalPause; ///< Duration of all runs, in milliseconds
+	} gcStatistics;
+
 	MessageState *_msgState;
 
 	// MemorySegment provides access to a 256-byte block of memory that remains
@@ -570,6 +570,89 @@ uint32 findOffset(const int16 relOffset, const Script *scr, const uint32 pcOffse
 	return offset;
 }
 
+/**
+ * Lets the debugger console open and checks the stack, before each
+ * instruction, whether it is fused or not.
+ */
+static void checkBeforeInstruction(EngineState *s) {
+	g_sci->getSciDebugger()->onFrame();
+
+	if (s->xs->sp < s->xs->fp)
+		error("run_vm(): stack underflow, sp: %04x:%04x, fp: %04x:%04x",
+		PRINT_REG(*s->xs->sp), PRINT_REG(*s->xs->fp));
+
+	s->variablesMax[VAR_TEMP] = s->xs->sp - s->xs->fp;
+}
+
+/**
+ * Returns whether the instruction at the program counter can be executed as
+ * part of the previous one, i.e. without the hook and breakpoint checks done
+ * before each instruction. Nothing is fused while the debugger is in use.
+ */
+static bool canFuseInstruction(EngineState *s, const Script *scr, const VmHooks &vmHooks) {
+	return g_sci->_debugState.fuseInstructions && !vmHooks.hasHooks() &&
+		!g_sci->_debugState.debugging && !g_sci->getSciDebugger()->isActive() &&
+		!(g_sci->_debugState._activeBreakpointTypes & BREAK_ADDRESS) &&
+		s->xs->addr.pc.getOffset() < scr->getBufSize();
+}
+
+/** Starts executing an instruction as part of the previous one. */
+static void beginFusedInstruction(EngineState *s) {
+	g_sci->_debugState.old_pc_offset = s->xs->addr.pc.getOffset();
+	g_sci->_debugState.old_sp = s->xs->sp;
+	checkBeforeInstruction(s);
+}
+
+/** Ends an instruction executed as part of the previous one. */
+static void endFusedInstruction(EngineState *s, const DecodedInstruction &instruction) {
+	s->xs->addr.pc.incOffset(instruction.size);
+	++s->scriptStepCounter;
+	++s->fusedStepCounter;
+}
+
+/**
+ * Executes the push immediate instructions following the current one. Such
+ * chains are used to pass the selectors and parameters of sends.
+ */
+static void fusePushImmediates(EngineState *s, Script *scr, const VmHooks &vmHooks) {
+	while (canFuseInstruction(s, scr, vmHooks)) {
+		// Copied, as the debugger may drop the cache of the script
+		const DecodedInstruction instruction = scr->decodeInstruction(s->xs->addr.pc.getOffset());
+		const byte opcode = instruction.extOpcode >> 1;
+		if (opcode != op_pushi && opcode != op_push0 && opcode != op_push1 && opcode != op_push2)
+			return;
+
+		beginFusedInstruction(s);
+		PUSH(opcode == op_pushi ? instruction.params[0] : opcode - op_push0);
+		endFusedInstruction(s, instruction);
+	}
+}
+
+/**
+ * Executes a conditional branch following a load immediate, as generated for
+ * loops with constant conditions.
+ */
+static void fuseBranch(EngineState *s, Script *scr, const Script *local_script, const VmHooks &vmHooks) {
+	if (!canFuseInstruction(s, scr, vmHooks))
+		return;
+
+	const DecodedInstruction instruction = scr->decodeInstruction(s->xs->addr.pc.getOffset());
+	const byte opcode = instruction.extOpcode >> 1;
+	if (opcode != op_bt && opcode != op_bnt)
+		return;
+
+	beginFusedInstruction(s);
+	endFusedInstruction(s, instruction);
+
+	if ((s->r_acc.getOffset() || s->r_acc.getSegment()) == (opcode == op_bt))
+		s->xs->addr.pc.incOffset(instruction.params[0]);
+
+	if (s->xs->addr.pc.getOffset() >= local_script->getScriptSize())
+		error("[VM] %s: request to jump past the end of script %d (offset %d, script is %d bytes)",
+			opcode == op_bt ? "op_bt" : "op_bnt", local_script->getScriptNumber(),
+			s->xs->addr.pc.getOffset(), local_script->getScriptSize());
+}
+
 void run_vm(EngineState *s) {
 	assert(s);
 
@@ -649,14 +732,7 @@ void run_vm(EngineState *s) {
 			g_sci->scriptDebug();
 			g_sci->_debugState.breakpointWasHit = false;
 		}
-		Console *con = g_sci->getSciDebugger();
-		con->onFrame();
-
-		if (s->xs->sp < s->xs->fp)
-			error("run_vm(): stack underflow, sp: %04x:%04x, fp: %04x:%04x",
-			PRINT_REG(*s->xs->sp), PRINT_REG(*s->xs->fp));
-
-		s->variablesMax[VAR_TEMP] = s->xs->sp - s->xs->fp;
+		checkBeforeInstruction(s);
 
 		if (s->xs->addr.pc.getOffset() >= scr->getBufSize())
 			error("run_vm(): program counter gone astray, addr: %d, code buffer size: %d",
@@ -664,9 +740,12 @@ void run_vm(EngineState *s) {
 
 		// Get opcode
 		byte extOpcode;
-		if (!vmHooks.isActive(s))
-			s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
-		else {
+		if (!vmHooks.isActive(s)) {
+			const DecodedInstruction &instruction = scr->decodeInstruction(s->xs->addr.pc.getOffset());
+			extOpcode = instruction.extOpcode;
+			memcpy(opparams, instruction.params, sizeof(instruction.params));
+			s->xs->addr.pc.incOffset(instruction.size);
+		} else {
 			int offset = readPMachineInstruction(vmHooks.data(), extOpcode, opparams);
 			vmHooks.advance(offset);
 		}
@@ -847,6 +926,7 @@ void run_vm(EngineState *s) {
 		case op_ldi: // 0x1a (26)
 			// Load data immediate
 			s->r_acc = make_reg(0, opparams[0]);
+			fuseBranch(s, scr, local_script, vmHooks);
 			break;
 
 		case op_push: // 0x1b (27)
@@ -857,6 +937,7 @@ void run_vm(EngineState *s) {
 		case op_pushi: // 0x1c (28)
 			// Push immediate
 			PUSH(opparams[0]);
+			fusePushImmediates(s, scr, vmHooks);
 			break;
 
 		case op_toss: // 0x1d (29)
@@ -906,10 +987,13 @@ void run_vm(EngineState *s) {
 		}
 
 		case op_callk: { // 0x21 (33)
-			// Run the garbage collector, if needed
-			if (s->gcCountDown-- <= 0) {
+			// Run the garbage collector, if needed. The garbage found by a
+			// run is freed in parts by the following kernel calls.
+			if (!s->_segMan->getPendingGarbage().empty()) {
+				run_gc_deferred_sweep(s);
+			} else if (s->gcCountDown-- <= 0) {
 				s->gcCountDown = s->scriptGCInterval;
-				run_gc(s);
+				run_gc_deferred_sweep(s);
 			}
 
 			// Call kernel function
@@ -1269,14 +1353,17 @@ void run_vm(EngineState *s) {
 
 		case op_push0: // 0x3b (59)
 			PUSH(0);
+			fusePushImmediates(s, scr, vmHooks);
 			break;
 
 		case op_push1: // 0x3c (60)
 			PUSH(1);
+			fusePushImmediates(s, scr, vmHooks);
 			break;
 
 		case op_push2: // 0x3d (61)
 			PUSH(2);
+			fusePushImmediates(s, scr, vmHooks);
 			break;
 
 		case op_pushSelf: // 0x3e (62)
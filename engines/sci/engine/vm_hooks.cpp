@@ -179,6 +179,9 @@ bool hook_exec_match(Sci::EngineState *s, HookEntry entry) {
 }
 
 void VmHooks::vm_hook_before_exec(Sci::EngineState *s) {
+	if (_hooksMap.empty())
+		return;
+
 	if (_just_finished) {
 		_just_finished = false;
 		_lastPc = NULL_REG;
@@ -83,6 +83,9 @@ public:
 
 	bool isActive(Sci::EngineState *s);
 
+	/** Returns whether the game has any hooks */
+	bool hasHooks() const { return !_hooksMap.empty(); }
+
 	void advance(int offset);
 
 private:
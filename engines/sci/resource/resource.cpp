@@ -22,9 +22,11 @@
 
 // Resource library
 
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
 #ifdef ENABLE_SCI32
@@ -214,6 +216,7 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : SciSpan<const byte>
 	_source = nullptr;
 	_header = nullptr;
 	_headerSize = 0;
+	_loadCost = 0;
 }
 
 Resource::~Resource() {
@@ -423,10 +426,15 @@ void ResourceManager::disposeVolumeFileStream(Common::SeekableReadStream *fileSt
 }
 
 void ResourceManager::loadResource(Resource *res) {
+	// Only decompress() knows the cost of loading the resource, and the
+	// source may have changed since it was last loaded, e.g. to a patch file
+	res->_loadCost = 0;
 	res->_source->loadResource(this, res);
 	if (_patcher) {
 		_patcher->applyPatch(*res);
 	};
+	if (!res->_loadCost)
+		res->_loadCost = res->size();
 }
 
 
@@ -993,6 +1001,7 @@ void ResourceManager::init() {
 	_memoryLocked = 0;
 	_memoryLRU = 0;
 	_LRU.clear();
+	resetCacheStatistics();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 #ifdef ENABLE_SCI32
@@ -1066,6 +1075,14 @@ void ResourceManager::init() {
 		_maxMemoryLRU = 4096 * 1024; // 4MiB
 	}
 
+	// The budget may be raised for systems with plenty of memory, which
+	// saves decompressing the resources of recently visited rooms again
+	if (ConfMan.hasKey("sci_resource_cache_size")) {
+		const int size = ConfMan.getInt("sci_resource_cache_size");
+		if (size > 0)
+			_maxMemoryLRU = MIN<int>(size, kMaxCacheBudgetKiB) * 1024;
+	}
+
 	switch (_viewType) {
 	case kViewEga:
 		debugC(1, kDebugLevelResMan, "resMan: Detected EGA graphic resources");
@@ -1112,7 +1129,7 @@ void ResourceManager::removeFromLRU(Resource *res) {
 		warning("resMan: trying to remove resource that isn't enqueued");
 		return;
 	}
-	_LRU.remove(res);
+	_LRU.erase(res->_lruPosition);
 	_memoryLRU -= res->size();
 	res->_status = kResStatusAllocated;
 }
@@ -1123,6 +1140,7 @@ void ResourceManager::addToLRU(Resource *res) {
 		return;
 	}
 	_LRU.push_front(res);
+	res->_lruPosition = _LRU.begin();
 	_memoryLRU += res->size();
 #if SCI_VERBOSE_RESMAN
 	debug("Adding %s (%d bytes) to lru control: %d bytes total",
@@ -1150,11 +1168,24 @@ void ResourceManager::printLRU() {
 }
 
 void ResourceManager::freeOldResources() {
+	// Among the few least recently used resources, free first the one which
+	// costs the least to load again for the memory it frees. Loading costs
+	// the bytes read, plus the bytes decompressed for compressed resources.
+	enum { kEvictionCandidates = 4 };
+
 	while (_maxMemoryLRU < _memoryLRU) {
 		assert(!_LRU.empty());
-		Resource *goner = _LRU.back();
+		Common::List<Resource *>::iterator it = _LRU.end();
+		Resource *goner = *--it;
+		for (int i = 1; i < kEvictionCandidates && it != _LRU.begin(); ++i) {
+			Resource *candidate = *--it;
+			if ((uint64)candidate->_loadCost * goner->size() < (uint64)goner->_loadCost * candidate->size())
+				goner = candidate;
+		}
+
 		removeFromLRU(goner);
 		goner->unalloc();
+		_cacheStatistics.evictions++;
 #ifdef SCI_VERBOSE_RESMAN
 		debug("resMan-debug: LRU: Freeing %s (%d bytes)", goner->_id.toString().c_str(), goner->size);
 #endif
@@ -1197,15 +1228,22 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	if (retval->_status == kResStatusNoMalloc) {
+		const uint32 start = g_system->getMillis();
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
-		// The resource is removed from its current position
-		// in the LRU list because it has been requested
-		// again. Below, it will either be locked, or it
-		// will be added back to the LRU list at the 'most
-		// recent' position.
-		removeFromLRU(retval);
+		_cacheStatistics.loadMillis += g_system->getMillis() - start;
+		_cacheStatistics.misses++;
+	} else {
+		_cacheStatistics.hits++;
+
+		if (retval->_status == kResStatusEnqueued)
+			// The resource is removed from its current position
+			// in the LRU list because it has been requested
+			// again. Below, it will either be locked, or it
+			// will be added back to the LRU list at the 'most
+			// recent' position.
+			removeFromLRU(retval);
+	}
 
 	// Unless an error occurred, the resource is now either
 	// locked or allocated, but never queued or freed.
@@ -1249,6 +1287,18 @@ void ResourceManager::unlockResource(Resource *res) {
 	freeOldResources();
 }
 
+void ResourceManager::resetCacheStatistics() {
+	_cacheStatistics.hits = 0;
+	_cacheStatistics.misses = 0;
+	_cacheStatistics.evictions = 0;
+	_cacheStatistics.loadMillis = 0;
+}
+
+void ResourceManager::setCacheBudgetKiB(uint32 kiB) {
+	_maxMemoryLRU = MIN<uint32>(kiB, kMaxCacheBudgetKiB) * 1024;
+	freeOldResources();
+}
+
 const char *ResourceManager::versionDescription(ResVersion version) const {
 	switch (version) {
 	case kResVersionUnknown:
@@ -2226,6 +2276,9 @@ Resource *ResourceManager::updateResource(ResourceId resId, ResourceSource *src,
 		if (res == nullptr) {
 			res = new Resource(this, resId);
 			_resMap.setVal(resId, res);
+		} else if (res->_status == kResStatusEnqueued) {
+			removeFromLRU(res);
+			res->unalloc();
 		}
 
 		res->_status = kResStatusNoMalloc;
@@ -2384,6 +2437,7 @@ int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file
 	byte *ptr = new byte[_size];
 	_data = ptr;
 	_status = kResStatusAllocated;
+	_loadCost = szPacked + (compression != kCompNone ? _size : 0);
 	errorNum = ptr ? dec->unpack(file, ptr, szPacked, _size) : SCI_ERROR_RESOURCE_TOO_BIG;
 	if (errorNum) {
 		unalloc();
@@ -300,6 +300,8 @@ protected:
 	uint16 _lockers; /**< Number of places where this resource was locked */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
+	uint32 _loadCost; /**< Bytes read and decompressed when the resource was last loaded */
+	Common::List<Resource *>::iterator _lruPosition; /**< Position in the LRU list, while enqueued */
 
 	bool loadPatch(Common::SeekableReadStream *file);
 	bool loadFromPatchFile();
@@ -369,6 +371,32 @@ public:
 	 */
 	void unlockResource(Resource *res);
 
+	struct CacheStatistics {
+		uint32 hits;       ///< Requests for resources which were already loaded
+		uint32 misses;     ///< Requests for resources which had to be loaded
+		uint32 evictions;  ///< Unlocked resources freed to stay within the budget
+		uint32 loadMillis; ///< Time spent loading and decompressing resources
+	};
+
+	const CacheStatistics &getCacheStatistics() const { return _cacheStatistics; }
+	void resetCacheStatistics();
+
+	enum {
+		/** Upper bound of the cache budget, so that it fits in an int */
+		kMaxCacheBudgetKiB = 1024 * 1024
+	};
+
+	/**
+	 * Sets the number of KiB which unlocked resources may use before the
+	 * least recently used ones are freed. The budget is limited to
+	 * kMaxCacheBudgetKiB.
+	 */
+	void setCacheBudgetKiB(uint32 kiB);
+	int getCacheBudget() const { return _maxMemoryLRU; }
+	int getCacheMemory() const { return _memoryLRU; }
+	int getLockedMemory() const { return _memoryLocked; }
+	uint getCacheSize() const { return _LRU.size(); }
+
 	/**
 	 * Tests whether a resource exists.
 	 *
@@ -490,6 +518,7 @@ protected:
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
 	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	CacheStatistics _cacheStatistics;
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -97,6 +97,7 @@ ScummDebugger::ScummDebugger(ScummEngine *s)
 	registerCmd("imuse",     WRAP_METHOD(ScummDebugger, Cmd_IMuse));
 
 	registerCmd("resetcursors",    WRAP_METHOD(ScummDebugger, Cmd_ResetCursors));
+	registerCmd("stripcache",      WRAP_METHOD(ScummDebugger, Cmd_StripCache));
 }
 
 ScummDebugger::~ScummDebugger() {
@@ -845,4 +846,17 @@ bool ScummDebugger::Cmd_ResetCursors(int argc, const char **argv) {
 	return false;
 }
 
+bool ScummDebugger::Cmd_StripCache(int argc, const char **argv) {
+	if (argc > 1 && !strcmp(argv[1], "clear")) {
+		_vm->_gdi->clearStripCache();
+		debugPrintf("Decoded room strips cleared\n");
+		return true;
+	}
+
+	uint32 hits, misses, memory;
+	_vm->_gdi->getStripCacheStatistics(hits, misses, memory);
+	debugPrintf("Decoded room strips: %u bytes, %u hits, %u misses - use 'stripcache clear' to drop them\n", memory, hits, misses);
+	return true;
+}
+
 } // End of namespace Scumm
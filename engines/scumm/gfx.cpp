@@ -215,6 +215,13 @@ Gdi::Gdi(ScummEngine *vm) : _vm(vm) {
 	_zbufferDisabled = false;
 	_objectMode = false;
 	_distaff = false;
+
+	_stripCacheImage = 0;
+	memset(_stripCachePalette, 0, sizeof(_stripCachePalette));
+	_stripCacheEnabled = false;
+	_stripCacheMemory = 0;
+	_stripCacheHits = 0;
+	_stripCacheMisses = 0;
 }
 
 Gdi::~Gdi() {
@@ -272,9 +279,15 @@ void Gdi::init() {
 		// the backbuf (thus we have to treat the right border seperately).
 		_numStrips += 1;
 	}
+
+	// Only the strips of the generic renderer are cached
+	_stripCacheEnabled = (_vm->_game.version >= 3 && _vm->_game.heversion == 0 &&
+		_vm->_game.platform != Common::kPlatformNES && !(_vm->_game.features & GF_16BIT_COLOR));
+	clearStripCache();
 }
 
 void Gdi::roomChanged(byte *roomptr) {
+	clearStripCache();
 }
 
 void GdiNES::roomChanged(byte *roomptr) {
@@ -1021,7 +1034,7 @@ void ScummEngine::redrawBGStrip(int start, int num) {
 	else
 		room = getResourceAddress(rtRoom, _roomResource);
 
-	_gdi->drawBitmap(room + _IM00_offs, &_virtscr[kMainVirtScreen], s, 0, _roomWidth, _virtscr[kMainVirtScreen].h, s, num, 0);
+	_gdi->drawBitmap(room + _IM00_offs, &_virtscr[kMainVirtScreen], s, 0, _roomWidth, _virtscr[kMainVirtScreen].h, s, num, Gdi::dbRoomBackground);
 }
 
 void ScummEngine::restoreBackground(Common::Rect rect, byte backColor) {
@@ -1861,7 +1874,18 @@ void Gdi::drawBitmap(const byte *ptr, VirtScreen *vs, int x, const int y, const
 		else
 			dstPtr = (byte *)vs->getBasePtr(x * 8, y);
 
-		transpStrip = drawStrip(dstPtr, vs, x, y, width, height, stripnr, smap_ptr);
+		// Room background strips are only decoded once
+		DecodedStrip *decodedStrip = 0;
+		if (flag & dbRoomBackground)
+			decodedStrip = findDecodedStrip(ptr, stripnr, y, height, numzbuf);
+		const bool cached = decodedStrip && decodedStrip->state == DecodedStrip::kDecoded;
+
+		bool transparent = false;
+		if (cached)
+			restoreDecodedStrip(*decodedStrip, dstPtr, vs, x, y, zplane_list);
+		else
+			transparent = drawStrip(dstPtr, vs, x, y, width, height, stripnr, smap_ptr);
+		transpStrip = transparent;
 
 		// COMI and HE games only uses flag value
 		if (_vm->_game.version == 8 || _vm->_game.heversion >= 60)
@@ -1875,7 +1899,11 @@ void Gdi::drawBitmap(const byte *ptr, VirtScreen *vs, int x, const int y, const
 				clear8Col(frontBuf, vs->pitch, height, vs->format.bytesPerPixel);
 		}
 
-		decodeMask(x, y, width, height, stripnr, numzbuf, zplane_list, transpStrip, flag);
+		if (!cached) {
+			decodeMask(x, y, width, height, stripnr, numzbuf, zplane_list, transpStrip, flag);
+			if (decodedStrip)
+				storeDecodedStrip(*decodedStrip, dstPtr, vs, x, y, height, numzbuf, zplane_list, transparent);
+		}
 
 #if 0
 		// HACK: blit mask(s) onto normal screen. Useful to debug masking
@@ -1978,6 +2006,98 @@ bool GdiV2::drawStrip(byte *dstPtr, VirtScreen *vs, int x, int y, const int widt
 	return false;
 }
 
+Gdi::DecodedStrip *Gdi::findDecodedStrip(const byte *ptr, int stripnr, int y, int height, int numzbuf) {
+	if (!_stripCacheEnabled)
+		return 0;
+
+	// The strips depend on the room palette, which is applied while decoding
+	if (ptr != _stripCacheImage || memcmp(_stripCachePalette, _vm->_roomPalette, sizeof(_stripCachePalette))) {
+		clearStripCache();
+		_stripCacheImage = ptr;
+		memcpy(_stripCachePalette, _vm->_roomPalette, sizeof(_stripCachePalette));
+	}
+
+	if ((uint)stripnr >= _stripCache.size())
+		_stripCache.resize(stripnr + 1);
+
+	DecodedStrip &strip = _stripCache[stripnr];
+	if (strip.state != DecodedStrip::kNotDecoded &&
+		(strip.y != y || strip.height != height || strip.numzbuf != numzbuf)) {
+		_stripCacheMemory -= strip.pixels.size() + strip.masks.size();
+		strip = DecodedStrip();
+	}
+
+	if (strip.state == DecodedStrip::kDecoded)
+		_stripCacheHits++;
+	else
+		_stripCacheMisses++;
+
+	return &strip;
+}
+
+void Gdi::storeDecodedStrip(DecodedStrip &strip, const byte *dstPtr, VirtScreen *vs, int x, int y, int height,
+	                int numzbuf, const byte *zplane_list[9], bool transparent) {
+	strip.y = y;
+	strip.height = height;
+	strip.numzbuf = numzbuf;
+
+	if (transparent) {
+		strip.state = DecodedStrip::kTransparent;
+		return;
+	}
+
+	const int lineSize = 8 * vs->format.bytesPerPixel;
+	strip.pixels.resize(lineSize * height);
+	for (int h = 0; h < height; h++)
+		memcpy(&strip.pixels[h * lineSize], dstPtr + h * vs->pitch, lineSize);
+
+	// Planes without data are left alone by decodeMask()
+	if (numzbuf > 1) {
+		strip.masks.resize((numzbuf - 1) * height);
+		for (int i = 1; i < numzbuf; i++) {
+			if (!zplane_list[i])
+				continue;
+
+			const byte *mask_ptr = getMaskBuffer(x, y, i);
+			byte *dst = &strip.masks[(i - 1) * height];
+			for (int h = 0; h < height; h++)
+				dst[h] = mask_ptr[h * _numStrips];
+		}
+	}
+
+	_stripCacheMemory += strip.pixels.size() + strip.masks.size();
+	strip.state = DecodedStrip::kDecoded;
+}
+
+void Gdi::restoreDecodedStrip(const DecodedStrip &strip, byte *dstPtr, VirtScreen *vs, int x, int y,
+	                const byte *zplane_list[9]) {
+	const int lineSize = 8 * vs->format.bytesPerPixel;
+	for (int h = 0; h < strip.height; h++)
+		memcpy(dstPtr + h * vs->pitch, &strip.pixels[h * lineSize], lineSize);
+
+	for (int i = 1; i < strip.numzbuf; i++) {
+		if (!zplane_list[i])
+			continue;
+
+		byte *mask_ptr = getMaskBuffer(x, y, i);
+		const byte *src = &strip.masks[(i - 1) * strip.height];
+		for (int h = 0; h < strip.height; h++)
+			mask_ptr[h * _numStrips] = src[h];
+	}
+}
+
+void Gdi::clearStripCache() {
+	_stripCache.clear();
+	_stripCacheImage = 0;
+	_stripCacheMemory = 0;
+}
+
+void Gdi::getStripCacheStatistics(uint32 &hits, uint32 &misses, uint32 &memory) const {
+	hits = _stripCacheHits;
+	misses = _stripCacheMisses;
+	memory = _stripCacheMemory;
+}
+
 void Gdi::decodeMask(int x, int y, const int width, const int height,
 	                int stripnr, int numzbuf, const byte *zplane_list[9],
 	                bool transpStrip, byte flag) {
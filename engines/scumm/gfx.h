@@ -24,6 +24,7 @@
 #define SCUMM_GFX_H
 
 #include "common/system.h"
+#include "common/array.h"
 #include "common/list.h"
 
 #include "graphics/surface.h"
@@ -209,6 +210,39 @@ protected:
 	/** Flag which is true when an object is being rendered, false otherwise. */
 	bool _objectMode;
 
+	/**
+	 * A strip of the room background and its z-plane masks, as decoded by
+	 * drawStrip() and decodeMask(). Redrawing the strip, e.g. when scrolling,
+	 * then only copies them.
+	 */
+	struct DecodedStrip {
+		enum State {
+			kNotDecoded,
+			kDecoded,
+			kTransparent ///< Not cached, as its result depends on the previous contents
+		};
+
+		State state;
+		int y, height, numzbuf;
+		Common::Array<byte> pixels;
+		Common::Array<byte> masks;
+
+		DecodedStrip() : state(kNotDecoded), y(0), height(0), numzbuf(0) {}
+	};
+
+	Common::Array<DecodedStrip> _stripCache;
+	const byte *_stripCacheImage;
+	byte _stripCachePalette[256];
+	bool _stripCacheEnabled;
+	uint32 _stripCacheMemory;
+	uint32 _stripCacheHits, _stripCacheMisses;
+
+	DecodedStrip *findDecodedStrip(const byte *ptr, int stripnr, int y, int height, int numzbuf);
+	void storeDecodedStrip(DecodedStrip &strip, const byte *dstPtr, VirtScreen *vs, int x, int y, int height,
+	                int numzbuf, const byte *zplane_list[9], bool transparent);
+	void restoreDecodedStrip(const DecodedStrip &strip, byte *dstPtr, VirtScreen *vs, int x, int y,
+	                const byte *zplane_list[9]);
+
 public:
 	/** Flag which is true when loading objects or titles for distaff, in PCEngine version of Loom. */
 	bool _distaff;
@@ -279,10 +313,15 @@ public:
 
 	void resetBackground(int top, int bottom, int strip);
 
+	/** Drops the decoded strips of the room background */
+	void clearStripCache();
+	void getStripCacheStatistics(uint32 &hits, uint32 &misses, uint32 &memory) const;
+
 	enum DrawBitmapFlags {
 		dbAllowMaskOr   = 1 << 0,
 		dbDrawMaskOnAll = 1 << 1,
-		dbObjectMode    = 2 << 2
+		dbObjectMode    = 2 << 2,
+		dbRoomBackground = 1 << 4
 	};
 };
 
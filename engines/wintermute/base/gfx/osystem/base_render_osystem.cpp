@@ -34,6 +34,7 @@
 #include "engines/wintermute/math/math_util.h"
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/base_sprite.h"
+#include "engines/wintermute/wintermute.h"
 #include "common/system.h"
 #include "graphics/transparent_surface.h"
 #include "common/queue.h"
@@ -57,7 +58,6 @@ BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame) {
 
 	_borderLeft = _borderRight = _borderTop = _borderBottom = 0;
 	_ratioX = _ratioY = 1.0f;
-	_dirtyRect = nullptr;
 	_disableDirtyRects = false;
 	if (ConfMan.hasKey("dirty_rects")) {
 		_disableDirtyRects = !ConfMan.getBool("dirty_rects");
@@ -75,8 +75,6 @@ BaseRenderOSystem::~BaseRenderOSystem() {
 		delete ticket;
 	}
 
-	delete _dirtyRect;
-
 	_renderSurface->free();
 	delete _renderSurface;
 	_blankSurface->free();
@@ -162,8 +160,7 @@ bool BaseRenderOSystem::forcedFlip() {
 bool BaseRenderOSystem::flip() {
 	if (_skipThisFrame) {
 		_skipThisFrame = false;
-		delete _dirtyRect;
-		_dirtyRect = nullptr;
+		_dirtyRegion.clear();
 		g_system->updateScreen();
 		_needsFlip = false;
 
@@ -202,9 +199,7 @@ bool BaseRenderOSystem::flip() {
 		if (_disableDirtyRects || screenChanged) {
 			g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->pitch, 0, 0, _renderSurface->w, _renderSurface->h);
 		}
-		//  g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
-		delete _dirtyRect;
-		_dirtyRect = nullptr;
+		_dirtyRegion.clear();
 		_needsFlip = false;
 	}
 	_lastFrameIter = _renderQueue.end();
@@ -306,22 +301,10 @@ void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::S
 
 	if (owner) { // Fade-tickets are owner-less
 		RenderTicket compare(owner, nullptr, srcRect, dstRect, transform);
-		RenderQueueIterator it = _lastFrameIter;
-		++it;
-		// Avoid calling end() and operator* every time, when potentially going through
-		// LOTS of tickets.
-		RenderQueueIterator endIterator = _renderQueue.end();
-		RenderTicket *compareTicket = nullptr;
-		for (; it != endIterator; ++it) {
-			compareTicket = *it;
-			if (*(compareTicket) == compare && compareTicket->_isValid) {
-				if (_disableDirtyRects) {
-					drawFromSurface(compareTicket);
-				} else {
-					drawFromQueuedTicket(it);
-				}
-				return;
-			}
+		RenderQueueIterator it;
+		if (findQueuedTicket(compare, it)) {
+			drawFromQueuedTicket(it);
+			return;
 		}
 	}
 	RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, transform);
@@ -341,6 +324,7 @@ void BaseRenderOSystem::invalidateTicket(RenderTicket *renderTicket) {
 }
 
 void BaseRenderOSystem::invalidateTicketsFromSurface(BaseSurfaceOSystem *surf) {
+	_transformCache.invalidate(surf);
 	RenderQueueIterator it;
 	for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
 		if ((*it)->_owner == surf) {
@@ -366,6 +350,7 @@ void BaseRenderOSystem::drawFromTicket(RenderTicket *renderTicket) {
 		--_lastFrameIter;
 		addDirtyRect(renderTicket->_dstRect);
 	}
+	addTicketToIndex(_lastFrameIter);
 }
 
 void BaseRenderOSystem::drawFromQueuedTicket(const RenderQueueIterator &ticket) {
@@ -379,19 +364,65 @@ void BaseRenderOSystem::drawFromQueuedTicket(const RenderQueueIterator &ticket)
 		--_lastFrameIter;
 		// Remove the ticket from the list
 		assert(*_lastFrameIter != renderTicket);
+		removeTicketFromIndex(renderTicket);
 		_renderQueue.erase(ticket);
 		// Is not in order, so readd it as if it was a new ticket
 		drawFromTicket(renderTicket);
 	}
 }
 
-void BaseRenderOSystem::addDirtyRect(const Common::Rect &rect) {
-	if (!_dirtyRect) {
-		_dirtyRect = new Common::Rect(rect);
-	} else {
-		_dirtyRect->extend(rect);
+BaseRenderOSystem::TicketKey::TicketKey(const RenderTicket &ticket) :
+	owner(ticket._owner), x(ticket._dstRect.left), y(ticket._dstRect.top) {
+}
+
+void BaseRenderOSystem::addTicketToIndex(const RenderQueueIterator &ticket) {
+	if (!(*ticket)->_owner)
+		return;
+	IndexedTicket indexed;
+	indexed.ticket = *ticket;
+	indexed.pos = ticket;
+	_ticketIndex[TicketKey(**ticket)].push_back(indexed);
+}
+
+void BaseRenderOSystem::removeTicketFromIndex(const RenderTicket *ticket) {
+	if (!ticket->_owner)
+		return;
+	TicketIndex::iterator i = _ticketIndex.find(TicketKey(*ticket));
+	if (i == _ticketIndex.end())
+		return;
+
+	Common::Array<IndexedTicket> &tickets = i->_value;
+	for (uint j = 0; j < tickets.size(); ++j) {
+		if (tickets[j].ticket == ticket) {
+			tickets.remove_at(j);
+			break;
+		}
+	}
+	if (tickets.empty())
+		_ticketIndex.erase(i);
+}
+
+bool BaseRenderOSystem::findQueuedTicket(const RenderTicket &compare, RenderQueueIterator &ticket) {
+	TicketIndex::iterator i = _ticketIndex.find(TicketKey(compare));
+	if (i == _ticketIndex.end())
+		return false;
+
+	// The tickets which were drawn in this frame already want a draw
+	const Common::Array<IndexedTicket> &tickets = i->_value;
+	for (uint j = 0; j < tickets.size(); ++j) {
+		const RenderTicket *candidate = tickets[j].ticket;
+		if (!candidate->_wantsDraw && candidate->_isValid && *candidate == compare) {
+			ticket = tickets[j].pos;
+			return true;
+		}
 	}
-	_dirtyRect->clip(_renderRect);
+	return false;
+}
+
+void BaseRenderOSystem::addDirtyRect(const Common::Rect &rect) {
+	Common::Rect dirtyRect(rect);
+	dirtyRect.clip(_renderRect);
+	_dirtyRegion.addRect(dirtyRect);
 }
 
 void BaseRenderOSystem::drawTickets() {
@@ -404,13 +435,14 @@ void BaseRenderOSystem::drawTickets() {
 		if ((*it)->_wantsDraw == false) {
 			RenderTicket *ticket = *it;
 			addDirtyRect((*it)->_dstRect);
+			removeTicketFromIndex(ticket);
 			it = _renderQueue.erase(it);
 			delete ticket;
 		} else {
 			++it;
 		}
 	}
-	if (!_dirtyRect || _dirtyRect->width() == 0 || _dirtyRect->height() == 0) {
+	if (_dirtyRegion.isEmpty()) {
 		it = _renderQueue.begin();
 		while (it != _renderQueue.end()) {
 			RenderTicket *ticket = *it;
@@ -420,43 +452,53 @@ void BaseRenderOSystem::drawTickets() {
 		return;
 	}
 
+	const Common::Array<Common::Rect> &dirtyRects = _dirtyRegion.getRects();
+	const Common::Rect &dirtyBounds = _dirtyRegion.getBounds();
+
 	it = _renderQueue.begin();
 	_lastFrameIter = _renderQueue.end();
 	// A special case: If the screen has one giant OPAQUE rect to be drawn, then we skip filling
-	// the background color. Typical use-case: Fullscreen FMVs.
+	// the background color in the dirty rects it covers. Typical use-case: Fullscreen FMVs.
 	// Caveat: The FPS-counter will invalidate this.
+	const RenderTicket *opaqueTicket = nullptr;
 	if (it != _lastFrameIter && _renderQueue.front() == _renderQueue.back() && (*it)->_transform._alphaDisable == true) {
-		// If our single opaque rect fills the dirty rect, we can skip filling.
-		if (*_dirtyRect != (*it)->_dstRect) {
-			// Apply the clear-color to the dirty rect.
-			_renderSurface->fillRect(*_dirtyRect, _clearColor);
+		opaqueTicket = *it;
+	}
+	for (uint i = 0; i < dirtyRects.size(); ++i) {
+		// Apply the clear-color to the dirty rect, unless the opaque rect fills it.
+		if (!opaqueTicket || !opaqueTicket->_dstRect.contains(dirtyRects[i])) {
+			_renderSurface->fillRect(dirtyRects[i], _clearColor);
 		}
-		// Otherwise Do NOT fill.
-	} else {
-		// Apply the clear-color to the dirty rect.
-		_renderSurface->fillRect(*_dirtyRect, _clearColor);
 	}
 	for (; it != _renderQueue.end(); ++it) {
 		RenderTicket *ticket = *it;
-		if (ticket->_dstRect.intersects(*_dirtyRect)) {
-			// dstClip is the area we want redrawn.
-			Common::Rect dstClip(ticket->_dstRect);
-			// reduce it to the dirty rect
-			dstClip.clip(*_dirtyRect);
-			// we need to keep track of the position to redraw the dirty rect
-			Common::Rect pos(dstClip);
-			int16 offsetX = ticket->_dstRect.left;
-			int16 offsetY = ticket->_dstRect.top;
-			// convert from screen-coords to surface-coords.
-			dstClip.translate(-offsetX, -offsetY);
-
-			drawFromSurface(ticket, &pos, &dstClip);
-			_needsFlip = true;
+		if (ticket->_dstRect.intersects(dirtyBounds)) {
+			for (uint i = 0; i < dirtyRects.size(); ++i) {
+				if (!ticket->_dstRect.intersects(dirtyRects[i]))
+					continue;
+				// dstClip is the area we want redrawn.
+				Common::Rect dstClip(ticket->_dstRect);
+				// reduce it to the dirty rect
+				dstClip.clip(dirtyRects[i]);
+				// we need to keep track of the position to redraw the dirty rect
+				Common::Rect pos(dstClip);
+				int16 offsetX = ticket->_dstRect.left;
+				int16 offsetY = ticket->_dstRect.top;
+				// convert from screen-coords to surface-coords.
+				dstClip.translate(-offsetX, -offsetY);
+
+				drawFromSurface(ticket, &pos, &dstClip);
+				_needsFlip = true;
+			}
 		}
 		// Some tickets want redraw but don't actually clip the dirty area (typically the ones that shouldnt become clear-color)
 		ticket->_wantsDraw = false;
 	}
-	g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(_dirtyRect->left, _dirtyRect->top), _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
+	for (uint i = 0; i < dirtyRects.size(); ++i) {
+		const Common::Rect &dirtyRect = dirtyRects[i];
+		g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(dirtyRect.left, dirtyRect.top), _renderSurface->pitch, dirtyRect.left, dirtyRect.top, dirtyRect.width(), dirtyRect.height());
+	}
+	debugC(kWintermuteDebugRender, "BaseRenderOSystem::drawTickets - Redrew %u pixels in %u rects", _dirtyRegion.getArea(), dirtyRects.size());
 
 	it = _renderQueue.begin();
 	// Clean out the old tickets
@@ -464,6 +506,7 @@ void BaseRenderOSystem::drawTickets() {
 		if ((*it)->_isValid == false) {
 			RenderTicket *ticket = *it;
 			addDirtyRect((*it)->_dstRect);
+			removeTicketFromIndex(ticket);
 			it = _renderQueue.erase(it);
 			delete ticket;
 		} else {
@@ -596,6 +639,7 @@ void BaseRenderOSystem::endSaveLoad() {
 	// so just skip this single frame.
 	_skipThisFrame = true;
 	_lastFrameIter = _renderQueue.end();
+	_ticketIndex.clear();
 
 	_renderSurface->fillRect(Common::Rect(0, 0, _renderSurface->w, _renderSurface->h), _renderSurface->format.ARGBToColor(255, 0, 0, 0));
 	g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->pitch, 0, 0, _renderSurface->w, _renderSurface->h);
@@ -30,10 +30,13 @@
 #define WINTERMUTE_BASE_RENDERER_SDL_H
 
 #include "engines/wintermute/base/gfx/base_renderer.h"
+#include "engines/wintermute/base/gfx/osystem/dirty_region.h"
 #include "common/rect.h"
 #include "graphics/surface.h"
+#include "common/hashmap.h"
 #include "common/list.h"
 #include "graphics/transform_struct.h"
+#include "graphics/transparent_surface.h"
 
 namespace Wintermute {
 class BaseSurfaceOSystem;
@@ -83,6 +86,8 @@ public:
 
 	void invalidateTicket(RenderTicket *renderTicket);
 	void invalidateTicketsFromSurface(BaseSurfaceOSystem *surf);
+	/** The cache of the scaled and rotated surfaces of the tickets */
+	Graphics::TransformedSurfaceCache &getTransformCache() { return _transformCache; }
 	/**
 	 * Insert a new ticket into the queue, adding a dirty rect
 	 * @param renderTicket the ticket to be added.
@@ -125,18 +130,61 @@ private:
 	 * Traverse the tickets that are dirty, and draw them
 	 */
 	void drawTickets();
+	/**
+	 * Add a ticket of the queue to the index, by owner and position, for
+	 * finding it when it is drawn again in the next frame.
+	 * @param ticket the position of the ticket in the queue
+	 */
+	void addTicketToIndex(const RenderQueueIterator &ticket);
+	/**
+	 * Remove a ticket from the index, before it leaves the queue.
+	 */
+	void removeTicketFromIndex(const RenderTicket *ticket);
+	/**
+	 * Find a ticket of last frame which is equal to the given one, and has not
+	 * been drawn yet in this frame.
+	 * @param compare the ticket to look for
+	 * @param ticket set to the iterator pointing to the ticket found
+	 */
+	bool findQueuedTicket(const RenderTicket &compare, RenderQueueIterator &ticket);
 	// Non-dirty-rects:
 	void drawFromSurface(RenderTicket *ticket);
 	// Dirty-rects:
 	void drawFromSurface(RenderTicket *ticket, Common::Rect *dstRect, Common::Rect *clipRect);
-	Common::Rect *_dirtyRect;
+	DirtyRegion _dirtyRegion;
 	Common::List<RenderTicket *> _renderQueue;
 
+	struct TicketKey {
+		TicketKey(const RenderTicket &ticket);
+		bool operator==(const TicketKey &key) const {
+			return owner == key.owner && x == key.x && y == key.y;
+		}
+
+		BaseSurfaceOSystem *owner;
+		int16 x, y;
+	};
+
+	struct TicketKeyHash {
+		uint operator()(const TicketKey &key) const {
+			return (uint)(size_t)key.owner ^ ((uint16)key.x * 31 + (uint16)key.y) * 2654435761U;
+		}
+	};
+
+	struct IndexedTicket {
+		RenderTicket *ticket;
+		RenderQueueIterator pos;
+	};
+
+	typedef Common::HashMap<TicketKey, Common::Array<IndexedTicket>, TicketKeyHash> TicketIndex;
+	/** The tickets of the queue which have an owner */
+	TicketIndex _ticketIndex;
+
 	bool _needsFlip;
 	RenderQueueIterator _lastFrameIter;
 	Common::Rect _renderRect;
 	Graphics::Surface *_renderSurface;
 	Graphics::Surface *_blankSurface;
+	Graphics::TransformedSurfaceCache _transformCache;
 
 	int _borderLeft;
 	int _borderTop;
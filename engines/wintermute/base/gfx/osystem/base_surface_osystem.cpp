@@ -149,6 +149,8 @@ bool BaseSurfaceOSystem::finishLoad() {
 
 	_surface->free();
 	delete _surface;
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
+	renderer->getTransformCache().invalidate(this);
 
 	bool needsColorKey = false;
 	bool replaceAlpha = true;
@@ -342,6 +344,9 @@ bool BaseSurfaceOSystem::startPixelOp() {
 //////////////////////////////////////////////////////////////////////////
 bool BaseSurfaceOSystem::endPixelOp() {
 	//SDL_UnlockTexture(_texture);
+	// Copies scaled while the pixels were being changed are outdated
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
+	renderer->getTransformCache().invalidate(this);
 	return STATUS_OK;
 }
 
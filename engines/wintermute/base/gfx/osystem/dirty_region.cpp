@@ -0,0 +1,125 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/wintermute/base/gfx/osystem/dirty_region.h"
+
+namespace Wintermute {
+
+// Area which may be redrawn needlessly to merge two rects, in addition to
+// a quarter of the area of the rects
+#define DIRTY_REGION_MERGE_SLACK 1024
+
+DirtyRegion::DirtyRegion(uint maxRects) : _maxRects(MAX<uint>(maxRects, 1)) {
+}
+
+void DirtyRegion::clear() {
+	_rects.clear();
+	_bounds = Common::Rect();
+}
+
+uint32 DirtyRegion::getArea() const {
+	uint32 total = 0;
+	for (uint i = 0; i < _rects.size(); ++i)
+		total += area(_rects[i]);
+	return total;
+}
+
+bool DirtyRegion::intersects(const Common::Rect &rect) const {
+	if (!_bounds.intersects(rect))
+		return false;
+	for (uint i = 0; i < _rects.size(); ++i) {
+		if (_rects[i].intersects(rect))
+			return true;
+	}
+	return false;
+}
+
+bool DirtyRegion::shouldMerge(const Common::Rect &a, const Common::Rect &b) {
+	// Overlapping rects are always merged, so that the rects stay disjoint
+	if (a.intersects(b))
+		return true;
+
+	Common::Rect merged(a);
+	merged.extend(b);
+	const uint32 sum = area(a) + area(b);
+	return area(merged) - sum <= sum / 4 + DIRTY_REGION_MERGE_SLACK;
+}
+
+void DirtyRegion::addRect(const Common::Rect &rect) {
+	if (rect.isEmpty())
+		return;
+
+	if (_rects.empty())
+		_bounds = rect;
+	else
+		_bounds.extend(rect);
+
+	insertRect(rect);
+	while (_rects.size() > _maxRects)
+		mergeClosestRects();
+}
+
+void DirtyRegion::insertRect(Common::Rect rect) {
+	// Absorb the rects which should be merged with the new one. The merged rect
+	// may now overlap others, so look again until none is found.
+	uint i = 0;
+	while (i < _rects.size()) {
+		if (_rects[i].contains(rect))
+			return;
+
+		if (shouldMerge(_rects[i], rect)) {
+			rect.extend(_rects[i]);
+			_rects[i] = _rects.back();
+			_rects.pop_back();
+			i = 0;
+		} else {
+			++i;
+		}
+	}
+
+	_rects.push_back(rect);
+}
+
+void DirtyRegion::mergeClosestRects() {
+	uint bestA = 0, bestB = 1;
+	uint32 bestWaste = 0xFFFFFFFF;
+	for (uint a = 0; a < _rects.size(); ++a) {
+		for (uint b = a + 1; b < _rects.size(); ++b) {
+			Common::Rect merged(_rects[a]);
+			merged.extend(_rects[b]);
+			const uint32 waste = area(merged) - area(_rects[a]) - area(_rects[b]);
+			if (waste < bestWaste) {
+				bestA = a;
+				bestB = b;
+				bestWaste = waste;
+			}
+		}
+	}
+
+	Common::Rect merged(_rects[bestA]);
+	merged.extend(_rects[bestB]);
+	_rects.remove_at(bestB);
+	_rects.remove_at(bestA);
+	insertRect(merged);
+}
+
+} // End of namespace Wintermute
@@ -0,0 +1,73 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef WINTERMUTE_DIRTY_REGION_H
+#define WINTERMUTE_DIRTY_REGION_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Wintermute {
+
+/**
+ * The part of the screen which has to be redrawn, as a list of disjoint rects.
+ *
+ * Overlapping rects are merged, as well as rects whose bounding box does not
+ * add much to their area, so that nearby changes are redrawn in one go while
+ * changes far apart stay separate. When there are too many rects, the pairs
+ * which waste the least area are merged.
+ */
+class DirtyRegion {
+public:
+	DirtyRegion(uint maxRects = 16);
+
+	/** Add a rect to the region. Empty rects are ignored. */
+	void addRect(const Common::Rect &rect);
+	/** Remove all the rects */
+	void clear();
+
+	bool isEmpty() const { return _rects.empty(); }
+	const Common::Array<Common::Rect> &getRects() const { return _rects; }
+	/** The bounding box of all the rects */
+	const Common::Rect &getBounds() const { return _bounds; }
+	/** Number of pixels in the region */
+	uint32 getArea() const;
+
+	bool intersects(const Common::Rect &rect) const;
+
+private:
+	static uint32 area(const Common::Rect &rect) {
+		return (uint32)rect.width() * rect.height();
+	}
+	static bool shouldMerge(const Common::Rect &a, const Common::Rect &b);
+
+	void insertRect(Common::Rect rect);
+	void mergeClosestRects();
+
+	Common::Array<Common::Rect> _rects;
+	Common::Rect _bounds;
+	uint _maxRects;
+};
+
+} // End of namespace Wintermute
+
+#endif
@@ -30,6 +30,7 @@
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/gfx/osystem/render_ticket.h"
 #include "engines/wintermute/base/gfx/osystem/base_surface_osystem.h"
+#include "engines/wintermute/base/gfx/osystem/base_render_osystem.h"
 #include "graphics/transform_tools.h"
 #include "common/textconsole.h"
 
@@ -43,14 +44,11 @@ RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *s
 	_wantsDraw(true),
 	_transform(transform) {
 	if (surf) {
+		assert(surf->format.bytesPerPixel == 4);
 		_surface = new Graphics::Surface();
-		_surface->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
-		assert(_surface->format.bytesPerPixel == 4);
-		// Get a clipped copy of the surface
-		for (int i = 0; i < _surface->h; i++) {
-			memcpy(_surface->getBasePtr(0, i), surf->getBasePtr(srcRect->left, srcRect->top + i), srcRect->width() * _surface->format.bytesPerPixel);
-		}
-		// Then scale it if necessary
+		// Get a clipped copy of the surface, scaled if necessary. The scaled
+		// copies come from the cache of the renderer, since the same sprite
+		// is often drawn with the same transformation at another position.
 		//
 		// NB: The numTimesX/numTimesY properties don't yet mix well with
 		// scaling and rotation, but there is no need for that functionality at
@@ -59,23 +57,18 @@ RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *s
 		// (Mirroring should most likely be done before rotation. See also
 		// TransformTools.)
 		if (_transform._angle != Graphics::kDefaultAngle) {
-			Graphics::TransparentSurface src(*_surface, false);
-			Graphics::Surface *temp;
-			if (owner->_gameRef->getBilinearFiltering()) {
-				temp = src.rotoscaleT<Graphics::FILTER_BILINEAR>(transform);
-			} else {
-				temp = src.rotoscaleT<Graphics::FILTER_NEAREST>(transform);
-			}
-			_surface->free();
-			delete _surface;
-			_surface = temp;
+			BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(owner->_gameRef->_renderer);
+			_surface->copyFrom(*renderer->getTransformCache().rotoscale(owner, *surf, *srcRect, transform, owner->_gameRef->getBilinearFiltering()));
 		} else if ((dstRect->width() != srcRect->width() ||
 					dstRect->height() != srcRect->height()) &&
 					_transform._numTimesX * _transform._numTimesY == 1) {
-			Graphics::Surface *temp = _surface->scale(dstRect->width(), dstRect->height(), owner->_gameRef->getBilinearFiltering());
-			_surface->free();
-			delete _surface;
-			_surface = temp;
+			BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(owner->_gameRef->_renderer);
+			_surface->copyFrom(*renderer->getTransformCache().scale(owner, *surf, *srcRect, dstRect->width(), dstRect->height(), owner->_gameRef->getBilinearFiltering()));
+		} else {
+			_surface->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
+			for (int i = 0; i < _surface->h; i++) {
+				memcpy(_surface->getBasePtr(0, i), surf->getBasePtr(srcRect->left, srcRect->top + i), srcRect->width() * _surface->format.bytesPerPixel);
+			}
 		}
 	} else {
 		_surface = nullptr;
@@ -33,7 +33,12 @@ namespace Graphics {
  * DRAWSTEP handling functions
  ********************************************************************/
 void VectorRenderer::drawStep(const Common::Rect &area, const Common::Rect &clip, const DrawStep &step, uint32 extra) {
+	applyStepState(area, clip, step, extra);
 
+	(this->*(step.drawingCall))(area, step);
+}
+
+void VectorRenderer::applyStepState(const Common::Rect &area, const Common::Rect &clip, const DrawStep &step, uint32 extra) {
 	if (step.bgColor.set)
 		setBgColor(step.bgColor.r, step.bgColor.g, step.bgColor.b);
 
@@ -55,8 +60,6 @@ void VectorRenderer::drawStep(const Common::Rect &area, const Common::Rect &clip
 	setClippingRect(applyStepClippingRect(area, clip, step));
 
 	_dynamicData = extra;
-
-	(this->*(step.drawingCall))(area, step);
 }
 
 Common::Rect VectorRenderer::applyStepClippingRect(const Common::Rect &area, const Common::Rect &clip, const DrawStep &step) {
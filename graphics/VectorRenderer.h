@@ -294,6 +294,15 @@ public:
 	 */
 	virtual void setGradientColors(uint8 r1, uint8 g1, uint8 b1, uint8 r2, uint8 g2, uint8 b2) = 0;
 
+	/**
+	 * Get the active colors of the renderer, in the pixel format of
+	 * the renderer.
+	 *
+	 * @param colors Filled with the foreground, background, bevel, gradient
+	 *               start and gradient end colors, in that order.
+	 */
+	virtual void getColors(uint32 colors[5]) const = 0;
+
 	/**
 	 * Sets the active drawing surface. All drawing from this
 	 * point on will be done on that surface.
@@ -486,6 +495,12 @@ public:
 	 */
 	virtual void drawStep(const Common::Rect &area, const Common::Rect &clip, const DrawStep &step, uint32 extra = 0);
 
+	/**
+	 * Sets up the colors and options of the specified draw step, as
+	 * drawStep() does, without drawing anything.
+	 */
+	void applyStepState(const Common::Rect &area, const Common::Rect &clip, const DrawStep &step, uint32 extra = 0);
+
 	/**
 	 * Copies the part of the current frame to the system overlay.
 	 *
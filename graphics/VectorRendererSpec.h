@@ -82,6 +82,13 @@ public:
 	void setBgColor(uint8 r, uint8 g, uint8 b) override { _bgColor = _format.RGBToColor(r, g, b); }
 	void setBevelColor(uint8 r, uint8 g, uint8 b) override { _bevelColor = _format.RGBToColor(r, g, b); }
 	void setGradientColors(uint8 r1, uint8 g1, uint8 b1, uint8 r2, uint8 g2, uint8 b2) override;
+	void getColors(uint32 colors[5]) const override {
+		colors[0] = _fgColor;
+		colors[1] = _bgColor;
+		colors[2] = _bevelColor;
+		colors[3] = _gradientStart;
+		colors[4] = _gradientEnd;
+	}
 	void setClippingRect(const Common::Rect &clippingArea) override { _clippingArea = clippingArea; }
 
 	void copyFrame(OSystem *sys, const Common::Rect &r) override;
@@ -439,9 +439,59 @@ int Font::getStringWidth(const Common::String &str) const {
 }
 
 int Font::getStringWidth(const Common::U32String &str) const {
+	const int width = getCachedStringWidth(str);
+	if (width >= 0)
+		return width;
+
+	return getStringWidthImpl(*this, str);
+}
+
+int Font::computeStringWidth(const Common::U32String &str) const {
 	return getStringWidthImpl(*this, str);
 }
 
+void Font::layoutString(const Common::U32String &input, int w, TextAlign align, int deltax, bool useEllipsis, TextRun &run) const {
+	// This follows the logic of drawStringImpl, for a string drawn at (0, 0)
+	const Common::U32String str = useEllipsis ? handleEllipsis(*this, input, w) : input;
+	const int rightX = w + 1;
+	const int width = getStringWidth(str);
+
+	int x = 0;
+	if (align == kTextAlignCenter)
+		x = (w - width)/2;
+	else if (align == kTextAlignRight)
+		x = w - width;
+	x += deltax;
+
+	run.chars.clear();
+	run.bbox = Common::Rect();
+
+	Common::U32String::unsigned_type last = 0;
+	for (Common::U32String::const_iterator i = str.begin(), end = str.end(); i != end; ++i) {
+		const Common::U32String::unsigned_type cur = *i;
+		x += getKerningOffset(last, cur);
+		last = cur;
+
+		Common::Rect charBox = getBoundingBox(cur);
+		if (x + charBox.right > rightX)
+			break;
+		if (x + charBox.right >= 0) {
+			TextRun::Char chr;
+			chr.chr = cur;
+			chr.x = x;
+			run.chars.push_back(chr);
+
+			charBox.translate(x, 0);
+			if (run.chars.size() == 1)
+				run.bbox = charBox;
+			else
+				run.bbox.extend(charBox);
+		}
+
+		x += getCharWidth(cur);
+	}
+}
+
 void Font::drawChar(ManagedSurface *dst, uint32 chr, int x, int y, uint32 color) const {
 	drawChar(dst->surfacePtr(), chr, x, y, color);
 
@@ -456,6 +506,14 @@ void Font::drawString(Surface *dst, const Common::String &str, int x, int y, int
 }
 
 void Font::drawString(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax, bool useEllipsis) const {
+	const TextRun *run = getCachedTextRun(str, w, align, deltax, useEllipsis);
+	if (run) {
+		assert(dst != 0);
+		for (uint i = 0; i < run->chars.size(); ++i)
+			drawChar(dst, run->chars[i].chr, x + run->chars[i].x, y, color);
+		return;
+	}
+
 	Common::U32String renderStr = useEllipsis ? handleEllipsis(*this, str, w) : str;
 	drawStringImpl(*this, dst, renderStr, x, y, w, color, align, deltax);
 }
@@ -470,6 +528,20 @@ void Font::drawString(ManagedSurface *dst, const Common::String &str, int x, int
 }
 
 void Font::drawString(ManagedSurface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax, bool useEllipsis) const {
+	const TextRun *run = getCachedTextRun(str, w, align, deltax, useEllipsis);
+	if (run) {
+		assert(dst != 0);
+		for (uint i = 0; i < run->chars.size(); ++i)
+			drawChar(dst, run->chars[i].chr, x + run->chars[i].x, y, color);
+
+		if (w != 0 && !run->chars.empty()) {
+			Common::Rect bbox = run->bbox;
+			bbox.translate(x, y);
+			dst->addDirtyRect(bbox);
+		}
+		return;
+	}
+
 	Common::U32String renderStr = useEllipsis ? handleEllipsis(*this, str, w) : str;
 	drawStringImpl(*this, dst, renderStr, x, y, w, color, align, deltax);
 
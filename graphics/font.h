@@ -23,14 +23,11 @@
 #ifndef GRAPHICS_FONT_H
 #define GRAPHICS_FONT_H
 
+#include "common/array.h"
 #include "common/str.h"
 #include "common/ustr.h"
 #include "common/rect.h"
 
-namespace Common {
-template<class T> class Array;
-}
-
 namespace Graphics {
 
 /**
@@ -239,6 +236,49 @@ public:
 	int wordWrapText(const Common::String &str, int maxWidth, Common::Array<Common::String> &lines, int initWidth = 0, uint32 mode = kWordWrapOnExplicitNewLines) const;
 	/** @overload */
 	int wordWrapText(const Common::U32String &str, int maxWidth, Common::Array<Common::U32String> &lines, int initWidth = 0, uint32 mode = kWordWrapOnExplicitNewLines) const;
+
+protected:
+	/**
+	 * The layout of a string as drawn by drawString, after the ellipsis,
+	 * the alignment and the clipping to the text area have been applied.
+	 */
+	struct TextRun {
+		struct Char {
+			uint32 chr;
+			int x; ///< Position relative to the x coordinate passed to drawString.
+		};
+
+		Common::Array<Char> chars;
+		Common::Rect bbox; ///< Bounding box of the drawn characters, relative to (x, y).
+	};
+
+	/**
+	 * Compute the layout of a string for drawString.
+	 *
+	 * @see drawString
+	 */
+	void layoutString(const Common::U32String &str, int w, TextAlign align, int deltax, bool useEllipsis, TextRun &run) const;
+
+	/**
+	 * Compute the width of a string without using getCachedStringWidth.
+	 */
+	int computeStringWidth(const Common::U32String &str) const;
+
+	/**
+	 * Return the layout of a string for drawString from a cache of the font.
+	 *
+	 * Fonts for which measuring strings is expensive can cache the
+	 * layouts of the strings they draw repeatedly. The default
+	 * implementation returns nullptr, in which case the string is laid out
+	 * while it is drawn.
+	 */
+	virtual const TextRun *getCachedTextRun(const Common::U32String &str, int w, TextAlign align, int deltax, bool useEllipsis) const { return nullptr; }
+
+	/**
+	 * Return the width of a string from a cache of the font, or -1 when the
+	 * font does not cache string widths, which is the default.
+	 */
+	virtual int getCachedStringWidth(const Common::U32String &str) const { return -1; }
 };
 /** @} */
 } // End of namespace Graphics
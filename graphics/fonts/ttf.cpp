@@ -39,6 +39,8 @@
 #include "common/stream.h"
 #include "common/memstream.h"
 #include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/lru-cache.h"
 #include "common/ptr.h"
 #include "common/unzip.h"
 
@@ -160,6 +162,10 @@ public:
 	virtual void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const;
 	virtual void drawChar(ManagedSurface *dst, uint32 chr, int x, int y, uint32 color) const;
 
+protected:
+	virtual const TextRun *getCachedTextRun(const Common::U32String &str, int w, TextAlign align, int deltax, bool useEllipsis) const;
+	virtual int getCachedStringWidth(const Common::U32String &str) const;
+
 private:
 	bool _initialized;
 	FT_Face _face;
@@ -171,7 +177,8 @@ private:
 	int _ascent, _descent;
 
 	struct Glyph {
-		Surface image;
+		int atlasX, atlasY; ///< Position of the image in the glyph atlas
+		int width, height;  ///< Size of the image
 		int xOffset, yOffset;
 		int advance;
 		FT_UInt slot;
@@ -183,6 +190,55 @@ private:
 	bool _allowLateCaching;
 	void assureCached(uint32 chr) const;
 
+	/**
+	 * The images of all cached glyphs, as 8-bit coverage values. Glyphs are
+	 * packed into rows from left to right, and the atlas grows downwards
+	 * when glyphs are cached late.
+	 */
+	mutable Surface _atlas;
+	mutable int _atlasX, _atlasY, _atlasRowHeight;
+	void allocateAtlasArea(int w, int h, int &x, int &y) const;
+
+	/**
+	 * The non-zero kerning offsets between the glyphs cached when loading
+	 * the font, which are the characters 0 to 255. It is filled when
+	 * kerning is first queried.
+	 */
+	typedef Common::HashMap<uint32, int> KerningTable;
+	mutable KerningTable _kerningTable;
+	mutable bool _kerningTableBuilt;
+	void buildKerningTable() const;
+
+	enum {
+		kTextRunCacheSize = 256,
+		kStringWidthCacheSize = 512
+	};
+
+	struct TextRunKey {
+		Common::U32String str;
+		int w;
+		TextAlign align;
+		int deltax;
+		bool useEllipsis;
+	};
+
+	struct TextRunKey_Hash {
+		uint operator()(const TextRunKey &key) const {
+			return Common::Hash<Common::U32String>()(key.str) ^ (key.w * 2654435761U) ^ (key.deltax << 8) ^ (key.align << 4) ^ key.useEllipsis;
+		}
+	};
+
+	struct TextRunKey_EqualTo {
+		bool operator()(const TextRunKey &x, const TextRunKey &y) const {
+			return x.w == y.w && x.align == y.align && x.deltax == y.deltax && x.useEllipsis == y.useEllipsis && x.str == y.str;
+		}
+	};
+
+	/** Layouts of the recently drawn strings */
+	mutable Common::LRUCache<TextRunKey, TextRun, TextRunKey_Hash, TextRunKey_EqualTo> _textRuns;
+	/** Widths of the recently measured strings */
+	mutable Common::LRUCache<Common::U32String, int> _stringWidths;
+
 	Common::SeekableReadStream *readTTFTable(FT_ULong tag) const;
 
 	int computePointSize(int size, TTFSizeMode sizeMode) const;
@@ -201,8 +257,10 @@ private:
 
 TTFFont::TTFFont()
     : _initialized(false), _face(), _ttfFile(0), _size(0), _width(0), _height(0), _ascent(0),
-      _descent(0), _glyphs(), _loadFlags(FT_LOAD_TARGET_NORMAL), _renderMode(FT_RENDER_MODE_NORMAL),
-      _hasKerning(false), _allowLateCaching(false), _fakeBold(false), _fakeItalic(false) {
+      _descent(0), _glyphs(), _atlasX(0), _atlasY(0), _atlasRowHeight(0), _kerningTableBuilt(false),
+      _textRuns(kTextRunCacheSize), _stringWidths(kStringWidthCacheSize), _loadFlags(FT_LOAD_TARGET_NORMAL),
+      _renderMode(FT_RENDER_MODE_NORMAL), _hasKerning(false), _allowLateCaching(false), _fakeBold(false),
+      _fakeItalic(false) {
 }
 
 TTFFont::~TTFFont() {
@@ -212,8 +270,7 @@ TTFFont::~TTFFont() {
 		delete[] _ttfFile;
 		_ttfFile = 0;
 
-		for (GlyphCache::iterator i = _glyphs.begin(), end = _glyphs.end(); i != end; ++i)
-			i->_value.image.free();
+		_atlas.free();
 
 		_initialized = false;
 	}
@@ -353,6 +410,15 @@ bool TTFFont::load(uint8 *ttfFile, uint32 sizeFile, int32 faceIndex, bool bold,
 		_loadFlags |= FT_LOAD_NO_BITMAP;
 	}
 
+	// Make the glyph atlas wide enough for several glyphs per row, and high
+	// enough for the ISO-8859-1 characters of a typical font
+	int atlasWidth = 256;
+	while (atlasWidth < 4 * (_width + _height))
+		atlasWidth *= 2;
+	_atlas.create(atlasWidth, MAX(256, 64 * _height * _width / atlasWidth), PixelFormat::createFormatCLUT8());
+	memset(_atlas.getPixels(), 0, _atlas.h * _atlas.pitch);
+	_atlasX = _atlasY = _atlasRowHeight = 0;
+
 	if (!mapping) {
 		// Allow loading of all unicode characters.
 		_allowLateCaching = true;
@@ -376,6 +442,7 @@ bool TTFFont::load(uint8 *ttfFile, uint32 sizeFile, int32 faceIndex, bool bold,
 				_glyphs.erase(i);
 				if (isRequired) {
 					g_ttf.closeFont(_face);
+					_atlas.free();
 
 					// Don't delete ttfFile as we return fail
 					_ttfFile = 0;
@@ -388,6 +455,7 @@ bool TTFFont::load(uint8 *ttfFile, uint32 sizeFile, int32 faceIndex, bool bold,
 
 	if (_glyphs.size() == 0) {
 		g_ttf.closeFont(_face);
+		_atlas.free();
 
 		// Don't delete ttfFile as we return fail
 		_ttfFile = 0;
@@ -543,6 +611,14 @@ int TTFFont::getKerningOffset(uint32 left, uint32 right) const {
 	if (!_hasKerning)
 		return 0;
 
+	if (left < 256 && right < 256) {
+		if (!_kerningTableBuilt)
+			buildKerningTable();
+
+		KerningTable::const_iterator kerning = _kerningTable.find((left << 8) | right);
+		return kerning != _kerningTable.end() ? kerning->_value : 0;
+	}
+
 	assureCached(left);
 	assureCached(right);
 
@@ -571,16 +647,67 @@ int TTFFont::getKerningOffset(uint32 left, uint32 right) const {
 	return (kerningVector.x / 64);
 }
 
+void TTFFont::buildKerningTable() const {
+	// The characters 0 to 255 are cached when loading the font, and never
+	// later, so the table stays complete
+	FT_UInt slots[256];
+	for (uint i = 0; i < 256; ++i) {
+		GlyphCache::const_iterator glyphEntry = _glyphs.find(i);
+		slots[i] = (glyphEntry != _glyphs.end()) ? glyphEntry->_value.slot : 0;
+	}
+
+	for (uint left = 0; left < 256; ++left) {
+		if (!slots[left])
+			continue;
+
+		for (uint right = 0; right < 256; ++right) {
+			if (!slots[right])
+				continue;
+
+			FT_Vector kerningVector;
+			FT_Get_Kerning(_face, slots[left], slots[right], FT_KERNING_DEFAULT, &kerningVector);
+			const int offset = kerningVector.x / 64;
+			if (offset)
+				_kerningTable[(left << 8) | right] = offset;
+		}
+	}
+
+	_kerningTableBuilt = true;
+}
+
+const Font::TextRun *TTFFont::getCachedTextRun(const Common::U32String &str, int w, TextAlign align, int deltax, bool useEllipsis) const {
+	TextRunKey key;
+	key.str = str;
+	key.w = w;
+	key.align = align;
+	key.deltax = deltax;
+	key.useEllipsis = useEllipsis;
+
+	const TextRun *run = _textRuns.find(key);
+	if (run)
+		return run;
+
+	TextRun newRun;
+	layoutString(str, w, align, deltax, useEllipsis, newRun);
+	return &_textRuns.insert(key, newRun);
+}
+
+int TTFFont::getCachedStringWidth(const Common::U32String &str) const {
+	const int *width = _stringWidths.find(str);
+	if (width)
+		return *width;
+
+	return _stringWidths.insert(str, computeStringWidth(str));
+}
+
 Common::Rect TTFFont::getBoundingBox(uint32 chr) const {
 	assureCached(chr);
 	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
 	if (glyphEntry == _glyphs.end()) {
 		return Common::Rect();
 	} else {
-		const int xOffset = glyphEntry->_value.xOffset;
-		const int yOffset = glyphEntry->_value.yOffset;
-		const Graphics::Surface &image = glyphEntry->_value.image;
-		return Common::Rect(xOffset, yOffset, xOffset + image.w, yOffset + image.h);
+		const Glyph &glyph = glyphEntry->_value;
+		return Common::Rect(glyph.xOffset, glyph.yOffset, glyph.xOffset + glyph.width, glyph.yOffset + glyph.height);
 	}
 }
 
@@ -667,10 +794,10 @@ void TTFFont::drawChar(Surface * dst, uint32 chr, int x, int y, uint32 color,
 	if (y > dst->h)
 		return;
 
-	int w = glyph.image.w;
-	int h = glyph.image.h;
+	int w = glyph.width;
+	int h = glyph.height;
 
-	const uint8 *srcPos = (const uint8 *)glyph.image.getPixels();
+	const uint8 *srcPos = (const uint8 *)_atlas.getBasePtr(glyph.atlasX, glyph.atlasY);
 
 	// Make sure we are not drawing outside the screen bounds
 	if (x < 0) {
@@ -686,7 +813,7 @@ void TTFFont::drawChar(Surface * dst, uint32 chr, int x, int y, uint32 color,
 		return;
 
 	if (y < 0) {
-		srcPos -= y * glyph.image.pitch;
+		srcPos -= y * _atlas.pitch;
 		h += y;
 		y = 0;
 	}
@@ -715,12 +842,12 @@ void TTFFont::drawChar(Surface * dst, uint32 chr, int x, int y, uint32 color,
 			}
 
 			dstPos += dst->pitch;
-			srcPos += glyph.image.pitch;
+			srcPos += _atlas.pitch;
 		}
 	} else if (dst->format.bytesPerPixel == 2) {
-		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format, transparentColor);
+		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, _atlas.pitch, w, h, color, dst->format, transparentColor);
 	} else if (dst->format.bytesPerPixel == 4) {
-		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format, transparentColor);
+		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, _atlas.pitch, w, h, color, dst->format, transparentColor);
 	}
 }
 
@@ -788,8 +915,19 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 		bitmap = &_face->glyph->bitmap;
 	}
 
+	if (bitmap->pixel_mode != FT_PIXEL_MODE_MONO && bitmap->pixel_mode != FT_PIXEL_MODE_GRAY) {
+		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap->pixel_mode);
+#if FAKE_BOLD == 1
+		if (_fakeBold) {
+			FT_Bitmap_Done(_face->glyph->library, &ownBitmap);
+		}
+#endif
+		return false;
+	}
 
-	glyph.image.create(bitmap->width, bitmap->rows, PixelFormat::createFormatCLUT8());
+	glyph.width = bitmap->width;
+	glyph.height = bitmap->rows;
+	allocateAtlasArea(glyph.width, glyph.height, glyph.atlasX, glyph.atlasY);
 
 	const uint8 *src = bitmap->buffer;
 	int srcPitch = bitmap->pitch;
@@ -798,13 +936,12 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 		srcPitch = -srcPitch;
 	}
 
-	uint8 *dst = (uint8 *)glyph.image.getPixels();
-	memset(dst, 0, glyph.image.h * glyph.image.pitch);
+	uint8 *dst = (uint8 *)_atlas.getBasePtr(glyph.atlasX, glyph.atlasY);
 
-	switch (bitmap->pixel_mode) {
-	case FT_PIXEL_MODE_MONO:
+	if (bitmap->pixel_mode == FT_PIXEL_MODE_MONO) {
 		for (int y = 0; y < (int)bitmap->rows; ++y) {
 			const uint8 *curSrc = src;
+			uint8 *curDst = dst;
 			uint8 mask = 0;
 
 			for (int x = 0; x < (int)bitmap->width; ++x) {
@@ -812,28 +949,21 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 					mask = *curSrc++;
 
 				if (mask & 0x80)
-					*dst = 255;
+					*curDst = 255;
 
 				mask <<= 1;
-				++dst;
+				++curDst;
 			}
 
+			dst += _atlas.pitch;
 			src += srcPitch;
 		}
-		break;
-
-	case FT_PIXEL_MODE_GRAY:
+	} else {
 		for (int y = 0; y < (int)bitmap->rows; ++y) {
 			memcpy(dst, src, bitmap->width);
-			dst += glyph.image.pitch;
+			dst += _atlas.pitch;
 			src += srcPitch;
 		}
-		break;
-
-	default:
-		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap->pixel_mode);
-		glyph.image.free();
-		return false;
 	}
 
 #if FAKE_BOLD == 1
@@ -845,6 +975,31 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	return true;
 }
 
+void TTFFont::allocateAtlasArea(int w, int h, int &x, int &y) const {
+	if (_atlasX + w > _atlas.w) {
+		_atlasX = 0;
+		_atlasY += _atlasRowHeight;
+		_atlasRowHeight = 0;
+	}
+
+	// Glyphs wider than the atlas cannot happen with the width chosen in
+	// load, but make the atlas wider in case they do
+	if (w > _atlas.w || _atlasY + h > _atlas.h) {
+		Surface atlas;
+		atlas.create(MAX<int>(_atlas.w, w), MAX(_atlas.h * 2, _atlasY + h), PixelFormat::createFormatCLUT8());
+		memset(atlas.getPixels(), 0, atlas.h * atlas.pitch);
+		for (int row = 0; row < _atlas.h; ++row)
+			memcpy(atlas.getBasePtr(0, row), _atlas.getBasePtr(0, row), _atlas.w);
+		_atlas.free();
+		_atlas = atlas;
+	}
+
+	x = _atlasX;
+	y = _atlasY;
+	_atlasX += w;
+	_atlasRowHeight = MAX(_atlasRowHeight, h);
+}
+
 void TTFFont::assureCached(uint32 chr) const {
 	if (!chr || !_allowLateCaching || _glyphs.contains(chr)) {
 		return;
@@ -21,6 +21,8 @@
  */
 
 #include "graphics/managed_surface.h"
+#include "graphics/managed_surface_intern.h"
+#include "graphics/palette_remap.h"
 #include "common/algorithm.h"
 #include "common/textconsole.h"
 
@@ -244,6 +246,231 @@ void ManagedSurface::blitFrom(const ManagedSurface &src, const Common::Rect &src
 		blitFromInner(src._innerSurface, srcRect, destRect, src._paletteSet ? src._palette : nullptr);
 }
 
+static bool s_blitKernelsEnabled = true;
+
+void setBlitKernels(bool enable) {
+	s_blitKernelsEnabled = enable;
+}
+
+/**
+ * Returns true if every bit of the pixels belongs to a color component, so
+ * that decoding and encoding a pixel returns the same value.
+ */
+static inline bool isFullyPacked(const PixelFormat &format) {
+	return format.aBits() + format.rBits() + format.gBits() + format.bBits() == format.bytesPerPixel * 8;
+}
+
+/**
+ * Returns the bits of the alpha component. A pixel is opaque when all of
+ * them are set, and transparent when none are.
+ */
+static inline uint32 alphaMask(const PixelFormat &format) {
+	return ((1 << format.aBits()) - 1) << format.aShift;
+}
+
+/**
+ * Blends a partially transparent color with the one of the destination pixel
+ */
+static inline void blendPixel(const PixelFormat &format, byte *destVal, byte aSrc, byte rSrc, byte gSrc, byte bSrc,
+		byte &aDest, byte &rDest, byte &gDest, byte &bDest) {
+	if (format.bytesPerPixel == 2) {
+		uint32 destColor = *(uint16 *)destVal;
+		format.colorToARGB(destColor, aDest, rDest, gDest, bDest);
+	} else if (format.bytesPerPixel == 4) {
+		uint32 destColor = *(uint32 *)destVal;
+		format.colorToARGB(destColor, aDest, rDest, gDest, bDest);
+	} else {
+		aDest = 0xFF;
+		rDest = destVal[0];
+		gDest = destVal[1];
+		bDest = destVal[2];
+	}
+
+	double sAlpha = (double)aSrc / 255.0;
+	double dAlpha = (double)aDest / 255.0;
+	dAlpha *= (1.0 - sAlpha);
+	rDest = static_cast<uint8>((rSrc * sAlpha + rDest * dAlpha) / (sAlpha + dAlpha));
+	gDest = static_cast<uint8>((gSrc * sAlpha + gDest * dAlpha) / (sAlpha + dAlpha));
+	bDest = static_cast<uint8>((bSrc * sAlpha + bDest * dAlpha) / (sAlpha + dAlpha));
+	aDest = static_cast<uint8>(255. * (sAlpha + dAlpha));
+}
+
+/**
+ * Blends a partially transparent color with the destination color, in
+ * integers. The result is the exact one rounded down, which the double
+ * arithmetic of blendPixel() misses by one for about one color in a thousand.
+ */
+static inline void blendColors(byte aSrc, byte rSrc, byte gSrc, byte bSrc,
+		byte &aDest, byte &rDest, byte &gDest, byte &bDest) {
+	// The weights of blendPixel(), scaled by 255 * 255
+	const uint32 sWeight = aSrc * 255;
+	const uint32 dWeight = aDest * (255 - aSrc);
+	const uint32 weight = sWeight + dWeight;
+	rDest = (rSrc * sWeight + rDest * dWeight) / weight;
+	gDest = (gSrc * sWeight + gDest * dWeight) / weight;
+	bDest = (bSrc * sWeight + bDest * dWeight) / weight;
+	aDest = weight / 255;
+}
+
+static inline void writePixel(const PixelFormat &format, byte *destVal, byte aDest, byte rDest, byte gDest, byte bDest) {
+	uint destPixel = format.ARGBToColor(aDest, rDest, gDest, bDest);
+	if (format.bytesPerPixel == 2)
+		*(uint16 *)destVal = destPixel;
+	else if (format.bytesPerPixel == 4)
+		*(uint32 *)destVal = destPixel;
+	else {
+		destVal[0] = rDest;
+		destVal[1] = gDest;
+		destVal[2] = bDest;
+	}
+}
+
+/** Copies the source pixels, for surfaces of the same format without alpha */
+template<typename T>
+struct CopyBlitKernel {
+	static const bool kCanCopyRows = true;
+
+	inline void operator()(T srcVal, T &destVal) const {
+		destVal = srcVal;
+	}
+};
+
+/** Blends pixels of the same format, copying the opaque ones as they are */
+template<typename T>
+struct AlphaBlitKernel {
+	static const bool kCanCopyRows = false;
+
+	const PixelFormat &_format;
+	const uint32 _alphaMask;
+
+	AlphaBlitKernel(const PixelFormat &format) : _format(format), _alphaMask(alphaMask(format)) {}
+
+	inline void operator()(T srcVal, T &destVal) const {
+		const uint32 alpha = srcVal & _alphaMask;
+		if (alpha == _alphaMask) {
+			destVal = srcVal;
+		} else if (alpha != 0) {
+			byte aSrc, rSrc, gSrc, bSrc, aDest, rDest, gDest, bDest;
+			_format.colorToARGB(srcVal, aSrc, rSrc, gSrc, bSrc);
+			_format.colorToARGB(destVal, aDest, rDest, gDest, bDest);
+			blendColors(aSrc, rSrc, gSrc, bSrc, aDest, rDest, gDest, bDest);
+			destVal = _format.ARGBToColor(aDest, rDest, gDest, bDest);
+		}
+	}
+};
+
+/** Draws paletted pixels, with the palette converted to the destination format once */
+template<typename TDEST>
+struct PaletteBlitKernel {
+	static const bool kCanCopyRows = false;
+
+	const PixelFormat &_format;
+	const uint32 *_palette;
+	uint32 _colors[256];
+
+	PaletteBlitKernel(const PixelFormat &format, const uint32 *palette) : _format(format), _palette(palette) {
+		for (int i = 0; i < 256; ++i) {
+			const uint32 col = palette[i];
+			_colors[i] = format.ARGBToColor(0xff, col & 0xff, (col >> 8) & 0xff, (col >> 16) & 0xff);
+		}
+	}
+
+	inline void operator()(byte srcVal, TDEST &destVal) const {
+		const uint32 col = _palette[srcVal];
+		const byte aSrc = (col >> 24) & 0xff;
+		if (aSrc == 0xff) {
+			destVal = _colors[srcVal];
+		} else if (aSrc != 0) {
+			byte aDest, rDest, gDest, bDest;
+			_format.colorToARGB(destVal, aDest, rDest, gDest, bDest);
+			blendColors(aSrc, col & 0xff, (col >> 8) & 0xff, (col >> 16) & 0xff, aDest, rDest, gDest, bDest);
+			destVal = _format.ARGBToColor(aDest, rDest, gDest, bDest);
+		}
+	}
+};
+
+/**
+ * Runs a blitting kernel over the destination pixels, which are clipped
+ * once for the whole blit
+ */
+template<typename TSRC, typename TDEST, class Kernel>
+static void blitWithKernel(const Surface &src, const Common::Rect &srcRect, ManagedSurface &dest,
+		const Common::Rect &destRect, int scaleX, int scaleY, const Kernel &kernel) {
+	const int left = MAX<int>(destRect.left, 0);
+	const int right = MIN<int>(destRect.right, dest.w);
+	if (left >= right)
+		return;
+
+	const int startX = left - destRect.left;
+	const int width = right - left;
+	for (int destY = destRect.top, scaleYCtr = 0; destY < destRect.bottom; ++destY, scaleYCtr += scaleY) {
+		if (destY < 0 || destY >= dest.h)
+			continue;
+		const TSRC *srcP = (const TSRC *)src.getBasePtr(srcRect.left, scaleYCtr / SCALE_THRESHOLD + srcRect.top);
+		TDEST *destP = (TDEST *)dest.getBasePtr(left, destY);
+
+		if (scaleX == SCALE_THRESHOLD) {
+			srcP += startX;
+			if (Kernel::kCanCopyRows) {
+				Common::copy(srcP, srcP + width, destP);
+			} else {
+				for (int x = 0; x < width; ++x)
+					kernel(srcP[x], destP[x]);
+			}
+		} else {
+			for (int x = 0, scaleXCtr = startX * scaleX; x < width; ++x, scaleXCtr += scaleX)
+				kernel(srcP[scaleXCtr / SCALE_THRESHOLD], destP[x]);
+		}
+	}
+}
+
+/**
+ * Blits with the kernel specialised for the source and destination formats,
+ * if there is one. Returns false if the generic code has to be used.
+ */
+static bool blitFromSpecialised(const Surface &src, const Common::Rect &srcRect, ManagedSurface &dest,
+		const Common::Rect &destRect, int scaleX, int scaleY, const uint32 *srcPalette) {
+	const PixelFormat &format = dest.format;
+	if (format.bytesPerPixel == 1) {
+		if (src.format.bytesPerPixel != 1)
+			return false;
+		blitWithKernel<byte, byte>(src, srcRect, dest, destRect, scaleX, scaleY, CopyBlitKernel<byte>());
+		return true;
+	}
+
+	if (src.format.bytesPerPixel == 1) {
+		if (!srcPalette)
+			return false;
+		if (format.bytesPerPixel == 2) {
+			blitWithKernel<byte, uint16>(src, srcRect, dest, destRect, scaleX, scaleY, PaletteBlitKernel<uint16>(format, srcPalette));
+			return true;
+		} else if (format.bytesPerPixel == 4) {
+			blitWithKernel<byte, uint32>(src, srcRect, dest, destRect, scaleX, scaleY, PaletteBlitKernel<uint32>(format, srcPalette));
+			return true;
+		}
+		return false;
+	}
+
+	if (src.format != format || !isFullyPacked(format))
+		return false;
+
+	if (format.bytesPerPixel == 2) {
+		if (format.aBits() == 0)
+			blitWithKernel<uint16, uint16>(src, srcRect, dest, destRect, scaleX, scaleY, CopyBlitKernel<uint16>());
+		else
+			blitWithKernel<uint16, uint16>(src, srcRect, dest, destRect, scaleX, scaleY, AlphaBlitKernel<uint16>(format));
+		return true;
+	} else if (format.bytesPerPixel == 4) {
+		if (format.aBits() == 0)
+			blitWithKernel<uint32, uint32>(src, srcRect, dest, destRect, scaleX, scaleY, CopyBlitKernel<uint32>());
+		else
+			blitWithKernel<uint32, uint32>(src, srcRect, dest, destRect, scaleX, scaleY, AlphaBlitKernel<uint32>(format));
+		return true;
+	}
+
+	return false;
+}
+
 void ManagedSurface::blitFromInner(const Surface &src, const Common::Rect &srcRect,
 		const Common::Rect &destRect, const uint32 *srcPalette) {
 
@@ -253,7 +480,6 @@ void ManagedSurface::blitFromInner(const Surface &src, const Common::Rect &srcRe
 	const int scaleX = SCALE_THRESHOLD * srcRect.width() / destRect.width();
 	const int scaleY = SCALE_THRESHOLD * srcRect.height() / destRect.height();
 
-	uint destPixel;
 	byte rSrc, gSrc, bSrc, aSrc;
 	byte aDest = 0, rDest = 0, gDest = 0, bDest = 0;
 
@@ -268,6 +494,11 @@ void ManagedSurface::blitFromInner(const Surface &src, const Common::Rect &srcRe
 			|| (src.format.bytesPerPixel == 1 && srcPalette));
 	}
 
+	if (s_blitKernelsEnabled && blitFromSpecialised(src, srcRect, *this, destRect, scaleX, scaleY, srcPalette)) {
+		addDirtyRect(Common::Rect(0, 0, this->w, this->h));
+		return;
+	}
+
 	const bool noScale = scaleX == SCALE_THRESHOLD && scaleY == SCALE_THRESHOLD;
 	for (int destY = destRect.top, scaleYCtr = 0; destY < destRect.bottom; ++destY, scaleYCtr += scaleY) {
 		if (destY < 0 || destY >= h)
@@ -320,38 +551,10 @@ void ManagedSurface::blitFromInner(const Surface &src, const Common::Rect &srcRe
 				bDest = bSrc;
 			} else {
 				// Partially transparent, so calculate new pixel colors
-				if (format.bytesPerPixel == 2) {
-					uint32 destColor = *(uint16 *)destVal;
-					format.colorToARGB(destColor, aDest, rDest, gDest, bDest);
-				} else if (format.bytesPerPixel == 4) {
-					uint32 destColor = *(uint32 *)destVal;
-					format.colorToARGB(destColor, aDest, rDest, gDest, bDest);
-				} else {
-					aDest = 0xFF;
-					rDest = destVal[0];
-					gDest = destVal[1];
-					bDest = destVal[2];
-				}
-
-				double sAlpha = (double)aSrc / 255.0;
-				double dAlpha = (double)aDest / 255.0;
-				dAlpha *= (1.0 - sAlpha);
-				rDest = static_cast<uint8>((rSrc * sAlpha + rDest * dAlpha) / (sAlpha + dAlpha));
-				gDest = static_cast<uint8>((gSrc * sAlpha + gDest * dAlpha) / (sAlpha + dAlpha));
-				bDest = static_cast<uint8>((bSrc * sAlpha + bDest * dAlpha) / (sAlpha + dAlpha));
-				aDest = static_cast<uint8>(255. * (sAlpha + dAlpha));
+				blendPixel(format, destVal, aSrc, rSrc, gSrc, bSrc, aDest, rDest, gDest, bDest);
 			}
 
-			destPixel = format.ARGBToColor(aDest, rDest, gDest, bDest);
-			if (format.bytesPerPixel == 2)
-				*(uint16 *)destVal = destPixel;
-			else if (format.bytesPerPixel == 4)
-				*(uint32 *)destVal = destPixel;
-			else {
-				destVal[0] = rDest;
-				destVal[1] = gDest;
-				destVal[2] = bDest;
-			}
+			writePixel(format, destVal, aDest, rDest, gDest, bDest);
 		}
 	}
 
@@ -433,46 +636,9 @@ void ManagedSurface::transBlitFrom(const ManagedSurface &src, const Common::Rect
 		srcAlpha, srcPalette, dstPalette, mask, maskOnly);
 }
 
-static uint findBestColor(const uint32 *palette, byte cr, byte cg, byte cb) {
-	uint bestColor = 0;
-	double min = 0xFFFFFFFF;
-
-	for (uint i = 0; i < 256; ++i) {
-		uint col = palette[i];
-
-		int rmean = ((col & 0xff) + cr) / 2;
-		int r = (col & 0xff) - cr;
-		int g = ((col >> 8) & 0xff) - cg;
-		int b = ((col >> 16) & 0xff) - cb;
-
-		double dist = sqrt((((512 + rmean) * r * r) >> 8) + 4 * g * g + (((767 - rmean) * b * b) >> 8));
-		if (min > dist) {
-			bestColor = i;
-			min = dist;
-		}
-	}
-
-	return bestColor;
-}
-
-static byte *createPaletteLookup(const uint32 *srcPalette, const uint32 *dstPalette) {
-	byte *lookup = new byte[256];
-
-	for (int i = 0; i < 256; i++) {
-		uint col = srcPalette[i];
-		if (col == dstPalette[i]) {
-			lookup[i] = i;
-		} else {
-			lookup[i] = findBestColor(dstPalette, col & 0xff, (col >> 8) & 0xff, (col >> 16) & 0xff);
-		}
-	}
-
-	return lookup;
-}
-
 template<typename TSRC, typename TDEST>
 void transBlitPixel(TSRC srcVal, TDEST &destVal, const Graphics::PixelFormat &srcFormat, const Graphics::PixelFormat &destFormat,
-		uint overrideColor, uint srcAlpha, const uint32 *srcPalette, const byte *lookup) {
+		uint overrideColor, uint srcAlpha, const uint32 *srcPalette, const byte *lookup, bool integerBlend) {
 	// Decode and re-encode each pixel
 	byte aSrc, rSrc, gSrc, bSrc;
 	if (srcFormat.bytesPerPixel == 1) {
@@ -505,13 +671,17 @@ void transBlitPixel(TSRC srcVal, TDEST &destVal, const Graphics::PixelFormat &sr
 	} else {
 		// Partially transparent, so calculate new pixel colors
 		destFormat.colorToARGB(destVal, aDest, rDest, gDest, bDest);
-		double sAlpha = (double)aSrc / 255.0;
-		double dAlpha = (double)aDest / 255.0;
-		dAlpha *= (1.0 - sAlpha);
-		rDest = static_cast<uint8>((rSrc * sAlpha + rDest * dAlpha) / (sAlpha + dAlpha));
-		gDest = static_cast<uint8>((gSrc * sAlpha + gDest * dAlpha) / (sAlpha + dAlpha));
-		bDest = static_cast<uint8>((bSrc * sAlpha + bDest * dAlpha) / (sAlpha + dAlpha));
-		aDest = static_cast<uint8>(255. * (sAlpha + dAlpha));
+		if (integerBlend) {
+			blendColors(aSrc, rSrc, gSrc, bSrc, aDest, rDest, gDest, bDest);
+		} else {
+			double sAlpha = (double)aSrc / 255.0;
+			double dAlpha = (double)aDest / 255.0;
+			dAlpha *= (1.0 - sAlpha);
+			rDest = static_cast<uint8>((rSrc * sAlpha + rDest * dAlpha) / (sAlpha + dAlpha));
+			gDest = static_cast<uint8>((gSrc * sAlpha + gDest * dAlpha) / (sAlpha + dAlpha));
+			bDest = static_cast<uint8>((bSrc * sAlpha + bDest * dAlpha) / (sAlpha + dAlpha));
+			aDest = static_cast<uint8>(255. * (sAlpha + dAlpha));
+		}
 	}
 
 	destVal = destFormat.ARGBToColor(aDest, rDest, gDest, bDest);
@@ -519,7 +689,7 @@ void transBlitPixel(TSRC srcVal, TDEST &destVal, const Graphics::PixelFormat &sr
 
 template<>
 void transBlitPixel<byte, byte>(byte srcVal, byte &destVal, const Graphics::PixelFormat &srcFormat, const Graphics::PixelFormat &destFormat,
-		uint overrideColor, uint srcAlpha, const uint32 *srcPalette, const byte *lookup) {
+		uint overrideColor, uint srcAlpha, const uint32 *srcPalette, const byte *lookup, bool integerBlend) {
 	if (srcAlpha == 0) {
 		// Completely transparent, so skip
 		return;
@@ -540,9 +710,12 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, ManagedSurface &
 	byte rst = 0, gst = 0, bst = 0, rdt = 0, gdt = 0, bdt = 0;
 	byte r = 0, g = 0, b = 0;
 
-	byte *lookup = nullptr;
-	if (srcPalette && dstPalette)
-		lookup = createPaletteLookup(srcPalette, dstPalette);
+	// Only needed between two palettes, and not when they are the same
+	byte lookupTable[256];
+	const byte *lookup = nullptr;
+	if (sizeof(TSRC) == 1 && sizeof(TDEST) == 1 && srcPalette && dstPalette &&
+			!PaletteRemapMan.getRemap(srcPalette, dstPalette, lookupTable))
+		lookup = lookupTable;
 
 	// If we're dealing with a 32-bit source surface, we need to split up the RGB,
 	// since we'll want to find matching RGB pixels irrespective of the alpha
@@ -550,11 +723,33 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, ManagedSurface &
 	if (isSrcTrans32) {
 		src.format.colorToRGB(transColor, rst, gst, bst);
 	}
-	bool isDestTrans32 = dest.format.aBits() != 0 && dest.hasTransparentColor();
+	const bool hasDestTrans = dest.hasTransparentColor();
+	const uint destTransColor = hasDestTrans ? dest.getTransparentColor() : 0;
+	bool isDestTrans32 = dest.format.aBits() != 0 && hasDestTrans;
 	if (isDestTrans32) {
-		dest.format.colorToRGB(dest.getTransparentColor(), rdt, gdt, bdt);
+		dest.format.colorToRGB(destTransColor, rdt, gdt, bdt);
+	}
+
+	// Fully opaque pixels which can be stored without decoding them: pixels
+	// of the same format, or palette colors converted once for the blit.
+	// The other pixels are blended in integers.
+	const bool kernels = s_blitKernelsEnabled && srcAlpha == 0xff && !mask;
+	const bool copyOpaque = kernels && sizeof(TSRC) > 1 && sizeof(TSRC) == sizeof(TDEST) &&
+		src.format == dest.format && isFullyPacked(src.format);
+	const uint32 srcAlphaMask = alphaMask(src.format);
+	uint32 *paletteColors = nullptr;
+	if (kernels && sizeof(TSRC) == 1 && sizeof(TDEST) > 1 && srcPalette) {
+		paletteColors = new uint32[256];
+		for (int i = 0; i < 256; ++i) {
+			const uint32 col = srcPalette[i];
+			paletteColors[i] = dest.format.ARGBToColor(0xff, col & 0xff, (col >> 8) & 0xff, (col >> 16) & 0xff);
+		}
 	}
 
+	// Clip the rows once, rather than for every pixel
+	const int left = MAX<int>(destRect.left, 0);
+	const int right = MIN<int>(destRect.right, dest.w);
+
 	// Loop through drawing output lines
 	for (int destY = destRect.top, scaleYCtr = 0; destY < destRect.bottom; ++destY, scaleYCtr += scaleY) {
 		if (destY < 0 || destY >= dest.h)
@@ -568,23 +763,18 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, ManagedSurface &
 		TDEST *destLine = (TDEST *)dest.getBasePtr(destRect.left, destY);
 
 		// Loop through drawing the pixels of the row
-		for (int destX = destRect.left, xCtr = 0, scaleXCtr = 0; destX < destRect.right; ++destX, ++xCtr, scaleXCtr += scaleX) {
-			if (destX < 0 || destX >= dest.w)
-				continue;
-
+		for (int destX = left, xCtr = left - destRect.left, scaleXCtr = xCtr * scaleX; destX < right; ++destX, ++xCtr, scaleXCtr += scaleX) {
 			TSRC srcVal = srcLine[flipped ? src.w - scaleXCtr / SCALE_THRESHOLD - 1 : scaleXCtr / SCALE_THRESHOLD];
 			TDEST &destVal = destLine[xCtr];
 
-			dest.format.colorToRGB(destVal, r, g, b);
-
 			// Check if dest pixel is transparent
 			bool isDestPixelTrans = false;
 			if (isDestTrans32) {
 				dest.format.colorToRGB(destVal, r, g, b);
 				if (rdt == r && gdt == g && bdt == b)
 					isDestPixelTrans = true;
-			} else if (dest.hasTransparentColor()) {
-				isDestPixelTrans = destVal == dest.getTransparentColor();
+			} else if (hasDestTrans) {
+				isDestPixelTrans = destVal == destTransColor;
 			}
 
 			if (isSrcTrans32 && !maskOnly) {
@@ -604,18 +794,22 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, ManagedSurface &
 					// Remove transparent color on dest so it isn't alpha blended
 					destVal = 0;
 
-				transBlitPixel<TSRC, TDEST>(srcVal, destVal, src.format, dest.format, overrideColor, mskVal, srcPalette, lookup);
+				transBlitPixel<TSRC, TDEST>(srcVal, destVal, src.format, dest.format, overrideColor, mskVal, srcPalette, lookup, false);
+			} else if (copyOpaque && (srcVal & srcAlphaMask) == srcAlphaMask) {
+				destVal = srcVal;
+			} else if (paletteColors && (srcPalette[srcVal] >> 24) == 0xff) {
+				destVal = paletteColors[srcVal];
 			} else {
 				if (isDestPixelTrans)
 					// Remove transparent color on dest so it isn't alpha blended
 					destVal = 0;
 
-				transBlitPixel<TSRC, TDEST>(srcVal, destVal, src.format, dest.format, overrideColor, srcAlpha, srcPalette, lookup);
+				transBlitPixel<TSRC, TDEST>(srcVal, destVal, src.format, dest.format, overrideColor, srcAlpha, srcPalette, lookup, kernels);
 			}
 		}
 	}
 
-	delete[] lookup;
+	delete[] paletteColors;
 }
 
 #define HANDLE_BLIT(SRC_BYTES, DEST_BYTES, SRC_TYPE, DEST_TYPE) \
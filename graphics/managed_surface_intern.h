@@ -0,0 +1,39 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_MANAGED_SURFACE_INTERN_H
+#define GRAPHICS_MANAGED_SURFACE_INTERN_H
+
+namespace Graphics {
+
+/**
+ * Enable or disable the blitting code of ManagedSurface specialised for
+ * the common pixel formats, so that the tests can compare it with the
+ * generic code. It is enabled by default. It blends the partially
+ * transparent pixels in integers, so their color components can be one
+ * more than with the double arithmetic of the generic code.
+ */
+void setBlitKernels(bool enable);
+
+} // End of namespace Graphics
+
+#endif
@@ -27,6 +27,7 @@ MODULE_OBJS := \
 	macgui/macwindowmanager.o \
 	managed_surface.o \
 	nine_patch.o \
+	palette_remap.o \
 	pixelformat.o \
 	primitives.o \
 	renderer.o \
@@ -100,7 +101,8 @@ endif
 ifdef USE_HQ_SCALERS
 MODULE_OBJS += \
 	scaler/hq2x.o \
-	scaler/hq3x.o
+	scaler/hq3x.o \
+	scaler/hqx_pattern.o
 
 ifdef USE_NASM
 MODULE_OBJS += \
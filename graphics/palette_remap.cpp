@@ -0,0 +1,201 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/palette_remap.h"
+
+namespace Common {
+DECLARE_SINGLETON(Graphics::PaletteRemapCache);
+}
+
+namespace Graphics {
+
+namespace {
+
+/**
+ * Weighted distance between two colors, which takes into account the
+ * average red of both colors. This is the squared distance, since only
+ * the order matters.
+ */
+inline int colorDistance(uint32 col, byte cr, byte cg, byte cb) {
+	int rmean = ((col & 0xff) + cr) / 2;
+	int r = (col & 0xff) - cr;
+	int g = ((col >> 8) & 0xff) - cg;
+	int b = ((col >> 16) & 0xff) - cb;
+
+	return (((512 + rmean) * r * r) >> 8) + 4 * g * g + (((767 - rmean) * b * b) >> 8);
+}
+
+/**
+ * Nearest color search, with the palette sorted by green. The green distance
+ * alone is a lower bound of the color distance, so the search goes outwards
+ * from the wanted green and stops as soon as that bound exceeds the best
+ * distance found.
+ */
+class NearestColorFinder {
+public:
+	NearestColorFinder(const uint32 *palette) : _palette(palette) {
+		uint count[256];
+		memset(count, 0, sizeof(count));
+		for (int i = 0; i < 256; ++i)
+			++count[(palette[i] >> 8) & 0xff];
+
+		_start[0] = 0;
+		for (int i = 0; i < 256; ++i)
+			_start[i + 1] = _start[i] + count[i];
+
+		// Sort while keeping the order of the indices with the same green
+		uint16 pos[256];
+		memcpy(pos, _start, sizeof(pos));
+		for (int i = 0; i < 256; ++i) {
+			const byte green = (palette[i] >> 8) & 0xff;
+			_order[pos[green]] = i;
+			_green[pos[green]] = green;
+			++pos[green];
+		}
+	}
+
+	uint find(byte cr, byte cg, byte cb) const {
+		uint best = 0;
+		int bestDist = 0x7fffffff;
+		const int start = _start[cg];
+
+		for (int i = start; i < 256; ++i) {
+			const int dg = _green[i] - cg;
+			if (4 * dg * dg > bestDist)
+				break;
+			check(_order[i], cr, cg, cb, best, bestDist);
+		}
+
+		for (int i = start - 1; i >= 0; --i) {
+			const int dg = _green[i] - cg;
+			if (4 * dg * dg > bestDist)
+				break;
+			check(_order[i], cr, cg, cb, best, bestDist);
+		}
+
+		return best;
+	}
+
+private:
+	void check(uint index, byte cr, byte cg, byte cb, uint &best, int &bestDist) const {
+		const int dist = colorDistance(_palette[index], cr, cg, cb);
+		if (dist < bestDist || (dist == bestDist && index < best)) {
+			best = index;
+			bestDist = dist;
+		}
+	}
+
+	const uint32 *_palette;
+	/** Palette indices sorted by green */
+	byte _order[256];
+	/** Green of the sorted colors */
+	byte _green[256];
+	/** Position of the first sorted color with at least the given green */
+	uint16 _start[257];
+};
+
+} // End of anonymous namespace
+
+uint findBestColor(const uint32 *palette, byte r, byte g, byte b) {
+	uint bestColor = 0;
+	int min = 0x7fffffff;
+
+	for (uint i = 0; i < 256; ++i) {
+		const int dist = colorDistance(palette[i], r, g, b);
+		if (min > dist) {
+			bestColor = i;
+			min = dist;
+		}
+	}
+
+	return bestColor;
+}
+
+PaletteRemapCache::PaletteRemapCache() : _tables(16) {
+}
+
+void PaletteRemapCache::clear() {
+	_tables.clear();
+}
+
+void PaletteRemapCache::setMaxEntries(uint maxEntries) {
+	_tables.setCapacity(MAX<uint>(maxEntries, 1));
+}
+
+uint PaletteRemapCache::PalettePairHash::operator()(const PalettePair &pair) const {
+	// FNV-1a over both palettes
+	uint32 hash = 2166136261U;
+	for (int i = 0; i < 256; ++i)
+		hash = (hash ^ pair.srcPalette[i]) * 16777619U;
+	for (int i = 0; i < 256; ++i)
+		hash = (hash ^ pair.dstPalette[i]) * 16777619U;
+	return hash;
+}
+
+bool PaletteRemapCache::PalettePairEqual::operator()(const PalettePair &x, const PalettePair &y) const {
+	return !memcmp(x.srcPalette, y.srcPalette, sizeof(x.srcPalette)) &&
+		!memcmp(x.dstPalette, y.dstPalette, sizeof(x.dstPalette));
+}
+
+bool PaletteRemapCache::createRemap(const uint32 *srcPalette, const uint32 *dstPalette, byte *map) {
+	NearestColorFinder finder(dstPalette);
+	bool identity = true;
+
+	for (int i = 0; i < 256; i++) {
+		const uint32 col = srcPalette[i];
+		if (col == dstPalette[i]) {
+			map[i] = i;
+		} else {
+			map[i] = finder.find(col & 0xff, (col >> 8) & 0xff, (col >> 16) & 0xff);
+			identity = identity && map[i] == i;
+		}
+	}
+
+	return identity;
+}
+
+bool PaletteRemapCache::getRemap(const uint32 *srcPalette, const uint32 *dstPalette, byte *map) {
+	memcpy(_key.srcPalette, srcPalette, sizeof(_key.srcPalette));
+	memcpy(_key.dstPalette, dstPalette, sizeof(_key.dstPalette));
+
+	const RemapTable *table = _tables.find(_key);
+	if (!table) {
+		RemapTable newTable;
+		newTable.identity = createRemap(srcPalette, dstPalette, newTable.map);
+		table = &_tables.insert(_key, newTable);
+	}
+
+	memcpy(map, table->map, sizeof(table->map));
+	return table->identity;
+}
+
+bool PaletteRemapCache::getRemapRGB(const byte *srcPalette, const byte *dstPalette, byte *map) {
+	uint32 src[256], dst[256];
+	for (int i = 0; i < 256; ++i) {
+		src[i] = 0xff000000 | (srcPalette[i * 3 + 2] << 16) | (srcPalette[i * 3 + 1] << 8) | srcPalette[i * 3];
+		dst[i] = 0xff000000 | (dstPalette[i * 3 + 2] << 16) | (dstPalette[i * 3 + 1] << 8) | dstPalette[i * 3];
+	}
+
+	return getRemap(src, dst, map);
+}
+
+} // End of namespace Graphics
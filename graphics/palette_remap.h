@@ -0,0 +1,129 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_PALETTE_REMAP_H
+#define GRAPHICS_PALETTE_REMAP_H
+
+#include "common/scummsys.h"
+#include "common/lru-cache.h"
+#include "common/singleton.h"
+
+namespace Graphics {
+
+/**
+ * @defgroup graphics_palette_remap Palette remapping
+ * @ingroup graphics
+ *
+ * @brief Tables mapping the colors of one palette to the closest colors of another.
+ *
+ * @{
+ */
+
+/**
+ * Find the color of a 256 color palette which is the closest to the given
+ * color. On ties, the lowest index is returned.
+ *
+ * The palette entries are in the format used by ManagedSurface: red in the
+ * lowest byte, then green, blue and alpha. The alpha is ignored.
+ */
+uint findBestColor(const uint32 *palette, byte r, byte g, byte b);
+
+/**
+ * Cache of the remap tables between pairs of 256 color palettes.
+ *
+ * Building a table requires a nearest color search for every source color,
+ * so the tables for the most recently used pairs of palettes are kept. This
+ * is shared between all the users, such as the transparent blits between
+ * CLUT8 surfaces and engines doing palette fades and remaps.
+ */
+class PaletteRemapCache : public Common::Singleton<PaletteRemapCache> {
+public:
+	/**
+	 * Get the table which maps each color of the source palette to the
+	 * closest color of the destination palette. Colors which are identical in
+	 * both palettes are kept.
+	 *
+	 * The palettes are in the format used by ManagedSurface.
+	 *
+	 * @param srcPalette	the 256 colors of the source palette
+	 * @param dstPalette	the 256 colors of the destination palette
+	 * @param map			filled with the 256 destination colors
+	 * @return true if the table is an identity mapping
+	 */
+	bool getRemap(const uint32 *srcPalette, const uint32 *dstPalette, byte *map);
+
+	/**
+	 * Same as getRemap, for palettes of 256 RGB triplets as used by
+	 * PaletteManager::setPalette.
+	 */
+	bool getRemapRGB(const byte *srcPalette, const byte *dstPalette, byte *map);
+
+	/** Discard all the cached tables. */
+	void clear();
+
+	/** Set the number of tables which are kept. */
+	void setMaxEntries(uint maxEntries);
+
+	/** Number of tables which were found in the cache. */
+	uint32 getHits() const { return _tables.getHits(); }
+
+	/** Number of tables which had to be built. */
+	uint32 getMisses() const { return _tables.getMisses(); }
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	PaletteRemapCache();
+
+	struct PalettePair {
+		uint32 srcPalette[256];
+		uint32 dstPalette[256];
+	};
+
+	struct PalettePairHash {
+		uint operator()(const PalettePair &pair) const;
+	};
+
+	struct PalettePairEqual {
+		bool operator()(const PalettePair &x, const PalettePair &y) const;
+	};
+
+	struct RemapTable {
+		byte map[256];
+		bool identity;
+	};
+
+	static bool createRemap(const uint32 *srcPalette, const uint32 *dstPalette, byte *map);
+
+	/** Tables of the most recently used palette pairs */
+	Common::LRUCache<PalettePair, RemapTable, PalettePairHash, PalettePairEqual> _tables;
+	/** Key of the lookups, a member since it is large for the stacks of some ports */
+	PalettePair _key;
+};
+
+/** Shortcut for accessing the palette remap cache. */
+#define PaletteRemapMan (::Graphics::PaletteRemapCache::instance())
+
+/** @} */
+
+} // End of namespace Graphics
+
+#endif
@@ -135,25 +135,25 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w5 = *(p);
 		w8 = *(p + nextlineSrc);
 
+		// The patterns are computed for a whole chunk of the row at once,
+		// which allows computeHQxPatterns to use SIMD code.
+		uint8 patterns[kHQxPatternChunk];
+		int patternIndex = kHQxPatternChunk;
+
 		int tmpWidth = width;
 		while (tmpWidth--) {
+			if (patternIndex == kHQxPatternChunk) {
+				computeHQxPatterns(p, nextlineSrc, patterns, tmpWidth < kHQxPatternChunk ? tmpWidth + 1 : kHQxPatternChunk);
+				patternIndex = 0;
+			}
+			const int pattern = patterns[patternIndex++];
+
 			p++;
 
 			w3 = *(p - nextlineSrc);
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
-
 			switch (pattern) {
 			case 0:
 			case 1:
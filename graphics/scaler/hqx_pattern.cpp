@@ -0,0 +1,227 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/scaler/intern.h"
+#include "graphics/scaler.h"
+#include "graphics/pixelformat.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HQX_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HQX_USE_NEON
+#endif
+
+extern "C" uint32 *RGBtoYUV;
+
+/**
+ * Reference implementation, based on the RGBtoYUV lookup table.
+ */
+static void computeHQxPatternsGeneric(const uint16 *p, uint32 nextlineSrc, uint8 *patterns, int width) {
+	for (int i = 0; i < width; ++i, ++p) {
+		const uint16 w5 = *p;
+		const uint16 w[8] = {
+			*(p - 1 - nextlineSrc), *(p - nextlineSrc), *(p + 1 - nextlineSrc),
+			*(p - 1),                                   *(p + 1),
+			*(p - 1 + nextlineSrc), *(p + nextlineSrc), *(p + 1 + nextlineSrc)
+		};
+
+		int pattern = 0;
+		const int yuv5 = RGBtoYUV[w5];
+		for (int j = 0; j < 8; ++j) {
+			if (w5 != w[j] && diffYUV(yuv5, RGBtoYUV[w[j]]))
+				pattern |= 1 << j;
+		}
+		patterns[i] = pattern;
+	}
+}
+
+#if defined(HQX_USE_SSE2) || defined(HQX_USE_NEON)
+
+/*
+ * The vectorized versions compute the YUV values on the fly instead of using
+ * the lookup table, in exactly the same way InitLUT() does. This only holds
+ * for the 565 and 555 formats, which is all the HQ scalers support.
+ *
+ *   Y = (r + g + b) >> 2
+ *   U = 128 + ((r - b) >> 2)
+ *   V = 128 + ((-r + 2 * g - b) >> 3)
+ *
+ * The offset of 128 cancels out in the comparison and is left out.
+ */
+
+#ifdef HQX_USE_SSE2
+
+struct YUVVector {
+	__m128i y, u, v;
+};
+
+template<int bits>
+static inline __m128i expandComponent(__m128i value) {
+	return _mm_or_si128(_mm_slli_epi16(value, 8 - bits), _mm_srli_epi16(value, 2 * bits - 8));
+}
+
+template<typename ColorMask>
+static inline YUVVector computeYUV(const uint16 *ptr) {
+	const __m128i pixels = _mm_loadu_si128((const __m128i *)ptr);
+
+	const __m128i r = expandComponent<ColorMask::kRedBits>(_mm_and_si128(_mm_srli_epi16(pixels, ColorMask::kRedShift), _mm_set1_epi16((1 << ColorMask::kRedBits) - 1)));
+	const __m128i g = expandComponent<ColorMask::kGreenBits>(_mm_and_si128(_mm_srli_epi16(pixels, ColorMask::kGreenShift), _mm_set1_epi16((1 << ColorMask::kGreenBits) - 1)));
+	const __m128i b = expandComponent<ColorMask::kBlueBits>(_mm_and_si128(_mm_srli_epi16(pixels, ColorMask::kBlueShift), _mm_set1_epi16((1 << ColorMask::kBlueBits) - 1)));
+
+	YUVVector yuv;
+	yuv.y = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(r, g), b), 2);
+	yuv.u = _mm_srai_epi16(_mm_sub_epi16(r, b), 2);
+	yuv.v = _mm_srai_epi16(_mm_sub_epi16(_mm_slli_epi16(g, 1), _mm_add_epi16(r, b)), 3);
+	return yuv;
+}
+
+static inline __m128i absDiff(__m128i a, __m128i b) {
+	return _mm_max_epi16(_mm_sub_epi16(a, b), _mm_sub_epi16(b, a));
+}
+
+/** Returns 0xFF in each of the low 8 bytes whose pixels differ by more than the thresholds. */
+static inline __m128i diffYUVVector(const YUVVector &a, const YUVVector &b) {
+	const __m128i diffY = _mm_cmpgt_epi16(absDiff(a.y, b.y), _mm_set1_epi16(0x30));
+	const __m128i diffU = _mm_cmpgt_epi16(absDiff(a.u, b.u), _mm_set1_epi16(0x07));
+	const __m128i diffV = _mm_cmpgt_epi16(absDiff(a.v, b.v), _mm_set1_epi16(0x06));
+	const __m128i diff = _mm_or_si128(_mm_or_si128(diffY, diffU), diffV);
+	return _mm_packs_epi16(diff, _mm_setzero_si128());
+}
+
+template<typename ColorMask>
+static void computeHQxPatternsSIMD(const uint16 *p, uint32 nextlineSrc, uint8 *patterns, int width) {
+	const int offsets[8] = {
+		-1 - (int)nextlineSrc, -(int)nextlineSrc, 1 - (int)nextlineSrc,
+		-1,                                       1,
+		-1 + (int)nextlineSrc, (int)nextlineSrc,  1 + (int)nextlineSrc
+	};
+
+	int i = 0;
+	for (; i + 8 <= width; i += 8, p += 8) {
+		const YUVVector yuv5 = computeYUV<ColorMask>(p);
+
+		__m128i pattern = _mm_setzero_si128();
+		for (int j = 0; j < 8; ++j) {
+			const __m128i diff = diffYUVVector(yuv5, computeYUV<ColorMask>(p + offsets[j]));
+			pattern = _mm_or_si128(pattern, _mm_and_si128(diff, _mm_set1_epi8(1 << j)));
+		}
+		_mm_storel_epi64((__m128i *)(patterns + i), pattern);
+	}
+
+	computeHQxPatternsGeneric(p, nextlineSrc, patterns + i, width - i);
+}
+
+#else // HQX_USE_NEON
+
+struct YUVVector {
+	int16x8_t y, u, v;
+};
+
+template<int bits>
+static inline uint16x8_t expandComponent(uint16x8_t value) {
+	return vorrq_u16(vshlq_n_u16(value, 8 - bits), vshrq_n_u16(value, 2 * bits - 8));
+}
+
+template<typename ColorMask>
+static inline YUVVector computeYUV(const uint16 *ptr) {
+	const uint16x8_t pixels = vld1q_u16(ptr);
+
+	const uint16x8_t r = expandComponent<ColorMask::kRedBits>(vandq_u16(vshrq_n_u16(pixels, ColorMask::kRedShift), vdupq_n_u16((1 << ColorMask::kRedBits) - 1)));
+	const uint16x8_t g = expandComponent<ColorMask::kGreenBits>(vandq_u16(vshrq_n_u16(pixels, ColorMask::kGreenShift), vdupq_n_u16((1 << ColorMask::kGreenBits) - 1)));
+	const uint16x8_t b = expandComponent<ColorMask::kBlueBits>(vandq_u16(pixels, vdupq_n_u16((1 << ColorMask::kBlueBits) - 1)));
+
+	const int16x8_t sr = vreinterpretq_s16_u16(r);
+	const int16x8_t sg = vreinterpretq_s16_u16(g);
+	const int16x8_t sb = vreinterpretq_s16_u16(b);
+
+	YUVVector yuv;
+	yuv.y = vshrq_n_s16(vaddq_s16(vaddq_s16(sr, sg), sb), 2);
+	yuv.u = vshrq_n_s16(vsubq_s16(sr, sb), 2);
+	yuv.v = vshrq_n_s16(vsubq_s16(vshlq_n_s16(sg, 1), vaddq_s16(sr, sb)), 3);
+	return yuv;
+}
+
+/** Returns 0xFF in each byte whose pixels differ by more than the thresholds. */
+static inline uint8x8_t diffYUVVector(const YUVVector &a, const YUVVector &b) {
+	const uint16x8_t diffY = vcgtq_s16(vabdq_s16(a.y, b.y), vdupq_n_s16(0x30));
+	const uint16x8_t diffU = vcgtq_s16(vabdq_s16(a.u, b.u), vdupq_n_s16(0x07));
+	const uint16x8_t diffV = vcgtq_s16(vabdq_s16(a.v, b.v), vdupq_n_s16(0x06));
+	return vmovn_u16(vorrq_u16(vorrq_u16(diffY, diffU), diffV));
+}
+
+template<typename ColorMask>
+static void computeHQxPatternsSIMD(const uint16 *p, uint32 nextlineSrc, uint8 *patterns, int width) {
+	const int offsets[8] = {
+		-1 - (int)nextlineSrc, -(int)nextlineSrc, 1 - (int)nextlineSrc,
+		-1,                                       1,
+		-1 + (int)nextlineSrc, (int)nextlineSrc,  1 + (int)nextlineSrc
+	};
+
+	int i = 0;
+	for (; i + 8 <= width; i += 8, p += 8) {
+		const YUVVector yuv5 = computeYUV<ColorMask>(p);
+
+		uint8x8_t pattern = vdup_n_u8(0);
+		for (int j = 0; j < 8; ++j) {
+			const uint8x8_t diff = diffYUVVector(yuv5, computeYUV<ColorMask>(p + offsets[j]));
+			pattern = vorr_u8(pattern, vand_u8(diff, vdup_n_u8(1 << j)));
+		}
+		vst1_u8(patterns + i, pattern);
+	}
+
+	computeHQxPatternsGeneric(p, nextlineSrc, patterns + i, width - i);
+}
+
+#endif
+
+#endif // HQX_USE_SSE2 || HQX_USE_NEON
+
+HQxPatternProc computeHQxPatterns = computeHQxPatternsGeneric;
+
+static HQxPatternProc s_hqxSIMDPatternProc = 0;
+static bool s_hqxSIMDEnabled = true;
+
+void InitHQxPatterns(const Graphics::PixelFormat &format) {
+	s_hqxSIMDPatternProc = 0;
+#if defined(HQX_USE_SSE2) || defined(HQX_USE_NEON)
+	if (format == Graphics::createPixelFormat<565>())
+		s_hqxSIMDPatternProc = computeHQxPatternsSIMD<Graphics::ColorMasks<565> >;
+	else if (format == Graphics::createPixelFormat<555>())
+		s_hqxSIMDPatternProc = computeHQxPatternsSIMD<Graphics::ColorMasks<555> >;
+#endif
+
+	setHQScalersSIMD(s_hqxSIMDEnabled);
+}
+
+bool setHQScalersSIMD(bool enable) {
+	s_hqxSIMDEnabled = enable;
+
+	if (enable && s_hqxSIMDPatternProc) {
+		computeHQxPatterns = s_hqxSIMDPatternProc;
+		return true;
+	}
+
+	computeHQxPatterns = computeHQxPatternsGeneric;
+	return false;
+}
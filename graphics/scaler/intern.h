@@ -26,6 +26,10 @@
 #include "common/scummsys.h"
 #include "graphics/colormasks.h"
 
+namespace Graphics {
+struct PixelFormat;
+}
+
 
 /**
  * Interpolate two 16 bit pixel *pairs* at once with equal weights 1.
@@ -485,6 +489,46 @@ static inline unsigned interpolate16_1_1_1_1(unsigned p1, unsigned p2, unsigned
 	return ((p1+p2+p3+p4) - lowbits) >> 2;
 }
 
+#ifdef USE_HQ_SCALERS
+
+enum {
+	/** Number of pixels the HQ scalers compute patterns for in one go. */
+	kHQxPatternChunk = 256
+};
+
+/**
+ * Compute the neighbourhood patterns used by the HQ scalers for a run of
+ * pixels of one row. For each pixel, bit n of the pattern is set if the
+ * (n + 1)th neighbour (in the order w1, w2, w3, w4, w6, w7, w8, w9) differs
+ * from the pixel according to diffYUV.
+ *
+ * @param p           first pixel of the run
+ * @param nextlineSrc source pitch in pixels
+ * @param patterns    receives one pattern per pixel
+ * @param width       number of pixels in the run
+ */
+typedef void (*HQxPatternProc)(const uint16 *p, uint32 nextlineSrc, uint8 *patterns, int width);
+
+/**
+ * The pattern implementation in use. Points to a vectorized version when the
+ * CPU and the pixel format allow it.
+ */
+extern HQxPatternProc computeHQxPatterns;
+
+/** Select the pattern implementation for the given format. Called by InitLUT. */
+void InitHQxPatterns(const Graphics::PixelFormat &format);
+
+/**
+ * Enable or disable the SIMD code paths of the HQ scalers, so that the tests
+ * can compare them with the generic C code. They are enabled by default and
+ * used whenever the CPU and the pixel format support them.
+ *
+ * @return whether the SIMD code paths are in use after the call
+ */
+bool setHQScalersSIMD(bool enable);
+
+#endif
+
 /**
  * Compare two YUV values (encoded 8-8-8) and check if they differ by more than
  * a certain hard coded threshold. Used by the hq scaler family.
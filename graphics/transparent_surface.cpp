@@ -36,8 +36,14 @@
 #include "graphics/conversion.h"
 #include "graphics/primitives.h"
 #include "graphics/transparent_surface.h"
+#include "graphics/transparent_surface_intern.h"
 #include "graphics/transform_tools.h"
 
+#if defined(__SSE2__) && defined(SCUMM_LITTLE_ENDIAN)
+#include <emmintrin.h>
+#define TRANSPARENT_USE_SSE2
+#endif
+
 namespace Graphics {
 
 static const int kBModShift = 0;//img->format.bShift;
@@ -82,6 +88,177 @@ TransparentSurface::TransparentSurface(const Surface &surf, bool copyData) : Sur
 	}
 }
 
+static bool s_blendSIMDEnabled = true;
+
+bool setTransparentSurfaceSIMD(bool enable) {
+	s_blendSIMDEnabled = enable;
+#ifdef TRANSPARENT_USE_SSE2
+	return enable;
+#else
+	return false;
+#endif
+}
+
+#ifdef TRANSPARENT_USE_SSE2
+
+/*
+ * The SSE2 versions blend four pixels at a time, with the color components
+ * widened to 16 bits. They compute the same results as the C loops: all the
+ * products fit in 16 bits, and the products which the C code shifts right by
+ * 16 are the high halves of 16 bit multiplications. The alpha is in the
+ * lowest byte of each pixel. The subtractive blending with color modulation
+ * has products which do not fit, so it has no SSE2 version.
+ */
+
+static inline __m128i selectBits(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/** The alpha of each of the two pixels, in all their components */
+static inline __m128i broadcastAlpha(__m128i pixels) {
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0x00), 0x00);
+}
+
+/** Mask of the alpha components of two widened pixels */
+static inline __m128i alphaComponents() {
+	return _mm_set_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+}
+
+/** Color modulation factors of the widened red, green and blue components */
+static inline __m128i colorFactors(byte cr, byte cg, byte cb) {
+	return _mm_set_epi16(cr, cg, cb, 0, cr, cg, cb, 0);
+}
+
+/** Mask of the components whose color modulation factor is not 255 */
+static inline __m128i modulatedComponents(byte cr, byte cg, byte cb) {
+	return _mm_set_epi16(cr != 255 ? -1 : 0, cg != 255 ? -1 : 0, cb != 255 ? -1 : 0, 0,
+	                     cr != 255 ? -1 : 0, cg != 255 ? -1 : 0, cb != 255 ? -1 : 0, 0);
+}
+
+/** Four input pixels, in the order in which they are written */
+static inline __m128i loadPixels(const byte *in, int32 inStep) {
+	if (inStep > 0)
+		return _mm_loadu_si128((const __m128i *)in);
+	return _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - 12)), 0x1B);
+}
+
+/**
+ * Blend the pixels of a row four at a time, with an operation on two widened
+ * pixels. Returns the number of pixels blended, with the pointers past them.
+ */
+template<class Op>
+static inline uint32 blendRowSSE2(byte *&in, byte *&out, uint32 width, int32 inStep, const Op &op) {
+	const __m128i zero = _mm_setzero_si128();
+	uint32 j = 0;
+	for (; j + 4 <= width; j += 4) {
+		const __m128i src = loadPixels(in, inStep);
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+		const __m128i lo = op(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero));
+		const __m128i hi = op(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero));
+		_mm_storeu_si128((__m128i *)out, _mm_packus_epi16(lo, hi));
+		in += 4 * inStep;
+		out += 16;
+	}
+	return j;
+}
+
+static inline uint32 blitRowBinarySSE2(byte *&in, byte *&out, uint32 width, int32 inStep) {
+	const __m128i alpha = _mm_set1_epi32(0xff);
+	uint32 j = 0;
+	for (; j + 4 <= width; j += 4) {
+		const __m128i src = loadPixels(in, inStep);
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+		const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(src, alpha), _mm_setzero_si128());
+		_mm_storeu_si128((__m128i *)out, selectBits(transparent, dst, _mm_or_si128(src, alpha)));
+		in += 4 * inStep;
+		out += 16;
+	}
+	return j;
+}
+
+struct AlphaBlendOp {
+	__m128i operator()(__m128i src, __m128i dst) const {
+		const __m128i a = broadcastAlpha(src);
+		__m128i res = _mm_add_epi16(_mm_mullo_epi16(src, a), _mm_mullo_epi16(dst, _mm_sub_epi16(_mm_set1_epi16(255), a)));
+		res = selectBits(alphaComponents(), _mm_set1_epi16(255), _mm_srli_epi16(res, 8));
+		return selectBits(_mm_cmpeq_epi16(a, _mm_setzero_si128()), dst, res);
+	}
+};
+
+struct AlphaBlendColorOp {
+	AlphaBlendColorOp(byte ca, byte cr, byte cg, byte cb) : alpha(_mm_set1_epi16(ca)), color(colorFactors(cr, cg, cb)) {}
+
+	__m128i operator()(__m128i src, __m128i dst) const {
+		const __m128i ina = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlpha(src), alpha), 8);
+		const __m128i faded = _mm_srli_epi16(_mm_mullo_epi16(dst, _mm_sub_epi16(_mm_set1_epi16(255), ina)), 8);
+		__m128i res = _mm_add_epi16(faded, _mm_mulhi_epu16(_mm_mullo_epi16(src, ina), color));
+		res = selectBits(alphaComponents(), _mm_set1_epi16(255), res);
+		return selectBits(_mm_cmpeq_epi16(ina, _mm_setzero_si128()), dst, res);
+	}
+
+	__m128i alpha, color;
+};
+
+struct AdditiveBlendOp {
+	__m128i operator()(__m128i src, __m128i dst) const {
+		const __m128i res = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(src, broadcastAlpha(src)), 8), dst);
+		return selectBits(alphaComponents(), dst, res);
+	}
+};
+
+struct AdditiveBlendColorOp {
+	AdditiveBlendColorOp(byte ca, byte cr, byte cg, byte cb) :
+		alpha(_mm_set1_epi16(ca)), color(colorFactors(cr, cg, cb)), modulated(modulatedComponents(cr, cg, cb)) {}
+
+	__m128i operator()(__m128i src, __m128i dst) const {
+		const __m128i ina = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlpha(src), alpha), 8);
+		const __m128i product = _mm_mullo_epi16(src, ina);
+		const __m128i add = selectBits(modulated, _mm_mulhi_epu16(product, color), _mm_srli_epi16(product, 8));
+		return selectBits(alphaComponents(), dst, _mm_add_epi16(dst, add));
+	}
+
+	__m128i alpha, color, modulated;
+};
+
+struct SubtractiveBlendOp {
+	__m128i operator()(__m128i src, __m128i dst) const {
+		const __m128i sub = _mm_mulhi_epu16(_mm_mullo_epi16(src, dst), broadcastAlpha(src));
+		return selectBits(alphaComponents(), dst, _mm_sub_epi16(dst, sub));
+	}
+};
+
+struct MultiplyBlendOp {
+	__m128i operator()(__m128i src, __m128i dst) const {
+		const __m128i a = broadcastAlpha(src);
+		const __m128i factor = _mm_srli_epi16(_mm_mullo_epi16(src, a), 8);
+		const __m128i res = selectBits(alphaComponents(), dst, _mm_srli_epi16(_mm_mullo_epi16(factor, dst), 8));
+		return selectBits(_mm_cmpeq_epi16(a, _mm_setzero_si128()), dst, res);
+	}
+};
+
+struct MultiplyBlendColorOp {
+	MultiplyBlendColorOp(byte ca, byte cr, byte cg, byte cb) :
+		alpha(_mm_set1_epi16(ca)), color(colorFactors(cr, cg, cb)), modulated(modulatedComponents(cr, cg, cb)) {}
+
+	__m128i operator()(__m128i src, __m128i dst) const {
+		const __m128i ina = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlpha(src), alpha), 8);
+		const __m128i product = _mm_mullo_epi16(src, ina);
+		const __m128i factor = selectBits(modulated, _mm_mulhi_epu16(product, color), _mm_srli_epi16(product, 8));
+		return selectBits(alphaComponents(), dst, _mm_srli_epi16(_mm_mullo_epi16(dst, factor), 8));
+	}
+
+	__m128i alpha, color, modulated;
+};
+
+#define BLEND_ROW_SIMD(OP) \
+	(s_blendSIMDEnabled ? blendRowSSE2(in, out, width, inStep, OP) : 0)
+
+#else
+
+#define BLEND_ROW_SIMD(OP) 0
+
+#endif // TRANSPARENT_USE_SSE2
+
 /**
  * Optimized version of doBlit to be used w/opaque blitting (no alpha).
  */
@@ -114,7 +291,12 @@ void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 	for (uint32 i = 0; i < height; i++) {
 		out = outo;
 		in = ino;
-		for (uint32 j = 0; j < width; j++) {
+		uint32 j = 0;
+#ifdef TRANSPARENT_USE_SSE2
+		if (s_blendSIMDEnabled)
+			j = blitRowBinarySSE2(in, out, width, inStep);
+#endif
+		for (; j < width; j++) {
 			uint32 pix = *(uint32 *)in;
 			int a = in[kAIndex];
 
@@ -150,7 +332,7 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			for (uint32 j = BLEND_ROW_SIMD(AlphaBlendOp()); j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kAIndex] = 255;
@@ -175,7 +357,7 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			for (uint32 j = BLEND_ROW_SIMD(AlphaBlendColorOp(ca, cr, cg, cb)); j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 
@@ -211,7 +393,7 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			for (uint32 j = BLEND_ROW_SIMD(AdditiveBlendOp()); j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MIN((in[kRIndex] * in[kAIndex] >> 8) + out[kRIndex], 255);
@@ -235,7 +417,7 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			for (uint32 j = BLEND_ROW_SIMD(AdditiveBlendColorOp(ca, cr, cg, cb)); j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 
@@ -278,7 +460,7 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			for (uint32 j = BLEND_ROW_SIMD(SubtractiveBlendOp()); j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MAX(out[kRIndex] - ((in[kRIndex] * out[kRIndex]) * in[kAIndex] >> 16), 0);
@@ -342,7 +524,7 @@ void doBlitMultiplyBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			for (uint32 j = BLEND_ROW_SIMD(MultiplyBlendOp()); j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MIN((in[kRIndex] * in[kAIndex] >> 8) * out[kRIndex] >> 8, 255);
@@ -365,7 +547,7 @@ void doBlitMultiplyBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			for (uint32 j = BLEND_ROW_SIMD(MultiplyBlendColorOp(ca, cr, cg, cb)); j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 
@@ -1009,4 +1191,135 @@ TransparentSurface *TransparentSurface::rotoscale(const TransformStruct &transfo
 	return rotoscaleT<FILTER_BILINEAR>(transform);
 }
 
+TransformedSurfaceCache::TransformedSurfaceCache(uint32 maxBytes) : _maxBytes(maxBytes), _bytes(0), _hits(0), _misses(0) {
+}
+
+TransformedSurfaceCache::~TransformedSurfaceCache() {
+	clear();
+}
+
+uint TransformedSurfaceCache::KeyHash::operator()(const Key &key) const {
+	uint hash = (uint)(size_t)key.id;
+	hash = hash * 31 + (uint16)key.srcRect.left + ((uint)(uint16)key.srcRect.top << 16);
+	hash = hash * 31 + key.width + ((uint)key.height << 16);
+	hash = hash * 31 + key.angle + ((uint)key.flip << 24);
+	hash = hash * 31 + (uint16)key.zoom.x + ((uint)(uint16)key.zoom.y << 16);
+	hash = hash * 31 + (uint16)key.hotspot.x + ((uint)(uint16)key.hotspot.y << 16);
+	return hash;
+}
+
+const Surface *TransformedSurfaceCache::find(const Key &key) {
+	Common::HashMap<Key, EntryList::iterator, KeyHash>::iterator i = _index.find(key);
+	if (i == _index.end()) {
+		++_misses;
+		return nullptr;
+	}
+
+	++_hits;
+	EntryList::iterator entry = i->_value;
+	if (entry != _entries.begin()) {
+		_entries.push_front(*entry);
+		_entries.erase(entry);
+		i->_value = _entries.begin();
+	}
+	return _entries.front().surface;
+}
+
+const Surface *TransformedSurfaceCache::insert(const Key &key, Surface *surface) {
+	// The new copy is kept even if it exceeds the budget on its own, since
+	// it is returned to the caller
+	const uint32 bytes = surfaceBytes(surface);
+	while (!_entries.empty() && _bytes + bytes > _maxBytes)
+		removeOldest();
+
+	Entry entry;
+	entry.key = key;
+	entry.surface = surface;
+	_entries.push_front(entry);
+	_index[key] = _entries.begin();
+	_bytes += bytes;
+	return surface;
+}
+
+void TransformedSurfaceCache::removeOldest() {
+	Entry &entry = _entries.back();
+	_index.erase(entry.key);
+	_bytes -= surfaceBytes(entry.surface);
+	entry.surface->free();
+	delete entry.surface;
+	_entries.pop_back();
+}
+
+const Surface *TransformedSurfaceCache::rotoscale(const void *id, const Surface &src, const Common::Rect &srcRect, const TransformStruct &transform, bool filtering) {
+	Key key;
+	key.id = id;
+	key.srcRect = srcRect;
+	key.angle = transform._angle;
+	key.zoom = transform._zoom;
+	key.hotspot = transform._hotspot;
+	key.flip = transform._flip;
+	key.filtering = filtering;
+
+	const Surface *cached = find(key);
+	if (cached)
+		return cached;
+
+	TransparentSurface part;
+	part.copyFrom(src.getSubArea(srcRect));
+	Surface *result;
+	if (filtering)
+		result = part.rotoscaleT<FILTER_BILINEAR>(transform);
+	else
+		result = part.rotoscaleT<FILTER_NEAREST>(transform);
+	part.free();
+
+	return insert(key, result);
+}
+
+const Surface *TransformedSurfaceCache::scale(const void *id, const Surface &src, const Common::Rect &srcRect, uint16 newWidth, uint16 newHeight, bool filtering) {
+	Key key;
+	key.id = id;
+	key.srcRect = srcRect;
+	key.width = newWidth;
+	key.height = newHeight;
+	key.filtering = filtering;
+
+	const Surface *cached = find(key);
+	if (cached)
+		return cached;
+
+	Surface part;
+	part.copyFrom(src.getSubArea(srcRect));
+	Surface *result = part.scale(newWidth, newHeight, filtering);
+	part.free();
+
+	return insert(key, result);
+}
+
+void TransformedSurfaceCache::invalidate(const void *id) {
+	EntryList::iterator i = _entries.begin();
+	while (i != _entries.end()) {
+		if (i->key.id == id) {
+			_index.erase(i->key);
+			_bytes -= surfaceBytes(i->surface);
+			i->surface->free();
+			delete i->surface;
+			i = _entries.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+void TransformedSurfaceCache::clear() {
+	while (!_entries.empty())
+		removeOldest();
+}
+
+void TransformedSurfaceCache::setMaxBytes(uint32 maxBytes) {
+	_maxBytes = maxBytes;
+	while (!_entries.empty() && _bytes > _maxBytes)
+		removeOldest();
+}
+
 } // End of namespace Graphics
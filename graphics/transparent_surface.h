@@ -23,6 +23,8 @@
 #ifndef GRAPHICS_TRANSPARENTSURFACE_H
 #define GRAPHICS_TRANSPARENTSURFACE_H
 
+#include "common/hashmap.h"
+#include "common/list.h"
 #include "graphics/surface.h"
 #include "graphics/transform_struct.h"
 
@@ -183,6 +185,101 @@ private:
 	AlphaType _alphaMode;
 };
 
+/**
+ * Cache of scaled and rotated copies of parts of surfaces.
+ *
+ * Sprites are often drawn with the same transformation in many frames, so
+ * the most recently used copies are kept, within a memory budget. The
+ * callers identify the contents of the source surfaces with a pointer, and
+ * have to invalidate it when the contents change.
+ */
+class TransformedSurfaceCache {
+public:
+	explicit TransformedSurfaceCache(uint32 maxBytes = 8 * 1024 * 1024);
+	~TransformedSurfaceCache();
+
+	/**
+	 * Get a part of a surface, rotated and scaled with TransparentSurface::rotoscaleT.
+	 *
+	 * @param id		identifies the contents of the source surface
+	 * @param src		the source surface, in the format of TransparentSurface
+	 * @param srcRect	the part of the source surface to transform
+	 * @param transform	the transformation
+	 * @param filtering	whether to use bilinear filtering
+	 * @return the transformed copy, valid until the next call
+	 */
+	const Surface *rotoscale(const void *id, const Surface &src, const Common::Rect &srcRect, const TransformStruct &transform, bool filtering);
+
+	/**
+	 * Get a part of a surface, scaled with Surface::scale.
+	 *
+	 * @see rotoscale
+	 */
+	const Surface *scale(const void *id, const Surface &src, const Common::Rect &srcRect, uint16 newWidth, uint16 newHeight, bool filtering);
+
+	/** Discard the copies of the surface identified by @p id. */
+	void invalidate(const void *id);
+	/** Discard all the copies. */
+	void clear();
+
+	/** Set the memory budget, discarding the least recently used copies as needed. */
+	void setMaxBytes(uint32 maxBytes);
+	/** Memory used by the copies. */
+	uint32 getBytes() const { return _bytes; }
+	uint32 getHits() const { return _hits; }
+	uint32 getMisses() const { return _misses; }
+
+private:
+	/**
+	 * Only the geometry of the transformation is part of the key. The
+	 * color modulation and blending are applied when the copy is drawn.
+	 */
+	struct Key {
+		const void *id;
+		Common::Rect srcRect;
+		int32 angle;
+		Common::Point zoom;
+		Common::Point hotspot;
+		byte flip;
+		uint16 width, height;
+		bool filtering;
+
+		Key() : id(nullptr), angle(0), flip(0), width(0), height(0), filtering(false) {}
+
+		bool operator==(const Key &key) const {
+			return id == key.id && srcRect == key.srcRect && angle == key.angle && zoom == key.zoom &&
+				hotspot == key.hotspot && flip == key.flip && width == key.width &&
+				height == key.height && filtering == key.filtering;
+		}
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &key) const;
+	};
+
+	struct Entry {
+		Key key;
+		Surface *surface;
+	};
+
+	typedef Common::List<Entry> EntryList;
+
+	const Surface *find(const Key &key);
+	const Surface *insert(const Key &key, Surface *surface);
+	void removeOldest();
+	static uint32 surfaceBytes(const Surface *surface) {
+		return surface->pitch * surface->h;
+	}
+
+	/** The copies, the most recently used first */
+	EntryList _entries;
+	Common::HashMap<Key, EntryList::iterator, KeyHash> _index;
+	uint32 _maxBytes;
+	uint32 _bytes;
+	uint32 _hits;
+	uint32 _misses;
+};
+
 /**
  * A deleter for Surface objects which can be used with SharedPtr.
  *
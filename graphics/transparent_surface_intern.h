@@ -0,0 +1,40 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_TRANSPARENTSURFACE_INTERN_H
+#define GRAPHICS_TRANSPARENTSURFACE_INTERN_H
+
+namespace Graphics {
+
+/**
+ * Enable or disable the SIMD code paths of the blending in
+ * TransparentSurface::blit, so that the tests can compare them with the
+ * generic C code. They are enabled by default and used whenever the CPU
+ * supports them.
+ *
+ * @return whether the SIMD code paths are in use after the call
+ */
+bool setTransparentSurfaceSIMD(bool enable);
+
+} // End of namespace Graphics
+
+#endif
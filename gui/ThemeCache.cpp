@@ -0,0 +1,421 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "gui/ThemeCache.h"
+#include "gui/ThemeEval.h"
+#include "gui/ThemeParser.h"
+
+#include "graphics/VectorRenderer.h"
+
+#include "common/fs.h"
+#include "common/system.h"
+
+namespace GUI {
+
+static void writeColor(Common::WriteStream &stream, const Graphics::DrawStep::Color &color) {
+	stream.writeByte(color.r);
+	stream.writeByte(color.g);
+	stream.writeByte(color.b);
+	stream.writeByte(color.set);
+}
+
+static void readColor(Common::ReadStream &stream, Graphics::DrawStep::Color &color) {
+	color.r = stream.readByte();
+	color.g = stream.readByte();
+	color.b = stream.readByte();
+	color.set = stream.readByte() != 0;
+}
+
+static void writeRect(Common::WriteStream &stream, const Common::Rect &rect) {
+	stream.writeSint16BE(rect.left);
+	stream.writeSint16BE(rect.top);
+	stream.writeSint16BE(rect.right);
+	stream.writeSint16BE(rect.bottom);
+}
+
+static void readRect(Common::ReadStream &stream, Common::Rect &rect) {
+	rect.left = stream.readSint16BE();
+	rect.top = stream.readSint16BE();
+	rect.right = stream.readSint16BE();
+	rect.bottom = stream.readSint16BE();
+}
+
+ThemeCache::ThemeCache() : _file(g_system->getOverlayWidth(), g_system->getOverlayHeight()), _ops(DisposeAfterUse::YES) {
+}
+
+void ThemeCache::addSource(const Common::String &name, Common::SeekableReadStream &stream) {
+	_file.addSource(name, stream);
+}
+
+bool ThemeCache::replay(const Common::FSNode &node, ThemeEngine *theme) {
+	if (!node.exists())
+		return false;
+
+	Common::SeekableReadStream *stream = node.createReadStream();
+	if (!stream)
+		return false;
+
+	bool result = false;
+	Common::SeekableReadStream *ops = _file.load(*stream);
+	if (ops) {
+		result = replayOps(*ops, theme);
+		delete ops;
+	}
+
+	delete stream;
+	return result;
+}
+
+bool ThemeCache::save(const Common::FSNode &node) {
+	Common::WriteStream *stream = node.createWriteStream();
+	if (!stream)
+		return false;
+
+	const bool result = _file.save(*stream, _ops.getData(), _ops.size());
+	delete stream;
+	return result;
+}
+
+void ThemeCache::recordDrawData(const Common::String &id, bool cached) {
+	_ops.writeByte(kOpDrawData);
+	ThemeCacheFile::writeString(_ops, id);
+	_ops.writeByte(cached);
+}
+
+void ThemeCache::recordDrawStep(const Common::String &drawDataId, const Common::String &function, const Common::String &file, const Graphics::DrawStep &step) {
+	_ops.writeByte(kOpDrawStep);
+	ThemeCacheFile::writeString(_ops, drawDataId);
+	ThemeCacheFile::writeString(_ops, function);
+	ThemeCacheFile::writeString(_ops, file);
+
+	// The drawing function and the bitmaps are looked up again on replay
+	writeColor(_ops, step.fgColor);
+	writeColor(_ops, step.bgColor);
+	writeColor(_ops, step.gradColor1);
+	writeColor(_ops, step.gradColor2);
+	writeColor(_ops, step.bevelColor);
+	_ops.writeByte(step.autoWidth);
+	_ops.writeByte(step.autoHeight);
+	_ops.writeSint16BE(step.x);
+	_ops.writeSint16BE(step.y);
+	_ops.writeSint16BE(step.w);
+	_ops.writeSint16BE(step.h);
+	writeRect(_ops, step.padding);
+	writeRect(_ops, step.clip);
+	_ops.writeByte(step.xAlign);
+	_ops.writeByte(step.yAlign);
+	_ops.writeByte(step.shadow);
+	_ops.writeByte(step.stroke);
+	_ops.writeByte(step.factor);
+	_ops.writeByte(step.radius);
+	_ops.writeByte(step.bevel);
+	_ops.writeByte(step.fillMode);
+	_ops.writeByte(step.shadowFillMode);
+	_ops.writeUint32BE(step.extraData);
+	_ops.writeUint32BE(step.scale);
+	_ops.writeByte(step.autoscale);
+}
+
+void ThemeCache::recordTextData(const Common::String &drawDataId, TextData textId, TextColor colorId, Graphics::TextAlign alignH, ThemeEngine::TextAlignVertical alignV) {
+	_ops.writeByte(kOpTextData);
+	ThemeCacheFile::writeString(_ops, drawDataId);
+	_ops.writeSint32BE(textId);
+	_ops.writeSint32BE(colorId);
+	_ops.writeSint32BE(alignH);
+	_ops.writeSint32BE(alignV);
+}
+
+void ThemeCache::recordFont(TextData textId, const Common::String &language, const Common::String &file, const Common::String &scalableFile, int pointsize) {
+	_ops.writeByte(kOpFont);
+	_ops.writeSint32BE(textId);
+	ThemeCacheFile::writeString(_ops, language);
+	ThemeCacheFile::writeString(_ops, file);
+	ThemeCacheFile::writeString(_ops, scalableFile);
+	_ops.writeSint32BE(pointsize);
+}
+
+void ThemeCache::recordTextColor(TextColor colorId, int r, int g, int b) {
+	_ops.writeByte(kOpTextColor);
+	_ops.writeSint32BE(colorId);
+	_ops.writeSint32BE(r);
+	_ops.writeSint32BE(g);
+	_ops.writeSint32BE(b);
+}
+
+void ThemeCache::recordBitmap(const Common::String &filename) {
+	_ops.writeByte(kOpBitmap);
+	ThemeCacheFile::writeString(_ops, filename);
+}
+
+void ThemeCache::recordAlphaBitmap(const Common::String &filename) {
+	_ops.writeByte(kOpAlphaBitmap);
+	ThemeCacheFile::writeString(_ops, filename);
+}
+
+void ThemeCache::recordCursor(const Common::String &filename, int hotspotX, int hotspotY) {
+	_ops.writeByte(kOpCursor);
+	ThemeCacheFile::writeString(_ops, filename);
+	_ops.writeSint32BE(hotspotX);
+	_ops.writeSint32BE(hotspotY);
+}
+
+void ThemeCache::recordVar(const Common::String &name, int value) {
+	_ops.writeByte(kOpVar);
+	ThemeCacheFile::writeString(_ops, name);
+	_ops.writeSint32BE(value);
+}
+
+void ThemeCache::recordDialog(const Common::String &name, const Common::String &overlays, int16 maxWidth, int16 maxHeight, int inset) {
+	_ops.writeByte(kOpDialog);
+	ThemeCacheFile::writeString(_ops, name);
+	ThemeCacheFile::writeString(_ops, overlays);
+	_ops.writeSint16BE(maxWidth);
+	_ops.writeSint16BE(maxHeight);
+	_ops.writeSint32BE(inset);
+}
+
+void ThemeCache::recordLayout(ThemeLayout::LayoutType type, int spacing, ThemeLayout::ItemAlign itemAlign) {
+	_ops.writeByte(kOpLayout);
+	_ops.writeSint32BE(type);
+	_ops.writeSint32BE(spacing);
+	_ops.writeSint32BE(itemAlign);
+}
+
+void ThemeCache::recordWidget(const Common::String &name, const Common::String &type, int w, int h, Graphics::TextAlign align, bool useRTL) {
+	_ops.writeByte(kOpWidget);
+	ThemeCacheFile::writeString(_ops, name);
+	ThemeCacheFile::writeString(_ops, type);
+	_ops.writeSint32BE(w);
+	_ops.writeSint32BE(h);
+	_ops.writeSint32BE(align);
+	_ops.writeByte(useRTL);
+}
+
+void ThemeCache::recordImportedLayout(const Common::String &name) {
+	_ops.writeByte(kOpImportedLayout);
+	ThemeCacheFile::writeString(_ops, name);
+}
+
+void ThemeCache::recordSpace(int size) {
+	_ops.writeByte(kOpSpace);
+	_ops.writeSint32BE(size);
+}
+
+void ThemeCache::recordPadding(int16 l, int16 r, int16 t, int16 b) {
+	_ops.writeByte(kOpPadding);
+	_ops.writeSint16BE(l);
+	_ops.writeSint16BE(r);
+	_ops.writeSint16BE(t);
+	_ops.writeSint16BE(b);
+}
+
+void ThemeCache::recordCloseLayout() {
+	_ops.writeByte(kOpCloseLayout);
+}
+
+void ThemeCache::recordCloseDialog() {
+	_ops.writeByte(kOpCloseDialog);
+}
+
+bool ThemeCache::replayOps(Common::SeekableReadStream &ops, ThemeEngine *theme) const {
+	ThemeEval *eval = theme->getEvaluator();
+
+	while (ops.pos() < ops.size()) {
+		switch (ops.readByte()) {
+		case kOpDrawData: {
+			const Common::String id = ThemeCacheFile::readString(ops);
+			const bool cached = ops.readByte() != 0;
+			if (!theme->addDrawData(id, cached))
+				return false;
+			break;
+		}
+
+		case kOpDrawStep: {
+			const Common::String drawDataId = ThemeCacheFile::readString(ops);
+			const Common::String function = ThemeCacheFile::readString(ops);
+			const Common::String file = ThemeCacheFile::readString(ops);
+
+			Graphics::DrawStep step;
+			readColor(ops, step.fgColor);
+			readColor(ops, step.bgColor);
+			readColor(ops, step.gradColor1);
+			readColor(ops, step.gradColor2);
+			readColor(ops, step.bevelColor);
+			step.autoWidth = ops.readByte() != 0;
+			step.autoHeight = ops.readByte() != 0;
+			step.x = ops.readSint16BE();
+			step.y = ops.readSint16BE();
+			step.w = ops.readSint16BE();
+			step.h = ops.readSint16BE();
+			readRect(ops, step.padding);
+			readRect(ops, step.clip);
+			step.xAlign = (Graphics::DrawStep::VectorAlignment)ops.readByte();
+			step.yAlign = (Graphics::DrawStep::VectorAlignment)ops.readByte();
+			step.shadow = ops.readByte();
+			step.stroke = ops.readByte();
+			step.factor = ops.readByte();
+			step.radius = ops.readByte();
+			step.bevel = ops.readByte();
+			step.fillMode = ops.readByte();
+			step.shadowFillMode = ops.readByte();
+			step.extraData = ops.readUint32BE();
+			step.scale = ops.readUint32BE();
+			step.autoscale = (ThemeEngine::AutoScaleMode)ops.readByte();
+
+			step.drawingCall = ThemeParser::getDrawingFunctionCallback(function);
+			if (!step.drawingCall)
+				return false;
+
+			if (function == "bitmap" && !(step.blitSrc = theme->getBitmap(file)))
+				return false;
+			if (function == "alphabitmap" && !(step.blitAlphaSrc = theme->getAlphaBitmap(file)))
+				return false;
+
+			theme->addDrawStep(drawDataId, step);
+			break;
+		}
+
+		case kOpTextData: {
+			const Common::String drawDataId = ThemeCacheFile::readString(ops);
+			const TextData textId = (TextData)ops.readSint32BE();
+			const TextColor colorId = (TextColor)ops.readSint32BE();
+			const Graphics::TextAlign alignH = (Graphics::TextAlign)ops.readSint32BE();
+			const ThemeEngine::TextAlignVertical alignV = (ThemeEngine::TextAlignVertical)ops.readSint32BE();
+			if (!theme->addTextData(drawDataId, textId, colorId, alignH, alignV))
+				return false;
+			break;
+		}
+
+		case kOpFont: {
+			const TextData textId = (TextData)ops.readSint32BE();
+			const Common::String language = ThemeCacheFile::readString(ops);
+			const Common::String file = ThemeCacheFile::readString(ops);
+			const Common::String scalableFile = ThemeCacheFile::readString(ops);
+			const int pointsize = ops.readSint32BE();
+			theme->storeFontNames(textId, language, file, scalableFile, pointsize);
+			if (!theme->addFont(textId, language, file, scalableFile, pointsize))
+				return false;
+			break;
+		}
+
+		case kOpTextColor: {
+			const TextColor colorId = (TextColor)ops.readSint32BE();
+			const int r = ops.readSint32BE();
+			const int g = ops.readSint32BE();
+			const int b = ops.readSint32BE();
+			if (!theme->addTextColor(colorId, r, g, b))
+				return false;
+			break;
+		}
+
+		case kOpBitmap:
+			if (!theme->addBitmap(ThemeCacheFile::readString(ops)))
+				return false;
+			break;
+
+		case kOpAlphaBitmap:
+			if (!theme->addAlphaBitmap(ThemeCacheFile::readString(ops)))
+				return false;
+			break;
+
+		case kOpCursor: {
+			const Common::String filename = ThemeCacheFile::readString(ops);
+			const int hotspotX = ops.readSint32BE();
+			const int hotspotY = ops.readSint32BE();
+			if (!theme->createCursor(filename, hotspotX, hotspotY))
+				return false;
+			break;
+		}
+
+		case kOpVar: {
+			const Common::String name = ThemeCacheFile::readString(ops);
+			eval->setVar(name, ops.readSint32BE());
+			break;
+		}
+
+		case kOpDialog: {
+			const Common::String name = ThemeCacheFile::readString(ops);
+			const Common::String overlays = ThemeCacheFile::readString(ops);
+			const int16 maxWidth = ops.readSint16BE();
+			const int16 maxHeight = ops.readSint16BE();
+			eval->addDialog(name, overlays, maxWidth, maxHeight, ops.readSint32BE());
+			break;
+		}
+
+		case kOpLayout: {
+			const ThemeLayout::LayoutType type = (ThemeLayout::LayoutType)ops.readSint32BE();
+			const int spacing = ops.readSint32BE();
+			eval->addLayout(type, spacing, (ThemeLayout::ItemAlign)ops.readSint32BE());
+			break;
+		}
+
+		case kOpWidget: {
+			const Common::String name = ThemeCacheFile::readString(ops);
+			const Common::String type = ThemeCacheFile::readString(ops);
+			const int w = ops.readSint32BE();
+			const int h = ops.readSint32BE();
+			const Graphics::TextAlign align = (Graphics::TextAlign)ops.readSint32BE();
+			eval->addWidget(name, type, w, h, align, ops.readByte() != 0);
+			break;
+		}
+
+		case kOpImportedLayout: {
+			const Common::String name = ThemeCacheFile::readString(ops);
+			if (!eval->hasDialog(name))
+				return false;
+			eval->addImportedLayout(name);
+			break;
+		}
+
+		case kOpSpace:
+			eval->addSpace(ops.readSint32BE());
+			break;
+
+		case kOpPadding: {
+			const int16 l = ops.readSint16BE();
+			const int16 r = ops.readSint16BE();
+			const int16 t = ops.readSint16BE();
+			eval->addPadding(l, r, t, ops.readSint16BE());
+			break;
+		}
+
+		case kOpCloseLayout:
+			eval->closeLayout();
+			break;
+
+		case kOpCloseDialog:
+			eval->closeDialog();
+			break;
+
+		default:
+			warning("ThemeCache: Unknown operation at offset %d", (int)ops.pos() - 1);
+			return false;
+		}
+
+		if (ops.err() || ops.eos())
+			return false;
+	}
+
+	return true;
+}
+
+} // End of namespace GUI
@@ -0,0 +1,130 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_THEME_CACHE_H
+#define GUI_THEME_CACHE_H
+
+#include "common/scummsys.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "graphics/font.h"
+
+#include "gui/ThemeCacheFile.h"
+#include "gui/ThemeEngine.h"
+#include "gui/ThemeLayout.h"
+
+namespace Common {
+class FSNode;
+}
+
+namespace Graphics {
+struct DrawStep;
+}
+
+namespace GUI {
+
+/**
+ * Binary copy of the results of parsing the STX files of a theme.
+ *
+ * While the XML files are parsed, ThemeParser records here every call it
+ * makes into the ThemeEngine and its ThemeEval: the draw data and their
+ * draw steps, the fonts, the text colors, the bitmaps and the layouts.
+ * These are saved to a file, together with a key which identifies the STX
+ * files and the overlay size they were parsed for, see ThemeCacheFile. When
+ * the theme is loaded again with the same key, the calls are replayed from
+ * the file, and the XML is not parsed at all.
+ */
+class ThemeCache {
+public:
+	ThemeCache();
+
+	/**
+	 * Add the contents of an STX file to the key of the cache. The stream is
+	 * rewound afterwards.
+	 */
+	void addSource(const Common::String &name, Common::SeekableReadStream &stream);
+
+	/**
+	 * Replay the calls saved in the given file into the theme, if its key
+	 * matches the sources added with addSource(). On failure, the theme may
+	 * have been partially set up.
+	 */
+	bool replay(const Common::FSNode &node, ThemeEngine *theme);
+
+	/** Save the recorded calls with the key of the sources to the given file. */
+	bool save(const Common::FSNode &node);
+
+	/**
+	 * @name Recording of the calls of ThemeParser
+	 * @{
+	 */
+	void recordDrawData(const Common::String &id, bool cached);
+	void recordDrawStep(const Common::String &drawDataId, const Common::String &function, const Common::String &file, const Graphics::DrawStep &step);
+	void recordTextData(const Common::String &drawDataId, TextData textId, TextColor colorId, Graphics::TextAlign alignH, ThemeEngine::TextAlignVertical alignV);
+	void recordFont(TextData textId, const Common::String &language, const Common::String &file, const Common::String &scalableFile, int pointsize);
+	void recordTextColor(TextColor colorId, int r, int g, int b);
+	void recordBitmap(const Common::String &filename);
+	void recordAlphaBitmap(const Common::String &filename);
+	void recordCursor(const Common::String &filename, int hotspotX, int hotspotY);
+
+	void recordVar(const Common::String &name, int value);
+	void recordDialog(const Common::String &name, const Common::String &overlays, int16 maxWidth, int16 maxHeight, int inset);
+	void recordLayout(ThemeLayout::LayoutType type, int spacing, ThemeLayout::ItemAlign itemAlign);
+	void recordWidget(const Common::String &name, const Common::String &type, int w, int h, Graphics::TextAlign align, bool useRTL);
+	void recordImportedLayout(const Common::String &name);
+	void recordSpace(int size);
+	void recordPadding(int16 l, int16 r, int16 t, int16 b);
+	void recordCloseLayout();
+	void recordCloseDialog();
+	/** @} */
+
+private:
+	enum Op {
+		kOpDrawData,
+		kOpDrawStep,
+		kOpTextData,
+		kOpFont,
+		kOpTextColor,
+		kOpBitmap,
+		kOpAlphaBitmap,
+		kOpCursor,
+		kOpVar,
+		kOpDialog,
+		kOpLayout,
+		kOpWidget,
+		kOpImportedLayout,
+		kOpSpace,
+		kOpPadding,
+		kOpCloseLayout,
+		kOpCloseDialog
+	};
+
+	bool replayOps(Common::SeekableReadStream &ops, ThemeEngine *theme) const;
+
+	ThemeCacheFile _file;
+	Common::MemoryWriteStreamDynamic _ops;
+};
+
+} // End of namespace GUI
+
+#endif
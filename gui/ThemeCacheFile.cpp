@@ -0,0 +1,126 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "gui/ThemeCacheFile.h"
+
+#include "base/version.h"
+
+#include "common/md5.h"
+
+namespace GUI {
+
+ThemeCacheFile::ThemeCacheFile(int16 overlayWidth, int16 overlayHeight)
+	: _overlayWidth(overlayWidth), _overlayHeight(overlayHeight), _sources(DisposeAfterUse::YES) {
+}
+
+void ThemeCacheFile::addSource(const Common::String &name, Common::SeekableReadStream &stream) {
+	uint8 digest[16];
+	computeStreamMD5(stream, digest);
+	stream.seek(0);
+
+	writeString(_sources, name);
+	_sources.write(digest, sizeof(digest));
+}
+
+void ThemeCacheFile::computeKey(uint8 key[16]) {
+	Common::MemoryWriteStreamDynamic data(DisposeAfterUse::YES);
+	data.writeUint32BE(kVersion);
+	writeString(data, gScummVMFullVersion);
+	data.writeSint16BE(_overlayWidth);
+	data.writeSint16BE(_overlayHeight);
+	data.write(_sources.getData(), _sources.size());
+
+	Common::MemoryReadStream stream(data.getData(), data.size());
+	computeStreamMD5(stream, key);
+}
+
+Common::SeekableReadStream *ThemeCacheFile::load(Common::SeekableReadStream &stream) {
+	if (stream.readUint32BE() != MKTAG('S', 'T', 'H', 'C') || stream.readUint32BE() != kVersion)
+		return nullptr;
+
+	uint8 key[16], fileKey[16], digest[16], fileDigest[16];
+	computeKey(key);
+
+	stream.read(fileKey, sizeof(fileKey));
+	const uint32 size = stream.readUint32BE();
+	stream.read(fileDigest, sizeof(fileDigest));
+
+	if (stream.err() || memcmp(key, fileKey, sizeof(key)) || (uint32)(stream.size() - stream.pos()) != size)
+		return nullptr;
+
+	// Use the contents of the file in place when it is memory mapped
+	Common::SeekableReadStream *ops;
+	const byte *data = stream.getDirectData(stream.pos(), size);
+	if (data) {
+		ops = new Common::MemoryReadStream(data, size);
+	} else {
+		byte *buffer = (byte *)malloc(size);
+		if (!buffer || stream.read(buffer, size) != size) {
+			free(buffer);
+			return nullptr;
+		}
+		ops = new Common::MemoryReadStream(buffer, size, DisposeAfterUse::YES);
+	}
+
+	computeStreamMD5(*ops, digest);
+	ops->seek(0);
+
+	if (memcmp(digest, fileDigest, sizeof(digest))) {
+		delete ops;
+		return nullptr;
+	}
+
+	return ops;
+}
+
+bool ThemeCacheFile::save(Common::WriteStream &stream, const byte *ops, uint32 size) {
+	uint8 key[16], digest[16];
+	computeKey(key);
+
+	Common::MemoryReadStream opsStream(ops, size);
+	computeStreamMD5(opsStream, digest);
+
+	stream.writeUint32BE(MKTAG('S', 'T', 'H', 'C'));
+	stream.writeUint32BE(kVersion);
+	stream.write(key, sizeof(key));
+	stream.writeUint32BE(size);
+	stream.write(digest, sizeof(digest));
+	stream.write(ops, size);
+	stream.finalize();
+
+	return !stream.err();
+}
+
+void ThemeCacheFile::writeString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint16BE(str.size());
+	stream.writeString(str);
+}
+
+Common::String ThemeCacheFile::readString(Common::ReadStream &stream) {
+	const uint16 size = stream.readUint16BE();
+	Common::String str;
+	for (uint16 i = 0; i < size && !stream.eos(); ++i)
+		str += (char)stream.readByte();
+	return str;
+}
+
+} // End of namespace GUI
@@ -0,0 +1,80 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GUI_THEME_CACHE_FILE_H
+#define GUI_THEME_CACHE_FILE_H
+
+#include "common/scummsys.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+namespace GUI {
+
+/**
+ * Format of the files of the ThemeCache.
+ *
+ * A file starts with a key, which identifies the STX files of the theme,
+ * the overlay size they were parsed for, the version of ScummVM and the
+ * version of the format. It is followed by the recorded operations and
+ * their checksum. A file whose key does not match is ignored.
+ */
+class ThemeCacheFile {
+public:
+	enum {
+		/** Increase when the format or the meaning of the recorded operations change. */
+		kVersion = 1
+	};
+
+	ThemeCacheFile(int16 overlayWidth, int16 overlayHeight);
+
+	/**
+	 * Add the contents of an STX file to the key. The stream is rewound
+	 * afterwards.
+	 */
+	void addSource(const Common::String &name, Common::SeekableReadStream &stream);
+
+	/**
+	 * Read the operations saved in a file, if its key matches the sources.
+	 * The returned stream may point into the data of the file stream, and
+	 * must be deleted first.
+	 *
+	 * @return the operations, or nullptr if the file is invalid or outdated.
+	 */
+	Common::SeekableReadStream *load(Common::SeekableReadStream &stream);
+
+	/** Save the given operations with the key of the sources. */
+	bool save(Common::WriteStream &stream, const byte *ops, uint32 size);
+
+	static void writeString(Common::WriteStream &stream, const Common::String &str);
+	static Common::String readString(Common::ReadStream &stream);
+
+private:
+	void computeKey(uint8 key[16]);
+
+	int16 _overlayWidth;
+	int16 _overlayHeight;
+	Common::MemoryWriteStreamDynamic _sources;
+};
+
+} // End of namespace GUI
+
+#endif
@@ -24,6 +24,7 @@
 #include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
+#include "common/lru-cache.h"
 #include "common/unzip.h"
 #include "common/tokenizer.h"
 #include "common/translation.h"
@@ -42,6 +43,7 @@
 #include "image/png.h"
 
 #include "gui/widget.h"
+#include "gui/ThemeCache.h"
 #include "gui/ThemeEngine.h"
 #include "gui/ThemeEval.h"
 #include "gui/ThemeParser.h"
@@ -89,6 +91,11 @@ struct WidgetDrawData {
 
 	DrawLayer _layer;
 
+	/** Whether the drawn steps may be kept in the DrawData cache */
+	bool _cacheable;
+	/** Mask of the renderer colors which the steps may use without setting them */
+	uint8 _inheritedColors;
+
 
 	/**
 	 * Calculates the background threshold offset of a given DrawData item.
@@ -98,6 +105,98 @@ struct WidgetDrawData {
 	 * value will be added when restoring the background of the widget.
 	 */
 	void calcBackgroundOffset();
+
+	/**
+	 * Checks whether the result of drawing the steps only depends on the
+	 * drawn area, on the pixels drawn over and on the renderer colors.
+	 * Like calcBackgroundOffset(), it must be called after loading all
+	 * the DrawSteps.
+	 */
+	void calcCacheability();
+};
+
+/**
+ * Recently drawn DrawData items, together with the pixels they were drawn over.
+ *
+ * Redrawing a dialog or scrolling a list draws the same buttons, tabs and
+ * frames over the same background again and again. The result of drawing
+ * the steps of an item is then copied from here.
+ */
+struct DrawDataCache {
+	enum {
+		kCapacity = 128,
+		/** Larger items are not kept, they are seldom the same twice. */
+		kMaxArea = 320 * 64,
+		/**
+		 * Budget for the pixels of all the entries. An item of kMaxArea
+		 * takes 160 KB with 32 bpp, so only a few of them fit.
+		 */
+		kMaxBytes = 2 * 1024 * 1024
+	};
+
+	struct Key {
+		DrawData type;
+		uint32 dynamic;
+		int16 width, height;
+		/** Parity of the position, used by the dithering of gradients */
+		uint8 parity;
+		uint32 colors[5];
+		uint32 backgroundHash;
+	};
+
+	struct Key_Hash {
+		uint operator()(const Key &key) const {
+			uint hash = key.backgroundHash ^ (key.type << 24) ^ (key.dynamic << 16) ^ (key.width * 2654435761U) ^ (key.height << 8) ^ key.parity;
+			for (int i = 0; i < ARRAYSIZE(key.colors); ++i)
+				hash = hash * 31 + key.colors[i];
+			return hash;
+		}
+	};
+
+	struct Key_EqualTo {
+		bool operator()(const Key &x, const Key &y) const {
+			return x.type == y.type && x.dynamic == y.dynamic && x.width == y.width && x.height == y.height &&
+			       x.parity == y.parity && x.backgroundHash == y.backgroundHash && !memcmp(x.colors, y.colors, sizeof(x.colors));
+		}
+	};
+
+	struct Entry {
+		/** Pixels of the extended area before drawing, to rule out hash collisions */
+		Common::Array<byte> background;
+		/** Pixels of the extended area after drawing */
+		Common::Array<byte> pixels;
+
+		uint32 getBytes() const { return background.size() + pixels.size(); }
+	};
+
+	DrawDataCache() : entries(kCapacity), bytes(0) {}
+
+	/** Add an empty entry, first removing the least recently used ones if the cache is full. */
+	Entry *insert(const Key &key) {
+		while (entries.size() >= kCapacity)
+			eraseOldest();
+		return &entries.insert(key, Entry());
+	}
+
+	/** Remove the least recently used entries, but the newest one, until the pixels fit in the budget. */
+	void trim() {
+		while (bytes > kMaxBytes && entries.size() > 1)
+			eraseOldest();
+	}
+
+	void eraseOldest() {
+		bytes -= entries.getOldest()->getBytes();
+		entries.eraseOldest();
+	}
+
+	void clear() {
+		entries.clear();
+		bytes = 0;
+	}
+
+	Common::LRUCache<Key, Entry, Key_Hash, Key_EqualTo> entries;
+	/** Total size of the pixels of the entries */
+	uint32 bytes;
 };
 
 /**********************************************************
@@ -195,6 +294,7 @@ ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 	_system = g_system;
 	_parser = new ThemeParser(this);
 	_themeEval = new GUI::ThemeEval();
+	_drawDataCache = new DrawDataCache();
 
 	_useCursor = false;
 
@@ -264,6 +364,9 @@ ThemeEngine::~ThemeEngine() {
 	}
 	_abitmaps.clear();
 
+	debug(1, "DrawData cache: %u hits, %u misses", _drawDataCache->entries.getHits(), _drawDataCache->entries.getMisses());
+	delete _drawDataCache;
+
 	delete _parser;
 	delete _themeEval;
 	delete[] _cursor;
@@ -318,6 +421,7 @@ const char *ThemeEngine::findModeConfigName(GraphicsMode mode) {
  *********************************************************/
 bool ThemeEngine::init() {
 	// reset everything and reload the graphics
+	const uint32 start = _system->getMillis();
 	_initOk = false;
 	_overlayFormat = _system->getOverlayFormat();
 	setGraphicsMode(_graphicsMode);
@@ -334,6 +438,8 @@ bool ThemeEngine::init() {
 		_font = FontMan.getFontByUsage(Graphics::FontManager::kGUIFont);
 	}
 
+	const uint32 screenDone = _system->getMillis();
+
 	// Try to create a Common::Archive with the files of the theme.
 	if (!_themeArchive && !_themeFile.empty()) {
 		Common::FSNode node(_themeFile);
@@ -364,8 +470,13 @@ bool ThemeEngine::init() {
 	// We pass the theme file here by default, so the user will
 	// have a descriptive error message. The only exception will
 	// be the builtin theme which has no filename.
+	const uint32 archiveDone = _system->getMillis();
 	loadTheme(_themeFile.empty() ? _themeId : _themeFile);
 
+	const uint32 end = _system->getMillis();
+	debug(1, "Theme '%s' initialized in %d ms: screen %d ms, archive %d ms, theme files %d ms",
+	      _themeId.c_str(), end - start, screenDone - start, archiveDone - screenDone, end - archiveDone);
+
 	return ready();
 }
 
@@ -467,6 +578,8 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	_vectorRenderer = Graphics::createRenderer(mode);
 	_vectorRenderer->setSurface(&_screen);
 
+	_drawDataCache->clear();
+
 	// Since we reinitialized our screen surfaces we know nothing has been
 	// drawn so far. Sometimes we still end up with dirty screen bits in the
 	// list. Clearing it avoids invalid overlay writes when the backend
@@ -489,6 +602,32 @@ void WidgetDrawData::calcBackgroundOffset() {
 	_shadowOffset = maxShadow;
 }
 
+void WidgetDrawData::calcCacheability() {
+	_cacheable = !_steps.empty();
+	_inheritedColors = 0;
+
+	for (Common::List<Graphics::DrawStep>::const_iterator step = _steps.begin();
+	        step != _steps.end(); ++step) {
+		// Filling covers the whole surface, not only the drawn area
+		if (step->drawingCall == &Graphics::VectorRenderer::drawCallback_FILLSURFACE)
+			_cacheable = false;
+	}
+
+	// Any color which is not set by the first step may be left over from
+	// what was drawn before
+	if (_cacheable) {
+		const Graphics::DrawStep &first = _steps.front();
+		if (!first.fgColor.set)
+			_inheritedColors |= 1 << 0;
+		if (!first.bgColor.set)
+			_inheritedColors |= 1 << 1;
+		if (!first.bevelColor.set)
+			_inheritedColors |= 1 << 2;
+		if (!first.gradColor1.set || !first.gradColor2.set)
+			_inheritedColors |= (1 << 3) | (1 << 4);
+	}
+}
+
 void ThemeEngine::restoreBackground(Common::Rect r) {
 	if (_vectorRenderer->getActiveSurface() == &_backBuffer) {
 		// Only restore the background when drawing to the screen surface
@@ -796,6 +935,8 @@ bool ThemeEngine::addDrawData(const Common::String &data, bool cached) {
 	_widgets[id] = new WidgetDrawData;
 	_widgets[id]->_layer = kDrawDataDefaults[id].layer;
 	_widgets[id]->_textDataId = kTextDataNone;
+	_widgets[id]->_cacheable = false;
+	_widgets[id]->_inheritedColors = 0;
 
 	return true;
 }
@@ -826,6 +967,7 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 			warning("Missing data asset: '%s'", kDrawDataDefaults[i].name);
 		} else {
 			_widgets[i]->calcBackgroundOffset();
+			_widgets[i]->calcCacheability();
 		}
 	}
 }
@@ -834,6 +976,13 @@ void ThemeEngine::unloadTheme() {
 	if (!_themeOk)
 		return;
 
+	clearThemeData();
+	_themeOk = false;
+}
+
+void ThemeEngine::clearThemeData() {
+	_drawDataCache->clear();
+
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
 		_widgets[i] = nullptr;
@@ -853,7 +1002,15 @@ void ThemeEngine::unloadTheme() {
 	}
 
 	_themeEval->reset();
-	_themeOk = false;
+}
+
+bool ThemeEngine::getThemeCacheNode(Common::FSNode &node) const {
+	if (_themeFile.empty())
+		return false;
+
+	// Themes are often installed in read-only directories, and the same
+	// theme may be found in several places
+	return ConfMan.getCacheFile("scummvm-theme-" + _themeId + ".cache", node);
 }
 
 void ThemeEngine::unloadExtraFont() {
@@ -932,26 +1089,76 @@ bool ThemeEngine::loadThemeXML(const Common::String &themeId) {
 	}
 
 	//
-	// Loop over all STX files, load and parse them
+	// Open all STX files, and try to set up the theme from the cache
+	// made when they were last parsed
 	//
+	const uint32 start = _system->getMillis();
+	ThemeCache cache;
+	Common::Array<Common::SeekableReadStream *> streams;
 	for (Common::ArchiveMemberList::iterator i = members.begin(); i != members.end(); ++i) {
 		assert((*i)->getName().hasSuffix(".stx"));
 
-		if (_parser->loadStream((*i)->createReadStream()) == false) {
-			warning("Failed to load STX file '%s'", (*i)->getDisplayName().c_str());
+		Common::SeekableReadStream *stream = (*i)->createReadStream();
+		if (stream)
+			cache.addSource((*i)->getName(), *stream);
+		streams.push_back(stream);
+	}
+
+	Common::FSNode cacheNode;
+	const bool cacheable = getThemeCacheNode(cacheNode);
+	if (cacheable) {
+		if (cache.replay(cacheNode, this)) {
+			for (uint i = 0; i < streams.size(); ++i)
+				delete streams[i];
+
+			debug(1, "Loaded theme '%s' from the cache in %d ms", themeId.c_str(), _system->getMillis() - start);
+			assert(!_themeName.empty());
+			return true;
+		}
+
+		// Discard whatever was set up before the cache was rejected
+		clearThemeData();
+		_parser->setRecorder(&cache);
+	}
+
+	//
+	// Loop over all STX files, load and parse them
+	//
+	bool result = true;
+	Common::ArchiveMemberList::iterator member = members.begin();
+	for (uint i = 0; i < streams.size(); ++i, ++member) {
+		if (!result) {
+			delete streams[i];
+			continue;
+		}
+
+		if (_parser->loadStream(streams[i]) == false) {
+			warning("Failed to load STX file '%s'", (*member)->getDisplayName().c_str());
 			_parser->close();
-			return false;
+			result = false;
+			continue;
 		}
 
 		if (_parser->parse() == false) {
-			warning("Failed to parse STX file '%s'", (*i)->getDisplayName().c_str());
+			warning("Failed to parse STX file '%s'", (*member)->getDisplayName().c_str());
 			_parser->close();
-			return false;
+			result = false;
+			continue;
 		}
 
 		_parser->close();
 	}
 
+	_parser->setRecorder(nullptr);
+
+	if (!result)
+		return false;
+
+	debug(1, "Parsed the STX files of theme '%s' in %d ms", themeId.c_str(), _system->getMillis() - start);
+
+	if (cacheable && !cache.save(cacheNode))
+		debug(1, "Could not write the theme cache '%s'", cacheNode.getPath().c_str());
+
 	assert(!_themeName.empty());
 	return true;
 }
@@ -980,6 +1187,9 @@ void ThemeEngine::drawDD(DrawData type, const Common::Rect &r, uint32 dynamic, b
 		extendedRect.bottom += drawData->_shadowOffset - drawData->_backgroundOffset;
 	}
 
+	const bool unclipped = area == r && !_clip.isEmpty() && _clip.contains(extendedRect) &&
+	                       Common::Rect(_screen.w, _screen.h).contains(extendedRect);
+
 	if (!_clip.isEmpty()) {
 		extendedRect.clip(_clip);
 	}
@@ -993,13 +1203,96 @@ void ThemeEngine::drawDD(DrawData type, const Common::Rect &r, uint32 dynamic, b
 		restoreBackground(extendedRect);
 
 	if (drawData->_layer == _layerToDraw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
+		drawDDSteps(type, drawData, area, extendedRect, dynamic, unclipped);
+		addDirtyRect(extendedRect);
+	}
+}
+
+static uint32 hashPixels(const Graphics::Surface *surface, const Common::Rect &r) {
+	const uint rowSize = r.width() * surface->format.bytesPerPixel;
+	uint32 hash = 2166136261U;
+	for (int y = r.top; y < r.bottom; ++y) {
+		const byte *src = (const byte *)surface->getBasePtr(r.left, y);
+		for (uint i = 0; i < rowSize; ++i)
+			hash = (hash ^ src[i]) * 16777619U;
+	}
+	return hash;
+}
+
+static void copyPixels(const Graphics::Surface *surface, const Common::Rect &r, Common::Array<byte> &pixels) {
+	const uint rowSize = r.width() * surface->format.bytesPerPixel;
+	pixels.resize(rowSize * r.height());
+	for (int y = r.top; y < r.bottom; ++y)
+		memcpy(&pixels[(y - r.top) * rowSize], surface->getBasePtr(r.left, y), rowSize);
+}
+
+static bool comparePixels(const Graphics::Surface *surface, const Common::Rect &r, const Common::Array<byte> &pixels) {
+	const uint rowSize = r.width() * surface->format.bytesPerPixel;
+	if (pixels.size() != rowSize * r.height())
+		return false;
+	for (int y = r.top; y < r.bottom; ++y) {
+		if (memcmp(&pixels[(y - r.top) * rowSize], surface->getBasePtr(r.left, y), rowSize))
+			return false;
+	}
+	return true;
+}
+
+void ThemeEngine::drawDDSteps(DrawData type, const WidgetDrawData *drawData, const Common::Rect &area,
+                              const Common::Rect &extendedRect, uint32 dynamic, bool cacheable) {
+	Common::List<Graphics::DrawStep>::const_iterator step;
+
+	Graphics::Surface *surface = _vectorRenderer->getActiveSurface();
+	if (!cacheable || !drawData->_cacheable || area.width() * area.height() > DrawDataCache::kMaxArea) {
 		for (step = drawData->_steps.begin(); step != drawData->_steps.end(); ++step) {
 			_vectorRenderer->drawStep(area, _clip, *step, dynamic);
 		}
+		return;
+	}
 
-		addDirtyRect(extendedRect);
+	DrawDataCache::Key key;
+	key.type = type;
+	key.dynamic = dynamic;
+	key.width = area.width();
+	key.height = area.height();
+	key.parity = (area.left & 1) | ((area.top & 1) << 1);
+	_vectorRenderer->getColors(key.colors);
+	for (int i = 0; i < ARRAYSIZE(key.colors); ++i) {
+		if (!(drawData->_inheritedColors & (1 << i)))
+			key.colors[i] = 0;
 	}
+	key.backgroundHash = hashPixels(surface, extendedRect);
+
+	DrawDataCache::Entry *entry = _drawDataCache->entries.find(key);
+	if (entry && comparePixels(surface, extendedRect, entry->background)) {
+		const uint rowSize = extendedRect.width() * surface->format.bytesPerPixel;
+		for (int y = extendedRect.top; y < extendedRect.bottom; ++y)
+			memcpy(surface->getBasePtr(extendedRect.left, y), &entry->pixels[(y - extendedRect.top) * rowSize], rowSize);
+
+		// Leave the renderer set up as drawing the steps would have
+		for (step = drawData->_steps.begin(); step != drawData->_steps.end(); ++step) {
+			_vectorRenderer->applyStepState(area, _clip, *step, dynamic);
+		}
+		return;
+	}
+
+	if (entry)
+		_drawDataCache->bytes -= entry->getBytes();
+	else
+		entry = _drawDataCache->insert(key);
+
+	copyPixels(surface, extendedRect, entry->background);
+	for (step = drawData->_steps.begin(); step != drawData->_steps.end(); ++step) {
+		_vectorRenderer->drawStep(area, _clip, *step, dynamic);
+	}
+	copyPixels(surface, extendedRect, entry->pixels);
+
+	_drawDataCache->bytes += entry->getBytes();
+	_drawDataCache->trim();
+}
+
+void ThemeEngine::getDrawDataCacheStatistics(uint32 &hits, uint32 &misses) const {
+	hits = _drawDataCache->entries.getHits();
+	misses = _drawDataCache->entries.getMisses();
 }
 
 void ThemeEngine::drawDDText(TextData type, TextColor color, const Common::Rect &r, const Common::U32String &text,
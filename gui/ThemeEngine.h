@@ -50,6 +50,7 @@ class VectorRenderer;
 namespace GUI {
 
 struct WidgetDrawData;
+struct DrawDataCache;
 struct TextDrawData;
 struct TextColorData;
 class Dialog;
@@ -663,6 +664,12 @@ public:
 	const Common::String &getThemeId() const { return _themeId; }
 	int getGraphicsMode() const { return _graphicsMode; }
 
+	/**
+	 * Get the number of DrawData elements copied from the DrawData cache,
+	 * and the number of those which had to be drawn.
+	 */
+	void getDrawDataCacheStatistics(uint32 &hits, uint32 &misses) const;
+
 protected:
 
 	/**
@@ -686,6 +693,21 @@ protected:
 	 */
 	void unloadTheme();
 
+	/**
+	 * Deletes the draw data, fonts, text colors and layouts set up
+	 * by the theme files.
+	 */
+	void clearThemeData();
+
+	/**
+	 * Finds the file used to cache the parsed STX files of the theme. It is
+	 * kept with the other caches, next to the configuration file, and named
+	 * after the theme id.
+	 *
+	 * @returns false if the theme can not be cached.
+	 */
+	bool getThemeCacheNode(Common::FSNode &node) const;
+
 	/**
 	 * Unload the language specific font loaded via loadExtraFont()
 	*/
@@ -716,6 +738,17 @@ protected:
 	                TextAlignVertical alignV = kTextAlignVTop, int deltax = 0,
 	                const Common::Rect &drawableTextArea = Common::Rect(0, 0, 0, 0));
 
+	/**
+	 * Draws the steps of a DrawData descriptor, or copies them from the
+	 * DrawData cache when they were already drawn with the same size over
+	 * the same pixels.
+	 *
+	 * @param cacheable Whether the steps are drawn unclipped, so that only
+	 *                  the pixels of extendedRect are modified.
+	 */
+	void drawDDSteps(DrawData type, const WidgetDrawData *drawData, const Common::Rect &area,
+	                 const Common::Rect &extendedRect, uint32 dynamic, bool cacheable);
+
 	/**
 	 * DEBUG: Draws a white square and writes some text next to it.
 	 */
@@ -783,6 +816,9 @@ protected:
 	 */
 	WidgetDrawData *_widgets[kDrawDataMAX];
 
+	/** Recently drawn DrawData elements. */
+	DrawDataCache *_drawDataCache;
+
 	/** Array of all the text fonts that can be drawn. */
 	TextDrawData *_texts[kTextDataMAX];
 
@@ -20,6 +20,7 @@
  *
  */
 
+#include "gui/ThemeCache.h"
 #include "gui/ThemeEngine.h"
 #include "gui/ThemeEval.h"
 #include "gui/ThemeParser.h"
@@ -112,6 +113,7 @@ ThemeParser::ThemeParser(ThemeEngine *parent) : XMLParser() {
 	_defaultStepGlobal = defaultDrawStep();
 	_defaultStepLocal = nullptr;
 	_theme = parent;
+	_recorder = nullptr;
 }
 
 ThemeParser::~ThemeParser() {
@@ -229,6 +231,9 @@ bool ThemeParser::parserCallback_language(ParserNode *node) {
 	if (!_theme->addFont(textDataId, node->values["id"], file, scalableFile, pointsize))
 		return parserError("Error loading localized Font in theme engine.");
 
+	if (_recorder)
+		_recorder->recordFont(textDataId, node->values["id"], file, scalableFile, pointsize);
+
 	return true;
 }
 
@@ -247,6 +252,9 @@ bool ThemeParser::parserCallback_text_color(ParserNode *node) {
 	if (!_theme->addTextColor(colorId, red, green, blue))
 		return parserError("Error while adding text color information.");
 
+	if (_recorder)
+		_recorder->recordTextColor(colorId, red, green, blue);
+
 	return true;
 }
 
@@ -268,6 +276,9 @@ bool ThemeParser::parserCallback_cursor(ParserNode *node) {
 	if (!_theme->createCursor(node->values["file"], spotx, spoty))
 		return parserError("Error creating Bitmap Cursor.");
 
+	if (_recorder)
+		_recorder->recordCursor(node->values["file"], spotx, spoty);
+
 	return true;
 }
 
@@ -280,6 +291,9 @@ bool ThemeParser::parserCallback_bitmap(ParserNode *node) {
 	if (!_theme->addBitmap(node->values["filename"]))
 		return parserError("Error loading Bitmap file '" + node->values["filename"] + "'");
 
+	if (_recorder)
+		_recorder->recordBitmap(node->values["filename"]);
+
 	return true;
 }
 
@@ -292,6 +306,9 @@ bool ThemeParser::parserCallback_alphabitmap(ParserNode *node) {
 	if (!_theme->addAlphaBitmap(node->values["filename"]))
 		return parserError("Error loading Bitmap file '" + node->values["filename"] + "'");
 
+	if (_recorder)
+		_recorder->recordAlphaBitmap(node->values["filename"]);
+
 	return true;
 }
 
@@ -312,6 +329,9 @@ bool ThemeParser::parserCallback_text(ParserNode *node) {
 	if (!_theme->addTextData(id, textDataId, textColorId, alignH, alignV))
 		return parserError("Error adding Text Data for '" + id + "'.");
 
+	if (_recorder)
+		_recorder->recordTextData(id, textDataId, textColorId, alignH, alignV);
+
 	return true;
 }
 
@@ -353,7 +373,7 @@ bool ThemeParser::parserCallback_color(ParserNode *node) {
 }
 
 
-static Graphics::DrawingFunctionCallback getDrawingFunctionCallback(const Common::String &name) {
+Graphics::DrawingFunctionCallback ThemeParser::getDrawingFunctionCallback(const Common::String &name) {
 
 	if (name == "circle")
 		return &Graphics::VectorRenderer::drawCallback_CIRCLE;
@@ -402,6 +422,10 @@ bool ThemeParser::parserCallback_drawstep(ParserNode *node) {
 	}
 
 	_theme->addDrawStep(getParentNode(node)->values["id"], *drawstep);
+
+	if (_recorder)
+		_recorder->recordDrawStep(getParentNode(node)->values["id"], functionName, node->values["file"], *drawstep);
+
 	delete drawstep;
 
 	return true;
@@ -423,6 +447,9 @@ bool ThemeParser::parserCallback_drawdata(ParserNode *node) {
 	if (_theme->addDrawData(node->values["id"], cached) == false)
 		return parserError("Error adding Draw Data set: Invalid DrawData name.");
 
+	if (_recorder)
+		_recorder->recordDrawData(node->values["id"], cached);
+
 	delete _defaultStepLocal;
 	_defaultStepLocal = nullptr;
 
@@ -704,7 +731,7 @@ bool ThemeParser::parserCallback_def(ParserNode *node) {
 	else if (!parseIntegerKey(node->values["value"], 1, &value))
 		return parserError("Invalid definition for '" + var + "'.");
 
-	_theme->getEvaluator()->setVar(var, value);
+	setVar(var, value);
 	return true;
 }
 
@@ -757,6 +784,9 @@ bool ThemeParser::parserCallback_widget(ParserNode *node) {
 		}
 
 		_theme->getEvaluator()->addWidget(var, node->values["type"], width, height, alignH, useRTL);
+
+		if (_recorder)
+			_recorder->recordWidget(var, node->values["type"], width, height, alignH, useRTL);
 	}
 
 	return true;
@@ -795,6 +825,9 @@ bool ThemeParser::parserCallback_dialog(ParserNode *node) {
 
 	_theme->getEvaluator()->addDialog(name, overlays, width, height, inset);
 
+	if (_recorder)
+		_recorder->recordDialog(name, overlays, width, height, inset);
+
 	if (node->values.contains("shading")) {
 		int shading = 0;
 		if (node->values["shading"] == "dim")
@@ -803,7 +836,7 @@ bool ThemeParser::parserCallback_dialog(ParserNode *node) {
 			shading = 2;
 		else return parserError("Invalid value for Dialog background shading.");
 
-		_theme->getEvaluator()->setVar("Dialog." + name + ".Shading", shading);
+		setVar("Dialog." + name + ".Shading", shading);
 	}
 
 	return true;
@@ -817,6 +850,9 @@ bool ThemeParser::parserCallback_import(ParserNode *node) {
 
 	_theme->getEvaluator()->addImportedLayout(importedName);
 
+	if (_recorder)
+		_recorder->recordImportedLayout(importedName);
+
 	return true;
 }
 
@@ -845,13 +881,19 @@ bool ThemeParser::parserCallback_layout(ParserNode *node) {
 		}
 	}
 
+	ThemeLayout::LayoutType type;
 	if (node->values["type"] == "vertical")
-		_theme->getEvaluator()->addLayout(GUI::ThemeLayout::kLayoutVertical, spacing, itemAlign);
+		type = GUI::ThemeLayout::kLayoutVertical;
 	else if (node->values["type"] == "horizontal")
-		_theme->getEvaluator()->addLayout(GUI::ThemeLayout::kLayoutHorizontal, spacing, itemAlign);
+		type = GUI::ThemeLayout::kLayoutHorizontal;
 	else
 		return parserError("Invalid layout type. Only 'horizontal' and 'vertical' layouts allowed.");
 
+	_theme->getEvaluator()->addLayout(type, spacing, itemAlign);
+
+	if (_recorder)
+		_recorder->recordLayout(type, spacing, itemAlign);
+
 	if (node->values.contains("padding")) {
 		int paddingL, paddingR, paddingT, paddingB;
 
@@ -859,6 +901,9 @@ bool ThemeParser::parserCallback_layout(ParserNode *node) {
 			return false;
 
 		_theme->getEvaluator()->addPadding(paddingL, paddingR, paddingT, paddingB);
+
+		if (_recorder)
+			_recorder->recordPadding(paddingL, paddingR, paddingT, paddingB);
 	}
 
 	return true;
@@ -876,18 +921,36 @@ bool ThemeParser::parserCallback_space(ParserNode *node) {
 	}
 
 	_theme->getEvaluator()->addSpace(size);
+
+	if (_recorder)
+		_recorder->recordSpace(size);
+
 	return true;
 }
 
 bool ThemeParser::closedKeyCallback(ParserNode *node) {
-	if (node->name == "layout")
+	if (node->name == "layout") {
 		_theme->getEvaluator()->closeLayout();
-	else if (node->name == "dialog")
+
+		if (_recorder)
+			_recorder->recordCloseLayout();
+	} else if (node->name == "dialog") {
 		_theme->getEvaluator()->closeDialog();
 
+		if (_recorder)
+			_recorder->recordCloseDialog();
+	}
+
 	return true;
 }
 
+void ThemeParser::setVar(const Common::String &name, int value) {
+	_theme->getEvaluator()->setVar(name, value);
+
+	if (_recorder)
+		_recorder->recordVar(name, value);
+}
+
 bool ThemeParser::parseCommonLayoutProps(ParserNode *node, const Common::String &var) {
 	if (node->values.contains("size")) {
 		int width, height;
@@ -930,8 +993,8 @@ bool ThemeParser::parseCommonLayoutProps(ParserNode *node, const Common::String
 		}
 
 
-		_theme->getEvaluator()->setVar(var + "Width", width);
-		_theme->getEvaluator()->setVar(var + "Height", height);
+		setVar(var + "Width", width);
+		setVar(var + "Height", height);
 	}
 
 	if (node->values.contains("pos")) {
@@ -986,8 +1049,8 @@ bool ThemeParser::parseCommonLayoutProps(ParserNode *node, const Common::String
 				return false;
 		}
 
-		_theme->getEvaluator()->setVar(var + "X", x);
-		_theme->getEvaluator()->setVar(var + "Y", y);
+		setVar(var + "X", x);
+		setVar(var + "Y", y);
 	}
 
 	if (node->values.contains("padding")) {
@@ -996,10 +1059,10 @@ bool ThemeParser::parseCommonLayoutProps(ParserNode *node, const Common::String
 		if (!parseIntegerKey(node->values["padding"], 4, &paddingL, &paddingR, &paddingT, &paddingB))
 			return false;
 
-		_theme->getEvaluator()->setVar(var + "Padding.Left", paddingL);
-		_theme->getEvaluator()->setVar(var + "Padding.Right", paddingR);
-		_theme->getEvaluator()->setVar(var + "Padding.Top", paddingT);
-		_theme->getEvaluator()->setVar(var + "Padding.Bottom", paddingB);
+		setVar(var + "Padding.Left", paddingL);
+		setVar(var + "Padding.Right", paddingR);
+		setVar(var + "Padding.Top", paddingT);
+		setVar(var + "Padding.Bottom", paddingB);
 	}
 
 
@@ -1009,7 +1072,7 @@ bool ThemeParser::parseCommonLayoutProps(ParserNode *node, const Common::String
 		if ((alignH = parseTextHAlign(node->values["textalign"])) == Graphics::kTextAlignInvalid)
 			return parserError("Invalid value for text alignment.");
 
-		_theme->getEvaluator()->setVar(var + "Align", alignH);
+		setVar(var + "Align", alignH);
 	}
 	return true;
 }
@@ -26,8 +26,11 @@
 #include "common/scummsys.h"
 #include "common/xmlparser.h"
 
+#include "graphics/VectorRenderer.h"
+
 namespace GUI {
 
+class ThemeCache;
 class ThemeEngine;
 
 class ThemeParser : public Common::XMLParser {
@@ -47,8 +50,17 @@ public:
 		return true;
 	}
 
+	/**
+	 * Set the cache which records the calls made into the theme while
+	 * parsing, or nullptr to stop recording.
+	 */
+	void setRecorder(ThemeCache *recorder) { _recorder = recorder; }
+
+	static Graphics::DrawingFunctionCallback getDrawingFunctionCallback(const Common::String &name);
+
 protected:
 	ThemeEngine *_theme;
+	ThemeCache *_recorder;
 
 	CUSTOM_XML_PARSER(ThemeParser) {
 		XML_KEY(render_info)
@@ -262,6 +274,7 @@ protected:
 	Graphics::DrawStep *defaultDrawStep();
 	bool parseDrawStep(ParserNode *stepNode, Graphics::DrawStep *drawstep, bool functionSpecific);
 	bool parseCommonLayoutProps(ParserNode *node, const Common::String &var);
+	void setVar(const Common::String &name, int value);
 
 	Graphics::DrawStep *_defaultStepGlobal;
 	Graphics::DrawStep *_defaultStepLocal;
@@ -179,6 +179,7 @@ bool GuiManager::loadNewTheme(Common::String id, ThemeEngine::GraphicsMode gfx,
 		gfx = ThemeEngine::_defaultRendererMode;
 
 	// Try to load the new theme
+	const uint32 start = _system->getMillis();
 	newTheme = new ThemeEngine(id, gfx);
 	assert(newTheme);
 
@@ -187,6 +188,8 @@ bool GuiManager::loadNewTheme(Common::String id, ThemeEngine::GraphicsMode gfx,
 		return false;
 	}
 
+	debug(1, "Loaded GUI theme '%s' in %d ms", id.c_str(), _system->getMillis() - start);
+
 	//
 	// Disable and delete the old theme
 	//
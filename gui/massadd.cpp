@@ -57,18 +57,15 @@ enum {
 
 MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	: Dialog("MassAdd"),
-	_dirsScanned(0),
+	_scan(startDir),
 	_oldGamesCount(0),
-	_dirTotal(0),
+	_scanStartTime(g_system->getMillis()),
 	_okButton(nullptr),
 	_dirProgressText(nullptr),
 	_gameProgressText(nullptr) {
 
 	U32StringArray l;
 
-	// The dir we start our scan at
-	_scanStack.push(startDir);
-
 	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
 	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
 
@@ -160,35 +157,22 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 }
 
 void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
+	if (_scan.isDone())
 		return;	// We have finished scanning
 
 	uint32 t = g_system->getMillis();
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
-
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
-		}
-
-		// Run the detector on the dir
-		DetectionResults detectionResults = EngineMan.detectGames(files);
-
-		if (detectionResults.foundUnknownGames()) {
-			Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
-			g_system->logMessage(LogMessageType::kInfo, report.encode().c_str());
-		}
-
+	// Run the engine detectors one at a time, so that the dialog stays
+	// responsive even for directories which take long to detect.
+	Common::FSNode dir;
+	DetectedGames candidates;
+	while ((g_system->getMillis() - t) < kMaxScanTime && _scan.step(dir, candidates)) {
 		// Just add all detected games / game variants. If we get more than one,
 		// that either means the directory contains multiple games, or the detector
 		// could not fully determine which game variant it was seeing. In either
 		// case, let the user choose which entries he wants to keep.
 		//
 		// However, we only add games which are not already in the config file.
-		DetectedGames candidates = detectionResults.listRecognizedGames();
 		for (DetectedGames::const_iterator cand = candidates.begin(); cand != candidates.end(); ++cand) {
 			const DetectedGame &result = *cand;
 
@@ -227,30 +211,19 @@ void MassAddDialog::handleTickle() {
 
 			_list->append(result.description);
 		}
-
-
-		// Recurse into all subdirs
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			if (file->isDirectory()) {
-				_scanStack.push(*file);
-
-				_dirTotal++;
-			}
-		}
-
-		_dirsScanned++;
+	}
 
 #if defined(USE_TASKBAR)
-		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
+	g_system->getTaskbarManager()->setProgressValue(_scan.getDirsScanned(), _scan.getDirsTotal());
+	g_system->getTaskbarManager()->setCount(_games.size());
 #endif
-	}
-
 
 	// Update the dialog
 	Common::U32String buf;
 
-	if (_scanStack.empty()) {
+	if (_scan.isDone()) {
+		debug(1, "Mass add: scanned %d directories in %d ms", _scan.getDirsScanned(), g_system->getMillis() - _scanStartTime);
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
@@ -261,7 +234,7 @@ void MassAddDialog::handleTickle() {
 		_gameProgressText->setLabel(buf);
 
 	} else {
-		buf = Common::U32String::format(_("Scanned %d directories ..."), _dirsScanned);
+		buf = Common::U32String::format(_("Scanned %d directories ..."), _scan.getDirsScanned());
 		_dirProgressText->setLabel(buf);
 
 		buf = Common::U32String::format(_("Discovered %d new games, ignored %d previously added games ..."), _games.size(), _oldGamesCount);
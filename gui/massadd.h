@@ -25,9 +25,9 @@
 
 #include "gui/dialog.h"
 #include "gui/widgets/list.h"
+#include "engines/metaengine.h"
 #include "common/fs.h"
 #include "common/hashmap.h"
-#include "common/stack.h"
 #include "common/str.h"
 
 namespace GUI {
@@ -51,7 +51,7 @@ public:
 	}
 
 private:
-	Common::Stack<Common::FSNode>  _scanStack;
+	DetectionScan _scan;
 	DetectedGames _games;
 
 	/**
@@ -61,9 +61,8 @@ private:
 	 */
 	Common::HashMap<Common::String, StringArray>	_pathToTargets;
 
-	int _dirsScanned;
 	int _oldGamesCount;
-	int _dirTotal;
+	uint32 _scanStartTime;
 
 	Widget *_okButton;
 	StaticTextWidget *_dirProgressText;
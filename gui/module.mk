@@ -21,6 +21,8 @@ MODULE_OBJS := \
 	saveload.o \
 	saveload-dialog.o \
 	themebrowser.o \
+	ThemeCache.o \
+	ThemeCacheFile.o \
 	ThemeEngine.o \
 	ThemeEval.o \
 	ThemeLayout.o \
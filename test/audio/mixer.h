@@ -0,0 +1,186 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+
+#include "common/system.h"
+#include "../null_osystem.h"
+
+class MixerTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kRate = 22050,
+		kCallbackFrames = 512
+	};
+
+	/** Mono ramp, which records its deletion */
+	class RampStream : public Audio::AudioStream {
+	public:
+		RampStream(int frames, bool *deleted) : _pos(0), _frames(frames), _deleted(deleted) {}
+		~RampStream() { *_deleted = true; }
+
+		int readBuffer(int16 *buffer, const int numSamples) {
+			const int samples = MIN(numSamples, _frames - _pos);
+			for (int i = 0; i < samples; ++i)
+				buffer[i] = (int16)((_pos + i) * 7);
+			_pos += samples;
+			return samples;
+		}
+
+		bool isStereo() const { return false; }
+		int getRate() const { return kRate; }
+		bool endOfData() const { return _pos == _frames; }
+
+	private:
+		int _pos;
+		const int _frames;
+		bool *const _deleted;
+	};
+
+	static void play(Audio::Mixer &mixer, Audio::Mixer::SoundType type, Audio::SoundHandle *handle, Audio::AudioStream *stream) {
+		mixer.playStream(type, handle, stream);
+	}
+
+	static void mix(Audio::MixerImpl &mixer, int16 *buffer) {
+		mixer.mixCallback((byte *)buffer, kCallbackFrames * 4);
+	}
+
+	static uint32 getTimedCallbacks(const Audio::MixerImpl &mixer) {
+		uint32 timed = 0;
+		for (int i = 0; i < Audio::MixerImpl::kDurationBuckets; ++i)
+			timed += mixer.getStatistics().durations[i];
+		return timed;
+	}
+
+	public:
+	void test_decode_ahead_available() {
+		Audio::MixerImpl mixer(kRate);
+#ifdef USE_CXX11
+		TS_ASSERT(mixer.setDecodeAhead(true));
+#else
+		TS_ASSERT(!mixer.setDecodeAhead(true));
+#endif
+		TS_ASSERT(!mixer.setDecodeAhead(false));
+	}
+
+	void test_statistics() {
+		Common::install_null_g_system();
+
+		Audio::MixerImpl mixer(kRate);
+		mixer.setReady(true);
+
+		// The callbacks are only timed on request
+		int16 buffer[kCallbackFrames * 2];
+		mix(mixer, buffer);
+		TS_ASSERT_EQUALS(mixer.getStatistics().callbacks, 1u);
+		TS_ASSERT_EQUALS(getTimedCallbacks(mixer), 0u);
+
+		mixer.setStatisticsEnabled(true);
+		mix(mixer, buffer);
+		mix(mixer, buffer);
+		TS_ASSERT_EQUALS(mixer.getStatistics().callbacks, 3u);
+		TS_ASSERT_EQUALS(getTimedCallbacks(mixer), 2u);
+	}
+
+	void test_decode_ahead_output() {
+#ifdef USE_CXX11
+		Common::install_null_g_system();
+
+		Audio::MixerImpl reference(kRate);
+		reference.setReady(true);
+
+		Audio::MixerImpl mixer(kRate);
+		TS_ASSERT(mixer.setDecodeAhead(true));
+		mixer.setReady(true);
+
+		bool referenceDeleted = false, deleted = false;
+		Audio::SoundHandle referenceHandle, handle;
+		play(reference, Audio::Mixer::kMusicSoundType, &referenceHandle, new RampStream(20000, &referenceDeleted));
+		play(mixer, Audio::Mixer::kMusicSoundType, &handle, new RampStream(20000, &deleted));
+
+		int16 expected[kCallbackFrames * 2], result[kCallbackFrames * 2];
+		bool same = true;
+		for (int i = 0; i < 50; ++i) {
+			mixer.decodeAhead();
+			mix(reference, expected);
+			mix(mixer, result);
+			same = same && !memcmp(expected, result, sizeof(expected));
+		}
+		TS_ASSERT(same);
+
+		TS_ASSERT(!reference.isSoundHandleActive(referenceHandle));
+		TS_ASSERT(!mixer.isSoundHandleActive(handle));
+		TS_ASSERT_EQUALS(mixer.getStatistics().callbacks, 50u);
+		TS_ASSERT_EQUALS(mixer.getStatistics().decodeUnderruns, 0u);
+
+		TS_ASSERT_EQUALS(getTimedCallbacks(mixer), 50u);
+
+		// The stream is deleted by the decoding
+		TS_ASSERT(referenceDeleted);
+		mixer.decodeAhead();
+		TS_ASSERT(deleted);
+#endif
+	}
+
+	void test_decode_ahead_underrun() {
+#ifdef USE_CXX11
+		Common::install_null_g_system();
+
+		Audio::MixerImpl mixer(kRate);
+		TS_ASSERT(mixer.setDecodeAhead(true));
+		mixer.setReady(true);
+
+		bool deleted = false;
+		Audio::SoundHandle handle;
+		play(mixer, Audio::Mixer::kSpeechSoundType, &handle, new RampStream(100000, &deleted));
+
+		// Without decoding, the samples decoded when the sound started run out
+		int16 buffer[kCallbackFrames * 2];
+		for (int i = 0; i < 40; ++i)
+			mix(mixer, buffer);
+		TS_ASSERT_LESS_THAN(0u, mixer.getStatistics().decodeUnderruns);
+		TS_ASSERT(mixer.isSoundHandleActive(handle));
+
+		mixer.resetStatistics();
+		mixer.decodeAhead();
+		mix(mixer, buffer);
+		TS_ASSERT_EQUALS(mixer.getStatistics().decodeUnderruns, 0u);
+		TS_ASSERT_EQUALS(mixer.getStatistics().callbacks, 1u);
+
+		mixer.stopHandle(handle);
+		TS_ASSERT(!deleted);
+		mixer.decodeAhead();
+		TS_ASSERT(deleted);
+#endif
+	}
+
+	void test_queued_commands() {
+#ifdef USE_CXX11
+		Common::install_null_g_system();
+
+		Audio::MixerImpl mixer(kRate);
+		TS_ASSERT(mixer.setDecodeAhead(true));
+		mixer.setReady(true);
+
+		bool deleted = false;
+		Audio::SoundHandle handle;
+		play(mixer, Audio::Mixer::kMusicSoundType, &handle, new RampStream(100000, &deleted));
+
+		// More changes than the queue holds
+		for (int i = 0; i < 1000; ++i)
+			mixer.setChannelVolume(handle, i % 256);
+		mixer.setChannelBalance(handle, -20);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 999 % 256);
+		TS_ASSERT_EQUALS(mixer.getChannelBalance(handle), -20);
+
+		// Silence
+		mixer.setChannelVolume(handle, 0);
+		int16 buffer[kCallbackFrames * 2];
+		mix(mixer, buffer);
+		bool silent = true;
+		for (int i = 0; i < kCallbackFrames * 2; ++i)
+			silent = silent && buffer[i] == 0;
+		TS_ASSERT(silent);
+#endif
+	}
+};
@@ -0,0 +1,106 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decoders/raw.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+#include "audio/rate_intern.h"
+
+#include "common/memstream.h"
+
+#include "../test_random.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kInputFrames = 5000,
+		kOutputFrames = 30000
+	};
+
+	/** Noise at full scale, including the extreme values */
+	static Audio::AudioStream *createNoiseStream(int rate, bool stereo, uint32 seed) {
+		const int samples = kInputFrames * (stereo ? 2 : 1);
+		byte *data = (byte *)malloc(samples * 2);
+		for (int i = 0; i < samples; ++i) {
+			uint16 value = nextTestRandom(seed);
+			if (i % 97 == 0)
+				value = (i & 1) ? 0x8000 : 0x7FFF;
+			WRITE_LE_UINT16(data + i * 2, value);
+		}
+
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream(data, samples * 2, DisposeAfterUse::YES);
+		return Audio::makeRawStream(stream, rate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (stereo ? Audio::FLAG_STEREO : 0));
+	}
+
+	/** Convert and mix the noise over noise, in chunks of varying sizes */
+	static int convert(int16 *output, int inRate, int outRate, bool stereo, bool reverseStereo, Audio::st_volume_t volL, Audio::st_volume_t volR) {
+		uint32 seed = 1;
+		for (int i = 0; i < kOutputFrames * 2; ++i)
+			output[i] = nextTestRandom(seed);
+
+		Audio::AudioStream *input = createNoiseStream(inRate, stereo, 2);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, reverseStereo);
+
+		static const int chunkSizes[] = { 1, 7, 1000, 4, 513, 3 };
+		int total = 0;
+		for (int i = 0; total < kOutputFrames; ++i) {
+			const int chunk = MIN<int>(chunkSizes[i % ARRAYSIZE(chunkSizes)], kOutputFrames - total);
+			const int frames = converter->flow(*input, output + total * 2, chunk, volL, volR);
+			total += frames;
+			if (frames < chunk)
+				break;
+		}
+
+		delete converter;
+		delete input;
+		return total;
+	}
+
+	void compareWithReference(int inRate, int outRate) {
+		static const Audio::st_volume_t volumes[][2] = {
+			{ Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume },
+			{ 255, 3 },
+			{ 0, 128 },
+			{ 1, Audio::Mixer::kMaxMixerVolume }
+		};
+
+		int16 *expected = new int16[kOutputFrames * 2];
+		int16 *result = new int16[kOutputFrames * 2];
+
+		for (int channels = 0; channels < 3; ++channels) {
+			const bool stereo = (channels != 0);
+			const bool reverseStereo = (channels == 2);
+
+			for (int i = 0; i < ARRAYSIZE(volumes); ++i) {
+				Audio::setRateConverterSIMD(false);
+				const int expectedFrames = convert(expected, inRate, outRate, stereo, reverseStereo, volumes[i][0], volumes[i][1]);
+
+				Audio::setRateConverterSIMD(true);
+				const int resultFrames = convert(result, inRate, outRate, stereo, reverseStereo, volumes[i][0], volumes[i][1]);
+
+				TS_ASSERT_LESS_THAN(0, expectedFrames);
+				TS_ASSERT_EQUALS(expectedFrames, resultFrames);
+				TS_ASSERT_EQUALS(memcmp(expected, result, kOutputFrames * 2 * sizeof(int16)), 0);
+			}
+		}
+
+		delete[] expected;
+		delete[] result;
+	}
+
+	public:
+	void test_copy() {
+		compareWithReference(22050, 22050);
+	}
+
+	void test_simple() {
+		compareWithReference(44100, 11025);
+	}
+
+	void test_linear_upsample() {
+		compareWithReference(11025, 44100);
+	}
+
+	void test_linear_downsample() {
+		compareWithReference(48000, 44100);
+	}
+};
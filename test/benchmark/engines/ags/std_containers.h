@@ -0,0 +1,75 @@
+#include <cxxtest/TestSuite.h>
+
+#include "engines/ags/lib/std/map.h"
+
+#include "../../../null_osystem.h"
+#include "../../../test_benchmark.h"
+
+/**
+ * Compare the containers with the access pattern of the managed object
+ * pool: 100k objects added, looked up by handle and by address, and then
+ * released.
+ */
+class AGSStdContainersBenchmarkSuite : public CxxTest::TestSuite
+{
+	typedef AGS3::std::map<int, int> IntMap;
+
+	enum {
+		kObjects = 100000
+	};
+
+	/** Same as the hash of the managed object pool */
+	struct PointerHash {
+		uint operator()(const char *v) const {
+			uint x = static_cast<uint>(reinterpret_cast<uintptr>(v));
+			return x + (x >> 3);
+		}
+	};
+
+	public:
+	void test_map_by_handle() {
+		Common::install_null_g_system();
+
+		uint sum = 0;
+		BenchmarkTimer timer;
+		IntMap map;
+		for (int i = 0; i < kObjects; ++i)
+			map[(i * 7919) % kObjects] = i;
+		const uint32 insertTime = timer.lap();
+
+		for (int r = 0; r < 10; ++r) {
+			for (int i = 0; i < kObjects; ++i)
+				sum += map.find(i)->_value;
+		}
+		const uint32 findTime = timer.lap();
+
+		for (int i = 0; i < kObjects; ++i)
+			map.erase((i * 7919) % kObjects);
+		const uint32 eraseTime = timer.lap();
+		debug("map<int>, %d objects: insert %u ms, 10x find %u ms, erase %u ms (%u)", kObjects, insertTime, findTime, eraseTime, sum);
+	}
+
+	void test_unordered_map_by_address() {
+		Common::install_null_g_system();
+
+		uint sum = 0;
+		Common::Array<char> objects;
+		objects.resize(kObjects);
+		BenchmarkTimer timer;
+		AGS3::std::unordered_map<const char *, int, PointerHash> handleByAddress;
+		for (int i = 0; i < kObjects; ++i)
+			handleByAddress.insert(AGS3::std::pair<const char *, int>(&objects[i], i));
+		const uint32 insertTime = timer.lap();
+
+		for (int r = 0; r < 10; ++r) {
+			for (int i = 0; i < kObjects; ++i)
+				sum += handleByAddress[&objects[i]];
+		}
+		const uint32 findTime = timer.lap();
+
+		for (int i = 0; i < kObjects; ++i)
+			handleByAddress.erase(&objects[i]);
+		const uint32 eraseTime = timer.lap();
+		debug("unordered_map<address>, %d objects: insert %u ms, 10x find %u ms, erase %u ms (%u)", kObjects, insertTime, findTime, eraseTime, sum);
+	}
+};
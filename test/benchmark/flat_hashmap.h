@@ -0,0 +1,82 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flat-hashmap.h"
+#include "common/hash-str.h"
+
+#include "../null_osystem.h"
+#include "../test_benchmark.h"
+
+/**
+ * Compare FlatHashMap with HashMap.
+ */
+class FlatHashMapBenchmarkSuite : public CxxTest::TestSuite
+{
+	typedef Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FlatStringMap;
+
+	static uint makeIntKey(uint i) { return i * 2654435761U; }
+	static Common::String makeStringKey(uint i) { return Common::String::format("some/path/file%u.dat", i); }
+
+	template<class Map, class KeyType>
+	void benchmark(const char *name, uint count, KeyType (*makeKey)(uint)) {
+		Common::Array<KeyType> keys, missingKeys;
+		for (uint i = 0; i < count; ++i) {
+			keys.push_back(makeKey(i));
+			missingKeys.push_back(makeKey(i + count));
+		}
+
+		// Run every operation on about the same total number of entries
+		const uint rounds = MAX<uint>(1, 1000000 / count);
+		uint sum = 0;
+
+		BenchmarkTimer timer;
+		for (uint r = 0; r < rounds; ++r) {
+			Map map;
+			for (uint i = 0; i < count; ++i)
+				map[keys[i]] = i;
+			sum += map.size();
+		}
+		const uint32 insertTime = timer.lap();
+
+		Map map;
+		for (uint i = 0; i < count; ++i)
+			map[keys[i]] = i;
+
+		timer.lap();
+		for (uint r = 0; r < rounds; ++r) {
+			for (uint i = 0; i < count; ++i)
+				sum += map.contains(keys[i]);
+		}
+		const uint32 hitTime = timer.lap();
+
+		for (uint r = 0; r < rounds; ++r) {
+			for (uint i = 0; i < count; ++i)
+				sum += map.contains(missingKeys[i]);
+		}
+		const uint32 missTime = timer.lap();
+
+		for (uint r = 0; r < rounds; ++r) {
+			for (typename Map::const_iterator i = map.begin(); i != map.end(); ++i)
+				sum++;
+		}
+		const uint32 iterateTime = timer.lap();
+
+		debug("%-18s %7u entries: insert %4u ms, hit %4u ms, miss %4u ms, iterate %4u ms (%u)",
+		      name, count, insertTime, hitTime, missTime, iterateTime, sum);
+	}
+
+	public:
+	void test_flat_hashmap() {
+		Common::install_null_g_system();
+
+		for (uint count = 100; count <= 1000000; count *= 10) {
+			benchmark<Common::HashMap<uint, uint> >("HashMap<uint>", count, makeIntKey);
+			benchmark<Common::FlatHashMap<uint, uint> >("FlatHashMap<uint>", count, makeIntKey);
+
+			// The node pool of HashMap cannot hold a million strings
+			if (count < 1000000) {
+				benchmark<Common::StringMap>("StringMap", count, makeStringKey);
+				benchmark<FlatStringMap>("FlatStringMap", count, makeStringKey);
+			}
+		}
+	}
+};
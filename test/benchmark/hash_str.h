@@ -0,0 +1,64 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/hash-str.h"
+
+#include "../null_osystem.h"
+#include "../test_benchmark.h"
+
+/**
+ * Time the archive member lookups in a set of 50000 members, and the
+ * filling of a map of member names, which grows its storage many times.
+ */
+class HashStrBenchmarkSuite : public CxxTest::TestSuite
+{
+	typedef Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> MemberMap;
+
+	class BenchmarkArchive : public Common::Archive {
+	public:
+		MemberMap _members;
+
+		virtual bool hasFile(const Common::String &name) const { return _members.contains(name); }
+		virtual int listMembers(Common::ArchiveMemberList &list) const { return 0; }
+		virtual const Common::ArchiveMemberPtr getMember(const Common::String &name) const { return Common::ArchiveMemberPtr(); }
+		virtual Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const { return nullptr; }
+	};
+
+	public:
+	void test_archive_lookup() {
+		Common::install_null_g_system();
+
+		const uint archives = 10, members = 5000, rounds = 20;
+		Common::Array<Common::String> names;
+		for (uint i = 0; i < archives * members; ++i)
+			names.push_back(Common::String::format("Data/Room%05u/Background.bin", i));
+
+		BenchmarkTimer timer;
+		for (uint r = 0; r < rounds; ++r) {
+			MemberMap map;
+			for (uint i = 0; i < names.size(); ++i)
+				map[names[i]] = true;
+		}
+		const uint32 fillTime = timer.lap();
+
+		Common::SearchSet searchSet;
+		for (uint i = 0; i < archives; ++i) {
+			BenchmarkArchive *archive = new BenchmarkArchive();
+			for (uint j = i; j < names.size(); j += archives)
+				archive->_members[names[j]] = true;
+			searchSet.add(Common::String::format("archive%u", i), archive);
+		}
+
+		uint found = 0;
+		timer.lap();
+		for (uint r = 0; r < rounds; ++r) {
+			for (uint i = 0; i < names.size(); ++i)
+				found += searchSet.hasFile(names[i]);
+		}
+		const uint32 lookupTime = timer.lap();
+
+		const uint count = rounds * names.size();
+		debug("%u members: %u ns per insertion in a map, %u ns per lookup in %u archives (%u)", names.size(),
+		      (uint)(fillTime * 1000000ULL / count), (uint)(lookupTime * 1000000ULL / count), archives, found);
+	}
+};
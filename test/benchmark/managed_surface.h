@@ -0,0 +1,89 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/managed_surface.h"
+#include "graphics/managed_surface_intern.h"
+
+#include "../null_osystem.h"
+#include "../test_benchmark.h"
+
+/**
+ * Time the blits of a 640x480 surface for all format combinations, with
+ * and without the specialised kernels.
+ */
+class ManagedSurfaceBenchmarkSuite : public CxxTest::TestSuite
+{
+	static Graphics::PixelFormat getFormat(int index) {
+		switch (index) {
+		case 0:
+			return Graphics::PixelFormat::createFormatCLUT8();
+		case 1:
+			return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		case 2:
+			return Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15);
+		case 3:
+			return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		default:
+			return Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0);
+		}
+	}
+
+	/** Random pixels, and a palette with many transparent colors */
+	static void fill(Graphics::ManagedSurface &surf, uint32 seed) {
+		fillBenchmarkSurface(*surf.surfacePtr(), seed);
+
+		if (surf.format.bytesPerPixel == 1) {
+			uint32 palette[256];
+			for (int i = 0; i < 256; ++i)
+				palette[i] = nextTestRandom(seed) | ((i % 3 == 0 ? 0 : 0xff) << 24);
+			surf.setPalette(palette, 0, 256);
+		}
+	}
+
+	public:
+	void test_blit() {
+		Common::install_null_g_system();
+
+		static const char *const names[] = { "CLUT8", "RGB565", "RGB5551", "RGBA8888", "XRGB8888" };
+		for (int srcFormat = 0; srcFormat < 5; ++srcFormat) {
+			for (int destFormat = 0; destFormat < 5; ++destFormat) {
+				// Paletted surfaces can only be drawn on paletted ones
+				if (destFormat == 0 && srcFormat != 0)
+					continue;
+
+				Graphics::ManagedSurface src(640, 480, getFormat(srcFormat));
+				Graphics::ManagedSurface dest(640, 480, getFormat(destFormat));
+				fill(src, 1);
+				fill(dest, 2);
+				dest.clearPalette();
+
+				const byte *keyPixel = (const byte *)src.getBasePtr(5, 5);
+				const uint32 keyColor = src.format.bytesPerPixel == 1 ? *keyPixel :
+				                        (src.format.bytesPerPixel == 2 ? *(const uint16 *)keyPixel : *(const uint32 *)keyPixel);
+
+				// The generic code is the reference
+				uint32 times[2][3];
+				for (int kernels = 0; kernels < 2; ++kernels) {
+					Graphics::setBlitKernels(kernels != 0);
+
+					BenchmarkTimer timer;
+					for (int i = 0; i < 20; ++i)
+						dest.blitFrom(src);
+					times[kernels][0] = timer.lap();
+
+					for (int i = 0; i < 20; ++i)
+						dest.blitFrom(src, Common::Rect(0, 0, 320, 240), Common::Rect(0, 0, 640, 480));
+					times[kernels][1] = timer.lap();
+
+					for (int i = 0; i < 20; ++i)
+						dest.transBlitFrom(src, keyColor);
+					times[kernels][2] = timer.lap();
+				}
+
+				const Common::String what = Common::String::format("%s -> %s, 20 blits", names[srcFormat], names[destFormat]);
+				debugBenchmark(what, times[0][0], times[1][0]);
+				debugBenchmark(what + " scaled", times[0][1], times[1][1]);
+				debugBenchmark(what + " with a key color", times[0][2], times[1][2]);
+			}
+		}
+	}
+};
@@ -0,0 +1,69 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/palette_remap.h"
+
+#include "../null_osystem.h"
+#include "../test_benchmark.h"
+
+/**
+ * The time to build the palette remap tables, without and with the cache.
+ */
+class PaletteRemapBenchmarkSuite : public CxxTest::TestSuite
+{
+	static void fillPalette(uint32 *palette, uint32 seed) {
+		for (int i = 0; i < 256; ++i)
+			palette[i] = 0xff000000 | (nextTestRandom(seed) & 0xffffff);
+	}
+
+	/** The search as it was done before, by checking every color */
+	static uint findBestColorReference(const uint32 *palette, byte cr, byte cg, byte cb) {
+		uint bestColor = 0;
+		double min = 0xFFFFFFFF;
+
+		for (uint i = 0; i < 256; ++i) {
+			uint col = palette[i];
+
+			int rmean = ((col & 0xff) + cr) / 2;
+			int r = (col & 0xff) - cr;
+			int g = ((col >> 8) & 0xff) - cg;
+			int b = ((col >> 16) & 0xff) - cb;
+
+			double dist = sqrt((double)((((512 + rmean) * r * r) >> 8) + 4 * g * g + (((767 - rmean) * b * b) >> 8)));
+			if (min > dist) {
+				bestColor = i;
+				min = dist;
+			}
+		}
+
+		return bestColor;
+	}
+
+	public:
+	void test_remap_tables() {
+		Common::install_null_g_system();
+
+		uint32 srcPalette[256], dstPalette[256];
+		fillPalette(srcPalette, 40);
+		fillPalette(dstPalette, 41);
+		byte map[256];
+
+		BenchmarkTimer timer;
+		for (int i = 0; i < 100; ++i) {
+			for (int c = 0; c < 256; ++c) {
+				const uint col = srcPalette[c];
+				map[c] = findBestColorReference(dstPalette, col & 0xff, (col >> 8) & 0xff, (col >> 16) & 0xff);
+			}
+		}
+		const uint32 reference = timer.lap();
+
+		for (int i = 0; i < 100; ++i) {
+			PaletteRemapMan.clear();
+			PaletteRemapMan.getRemap(srcPalette, dstPalette, map);
+		}
+		debugBenchmark("100 remap tables sorted by green", reference, timer.lap());
+
+		for (int i = 0; i < 100000; ++i)
+			PaletteRemapMan.getRemap(srcPalette, dstPalette, map);
+		debug("100000 cached remap tables: %u ms", timer.lap());
+	}
+};
@@ -0,0 +1,80 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/transparent_surface.h"
+#include "graphics/transparent_surface_intern.h"
+
+#include "../null_osystem.h"
+#include "../test_benchmark.h"
+
+/**
+ * Time the blits of a 640x480 surface for all blend modes and alpha types,
+ * with and without SIMD, and the cached scaling of a sprite.
+ */
+class TransparentSurfaceBenchmarkSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_blit() {
+		Common::install_null_g_system();
+
+		static const char *const blendNames[] = { "normal", "additive", "subtractive", "multiply" };
+		static const char *const alphaNames[] = { "opaque", "binary", "full" };
+		const Graphics::PixelFormat format = Graphics::TransparentSurface::getSupportedPixelFormat();
+
+		Graphics::TransparentSurface src;
+		src.create(640, 480, format);
+		fillBenchmarkSurface(src, 1);
+		Graphics::Surface dest;
+		dest.create(640, 480, format);
+		fillBenchmarkSurface(dest, 2);
+
+		for (int alphaType = Graphics::ALPHA_OPAQUE; alphaType <= Graphics::ALPHA_FULL; ++alphaType) {
+			src.setAlphaMode((Graphics::AlphaType)alphaType);
+			for (int blend = Graphics::BLEND_NORMAL; blend < Graphics::NUM_BLEND_MODES; ++blend) {
+				// The C code is the reference
+				uint32 times[2][2];
+				for (int simd = 0; simd < 2; ++simd) {
+					Graphics::setTransparentSurfaceSIMD(simd != 0);
+
+					BenchmarkTimer timer;
+					for (int i = 0; i < 20; ++i)
+						src.blit(dest, 0, 0, Graphics::FLIP_NONE, nullptr, TS_ARGB(255, 255, 255, 255), -1, -1, (Graphics::TSpriteBlendMode)blend);
+					times[simd][0] = timer.lap();
+
+					for (int i = 0; i < 20; ++i)
+						src.blit(dest, 0, 0, Graphics::FLIP_NONE, nullptr, TS_ARGB(128, 200, 100, 50), -1, -1, (Graphics::TSpriteBlendMode)blend);
+					times[simd][1] = timer.lap();
+				}
+
+				const Common::String what = Common::String::format("%s %s, 20 blits", alphaNames[alphaType], blendNames[blend]);
+				debugBenchmark(what, times[0][0], times[1][0]);
+				debugBenchmark(what + " modulated", times[0][1], times[1][1]);
+			}
+		}
+		Graphics::setTransparentSurfaceSIMD(true);
+
+		src.free();
+		dest.free();
+	}
+
+	void test_transform_cache() {
+		Common::install_null_g_system();
+
+		Graphics::TransparentSurface src;
+		src.create(640, 480, Graphics::TransparentSurface::getSupportedPixelFormat());
+		fillBenchmarkSurface(src, 1);
+
+		Graphics::TransformedSurfaceCache cache;
+		const Common::Rect srcRect(0, 0, 200, 150);
+		BenchmarkTimer timer;
+		for (int i = 0; i < 100; ++i) {
+			cache.invalidate(&src);
+			cache.scale(&src, src, srcRect, 300, 225, true);
+		}
+		const uint32 uncached = timer.lap();
+		for (int i = 0; i < 100; ++i)
+			cache.scale(&src, src, srcRect, 300, 225, true);
+		debugBenchmark("100 cached scalings of 200x150 to 300x225", uncached, timer.lap());
+
+		src.free();
+	}
+};
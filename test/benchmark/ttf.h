@@ -0,0 +1,78 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/font.h"
+#include "graphics/fonts/ttf.h"
+#include "graphics/managed_surface.h"
+
+#include "common/file.h"
+#include "common/fs.h"
+
+#include "../null_osystem.h"
+#include "../test_benchmark.h"
+
+/**
+ * Compare drawing the rows of a long game list in the launcher with and
+ * without the caches of the TTF font.
+ */
+class TTFFontBenchmarkSuite : public CxxTest::TestSuite
+{
+	/** Font which forwards the per character methods to another one */
+	class UncachedFont : public Graphics::Font {
+	public:
+		UncachedFont(const Graphics::Font *font) : _font(font) {}
+
+		virtual int getFontHeight() const { return _font->getFontHeight(); }
+		virtual int getMaxCharWidth() const { return _font->getMaxCharWidth(); }
+		virtual int getCharWidth(uint32 chr) const { return _font->getCharWidth(chr); }
+		virtual int getKerningOffset(uint32 left, uint32 right) const { return _font->getKerningOffset(left, right); }
+		virtual Common::Rect getBoundingBox(uint32 chr) const { return _font->getBoundingBox(chr); }
+		virtual void drawChar(Graphics::Surface *dst, uint32 chr, int x, int y, uint32 color) const { _font->drawChar(dst, chr, x, y, color); }
+		virtual void drawChar(Graphics::ManagedSurface *dst, uint32 chr, int x, int y, uint32 color) const { _font->drawChar(dst, chr, x, y, color); }
+
+	private:
+		const Graphics::Font *_font;
+	};
+
+#ifdef USE_FREETYPE2
+	uint32 benchmark(const Graphics::Font *font, const Common::Array<Common::U32String> &names) {
+		const int rows = 25, rowHeight = font->getFontHeight() + 2;
+		Graphics::ManagedSurface screen(640, rows * rowHeight, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+
+		// Scroll through the list one row per frame, drawing 10000 rows in
+		// all, as the launcher does
+		BenchmarkTimer timer;
+		for (uint frame = 0; frame < names.size() / rows; ++frame) {
+			screen.fillRect(Common::Rect(screen.w, screen.h), 0);
+			for (int row = 0; row < rows; ++row)
+				font->drawString(&screen, names[(frame + row) % names.size()], 4, row * rowHeight, 400, 0xFFFFFFFF, Graphics::kTextAlignLeft, 0, true);
+		}
+		return timer.lap();
+	}
+#endif
+
+	public:
+	void test_launcher_list() {
+#ifdef USE_FREETYPE2
+		Common::install_null_g_system();
+
+		Common::File file;
+		if (!file.open(Common::FSNode("test/engine-data/FreeSans.ttf")))
+			return;
+		Graphics::Font *font = Graphics::loadTTFFont(file, 14);
+		TS_ASSERT(font);
+		if (!font)
+			return;
+		UncachedFont reference(font);
+
+		const uint games = 10000;
+		Common::Array<Common::U32String> names;
+		for (uint i = 0; i < games; ++i)
+			names.push_back(Common::U32String(Common::String::format("Adventure Game %u: The Return of the Tentacle (CD/DOS/English)", i)));
+
+		const uint32 uncached = benchmark(&reference, names);
+		debugBenchmark(Common::String::format("%u launcher rows", games), uncached, benchmark(font, names));
+
+		delete font;
+#endif
+	}
+};
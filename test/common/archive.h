@@ -0,0 +1,192 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+
+class SearchSetTestSuite : public CxxTest::TestSuite
+{
+	/** Archive with a fixed list of members, each containing the archive id */
+	class TestArchive : public Common::Archive {
+	public:
+		TestArchive(byte id, const char *names, bool indexable) : _id(id), _indexable(indexable), _lookups(0), _listings(0) {
+			Common::String list(names);
+			uint start = 0;
+			for (uint i = 0; i <= list.size(); ++i) {
+				if (i == list.size() || list[i] == ' ') {
+					_names.push_back(Common::String(list.c_str() + start, i - start));
+					start = i + 1;
+				}
+			}
+		}
+
+		virtual bool hasFile(const Common::String &name) const {
+			++_lookups;
+			for (uint i = 0; i < _names.size(); ++i) {
+				if (_names[i].equalsIgnoreCase(name))
+					return true;
+			}
+			return false;
+		}
+
+		virtual int listMembers(Common::ArchiveMemberList &list) const {
+			for (uint i = 0; i < _names.size(); ++i)
+				list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_names[i], this)));
+			return _names.size();
+		}
+
+		virtual const Common::ArchiveMemberPtr getMember(const Common::String &name) const {
+			return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(name, this));
+		}
+
+		virtual Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const {
+			if (!hasFile(name))
+				return nullptr;
+			return new Common::MemoryReadStream(&_id, 1);
+		}
+
+		virtual bool getMemberNames(Common::StringArray &names) const {
+			++_listings;
+			if (!_indexable)
+				return false;
+			names.push_back(_names);
+			return true;
+		}
+
+		byte _id;
+		bool _indexable;
+		Common::StringArray _names;
+		mutable uint _lookups;
+		mutable uint _listings;
+	};
+
+	static int openedFrom(const Common::SearchSet &searchSet, const char *name) {
+		Common::SeekableReadStream *stream = searchSet.createReadStreamForMember(name);
+		if (!stream)
+			return -1;
+		const int id = stream->readByte();
+		delete stream;
+		return id;
+	}
+
+	public:
+	void test_priority_order() {
+		Common::SearchSet searchSet;
+		searchSet.setIndexEnabled(true);
+		searchSet.add("one", new TestArchive(1, "a.dat b.dat", true), 0);
+		searchSet.add("two", new TestArchive(2, "A.DAT c.dat", false), 10);
+		searchSet.add("three", new TestArchive(3, "b.dat c.dat d.dat", true), 5);
+
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), 2);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "B.dat"), 3);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "c.dat"), 2);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "d.dat"), 3);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "e.dat"), -1);
+		TS_ASSERT(searchSet.hasFile("D.DAT"));
+		TS_ASSERT(!searchSet.hasFile("e.dat"));
+
+		Common::ArchiveMemberList list;
+		TS_ASSERT_EQUALS(searchSet.listMatchingMembers(list, "b.dat"), 2);
+		TS_ASSERT_EQUALS(searchSet.listMatchingMembers(list, "*.dat"), 7);
+
+		// The index only holds the names of the archives a lookup reached
+		TS_ASSERT_EQUALS(searchSet.getIndexedArchives(), 2u);
+		TS_ASSERT_EQUALS(searchSet.getIndexLookups(), 8u);
+		TS_ASSERT_EQUALS(searchSet.getIndexHits(), 4u);
+	}
+
+	void test_skip_archives() {
+		Common::SearchSet searchSet;
+		searchSet.setIndexEnabled(true);
+		TestArchive *one = new TestArchive(1, "a.dat", true);
+		TestArchive *two = new TestArchive(2, "b.dat", true);
+		searchSet.add("one", one);
+		searchSet.add("two", two);
+
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "b.dat"), 2);
+		TS_ASSERT(!searchSet.hasFile("c.dat"));
+		TS_ASSERT_EQUALS(one->_lookups, 0u);
+		TS_ASSERT_EQUALS(two->_lookups, 1u);
+	}
+
+	void test_incremental_update() {
+		Common::SearchSet searchSet;
+		searchSet.setIndexEnabled(true);
+		searchSet.add("one", new TestArchive(1, "a.dat b.dat", true), 0);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), 1);
+
+		searchSet.add("two", new TestArchive(2, "a.dat", true), 5);
+		searchSet.add("three", new TestArchive(3, "b.dat", false), 5);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), 2);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "b.dat"), 3);
+
+		searchSet.setPriority("one", 10);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), 1);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "b.dat"), 1);
+
+		searchSet.remove("one");
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), 2);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "b.dat"), 3);
+
+		searchSet.remove("three");
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "b.dat"), -1);
+
+		// "one" is indexed again after its priority changed
+		TS_ASSERT_EQUALS(searchSet.getIndexedArchives(), 3u);
+
+		searchSet.clear();
+		TS_ASSERT(!searchSet.hasFile("a.dat"));
+		TS_ASSERT_EQUALS(searchSet.getIndexedArchives(), 3u);
+	}
+
+	void test_remove_changed_archive() {
+		Common::SearchSet searchSet;
+		searchSet.setIndexEnabled(true);
+		TestArchive *one = new TestArchive(1, "a.dat b.dat", true);
+		searchSet.add("one", one, 10);
+		searchSet.add("two", new TestArchive(2, "b.dat", true), 0);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), 1);
+
+		// The archive is removed from the entries of its old members too
+		one->_names.clear();
+		searchSet.remove("one");
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), -1);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "b.dat"), 2);
+		TS_ASSERT_EQUALS(searchSet.getIndexedArchives(), 2u);
+	}
+
+	void test_lazy_index() {
+		Common::SearchSet searchSet;
+		searchSet.setIndexEnabled(true);
+		TestArchive *one = new TestArchive(1, "a.dat", true);
+		TestArchive *two = new TestArchive(2, "b.dat", true);
+		TestArchive *three = new TestArchive(3, "c.dat", true);
+		searchSet.add("one", one, 10);
+		searchSet.add("two", two, 5);
+		searchSet.add("three", three, 0);
+
+		// The archives after the one containing the name are not listed
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), 1);
+		TS_ASSERT_EQUALS(one->_listings, 1u);
+		TS_ASSERT_EQUALS(two->_listings, 0u);
+		TS_ASSERT_EQUALS(three->_listings, 0u);
+
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "b.dat"), 2);
+		TS_ASSERT_EQUALS(three->_listings, 0u);
+		TS_ASSERT_EQUALS(searchSet.getIndexedArchives(), 2u);
+
+		// Each archive is only listed once
+		TS_ASSERT(!searchSet.hasFile("d.dat"));
+		TS_ASSERT(!searchSet.hasFile("d.dat"));
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "c.dat"), 3);
+		TS_ASSERT_EQUALS(one->_listings + two->_listings + three->_listings, 3u);
+		TS_ASSERT_EQUALS(one->_lookups + two->_lookups, 2u);
+	}
+
+	void test_index_disabled() {
+		Common::SearchSet searchSet;
+		searchSet.add("one", new TestArchive(1, "a.dat", true), 0);
+		searchSet.add("two", new TestArchive(2, "a.dat", false), 5);
+		TS_ASSERT_EQUALS(openedFrom(searchSet, "a.dat"), 2);
+		TS_ASSERT_EQUALS(searchSet.getIndexLookups(), 0u);
+	}
+};
@@ -0,0 +1,172 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flat-hashmap.h"
+#include "common/hash-str.h"
+
+#include "../test_random.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	typedef Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FlatStringMap;
+
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		FlatStringMap container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear(true);
+		TS_ASSERT(container2.empty());
+		TS_ASSERT(!container2.contains("foo"));
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+
+		FlatStringMap container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(container2.contains("foo"));
+		TS_ASSERT(container2.contains("QUUX"));
+		TS_ASSERT(!container2.contains("bar"));
+		TS_ASSERT(!container2.contains("asdf"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		container.erase(1);
+		container.erase(2);
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[4] = 96;
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17, -10), -10);
+
+		int val = 0;
+		TS_ASSERT(containerRef.tryGetVal(4, val));
+		TS_ASSERT_EQUALS(val, 96);
+		TS_ASSERT(!containerRef.tryGetVal(5, val));
+	}
+
+	void test_hash_map_copy() {
+		FlatStringMap map1, container2;
+		for (int i = 0; i < 100; ++i)
+			map1[Common::String::format("key%d", i)] = Common::String::format("value%d", i);
+		map1.erase("key50");
+
+		container2 = map1;
+		FlatStringMap container3(map1);
+		map1.clear();
+
+		TS_ASSERT_EQUALS(container2.size(), 99u);
+		TS_ASSERT_EQUALS(container3.size(), 99u);
+		TS_ASSERT(!container2.contains("key50"));
+		TS_ASSERT_EQUALS(container2["key23"], "value23");
+		TS_ASSERT_EQUALS(container3["KEY99"], "value99");
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5; ++i)
+			container[i] = i * 10;
+		container.erase(1);
+		container[1] = 42;
+		container.erase(0);
+		container.erase(1);
+
+		int found = 0;
+		Common::FlatHashMap<int, int>::iterator i;
+		for (i = container.begin(); i != container.end(); ++i) {
+			int key = i->_key;
+			TS_ASSERT(key >= 0 && key <= 4);
+			TS_ASSERT(!(found & (1 << key)));
+			TS_ASSERT_EQUALS(i->_value, key * 10);
+			found |= 1 << key;
+		}
+		TS_ASSERT(found == 16+8+4);
+
+		found = 0;
+		const Common::FlatHashMap<int, int> &containerRef = container;
+		Common::FlatHashMap<int, int>::const_iterator j;
+		for (j = containerRef.begin(); j != containerRef.end(); ++j)
+			found |= 1 << j->_key;
+		TS_ASSERT(found == 16+8+4);
+	}
+
+	void test_against_hashmap() {
+		// Random inserts and erases, including long runs of erases to
+		// exercise the cleanup of erased slots, checked against HashMap
+		Common::HashMap<uint, uint> reference;
+		Common::FlatHashMap<uint, uint> container;
+		uint32 seed = 1;
+
+		for (int i = 0; i < 200000; ++i) {
+			const uint32 r = nextTestRandom(seed);
+			const uint key = r % ((i / 20000 + 1) * 1000);
+			if ((r >> 20) % 3 == 0 || (i / 10000) % 4 == 3) {
+				reference.erase(key);
+				container.erase(key);
+			} else {
+				reference[key] = i;
+				container[key] = i;
+			}
+		}
+
+		TS_ASSERT_EQUALS(container.size(), reference.size());
+
+		uint count = 0;
+		for (Common::FlatHashMap<uint, uint>::const_iterator i = container.begin(); i != container.end(); ++i) {
+			TS_ASSERT(reference.contains(i->_key));
+			TS_ASSERT_EQUALS(reference[i->_key], i->_value);
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, reference.size());
+
+		for (uint key = 0; key < 11000; ++key)
+			TS_ASSERT_EQUALS(container.contains(key), reference.contains(key));
+	}
+
+	void test_aligned_keys() {
+		// Keys like aligned offsets have their low bits always zero
+		Common::FlatHashMap<uint, int> container;
+		for (int i = 0; i < 256; ++i)
+			container[i * 4096] = i;
+		TS_ASSERT_EQUALS(container.size(), 256u);
+		for (int i = 0; i < 256; ++i)
+			TS_ASSERT_EQUALS(container[i * 4096], i);
+	}
+};
@@ -5,6 +5,19 @@
 
 class HashMapTestSuite : public CxxTest::TestSuite
 {
+	/** Hash which counts its calls, and gives many keys the same hash */
+	struct CountingHash {
+		static uint &calls() {
+			static uint count = 0;
+			return count;
+		}
+
+		uint operator()(int x) const {
+			calls()++;
+			return x / 4;
+		}
+	};
+
 	public:
 	void test_empty_clear() {
 		Common::HashMap<int, int> container;
@@ -230,5 +243,29 @@ class HashMapTestSuite : public CxxTest::TestSuite
 		TS_ASSERT(found == 16+8+4);
 }
 
+	void test_stored_hashes() {
+		// The keys are only hashed once when inserted, even though the
+		// storage grows several times
+		Common::HashMap<int, int, CountingHash> h;
+		CountingHash::calls() = 0;
+		for (int i = 0; i < 1000; ++i)
+			h[i] = i * 2;
+		TS_ASSERT_EQUALS(CountingHash::calls(), 1000u);
+
+		// Keys with the same hash are still told apart
+		bool found = true;
+		for (int i = 0; i < 1000; ++i)
+			found = found && h.contains(i) && h[i] == i * 2;
+		TS_ASSERT(found);
+		TS_ASSERT(!h.contains(1000));
+
+		Common::HashMap<int, int, CountingHash> copy(h);
+		for (int i = 0; i < 1000; i += 2)
+			copy.erase(i);
+		copy[2000] = 1;
+		TS_ASSERT_EQUALS(copy.size(), 501u);
+		TS_ASSERT(copy.contains(999) && !copy.contains(998) && copy.contains(2000));
+	}
+
 	// TODO: Add test cases for iterators, find, ...
 };
@@ -0,0 +1,91 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/lru-cache.h"
+#include "common/hash-str.h"
+
+class LRUCacheTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_find_insert() {
+		Common::LRUCache<Common::String, int> cache(3);
+		TS_ASSERT(!cache.find("one"));
+
+		TS_ASSERT_EQUALS(cache.insert("one", 1), 1);
+		cache.insert("two", 2);
+		TS_ASSERT_EQUALS(cache.size(), 2u);
+		TS_ASSERT(cache.find("one"));
+		TS_ASSERT_EQUALS(*cache.find("two"), 2);
+
+		// Replacing a value does not add an entry
+		cache.insert("two", 22);
+		TS_ASSERT_EQUALS(cache.size(), 2u);
+		TS_ASSERT_EQUALS(*cache.find("two"), 22);
+
+		TS_ASSERT_EQUALS(cache.getHits(), 3u);
+		TS_ASSERT_EQUALS(cache.getMisses(), 1u);
+		cache.resetStatistics();
+		TS_ASSERT_EQUALS(cache.getHits(), 0u);
+	}
+
+	void test_eviction_order() {
+		Common::LRUCache<int, int> cache(3);
+		cache.insert(1, 10);
+		cache.insert(2, 20);
+		cache.insert(3, 30);
+
+		// 1 is now the most recently used, so 2 goes first
+		TS_ASSERT(cache.find(1));
+		cache.insert(4, 40);
+		TS_ASSERT(!cache.contains(2));
+		TS_ASSERT(cache.contains(1));
+		TS_ASSERT(cache.contains(3));
+		TS_ASSERT(cache.contains(4));
+
+		// contains() does not count as a use
+		TS_ASSERT(cache.contains(3));
+		cache.insert(5, 50);
+		TS_ASSERT(!cache.contains(3));
+		TS_ASSERT_EQUALS(cache.size(), 3u);
+	}
+
+	void test_erase_capacity() {
+		Common::LRUCache<int, int> cache(4);
+		for (int i = 0; i < 4; ++i)
+			cache.insert(i, i);
+
+		cache.erase(2);
+		cache.erase(7);
+		TS_ASSERT_EQUALS(cache.size(), 3u);
+		TS_ASSERT(!cache.find(2));
+
+		// The oldest ones are dropped when shrinking
+		cache.setCapacity(2);
+		TS_ASSERT_EQUALS(cache.getCapacity(), 2u);
+		TS_ASSERT_EQUALS(cache.size(), 2u);
+		TS_ASSERT(!cache.contains(0));
+		TS_ASSERT(cache.contains(1));
+		TS_ASSERT(cache.contains(3));
+
+		cache.clear();
+		TS_ASSERT_EQUALS(cache.size(), 0u);
+		cache.insert(8, 8);
+		TS_ASSERT_EQUALS(*cache.find(8), 8);
+	}
+
+	void test_erase_oldest() {
+		Common::LRUCache<int, int> cache(3);
+		TS_ASSERT(!cache.getOldest());
+		cache.eraseOldest();
+
+		cache.insert(1, 10);
+		cache.insert(2, 20);
+		cache.insert(3, 30);
+		TS_ASSERT(cache.find(1));
+		TS_ASSERT_EQUALS(*cache.getOldest(), 20);
+
+		cache.eraseOldest();
+		TS_ASSERT(!cache.contains(2));
+		TS_ASSERT_EQUALS(cache.size(), 2u);
+		TS_ASSERT_EQUALS(*cache.getOldest(), 30);
+	}
+};
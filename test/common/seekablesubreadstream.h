@@ -70,4 +70,14 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_direct_data() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+		Common::SeekableSubReadStream ssrs(&ms, 2, 8);
+
+		TS_ASSERT_EQUALS(ssrs.getDirectData(0, 6), contents + 2);
+		TS_ASSERT_EQUALS(ssrs.getDirectData(3, 2), contents + 5);
+		TS_ASSERT(!ssrs.getDirectData(4, 3));
+	}
 };
@@ -0,0 +1,257 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/bufferedstream.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+#include "common/system.h"
+#include "../null_osystem.h"
+
+class ZipArchiveTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kStoredSize = 100000,
+		kSmallSize = 10000,
+		kLargeSize = 1500000
+	};
+
+	/** Contents with no repetitions, so that they span many deflate blocks */
+	static byte contentAt(uint32 seed, uint32 pos) {
+		uint32 x = pos * 2654435761U + seed;
+		x ^= x >> 13;
+		x *= 0x5bd1e995;
+		x ^= x >> 15;
+		return 'a' + (x & 31);
+	}
+
+	static bool checkContents(Common::SeekableReadStream *stream, uint32 seed, uint32 pos, uint32 len) {
+		byte buffer[8192];
+		if (!stream->seek(pos) || stream->read(buffer, len) != len)
+			return false;
+		for (uint32 i = 0; i < len; ++i) {
+			if (buffer[i] != contentAt(seed, pos + i))
+				return false;
+		}
+		return true;
+	}
+
+#ifdef USE_ZLIB
+	struct Member {
+		const char *name;
+		uint32 seed;
+		uint32 size;
+		bool deflate;
+		uint32 offset;
+		uint32 crc;
+		Common::Array<byte> data;
+	};
+
+	/** Get the raw deflate data and its CRC from the gzip compressed stream */
+	static void deflateMember(Member &member) {
+		Common::MemoryWriteStreamDynamic *output = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(output);
+		for (uint32 i = 0; i < member.size; ++i)
+			gzip->writeByte(contentAt(member.seed, i));
+		gzip->finalize();
+
+		byte *data = output->getData();
+		const uint32 size = output->size();
+		delete gzip;
+
+		// 10 bytes of header, CRC and size as trailer
+		member.data.resize(size - 18);
+		memcpy(member.data.begin(), data + 10, size - 18);
+		member.crc = READ_LE_UINT32(data + size - 8);
+		free(data);
+	}
+
+	/** Make a zip of the members, optionally with the wrong CRCs */
+	static Common::SeekableReadStream *makeZip(Member *members, uint count, bool badCrc = false) {
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+
+		for (uint i = 0; i < count; ++i) {
+			Member &member = members[i];
+			// The CRC of stored members comes from the gzip trailer too
+			deflateMember(member);
+			if (!member.deflate) {
+				member.data.resize(member.size);
+				for (uint32 j = 0; j < member.size; ++j)
+					member.data[j] = contentAt(member.seed, j);
+			}
+
+			member.offset = zip.pos();
+			zip.writeUint32LE(0x04034b50);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(member.deflate ? 8 : 0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(badCrc ? ~member.crc : member.crc);
+			zip.writeUint32LE(member.data.size());
+			zip.writeUint32LE(member.size);
+			zip.writeUint16LE(strlen(member.name));
+			zip.writeUint16LE(0);
+			zip.writeString(member.name);
+			zip.write(member.data.begin(), member.data.size());
+		}
+
+		const uint32 centralDir = zip.pos();
+		for (uint i = 0; i < count; ++i) {
+			const Member &member = members[i];
+			zip.writeUint32LE(0x02014b50);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(member.deflate ? 8 : 0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(badCrc ? ~member.crc : member.crc);
+			zip.writeUint32LE(member.data.size());
+			zip.writeUint32LE(member.size);
+			zip.writeUint16LE(strlen(member.name));
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(member.offset);
+			zip.writeString(member.name);
+		}
+
+		const uint32 centralDirSize = zip.pos() - centralDir;
+		zip.writeUint32LE(0x06054b50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(count);
+		zip.writeUint16LE(count);
+		zip.writeUint32LE(centralDirSize);
+		zip.writeUint32LE(centralDir);
+		zip.writeUint16LE(0);
+
+		return new Common::MemoryReadStream(zip.getData(), zip.size(), DisposeAfterUse::YES);
+	}
+
+	/** Read the whole member in order, and return whether there was an error */
+	static bool readWithError(Common::Archive *archive, const char *name) {
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember(name);
+		if (!stream)
+			return true;
+
+		byte buffer[8192];
+		while (!stream->eos() && !stream->err())
+			stream->read(buffer, sizeof(buffer));
+
+		const bool err = stream->err();
+		delete stream;
+		return err;
+	}
+
+	void checkArchive(Common::Archive *archive, bool direct) {
+		TS_ASSERT(archive->hasFile("STORED.BIN"));
+		TS_ASSERT(!archive->hasFile("missing.txt"));
+		TS_ASSERT(!archive->createReadStreamForMember("missing.txt"));
+
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("stored.bin");
+		TS_ASSERT(stored);
+		TS_ASSERT_EQUALS(stored->size(), kStoredSize);
+		TS_ASSERT(checkContents(stored, 1, 0, 8192));
+		TS_ASSERT(checkContents(stored, 1, kStoredSize - 100, 100));
+		TS_ASSERT_EQUALS(stored->getDirectData(0, kStoredSize) != nullptr, direct);
+
+		Common::SeekableReadStream *small = archive->createReadStreamForMember("small.txt");
+		TS_ASSERT(small);
+		TS_ASSERT_EQUALS(small->size(), kSmallSize);
+		TS_ASSERT(checkContents(small, 2, 0, 8192));
+
+		Common::SeekableReadStream *large = archive->createReadStreamForMember("large.txt");
+		TS_ASSERT(large);
+		TS_ASSERT_EQUALS(large->size(), kLargeSize);
+
+		// Sequential
+		bool ok = true;
+		for (uint32 pos = 0; pos < kLargeSize && ok; pos += 7000)
+			ok = checkContents(large, 3, pos, MIN<uint32>(7000, kLargeSize - pos));
+		TS_ASSERT(ok);
+
+		byte b;
+		TS_ASSERT_EQUALS(large->read(&b, 1), 0u);
+		TS_ASSERT(large->eos());
+
+		// Random and backwards, interleaved with a second stream of the
+		// same member and with the other members
+		Common::SeekableReadStream *large2 = archive->createReadStreamForMember("large.txt");
+		TS_ASSERT(large2);
+		uint32 seed = 1;
+		for (int i = 0; i < 100 && ok; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const uint32 pos = (seed >> 4) % (kLargeSize - 5000);
+			ok = checkContents(large, 3, pos, 5000) &&
+			     checkContents(large2, 3, kLargeSize - 5000 - pos, 5000) &&
+			     checkContents(stored, 1, pos % (kStoredSize - 100), 100);
+		}
+		TS_ASSERT(ok);
+
+		delete large2;
+		delete large;
+		delete small;
+
+		// Member streams may outlive the archive
+		delete archive;
+		TS_ASSERT(checkContents(stored, 1, 1000, 1000));
+		delete stored;
+	}
+#endif
+
+	public:
+	void test_members() {
+#ifdef USE_ZLIB
+		Common::install_null_g_system();
+
+		Member members[] = {
+			{ "stored.bin", 1, kStoredSize, false, 0, 0, Common::Array<byte>() },
+			{ "small.txt", 2, kSmallSize, true, 0, 0, Common::Array<byte>() },
+			{ "large.txt", 3, kLargeSize, true, 0, 0, Common::Array<byte>() }
+		};
+
+		// In memory, where stored members are used in place
+		Common::Archive *archive = Common::makeZipArchive(makeZip(members, ARRAYSIZE(members)));
+		TS_ASSERT(archive);
+		checkArchive(archive, true);
+
+		// Behind a stream which has to be read
+		Common::SeekableReadStream *stream = Common::wrapBufferedSeekableReadStream(makeZip(members, ARRAYSIZE(members)), 4096, DisposeAfterUse::YES);
+		archive = Common::makeZipArchive(stream);
+		TS_ASSERT(archive);
+		checkArchive(archive, false);
+#endif
+	}
+
+	void test_crc() {
+#ifdef USE_ZLIB
+		Common::install_null_g_system();
+
+		Member members[] = {
+			{ "stored.bin", 1, kStoredSize, false, 0, 0, Common::Array<byte>() },
+			{ "large.txt", 3, kLargeSize, true, 0, 0, Common::Array<byte>() }
+		};
+
+		for (int buffered = 0; buffered < 2; ++buffered) {
+			Common::SeekableReadStream *zip = makeZip(members, ARRAYSIZE(members));
+			if (buffered)
+				zip = Common::wrapBufferedSeekableReadStream(zip, 4096, DisposeAfterUse::YES);
+			Common::Archive *archive = Common::makeZipArchive(zip);
+			TS_ASSERT(!readWithError(archive, "stored.bin"));
+			TS_ASSERT(!readWithError(archive, "large.txt"));
+			delete archive;
+
+			zip = makeZip(members, ARRAYSIZE(members), true);
+			if (buffered)
+				zip = Common::wrapBufferedSeekableReadStream(zip, 4096, DisposeAfterUse::YES);
+			archive = Common::makeZipArchive(zip);
+			TS_ASSERT(readWithError(archive, "stored.bin"));
+			TS_ASSERT(readWithError(archive, "large.txt"));
+			delete archive;
+		}
+#endif
+	}
+};
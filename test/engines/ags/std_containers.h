@@ -0,0 +1,169 @@
+#include <cxxtest/TestSuite.h>
+
+#include "engines/ags/lib/std/map.h"
+#include "engines/ags/lib/std/set.h"
+#include "common/hash-str.h"
+
+#include "../../test_random.h"
+
+class AGSStdContainersTestSuite : public CxxTest::TestSuite
+{
+	typedef AGS3::std::map<int, int> IntMap;
+	typedef AGS3::std::set<int> IntSet;
+
+	struct IgnoreCaseLess {
+		bool operator()(const Common::String &x, const Common::String &y) const {
+			return x.compareToIgnoreCase(y) < 0;
+		}
+	};
+
+	static bool isOrdered(const IntMap &map) {
+		size_t count = 0;
+		IntMap::const_iterator prev = map.end();
+		for (IntMap::const_iterator it = map.begin(); it != map.end(); ++it, ++count) {
+			if (prev != map.end() && !(prev->_key < it->_key))
+				return false;
+			prev = it;
+		}
+		return count == map.size();
+	}
+
+	public:
+	void test_map_order() {
+		IntMap map;
+		TS_ASSERT(map.empty());
+		TS_ASSERT(map.begin() == map.end());
+
+		// Random keys with repetitions, checked against a plain array
+		int values[1000];
+		for (int i = 0; i < 1000; ++i)
+			values[i] = -1;
+
+		uint32 seed = 1;
+		for (int i = 0; i < 5000; ++i) {
+			const int key = nextTestRandom(seed) % 1000;
+			map[key] = i;
+			values[key] = i;
+		}
+
+		size_t expected = 0;
+		for (int i = 0; i < 1000; ++i) {
+			if (values[i] == -1) {
+				TS_ASSERT(map.find(i) == map.end());
+				TS_ASSERT_EQUALS(map.count(i), 0u);
+			} else {
+				TS_ASSERT_EQUALS(map.find(i)->_value, values[i]);
+				TS_ASSERT_EQUALS(map.count(i), 1u);
+				++expected;
+			}
+		}
+		TS_ASSERT_EQUALS(map.size(), expected);
+		TS_ASSERT(isOrdered(map));
+
+		// Erase in random order, until the map is empty
+		for (int i = 0; i < 5000; ++i) {
+			const int key = nextTestRandom(seed) % 1000;
+			TS_ASSERT_EQUALS(map.erase(key), values[key] == -1 ? 0u : 1u);
+			values[key] = -1;
+		}
+		TS_ASSERT(isOrdered(map));
+		for (int i = 0; i < 1000; ++i)
+			map.erase(i);
+		TS_ASSERT(map.empty());
+		TS_ASSERT(map.begin() == map.end());
+	}
+
+	void test_map_iterators() {
+		IntMap map;
+		for (int i = 0; i < 100; ++i)
+			map[i * 2] = i;
+
+		TS_ASSERT_EQUALS(map.lower_bound(10)->_key, 10);
+		TS_ASSERT_EQUALS(map.lower_bound(11)->_key, 12);
+		TS_ASSERT_EQUALS(map.upper_bound(10)->_key, 12);
+		TS_ASSERT(map.lower_bound(199) == map.end());
+
+		IntMap::iterator last = map.end();
+		--last;
+		TS_ASSERT_EQUALS(last->_key, 198);
+
+		// Iterators to the other elements stay valid while erasing
+		IntMap::iterator kept = map.find(100);
+		for (IntMap::iterator it = map.begin(); it != map.end();) {
+			if (it->_key % 4 == 0 && it != kept)
+				it = map.erase(it);
+			else
+				++it;
+		}
+		TS_ASSERT_EQUALS(map.size(), 51u);
+		TS_ASSERT_EQUALS(kept->_key, 100);
+		TS_ASSERT_EQUALS(kept->_value, 50);
+		kept->_value = 7;
+		TS_ASSERT_EQUALS(map[100], 7);
+		TS_ASSERT(isOrdered(map));
+
+		// Insertion doesn't replace existing values
+		TS_ASSERT(!map.insert(AGS3::std::pair<int, int>(100, 9)).second);
+		TS_ASSERT(map.insert(AGS3::std::pair<int, int>(101, 9)).second);
+		TS_ASSERT_EQUALS(map[100], 7);
+		TS_ASSERT_EQUALS(map[101], 9);
+	}
+
+	void test_map_copy() {
+		AGS3::std::map<Common::String, IntMap> tree;
+		tree["a"][1] = 2;
+		tree["b"][3] = 4;
+
+		AGS3::std::map<Common::String, IntMap> copy(tree);
+		tree["a"][1] = 5;
+		tree.erase("b");
+		TS_ASSERT_EQUALS(copy.size(), 2u);
+		TS_ASSERT_EQUALS(copy["a"][1], 2);
+		TS_ASSERT_EQUALS(copy["b"][3], 4);
+
+		copy = tree;
+		TS_ASSERT_EQUALS(copy.size(), 1u);
+		TS_ASSERT_EQUALS(copy["a"][1], 5);
+	}
+
+	void test_map_comparator() {
+		// Keys are equivalent when neither is less than the other
+		AGS3::std::map<Common::String, int, IgnoreCaseLess> map;
+		map["Hello"] = 1;
+		map["HELLO"] = 2;
+		map["world"] = 3;
+		TS_ASSERT_EQUALS(map.size(), 2u);
+		TS_ASSERT_EQUALS(map.find("hello")->_value, 2);
+		TS_ASSERT_EQUALS(map.find("hello")->_key, "Hello");
+		TS_ASSERT_EQUALS(map.count("WORLD"), 1u);
+		TS_ASSERT_EQUALS(map.erase("WoRlD"), 1u);
+		TS_ASSERT_EQUALS(map.size(), 1u);
+	}
+
+	void test_set() {
+		IntSet set;
+		TS_ASSERT(set.insert(5).second);
+		TS_ASSERT(set.insert(1).second);
+		TS_ASSERT(set.insert(3).second);
+		TS_ASSERT(!set.insert(3).second);
+		TS_ASSERT_EQUALS(*set.insert(3).first, 3);
+		TS_ASSERT_EQUALS(set.size(), 3u);
+
+		IntSet::const_iterator it = set.begin();
+		TS_ASSERT_EQUALS(*it++, 1);
+		TS_ASSERT_EQUALS(*it++, 3);
+		TS_ASSERT_EQUALS(*it++, 5);
+		TS_ASSERT(it == set.end());
+
+		TS_ASSERT_EQUALS(set.count(3), 1u);
+		TS_ASSERT_EQUALS(*set.erase(set.find(3)), 5);
+		TS_ASSERT_EQUALS(set.count(3), 0u);
+
+		IntSet copy;
+		copy = set;
+		set.clear();
+		TS_ASSERT(set.empty());
+		TS_ASSERT_EQUALS(copy.size(), 2u);
+		TS_ASSERT_EQUALS(*copy.begin(), 1);
+	}
+};
@@ -0,0 +1,115 @@
+#include <cxxtest/TestSuite.h>
+#include "engines/wintermute/base/gfx/osystem/dirty_region.h"
+
+#include "../../test_random.h"
+
+/**
+ * Test suite for the DirtyRegion of the OSystem renderer
+ */
+class DirtyRegionTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 800,
+		kHeight = 600
+	};
+
+	static bool isDisjoint(const Wintermute::DirtyRegion &region) {
+		const Common::Array<Common::Rect> &rects = region.getRects();
+		for (uint i = 0; i < rects.size(); ++i) {
+			for (uint j = i + 1; j < rects.size(); ++j) {
+				if (rects[i].intersects(rects[j]))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	static bool covers(const Wintermute::DirtyRegion &region, const Common::Rect &rect) {
+		for (int y = rect.top; y < rect.bottom; ++y) {
+			for (int x = rect.left; x < rect.right; ++x) {
+				bool found = false;
+				for (uint i = 0; i < region.getRects().size() && !found; ++i)
+					found = region.getRects()[i].contains(x, y);
+				if (!found)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	public:
+	void test_separate_corners() {
+		Wintermute::DirtyRegion region;
+		TS_ASSERT(region.isEmpty());
+
+		region.addRect(Common::Rect(10, 10, 42, 42));
+		region.addRect(Common::Rect(700, 500, 732, 532));
+		TS_ASSERT_EQUALS(region.getRects().size(), 2u);
+		TS_ASSERT_EQUALS(region.getArea(), 2u * 32 * 32);
+		TS_ASSERT_EQUALS(region.getBounds(), Common::Rect(10, 10, 732, 532));
+		TS_ASSERT(!region.intersects(Common::Rect(100, 100, 600, 400)));
+		TS_ASSERT(region.intersects(Common::Rect(0, 0, 11, 11)));
+
+		region.clear();
+		TS_ASSERT(region.isEmpty());
+		TS_ASSERT_EQUALS(region.getArea(), 0u);
+	}
+
+	void test_merge() {
+		Wintermute::DirtyRegion region;
+
+		// Empty rects are ignored
+		region.addRect(Common::Rect(50, 50, 50, 80));
+		TS_ASSERT(region.isEmpty());
+
+		// Overlapping
+		region.addRect(Common::Rect(0, 0, 100, 100));
+		region.addRect(Common::Rect(50, 50, 150, 150));
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 150, 150));
+
+		// Contained
+		region.addRect(Common::Rect(10, 10, 20, 20));
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+
+		// Adjacent
+		region.addRect(Common::Rect(150, 0, 300, 150));
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 300, 150));
+
+		// Merging two rects can make them overlap a third one
+		region.clear();
+		region.addRect(Common::Rect(0, 0, 100, 10));
+		region.addRect(Common::Rect(0, 300, 100, 310));
+		region.addRect(Common::Rect(40, 100, 60, 200));
+		TS_ASSERT_EQUALS(region.getRects().size(), 3u);
+		region.addRect(Common::Rect(0, 10, 100, 300));
+		TS_ASSERT_EQUALS(region.getRects().size(), 1u);
+		TS_ASSERT_EQUALS(region.getRects()[0], Common::Rect(0, 0, 100, 310));
+	}
+
+	void test_random() {
+		uint32 seed = 1;
+		for (int maxRects = 1; maxRects <= 16; maxRects *= 4) {
+			Wintermute::DirtyRegion region(maxRects);
+			Common::Array<Common::Rect> added;
+
+			for (int i = 0; i < 200; ++i) {
+				const int x = nextTestRandom(seed) % kWidth, y = nextTestRandom(seed) % kHeight;
+				const int w = nextTestRandom(seed) % 60, h = nextTestRandom(seed) % 60;
+				const Common::Rect rect(x, y, MIN(x + w, (int)kWidth), MIN(y + h, (int)kHeight));
+				region.addRect(rect);
+				if (!rect.isEmpty())
+					added.push_back(rect);
+
+				TS_ASSERT_LESS_THAN_EQUALS(region.getRects().size(), (uint)maxRects);
+				TS_ASSERT(isDisjoint(region));
+			}
+
+			bool covered = true;
+			for (uint i = 0; i < added.size(); ++i)
+				covered = covered && covers(region, added[i]);
+			TS_ASSERT(covered);
+			TS_ASSERT_LESS_THAN_EQUALS(region.getArea(), (uint32)kWidth * kHeight);
+		}
+	}
+};
@@ -0,0 +1,180 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/managed_surface.h"
+#include "graphics/managed_surface_intern.h"
+
+#include "../test_random.h"
+
+class ManagedSurfaceTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kWidth = 67,
+		kHeight = 45
+	};
+
+	static uint32 getPixel(const Graphics::ManagedSurface &surf, int x, int y) {
+		const byte *pixel = (const byte *)surf.getBasePtr(x, y);
+		if (surf.format.bytesPerPixel == 1)
+			return *pixel;
+		else if (surf.format.bytesPerPixel == 2)
+			return *(const uint16 *)pixel;
+		return *(const uint32 *)pixel;
+	}
+
+	static Graphics::PixelFormat getFormat(int index) {
+		switch (index) {
+		case 0:
+			return Graphics::PixelFormat::createFormatCLUT8();
+		case 1:
+			return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		case 2:
+			return Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15);
+		case 3:
+			return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		default:
+			// The unused bits can't be copied as they are
+			return Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0);
+		}
+	}
+
+	/** Random pixels, with many fully transparent and opaque ones */
+	static void fill(Graphics::ManagedSurface &surf, uint32 seed) {
+		const Graphics::PixelFormat &format = surf.format;
+		for (int y = 0; y < surf.h; ++y) {
+			byte *pixels = (byte *)surf.getBasePtr(0, y);
+			for (int x = 0; x < surf.w; ++x) {
+				uint32 value = nextTestRandom(seed) ^ (nextTestRandom(seed) << 16);
+				if (format.aBits()) {
+					const uint32 alphaBits = ((1 << format.aBits()) - 1) << format.aShift;
+					const uint32 kind = nextTestRandom(seed) % 3;
+					value = kind == 0 ? (value & ~alphaBits) : (kind == 1 ? (value | alphaBits) : value);
+				}
+				if (format.bytesPerPixel == 1)
+					pixels[x] = value;
+				else if (format.bytesPerPixel == 2)
+					((uint16 *)pixels)[x] = value;
+				else
+					((uint32 *)pixels)[x] = value;
+			}
+		}
+
+		if (format.bytesPerPixel == 1) {
+			uint32 palette[256];
+			for (int i = 0; i < 256; ++i) {
+				const uint32 kind = nextTestRandom(seed) % 4;
+				palette[i] = (nextTestRandom(seed) & 0xffffff) | ((kind == 0 ? 0 : (kind == 1 ? nextTestRandom(seed) & 0xff : 0xff)) << 24);
+			}
+			surf.setPalette(palette, 0, 256);
+		}
+	}
+
+	/** Blit the same way with and without the specialised kernels, and compare */
+	template<class BlitFunc>
+	static bool compare(int srcFormat, int destFormat, BlitFunc blit) {
+		Graphics::ManagedSurface src(kWidth, kHeight, getFormat(srcFormat));
+		fill(src, srcFormat * 7 + 1);
+
+		Graphics::ManagedSurface expected(kWidth + 10, kHeight + 10, getFormat(destFormat));
+		Graphics::ManagedSurface result(kWidth + 10, kHeight + 10, getFormat(destFormat));
+		fill(expected, destFormat * 13 + 2);
+		fill(result, destFormat * 13 + 2);
+		expected.clearPalette();
+		result.clearPalette();
+
+		Graphics::setBlitKernels(false);
+		blit(src, expected);
+		Graphics::setBlitKernels(true);
+		blit(src, result);
+
+		for (int y = 0; y < expected.h; ++y) {
+			for (int x = 0; x < expected.w; ++x) {
+				if (!isSameBlend(expected.format, getPixel(expected, x, y), getPixel(result, x, y)))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * The kernels blend in integers, where the double arithmetic of the
+	 * generic code can round a component down by one
+	 */
+	static bool isSameBlend(const Graphics::PixelFormat &format, uint32 expected, uint32 result) {
+		if (expected == result)
+			return true;
+		if (format.bytesPerPixel == 1)
+			return false;
+
+		const byte bits[4] = { format.aBits(), format.rBits(), format.gBits(), format.bBits() };
+		const byte shifts[4] = { format.aShift, format.rShift, format.gShift, format.bShift };
+		uint32 componentBits = 0;
+		for (int i = 0; i < 4; ++i) {
+			const uint32 mask = (1 << bits[i]) - 1;
+			const uint32 e = (expected >> shifts[i]) & mask, r = (result >> shifts[i]) & mask;
+			if (r != e && r != e + 1)
+				return false;
+			componentBits |= mask << shifts[i];
+		}
+		return ((expected ^ result) & ~componentBits) == 0;
+	}
+
+	static bool isSupported(int srcFormat, int destFormat) {
+		// Paletted surfaces can only be drawn on paletted ones, or converted to true color
+		return destFormat != 0 || srcFormat == 0;
+	}
+
+	struct Blit {
+		Common::Rect _destRect;
+		Blit(const Common::Rect &destRect) : _destRect(destRect) {}
+
+		void operator()(Graphics::ManagedSurface &src, Graphics::ManagedSurface &dest) const {
+			dest.blitFrom(src, Common::Rect(3, 2, kWidth - 4, kHeight - 1), _destRect);
+		}
+	};
+
+	struct TransBlit {
+		Common::Rect _destRect;
+		bool _flipped;
+		uint _srcAlpha;
+		TransBlit(const Common::Rect &destRect, bool flipped, uint srcAlpha) : _destRect(destRect), _flipped(flipped), _srcAlpha(srcAlpha) {}
+
+		void operator()(Graphics::ManagedSurface &src, Graphics::ManagedSurface &dest) const {
+			// Use one of the pixels as key color
+			uint transColor = getPixel(src, 5, 5);
+			dest.transBlitFrom(src, Common::Rect(0, 0, kWidth, kHeight), _destRect, transColor, _flipped, 0, _srcAlpha);
+		}
+	};
+
+	public:
+	void test_blit() {
+		for (int srcFormat = 0; srcFormat < 5; ++srcFormat) {
+			for (int destFormat = 0; destFormat < 5; ++destFormat) {
+				if (!isSupported(srcFormat, destFormat))
+					continue;
+
+				// Unscaled, scaled and clipped against the bottom
+				TS_ASSERT(compare(srcFormat, destFormat, Blit(Common::Rect(4, 5, kWidth - 3, kHeight + 2))));
+				TS_ASSERT(compare(srcFormat, destFormat, Blit(Common::Rect(0, 0, kWidth + 7, kHeight + 10))));
+				TS_ASSERT(compare(srcFormat, destFormat, Blit(Common::Rect(2, 30, 30, 70))));
+
+				// The generic code doesn't clip unscaled paletted rows
+				if (destFormat != 0)
+					TS_ASSERT(compare(srcFormat, destFormat, Blit(Common::Rect(-10, -4, kWidth - 17, kHeight - 7))));
+			}
+		}
+	}
+
+	void test_trans_blit() {
+		for (int srcFormat = 0; srcFormat < 5; ++srcFormat) {
+			for (int destFormat = 0; destFormat < 5; ++destFormat) {
+				if (!isSupported(srcFormat, destFormat))
+					continue;
+
+				TS_ASSERT(compare(srcFormat, destFormat, TransBlit(Common::Rect(4, 5, kWidth + 4, kHeight + 5), false, 0xff)));
+				TS_ASSERT(compare(srcFormat, destFormat, TransBlit(Common::Rect(-5, -3, kWidth - 5, kHeight - 3), true, 0xff)));
+				TS_ASSERT(compare(srcFormat, destFormat, TransBlit(Common::Rect(0, 0, kWidth * 2, kHeight + 30), false, 0xff)));
+				TS_ASSERT(compare(srcFormat, destFormat, TransBlit(Common::Rect(4, 5, kWidth + 4, kHeight + 5), false, 0x80)));
+			}
+		}
+	}
+};
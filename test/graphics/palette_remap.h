@@ -0,0 +1,180 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/managed_surface.h"
+#include "graphics/palette_remap.h"
+
+#include "../test_random.h"
+
+class PaletteRemapTestSuite : public CxxTest::TestSuite
+{
+	/** Random colors, with few distinct greens and some duplicated colors */
+	static void fillPalette(uint32 *palette, uint32 seed) {
+		for (int i = 0; i < 256; ++i) {
+			const uint32 value = nextTestRandom(seed);
+			if (i > 0 && (value & 15) == 0)
+				palette[i] = palette[value % i];
+			else if (value & 16)
+				palette[i] = 0xff000000 | (value & 0xff00ff) | ((value % 5) * 60) << 8;
+			else
+				palette[i] = 0xff000000 | (value & 0xffffff);
+		}
+	}
+
+	/** The search as it was done before, by checking every color */
+	static uint findBestColorReference(const uint32 *palette, byte cr, byte cg, byte cb) {
+		uint bestColor = 0;
+		double min = 0xFFFFFFFF;
+
+		for (uint i = 0; i < 256; ++i) {
+			uint col = palette[i];
+
+			int rmean = ((col & 0xff) + cr) / 2;
+			int r = (col & 0xff) - cr;
+			int g = ((col >> 8) & 0xff) - cg;
+			int b = ((col >> 16) & 0xff) - cb;
+
+			double dist = sqrt((double)((((512 + rmean) * r * r) >> 8) + 4 * g * g + (((767 - rmean) * b * b) >> 8)));
+			if (min > dist) {
+				bestColor = i;
+				min = dist;
+			}
+		}
+
+		return bestColor;
+	}
+
+	static void createRemapReference(const uint32 *srcPalette, const uint32 *dstPalette, byte *map) {
+		for (int i = 0; i < 256; i++) {
+			uint col = srcPalette[i];
+			if (col == dstPalette[i])
+				map[i] = i;
+			else
+				map[i] = findBestColorReference(dstPalette, col & 0xff, (col >> 8) & 0xff, (col >> 16) & 0xff);
+		}
+	}
+
+	public:
+	void test_find_best_color() {
+		uint32 palette[256];
+		fillPalette(palette, 1);
+
+		uint32 seed = 2;
+		bool same = true;
+		for (int i = 0; i < 5000; ++i) {
+			const uint32 value = nextTestRandom(seed);
+			const byte r = value, g = value >> 8, b = value >> 16;
+			same = same && Graphics::findBestColor(palette, r, g, b) == findBestColorReference(palette, r, g, b);
+		}
+		TS_ASSERT(same);
+	}
+
+	void test_remap() {
+		PaletteRemapMan.clear();
+
+		for (uint32 seed = 1; seed < 40; ++seed) {
+			uint32 srcPalette[256], dstPalette[256];
+			fillPalette(srcPalette, seed);
+			fillPalette(dstPalette, seed * 7 + 3);
+			if (seed & 1)
+				memcpy(dstPalette, srcPalette, 100 * sizeof(uint32));
+
+			byte expected[256], result[256];
+			createRemapReference(srcPalette, dstPalette, expected);
+			PaletteRemapMan.getRemap(srcPalette, dstPalette, result);
+			TS_ASSERT_EQUALS(memcmp(expected, result, sizeof(expected)), 0);
+		}
+	}
+
+	void test_identity() {
+		uint32 palette[256], other[256];
+		fillPalette(palette, 5);
+		fillPalette(other, 6);
+
+		byte map[256];
+		TS_ASSERT(PaletteRemapMan.getRemap(palette, palette, map));
+		for (int i = 0; i < 256; ++i)
+			TS_ASSERT_EQUALS(map[i], i);
+		TS_ASSERT(!PaletteRemapMan.getRemap(palette, other, map));
+	}
+
+	void test_cache() {
+		PaletteRemapMan.clear();
+		PaletteRemapMan.setMaxEntries(2);
+
+		uint32 palettes[3][256];
+		for (int i = 0; i < 3; ++i)
+			fillPalette(palettes[i], i + 10);
+
+		byte map[256], expected[256];
+		const uint hits = PaletteRemapMan.getHits();
+		const uint misses = PaletteRemapMan.getMisses();
+
+		PaletteRemapMan.getRemap(palettes[0], palettes[1], map);
+		PaletteRemapMan.getRemap(palettes[1], palettes[0], map);
+		PaletteRemapMan.getRemap(palettes[0], palettes[1], map);
+		TS_ASSERT_EQUALS(PaletteRemapMan.getHits() - hits, 1u);
+		TS_ASSERT_EQUALS(PaletteRemapMan.getMisses() - misses, 2u);
+
+		// The least recently used table is dropped
+		PaletteRemapMan.getRemap(palettes[0], palettes[2], map);
+		PaletteRemapMan.getRemap(palettes[0], palettes[1], map);
+		PaletteRemapMan.getRemap(palettes[1], palettes[0], map);
+		TS_ASSERT_EQUALS(PaletteRemapMan.getHits() - hits, 2u);
+		TS_ASSERT_EQUALS(PaletteRemapMan.getMisses() - misses, 4u);
+
+		createRemapReference(palettes[1], palettes[0], expected);
+		TS_ASSERT_EQUALS(memcmp(expected, map, sizeof(expected)), 0);
+
+		// A changed palette is not mistaken for the cached one
+		palettes[0][200] ^= 0x10;
+		PaletteRemapMan.getRemap(palettes[1], palettes[0], map);
+		TS_ASSERT_EQUALS(PaletteRemapMan.getMisses() - misses, 5u);
+		createRemapReference(palettes[1], palettes[0], expected);
+		TS_ASSERT_EQUALS(memcmp(expected, map, sizeof(expected)), 0);
+
+		PaletteRemapMan.setMaxEntries(16);
+	}
+
+	void test_remap_rgb() {
+		uint32 src[256], dst[256];
+		byte srcRGB[256 * 3], dstRGB[256 * 3];
+		fillPalette(src, 20);
+		fillPalette(dst, 21);
+		for (int i = 0; i < 256; ++i) {
+			srcRGB[i * 3] = src[i] & 0xff;
+			srcRGB[i * 3 + 1] = (src[i] >> 8) & 0xff;
+			srcRGB[i * 3 + 2] = (src[i] >> 16) & 0xff;
+			dstRGB[i * 3] = dst[i] & 0xff;
+			dstRGB[i * 3 + 1] = (dst[i] >> 8) & 0xff;
+			dstRGB[i * 3 + 2] = (dst[i] >> 16) & 0xff;
+		}
+
+		byte expected[256], result[256];
+		createRemapReference(src, dst, expected);
+		PaletteRemapMan.getRemapRGB(srcRGB, dstRGB, result);
+		TS_ASSERT_EQUALS(memcmp(expected, result, sizeof(expected)), 0);
+	}
+
+	void test_trans_blit() {
+		uint32 srcPalette[256], dstPalette[256];
+		fillPalette(srcPalette, 30);
+		fillPalette(dstPalette, 31);
+		byte map[256];
+		createRemapReference(srcPalette, dstPalette, map);
+
+		Graphics::ManagedSurface src(16, 16, Graphics::PixelFormat::createFormatCLUT8());
+		Graphics::ManagedSurface dest(16, 16, Graphics::PixelFormat::createFormatCLUT8());
+		src.setPalette(srcPalette, 0, 256);
+		dest.setPalette(dstPalette, 0, 256);
+		for (int i = 0; i < 256; ++i)
+			*(byte *)src.getBasePtr(i % 16, i / 16) = i;
+		dest.clear(0);
+
+		dest.transBlitFrom(src, 255);
+		bool same = true;
+		for (int i = 0; i < 255; ++i)
+			same = same && *(const byte *)dest.getBasePtr(i % 16, i / 16) == map[i];
+		TS_ASSERT(same);
+		TS_ASSERT_EQUALS(*(const byte *)dest.getBasePtr(15, 15), 0);
+	}
+};
@@ -0,0 +1,94 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+#include "graphics/scaler/intern.h"
+#include "graphics/colormasks.h"
+
+// The assembly versions of the HQ scalers have no SIMD switch
+#if defined(USE_HQ_SCALERS) && !defined(USE_NASM)
+#define TEST_HQX 1
+#else
+#define TEST_HQX 0
+#endif
+
+class ScalerTestSuite : public CxxTest::TestSuite {
+#if TEST_HQX
+	enum {
+		kWidth = 300,
+		kHeight = 40,
+		kSrcPitch = (kWidth + 3) * 2,
+		kDstPitch = kWidth * 3 * 2,
+		kDstSize = kDstPitch * kHeight * 3
+	};
+
+	uint8 _src[kSrcPitch * (kHeight + 3)];
+	uint8 _expected[kDstSize];
+	uint8 _result[kDstSize];
+
+	/**
+	 * Fill the source with runs of similar colors, so that the pixels and
+	 * their neighbours produce all kinds of patterns.
+	 */
+	template<typename ColorMask>
+	void fillSource(uint32 seed) {
+		uint16 *src = (uint16 *)_src;
+		for (int i = 0; i < kSrcPitch / 2 * (kHeight + 3); ++i) {
+			seed = seed * 1103515245 + 12345;
+			const uint rnd = seed >> 16;
+			const uint base = ((i / 7) * 0x9E37) & 0xFFFF;
+			uint color = base;
+			if ((rnd & 3) == 0)
+				color = rnd;
+			else if ((rnd & 3) == 1)
+				color ^= rnd & 0x18E3;
+			src[i] = color & (ColorMask::kRedMask | ColorMask::kGreenMask | ColorMask::kBlueMask);
+		}
+	}
+
+	template<typename ColorMask>
+	void compareWithReference(uint32 bitFormat, ScalerProc *scaler, int scale) {
+		InitScalers(bitFormat);
+
+		for (uint32 seed = 1; seed <= 5; ++seed) {
+			fillSource<ColorMask>(seed);
+
+			memset(_expected, 0, kDstSize);
+			setHQScalersSIMD(false);
+			scaler(_src + kSrcPitch + 2, kSrcPitch, _expected, kDstPitch, kWidth, kHeight);
+
+			memset(_result, 0, kDstSize);
+			setHQScalersSIMD(true);
+			scaler(_src + kSrcPitch + 2, kSrcPitch, _result, kDstPitch, kWidth, kHeight);
+
+			TS_ASSERT_EQUALS(memcmp(_expected, _result, kDstPitch * kHeight * scale), 0);
+		}
+
+		DestroyScalers();
+	}
+#endif
+
+public:
+	void test_hq2x_565() {
+#if TEST_HQX
+		compareWithReference<Graphics::ColorMasks<565> >(565, HQ2x, 2);
+#endif
+	}
+
+	void test_hq2x_555() {
+#if TEST_HQX
+		compareWithReference<Graphics::ColorMasks<555> >(555, HQ2x, 2);
+#endif
+	}
+
+	void test_hq3x_565() {
+#if TEST_HQX
+		compareWithReference<Graphics::ColorMasks<565> >(565, HQ3x, 3);
+#endif
+	}
+
+	void test_hq3x_555() {
+#if TEST_HQX
+		compareWithReference<Graphics::ColorMasks<555> >(555, HQ3x, 3);
+#endif
+	}
+};
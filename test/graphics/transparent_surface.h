@@ -0,0 +1,151 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/transparent_surface.h"
+#include "graphics/transparent_surface_intern.h"
+
+#include "../test_random.h"
+
+class TransparentSurfaceTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kWidth = 37,
+		kHeight = 23
+	};
+
+	/** Random pixels, with many fully transparent and fully opaque ones */
+	static void fill(Graphics::Surface &surface, uint32 seed) {
+		for (int y = 0; y < surface.h; ++y) {
+			uint32 *pixels = (uint32 *)surface.getBasePtr(0, y);
+			for (int x = 0; x < surface.w; ++x) {
+				uint32 value = nextTestRandom(seed) | (nextTestRandom(seed) << 24);
+				if ((value & 0x300) == 0)
+					value &= 0x00ffffff;
+				else if ((value & 0x300) == 0x100)
+					value |= 0xff000000;
+				pixels[x] = value;
+			}
+		}
+	}
+
+	static bool sameSurfaces(const Graphics::Surface &a, const Graphics::Surface &b) {
+		if (a.w != b.w || a.h != b.h || a.format != b.format)
+			return false;
+		for (int y = 0; y < a.h; ++y) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+		return true;
+	}
+
+	/** Blit with and without SIMD, and compare the results */
+	static bool compareBlit(Graphics::AlphaType alphaType, Graphics::TSpriteBlendMode blend, uint color, int flipping, int width) {
+		const Graphics::PixelFormat format = Graphics::TransparentSurface::getSupportedPixelFormat();
+		Graphics::TransparentSurface src;
+		src.create(width, kHeight, format);
+		fill(src, width);
+		src.setAlphaMode(alphaType);
+
+		Graphics::Surface dest[2];
+		for (int simd = 0; simd < 2; ++simd) {
+			dest[simd].create(kWidth + 8, kHeight + 8, format);
+			fill(dest[simd], 7);
+
+			Graphics::setTransparentSurfaceSIMD(simd != 0);
+			src.blit(dest[simd], 3, 2, flipping, nullptr, color, -1, -1, blend);
+		}
+		Graphics::setTransparentSurfaceSIMD(true);
+
+		const bool same = sameSurfaces(dest[0], dest[1]);
+		src.free();
+		dest[0].free();
+		dest[1].free();
+		return same;
+	}
+
+	public:
+	void test_blit_simd() {
+		static const uint colors[] = {
+			TS_ARGB(255, 255, 255, 255), TS_ARGB(128, 255, 255, 255), TS_ARGB(0, 255, 255, 255),
+			TS_ARGB(255, 200, 100, 30), TS_ARGB(77, 10, 255, 140)
+		};
+		static const int flippings[] = {
+			Graphics::FLIP_NONE, Graphics::FLIP_H, Graphics::FLIP_V, Graphics::FLIP_HV
+		};
+
+		for (int alphaType = Graphics::ALPHA_OPAQUE; alphaType <= Graphics::ALPHA_FULL; ++alphaType) {
+			for (int blend = Graphics::BLEND_NORMAL; blend < Graphics::NUM_BLEND_MODES; ++blend) {
+				for (int c = 0; c < ARRAYSIZE(colors); ++c) {
+					for (int f = 0; f < ARRAYSIZE(flippings); ++f) {
+						// Odd widths, so that the remainder of the rows is tested
+						TS_ASSERT(compareBlit((Graphics::AlphaType)alphaType, (Graphics::TSpriteBlendMode)blend, colors[c], flippings[f], kWidth));
+						TS_ASSERT(compareBlit((Graphics::AlphaType)alphaType, (Graphics::TSpriteBlendMode)blend, colors[c], flippings[f], 3));
+					}
+				}
+			}
+		}
+	}
+
+	void test_transform_cache() {
+		Graphics::TransparentSurface src;
+		src.create(kWidth, kHeight, Graphics::TransparentSurface::getSupportedPixelFormat());
+		fill(src, 3);
+
+		const Common::Rect srcRect(2, 3, 30, 20);
+		Graphics::TransparentSurface part;
+		part.copyFrom(src.getSubArea(srcRect));
+
+		Graphics::TransformedSurfaceCache cache;
+		int a = 0, b = 0;
+
+		// Scaling
+		const Graphics::Surface *scaled = cache.scale(&a, src, srcRect, 50, 40, true);
+		Graphics::TransparentSurface *expected = part.scale(50, 40, true);
+		TS_ASSERT(sameSurfaces(*scaled, *expected));
+		expected->free();
+		delete expected;
+		TS_ASSERT_EQUALS(cache.getMisses(), 1u);
+
+		TS_ASSERT_EQUALS(cache.scale(&a, src, srcRect, 50, 40, true), scaled);
+		TS_ASSERT_EQUALS(cache.getHits(), 1u);
+		cache.scale(&a, src, srcRect, 50, 40, false);
+		cache.scale(&b, src, srcRect, 50, 40, true);
+		TS_ASSERT_EQUALS(cache.getMisses(), 3u);
+
+		// Rotation
+		const Graphics::TransformStruct transform(150, 80, 30, 4, 5);
+		const Graphics::Surface *rotated = cache.rotoscale(&a, src, srcRect, transform, false);
+		expected = part.rotoscaleT<Graphics::FILTER_NEAREST>(transform);
+		TS_ASSERT(sameSurfaces(*rotated, *expected));
+		expected->free();
+		delete expected;
+		TS_ASSERT_EQUALS(cache.rotoscale(&a, src, srcRect, transform, false), rotated);
+		TS_ASSERT_EQUALS(cache.getHits(), 2u);
+
+		// The color modulation and blending are applied when drawing
+		Graphics::TransformStruct modulated(transform);
+		modulated._rgbaMod = TS_ARGB(128, 200, 100, 50);
+		modulated._blendMode = Graphics::BLEND_ADDITIVE;
+		modulated._alphaDisable = true;
+		TS_ASSERT_EQUALS(cache.rotoscale(&a, src, srcRect, modulated, false), rotated);
+		TS_ASSERT_EQUALS(cache.getHits(), 3u);
+
+		// Invalidation only drops the copies of the given surface
+		cache.invalidate(&a);
+		cache.scale(&b, src, srcRect, 50, 40, true);
+		TS_ASSERT_EQUALS(cache.getHits(), 4u);
+		cache.scale(&a, src, srcRect, 50, 40, true);
+		TS_ASSERT_EQUALS(cache.getMisses(), 5u);
+
+		// The budget keeps at least the latest copy
+		cache.setMaxBytes(50 * 40 * 4);
+		TS_ASSERT_EQUALS(cache.getBytes(), 50u * 40 * 4);
+		cache.scale(&b, src, srcRect, 100, 80, true);
+		TS_ASSERT_EQUALS(cache.getBytes(), 100u * 80 * 4);
+
+		cache.clear();
+		TS_ASSERT_EQUALS(cache.getBytes(), 0u);
+
+		part.free();
+		src.free();
+	}
+};
@@ -0,0 +1,143 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/font.h"
+#include "graphics/fonts/ttf.h"
+#include "graphics/managed_surface.h"
+#include "graphics/surface.h"
+
+#include "common/file.h"
+#include "common/fs.h"
+
+#include "common/system.h"
+#include "../null_osystem.h"
+
+class TTFFontTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kWidth = 320,
+		kHeight = 40
+	};
+
+	/**
+	 * Font which forwards the per character methods to another one, so that
+	 * strings are laid out and drawn without the caches of the TTF font.
+	 */
+	class UncachedFont : public Graphics::Font {
+	public:
+		UncachedFont(const Graphics::Font *font) : _font(font) {}
+
+		virtual int getFontHeight() const { return _font->getFontHeight(); }
+		virtual int getMaxCharWidth() const { return _font->getMaxCharWidth(); }
+		virtual int getCharWidth(uint32 chr) const { return _font->getCharWidth(chr); }
+		virtual int getKerningOffset(uint32 left, uint32 right) const { return _font->getKerningOffset(left, right); }
+		virtual Common::Rect getBoundingBox(uint32 chr) const { return _font->getBoundingBox(chr); }
+		virtual void drawChar(Graphics::Surface *dst, uint32 chr, int x, int y, uint32 color) const { _font->drawChar(dst, chr, x, y, color); }
+		virtual void drawChar(Graphics::ManagedSurface *dst, uint32 chr, int x, int y, uint32 color) const { _font->drawChar(dst, chr, x, y, color); }
+
+	private:
+		const Graphics::Font *_font;
+	};
+
+#ifdef USE_FREETYPE2
+	static Graphics::Font *loadFont(int size) {
+		Common::File file;
+		if (!file.open(Common::FSNode("test/engine-data/FreeSans.ttf")))
+			return nullptr;
+		return Graphics::loadTTFFont(file, size);
+	}
+
+	static bool drawSame(const Graphics::Font *font, const Graphics::Font *reference, const Common::U32String &str, int w, Graphics::TextAlign align, int deltax, bool useEllipsis) {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		Graphics::Surface expected, result;
+		expected.create(kWidth, kHeight, format);
+		result.create(kWidth, kHeight, format);
+		memset(expected.getPixels(), 0x40, expected.h * expected.pitch);
+		memset(result.getPixels(), 0x40, result.h * result.pitch);
+
+		const uint32 color = format.ARGBToColor(255, 250, 200, 20);
+		reference->drawString(&expected, str, 10, 5, kWidth - 40, color, align, deltax, useEllipsis);
+		font->drawString(&result, str, 10, 5, kWidth - 40, color, align, deltax, useEllipsis);
+		// The second time, from the cache
+		font->drawString(&result, str, 10, 5, kWidth - 40, color, align, deltax, useEllipsis);
+		reference->drawString(&expected, str, 10, 5, kWidth - 40, color, align, deltax, useEllipsis);
+
+		const bool same = !memcmp(expected.getPixels(), result.getPixels(), result.h * result.pitch);
+		expected.free();
+		result.free();
+		return same;
+	}
+#endif
+
+	public:
+	void test_cached_strings() {
+#ifdef USE_FREETYPE2
+		Common::install_null_g_system();
+
+		Graphics::Font *font = loadFont(14);
+		TS_ASSERT(font);
+		if (!font)
+			return;
+		UncachedFont reference(font);
+
+		static const char *const strings[] = {
+			"Beneath a Steel Sky (CD/DOS/English)",
+			"AVATAR Wave To, Yellow",
+			"A string which is too long to fit into the area of the text, and which has to be shortened",
+			"Ends in an ellipsis...",
+			""
+		};
+		static const Graphics::TextAlign aligns[] = { Graphics::kTextAlignLeft, Graphics::kTextAlignCenter, Graphics::kTextAlignRight };
+
+		for (int i = 0; i < ARRAYSIZE(strings); ++i) {
+			const Common::U32String str(strings[i]);
+			TS_ASSERT_EQUALS(font->getStringWidth(str), reference.getStringWidth(str));
+			TS_ASSERT_EQUALS(font->getStringWidth(str), reference.getStringWidth(str));
+
+			for (int j = 0; j < ARRAYSIZE(aligns); ++j) {
+				TS_ASSERT(drawSame(font, &reference, str, 280, aligns[j], 0, true));
+				TS_ASSERT(drawSame(font, &reference, str, 280, aligns[j], -15, false));
+			}
+		}
+
+		delete font;
+#endif
+	}
+
+	void test_late_glyphs() {
+#ifdef USE_FREETYPE2
+		Common::install_null_g_system();
+
+		Graphics::Font *font = loadFont(20);
+		TS_ASSERT(font);
+		if (!font)
+			return;
+		UncachedFont reference(font);
+
+		const Common::U32String latin("Quartz glyph jocks vex dwarf");
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		Graphics::Surface before, after;
+		before.create(kWidth, kHeight, format);
+		after.create(kWidth, kHeight, format);
+		before.fillRect(Common::Rect(kWidth, kHeight), 0);
+		after.fillRect(Common::Rect(kWidth, kHeight), 0);
+		font->drawString(&before, latin, 0, 0, kWidth, 0xFFFFFFFF);
+
+		// Caching Greek and Cyrillic glyphs grows the atlas
+		Common::U32String str;
+		for (uint32 chr = 0x391; chr < 0x3C9; ++chr)
+			str += chr;
+		for (uint32 chr = 0x410; chr < 0x450; ++chr)
+			str += chr;
+		TS_ASSERT_LESS_THAN(0, font->getStringWidth(str));
+		TS_ASSERT(drawSame(font, &reference, Common::U32String(str.c_str() + 10, 20), 280, Graphics::kTextAlignLeft, 0, false));
+		TS_ASSERT(drawSame(font, &reference, Common::U32String(str.c_str() + 70, 20), 280, Graphics::kTextAlignLeft, 0, false));
+
+		font->drawString(&after, latin, 0, 0, kWidth, 0xFFFFFFFF);
+		TS_ASSERT(!memcmp(before.getPixels(), after.getPixels(), after.h * after.pitch));
+
+		before.free();
+		after.free();
+		delete font;
+#endif
+	}
+};
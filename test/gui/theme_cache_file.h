@@ -0,0 +1,95 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "gui/ThemeCacheFile.h"
+
+class ThemeCacheFileTestSuite : public CxxTest::TestSuite {
+	// Save some operations for the given STX file contents
+	static void saveCache(Common::MemoryWriteStreamDynamic &file, const char *stx, const byte *ops, uint32 size) {
+		GUI::ThemeCacheFile cacheFile(640, 480);
+		Common::MemoryReadStream source((const byte *)stx, strlen(stx));
+		cacheFile.addSource("default.stx", source);
+		TS_ASSERT(cacheFile.save(file, ops, size));
+	}
+
+	// Load the operations from the given file for the given STX file contents
+	static Common::SeekableReadStream *loadCache(const byte *data, uint32 size, const char *stx, int16 overlayWidth = 640) {
+		GUI::ThemeCacheFile cacheFile(overlayWidth, 480);
+		Common::MemoryReadStream source((const byte *)stx, strlen(stx));
+		cacheFile.addSource("default.stx", source);
+		TS_ASSERT_EQUALS(source.pos(), 0);
+
+		Common::MemoryReadStream file(data, size);
+		return cacheFile.load(file);
+	}
+
+public:
+	void test_round_trip() {
+		const byte ops[] = { 0, 1, 2, 3, 250, 251, 252, 253, 254, 255 };
+		Common::MemoryWriteStreamDynamic file(DisposeAfterUse::YES);
+		saveCache(file, "<render_info></render_info>", ops, sizeof(ops));
+
+		Common::SeekableReadStream *loaded = loadCache(file.getData(), file.size(), "<render_info></render_info>");
+		TS_ASSERT(loaded);
+		if (!loaded)
+			return;
+
+		TS_ASSERT_EQUALS(loaded->size(), (int64)sizeof(ops));
+		byte data[sizeof(ops)];
+		TS_ASSERT_EQUALS(loaded->read(data, sizeof(data)), sizeof(data));
+		TS_ASSERT(!memcmp(data, ops, sizeof(ops)));
+		delete loaded;
+	}
+
+	void test_strings() {
+		Common::MemoryWriteStreamDynamic stream(DisposeAfterUse::YES);
+		GUI::ThemeCacheFile::writeString(stream, "");
+		GUI::ThemeCacheFile::writeString(stream, "Dialog.Launcher");
+
+		Common::MemoryReadStream read(stream.getData(), stream.size());
+		TS_ASSERT_EQUALS(GUI::ThemeCacheFile::readString(read), "");
+		TS_ASSERT_EQUALS(GUI::ThemeCacheFile::readString(read), "Dialog.Launcher");
+		TS_ASSERT_EQUALS(read.pos(), read.size());
+	}
+
+	void test_source_changed() {
+		const byte ops[] = { 1, 2, 3 };
+		Common::MemoryWriteStreamDynamic file(DisposeAfterUse::YES);
+		saveCache(file, "<render_info></render_info>", ops, sizeof(ops));
+
+		TS_ASSERT(!loadCache(file.getData(), file.size(), "<render_info> </render_info>"));
+		TS_ASSERT(!loadCache(file.getData(), file.size(), "<render_info></render_info>", 320));
+	}
+
+	void test_version_changed() {
+		const byte ops[] = { 1, 2, 3 };
+		Common::MemoryWriteStreamDynamic file(DisposeAfterUse::YES);
+		saveCache(file, "<render_info></render_info>", ops, sizeof(ops));
+
+		// The version follows the 4 bytes of the tag
+		byte *data = file.getData();
+		TS_ASSERT_EQUALS(READ_BE_UINT32(data + 4), (uint32)GUI::ThemeCacheFile::kVersion);
+		WRITE_BE_UINT32(data + 4, GUI::ThemeCacheFile::kVersion + 1);
+		TS_ASSERT(!loadCache(data, file.size(), "<render_info></render_info>"));
+	}
+
+	void test_corrupted() {
+		const byte ops[] = { 1, 2, 3 };
+		Common::MemoryWriteStreamDynamic file(DisposeAfterUse::YES);
+		saveCache(file, "<render_info></render_info>", ops, sizeof(ops));
+
+		// Damaged operations
+		byte *data = file.getData();
+		data[file.size() - 1] ^= 0xff;
+		TS_ASSERT(!loadCache(data, file.size(), "<render_info></render_info>"));
+		data[file.size() - 1] ^= 0xff;
+
+		// Truncated file
+		TS_ASSERT(!loadCache(data, file.size() - 1, "<render_info></render_info>"));
+		TS_ASSERT(!loadCache(data, 6, "<render_info></render_info>"));
+
+		Common::SeekableReadStream *loaded = loadCache(data, file.size(), "<render_info></render_info>");
+		TS_ASSERT(loaded);
+		delete loaded;
+	}
+};
@@ -5,9 +5,15 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/math/*.h
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/math/*.h $(srcdir)/test/graphics/*.h $(srcdir)/test/video/*.h $(srcdir)/test/gui/*.h
 TEST_LIBS    :=
 
+# Benchmarks, which print their timings instead of checking results.
+# Run them with 'make clean-test test BENCHMARK=1'.
+ifdef BENCHMARK
+TESTS        += $(srcdir)/test/benchmark/*.h
+endif
+
 ifdef POSIX
 TEST_LIBS += test/null_osystem.o \
 	backends/fs/posix/posix-fs-factory.o \
@@ -15,7 +21,8 @@ TEST_LIBS += test/null_osystem.o \
 	backends/fs/posix/posix-iostream.o \
 	backends/fs/abstract-fs.o \
 	backends/fs/stdiostream.o \
-	backends/modular-backend.o
+	backends/modular-backend.o \
+	backends/timer/default/default-timer.o
 endif
 
 ifdef WIN32
@@ -24,16 +31,26 @@ TEST_LIBS += test/null_osystem.o \
 	backends/fs/windows/windows-fs.o \
 	backends/fs/abstract-fs.o \
 	backends/fs/stdiostream.o \
-	backends/modular-backend.o
+	backends/modular-backend.o \
+	backends/timer/default/default-timer.o
 endif
 
-TEST_LIBS +=	audio/libaudio.a math/libmath.a common/libcommon.a
+TEST_LIBS +=	gui/ThemeCacheFile.o base/version.o
+
+TEST_LIBS +=	video/libvideo.a audio/libaudio.a graphics/libgraphics.a math/libmath.a common/libcommon.a
 
 ifeq ($(ENABLE_WINTERMUTE), STATIC_PLUGIN)
 	TESTS += $(srcdir)/test/engines/wintermute/*.h
 	TEST_LIBS += engines/wintermute/libwintermute.a
 endif
 
+ifeq ($(ENABLE_AGS), STATIC_PLUGIN)
+	TESTS += $(srcdir)/test/engines/ags/*.h
+ifdef BENCHMARK
+	TESTS += $(srcdir)/test/benchmark/engines/ags/*.h
+endif
+endif
+
 ifeq ($(ENABLE_ULTIMA), STATIC_PLUGIN)
 	TESTS += $(srcdir)/test/engines/ultima/*/*/*.h
 	TEST_LIBS += engines/ultima/libultima.a
@@ -74,11 +91,12 @@ test/runner.cpp: $(TESTS)
 
 clean: clean-test
 clean-test:
-	-$(RM) test/runner.cpp test/runner test/engine-data/encoding.dat
+	-$(RM) test/runner.cpp test/runner test/engine-data/encoding.dat test/engine-data/FreeSans.ttf
 	-rmdir test/engine-data
 
 copy-dat:
 	$(MKDIR) test/engine-data
 	$(CP) $(srcdir)/dists/engine-data/encoding.dat test/engine-data/encoding.dat
+	$(CP) $(srcdir)/gui/themes/fonts/FreeSans.ttf test/engine-data/FreeSans.ttf
 
 .PHONY: test clean-test copy-dat
@@ -4,7 +4,9 @@
 #include "../backends/platform/null/null.cpp" 
 
 void Common::install_null_g_system() {
-	g_system = OSystem_NULL_create();
+	OSystem_NULL *system = new OSystem_NULL();
+	g_system = system;
+	system->initTestBackend();
 }
 
 void BaseBackend::displayMessageOnOSD(const Common::U32String &msg) {
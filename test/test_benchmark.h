@@ -0,0 +1,70 @@
+#ifndef TEST_TEST_BENCHMARK_H
+#define TEST_TEST_BENCHMARK_H
+
+#include "common/debug.h"
+#include "common/system.h"
+#include "graphics/surface.h"
+
+#include "test_random.h"
+
+/**
+ * Helpers shared by the benchmarks in test/benchmark/. They use the
+ * null OSystem, see Common::install_null_g_system().
+ */
+
+/**
+ * Measures the milliseconds spent in the successive steps of a benchmark.
+ */
+class BenchmarkTimer {
+public:
+	BenchmarkTimer() : _start(g_system->getMillis()) {}
+
+	/** Return the time since the construction or the previous call. */
+	uint32 lap() {
+		const uint32 now = g_system->getMillis();
+		const uint32 time = now - _start;
+		_start = now;
+		return time;
+	}
+
+private:
+	uint32 _start;
+};
+
+/**
+ * Print the times taken by the reference implementation and by the one
+ * which is benchmarked against it.
+ */
+inline void debugBenchmark(const Common::String &what, uint32 referenceTime, uint32 time) {
+	debug("%s: %u ms, reference %u ms", what.c_str(), time, referenceTime);
+}
+
+/**
+ * Fill a surface with random pixels. If the format has an alpha channel, a
+ * third of the pixels are fully transparent and another third fully opaque,
+ * so that the special cases for these are taken too.
+ */
+inline void fillBenchmarkSurface(Graphics::Surface &surface, uint32 seed) {
+	const Graphics::PixelFormat &format = surface.format;
+	const uint32 alphaBits = format.aBits() ? ((1 << format.aBits()) - 1) << format.aShift : 0;
+
+	for (int y = 0; y < surface.h; ++y) {
+		byte *pixels = (byte *)surface.getBasePtr(0, y);
+		for (int x = 0; x < surface.w; ++x) {
+			uint32 value = nextTestRandom(seed) ^ (nextTestRandom(seed) << 16);
+			if (alphaBits) {
+				const uint32 kind = nextTestRandom(seed) % 3;
+				value = kind == 0 ? (value & ~alphaBits) : (kind == 1 ? (value | alphaBits) : value);
+			}
+
+			if (format.bytesPerPixel == 1)
+				pixels[x] = value;
+			else if (format.bytesPerPixel == 2)
+				((uint16 *)pixels)[x] = value;
+			else
+				((uint32 *)pixels)[x] = value;
+		}
+	}
+}
+
+#endif
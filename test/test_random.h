@@ -0,0 +1,16 @@
+#ifndef TEST_TEST_RANDOM_H
+#define TEST_TEST_RANDOM_H
+
+#include "common/scummsys.h"
+
+/**
+ * Reproducible pseudo-random numbers for the tests. This is a simple LCG,
+ * since Common::RandomSource requires OSystem and seeds itself from the
+ * clock.
+ */
+inline uint32 nextTestRandom(uint32 &seed) {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+#endif
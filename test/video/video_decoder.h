@@ -0,0 +1,222 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/timer/default/default-timer.h"
+#include "graphics/surface.h"
+#include "video/video_decoder.h"
+
+#include "../null_osystem.h"
+
+/**
+ * A video of CLUT8 frames filled with their number, at 10 frames per
+ * second, with a new palette every 5 frames.
+ */
+class TestVideoDecoder : public Video::VideoDecoder {
+public:
+	enum {
+		kFrameCount = 23
+	};
+
+	TestVideoDecoder() {
+		loadStream(nullptr);
+	}
+
+	~TestVideoDecoder() {
+		close();
+	}
+
+	bool loadStream(Common::SeekableReadStream *stream) {
+		close();
+		addTrack(new TestVideoTrack());
+		return true;
+	}
+
+	// Run the prefetching as the timer proc would, for the given number of ticks
+	void prefetchFrames(uint ticks = 1) {
+		while (ticks--)
+			VideoDecoder::prefetchFrames();
+	}
+
+private:
+	class TestVideoTrack : public FixedRateVideoTrack {
+	public:
+		TestVideoTrack() : _curFrame(-1), _dirtyPalette(false) {
+			_surface.create(8, 6, Graphics::PixelFormat::createFormatCLUT8());
+			memset(_palette, 0, sizeof(_palette));
+		}
+
+		~TestVideoTrack() {
+			_surface.free();
+		}
+
+		bool isSeekable() const { return true; }
+		bool seek(const Audio::Timestamp &time) {
+			_curFrame = (int)getFrameAtTime(time) - 1;
+			return true;
+		}
+
+		uint16 getWidth() const { return _surface.w; }
+		uint16 getHeight() const { return _surface.h; }
+		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
+		int getCurFrame() const { return _curFrame; }
+		int getFrameCount() const { return kFrameCount; }
+
+		const Graphics::Surface *decodeNextFrame() {
+			_curFrame++;
+			memset(_surface.getPixels(), _curFrame, _surface.w * _surface.h);
+
+			if (_curFrame % 5 == 0) {
+				memset(_palette, _curFrame, sizeof(_palette));
+				_dirtyPalette = true;
+			}
+
+			return &_surface;
+		}
+
+		const byte *getPalette() const {
+			_dirtyPalette = false;
+			return _palette;
+		}
+		bool hasDirtyPalette() const { return _dirtyPalette; }
+
+	protected:
+		Common::Rational getFrameRate() const { return 10; }
+
+	private:
+		Graphics::Surface _surface;
+		int _curFrame;
+		byte _palette[256 * 3];
+		mutable bool _dirtyPalette;
+	};
+};
+
+class VideoDecoderTestSuite : public CxxTest::TestSuite {
+	static int getFrameNumber(const Graphics::Surface *frame) {
+		return frame ? *(const byte *)frame->getPixels() : -1;
+	}
+
+	public:
+	void test_prefetch_same_frames() {
+		Common::install_null_g_system();
+
+		TestVideoDecoder direct, prefetched;
+		prefetched.setPrefetchFrames(2);
+		TS_ASSERT_EQUALS(prefetched.getPrefetchFrames(), 2u);
+
+		bool same = true;
+		for (int i = 0; !direct.endOfVideo(); i++) {
+			// Some frames are ready in time, others are late
+			if (i % 4 == 0)
+				prefetched.prefetchFrames(2);
+
+			same = same && prefetched.getCurFrame() == direct.getCurFrame();
+			same = same && !prefetched.endOfVideo();
+			same = same && getFrameNumber(prefetched.decodeNextFrame()) == getFrameNumber(direct.decodeNextFrame());
+			same = same && prefetched.getCurFrame() == direct.getCurFrame();
+			same = same && prefetched.hasDirtyPalette() == direct.hasDirtyPalette();
+			if (direct.hasDirtyPalette())
+				same = same && !memcmp(prefetched.getPalette(), direct.getPalette(), 256 * 3);
+		}
+
+		TS_ASSERT(same);
+		TS_ASSERT(prefetched.endOfVideo());
+		TS_ASSERT_EQUALS(direct.getCurFrame(), (int)TestVideoDecoder::kFrameCount - 1);
+
+		Video::VideoDecoder::PrefetchStats stats = prefetched.getPrefetchStats();
+		TS_ASSERT_EQUALS(stats.prefetchedFrames + stats.lateFrames, (uint32)TestVideoDecoder::kFrameCount);
+		TS_ASSERT_LESS_THAN(0u, stats.lateFrames);
+		TS_ASSERT_EQUALS(stats.maxQueueDepth, 2u);
+		TS_ASSERT_EQUALS(stats.queueDepth, 0u);
+	}
+
+	void test_prefetch_timing() {
+		Common::install_null_g_system();
+
+		TestVideoDecoder decoder;
+		decoder.setPrefetchFrames(3);
+
+		// One frame is decoded per tick
+		decoder.prefetchFrames();
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().queueDepth, 1u);
+		decoder.prefetchFrames(3);
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().queueDepth, 3u);
+
+		// The status is the one of the shown frame, not of the tracks
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), -1);
+		TS_ASSERT_EQUALS(decoder.getTimeToNextFrame(), 0u);
+		TS_ASSERT_EQUALS(getFrameNumber(decoder.decodeNextFrame()), 0);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 0);
+		TS_ASSERT_EQUALS(decoder.getTimeToNextFrame(), 100u);
+
+		decoder.decodeNextFrame();
+		decoder.decodeNextFrame();
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().lateFrames, 0u);
+		TS_ASSERT_EQUALS(getFrameNumber(decoder.decodeNextFrame()), 3);
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().lateFrames, 1u);
+		TS_ASSERT_EQUALS(decoder.getTimeToNextFrame(), 400u);
+
+		// Disabling the prefetching keeps the queued frames
+		decoder.prefetchFrames();
+		decoder.setPrefetchFrames(0);
+		TS_ASSERT_EQUALS(decoder.getPrefetchFrames(), 0u);
+		TS_ASSERT_EQUALS(getFrameNumber(decoder.decodeNextFrame()), 4);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 4);
+		TS_ASSERT_EQUALS(getFrameNumber(decoder.decodeNextFrame()), 5);
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().lateFrames, 1u);
+	}
+
+	void test_prefetch_seek() {
+		Common::install_null_g_system();
+
+		TestVideoDecoder decoder;
+		decoder.setPrefetchFrames(4);
+		decoder.prefetchFrames();
+		decoder.decodeNextFrame();
+
+		// Seeking discards the frames decoded ahead
+		TS_ASSERT(decoder.seekToFrame(7));
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().queueDepth, 0u);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 6);
+		decoder.prefetchFrames();
+		TS_ASSERT_EQUALS(getFrameNumber(decoder.decodeNextFrame()), 7);
+
+		TS_ASSERT(decoder.rewind());
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), -1);
+		TS_ASSERT_EQUALS(getFrameNumber(decoder.decodeNextFrame()), 0);
+
+		// Frames past a new end are dropped
+		decoder.prefetchFrames(4);
+		decoder.setEndFrame(2);
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().queueDepth, 2u);
+		decoder.prefetchFrames();
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().queueDepth, 2u);
+	}
+	void test_prefetch_timer() {
+		Common::install_null_g_system();
+		DefaultTimerManager *timerManager = (DefaultTimerManager *)g_system->getTimerManager();
+
+		TestVideoDecoder decoder;
+		decoder.setPrefetchFrames(3);
+
+		// The null backend has no timer thread, so run the ticks here
+		uint ticks = 0;
+		bool overfilled = false;
+		while (decoder.getPrefetchStats().queueDepth < 3 && ticks < 100) {
+			g_system->delayMillis(11);
+			timerManager->handler();
+			overfilled = overfilled || decoder.getPrefetchStats().queueDepth > 3;
+			ticks++;
+		}
+
+		TS_ASSERT(!overfilled);
+		TS_ASSERT_LESS_THAN_EQUALS(3u, ticks);
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().queueDepth, 3u);
+		TS_ASSERT_EQUALS(getFrameNumber(decoder.decodeNextFrame()), 0);
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().lateFrames, 0u);
+
+		// Once disabled, the timer no longer decodes frames
+		decoder.setPrefetchFrames(0);
+		g_system->delayMillis(11);
+		timerManager->handler();
+		TS_ASSERT_EQUALS(decoder.getPrefetchStats().queueDepth, 2u);
+	}
+};
@@ -27,12 +27,103 @@
 
 #include "common/rational.h"
 #include "common/file.h"
+#include "common/singleton.h"
 #include "common/system.h"
+#include "common/timer.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
+/**
+ * Runs the frame prefetching of the decoders which enabled it, from a timer
+ * proc. All the decoders share one proc, since the timer manager removes the
+ * procs by callback.
+ */
+class FramePrefetcher : public Common::Singleton<FramePrefetcher> {
+public:
+	void addDecoder(VideoDecoder *decoder);
+	void removeDecoder(VideoDecoder *decoder);
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	FramePrefetcher() {}
+
+	static void timerProc(void *refCon);
+
+	Common::Array<VideoDecoder *> _decoders;
+	Common::Mutex _mutex;
+};
+
+} // End of namespace Video
+
+namespace Common {
+DECLARE_SINGLETON(Video::FramePrefetcher);
+}
+
+namespace Video {
+
+// Interval of the prefetching timer proc, in microseconds
+#define FRAME_PREFETCH_INTERVAL 10000
+
+void FramePrefetcher::addDecoder(VideoDecoder *decoder) {
+	bool first;
+	{
+		Common::StackLock lock(_mutex);
+		first = _decoders.empty();
+		_decoders.push_back(decoder);
+	}
+
+	// The timer manager stays locked while the proc runs, and the proc
+	// takes _mutex, so the proc is installed and removed without holding it
+	if (first)
+		g_system->getTimerManager()->installTimerProc(&timerProc, FRAME_PREFETCH_INTERVAL, this, "videoPrefetch");
+}
+
+void FramePrefetcher::removeDecoder(VideoDecoder *decoder) {
+	bool last = false;
+	{
+		Common::StackLock lock(_mutex);
+		for (uint i = 0; i < _decoders.size(); i++) {
+			if (_decoders[i] == decoder) {
+				_decoders.remove_at(i);
+				last = _decoders.empty();
+				break;
+			}
+		}
+	}
+
+	if (last)
+		g_system->getTimerManager()->removeTimerProc(&timerProc);
+}
+
+void FramePrefetcher::timerProc(void *refCon) {
+	FramePrefetcher *prefetcher = (FramePrefetcher *)refCon;
+	Common::StackLock lock(prefetcher->_mutex);
+
+	for (uint i = 0; i < prefetcher->_decoders.size(); i++)
+		prefetcher->_decoders[i]->prefetchFrames();
+}
+
+namespace {
+
+/**
+ * Copy a frame, reusing the pixels of the destination if they have the
+ * right size.
+ */
+void copyFrame(Graphics::Surface &dst, const Graphics::Surface &src) {
+	if (dst.w != src.w || dst.h != src.h || dst.format != src.format) {
+		dst.free();
+		dst.create(src.w, src.h, src.format);
+	}
+
+	for (int y = 0; y < src.h; y++)
+		memcpy(dst.getBasePtr(0, y), src.getBasePtr(0, y), src.w * src.format.bytesPerPixel);
+}
+
+} // End of anonymous namespace
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -49,6 +140,10 @@ VideoDecoder::VideoDecoder() {
 	_nextVideoTrack = 0;
 	_mainAudioTrack = 0;
 	_canSetDither = true;
+	_prefetchLimit = 0;
+	_prefetchEnabled = false;
+	_prefetchSurface = 0;
+	memset(&_prefetchStats, 0, sizeof(_prefetchStats));
 
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
@@ -57,13 +152,26 @@ VideoDecoder::VideoDecoder() {
 		_defaultHighColorFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
 }
 
+VideoDecoder::~VideoDecoder() {
+	// The subclasses must call close(), which stops the prefetching, since
+	// the prefetching decodes their tracks
+	assert(!_prefetchLimit);
+	freePrefetchedFrames();
+}
+
 void VideoDecoder::close() {
+	// Stop the prefetching first, since it decodes the tracks
+	setPrefetchFrames(0);
+
 	if (isPlaying())
 		stop();
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		delete *it;
 
+	freePrefetchedFrames();
+	memset(&_prefetchStats, 0, sizeof(_prefetchStats));
+
 	_tracks.clear();
 	_internalTracks.clear();
 	_externalTracks.clear();
@@ -98,6 +206,8 @@ bool VideoDecoder::needsUpdate() const {
 }
 
 void VideoDecoder::pauseVideo(bool pause) {
+	Common::StackLock lock(_prefetchMutex);
+
 	if (pause) {
 		_pauseLevel++;
 
@@ -188,6 +298,26 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 	_canSetDither = false;
 
+	if (!_prefetchLimit)
+		return decodeTrackFrame();
+
+	if (!peekPrefetchedFrame()) {
+		Common::StackLock lock(_prefetchMutex);
+
+		// The prefetching may have queued the frame while we waited
+		if (!peekPrefetchedFrame()) {
+			// The prefetching did not keep up, so decode the frame now. It
+			// is still copied, since the track may decode the next frame in
+			// the background while this one is shown.
+			if (!prefetchFrame(true))
+				return 0;
+		}
+	}
+
+	return popPrefetchedFrame();
+}
+
+const Graphics::Surface *VideoDecoder::decodeTrackFrame() {
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -209,6 +339,8 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 }
 
 bool VideoDecoder::setReverse(bool reverse) {
+	Common::StackLock lock(_prefetchMutex);
+
 	// Can only reverse video-only videos
 	if (reverse && hasAudio())
 		return false;
@@ -216,6 +348,8 @@ bool VideoDecoder::setReverse(bool reverse) {
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
+			flushPrefetchedFrames();
+
 			if (!((VideoTrack *)*it)->setReverse(reverse))
 				return false;
 
@@ -233,6 +367,20 @@ const byte *VideoDecoder::getPalette() {
 }
 
 int VideoDecoder::getCurFrame() const {
+	if (!_prefetchLimit)
+		return getTrackCurFrame();
+
+	// While frames are decoded ahead, the tracks are past the shown frame
+	const PrefetchedFrame *next = peekPrefetchedFrame();
+	if (next)
+		return next->prevFrame;
+
+	Common::StackLock lock(_prefetchMutex);
+	next = peekPrefetchedFrame();
+	return next ? next->prevFrame : getTrackCurFrame();
+}
+
+int VideoDecoder::getTrackCurFrame() const {
 	int32 frame = -1;
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
@@ -274,13 +422,15 @@ uint32 VideoDecoder::getTime() const {
 }
 
 uint32 VideoDecoder::getTimeToNextFrame() const {
-	if (endOfVideo() || _needsUpdate || !_nextVideoTrack)
+	uint32 nextFrameStartTime;
+	bool reversed;
+
+	if (_needsUpdate || !getNextFrameStart(nextFrameStartTime, reversed))
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
 
-	if (_nextVideoTrack->isReversed()) {
+	if (reversed) {
 		// For reversed videos, we need to handle the time difference the opposite way.
 		if (nextFrameStartTime >= currentTime)
 			return 0;
@@ -296,6 +446,18 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 }
 
 bool VideoDecoder::endOfVideo() const {
+	if (!_prefetchLimit)
+		return endOfTracks();
+
+	// The frames decoded ahead are still to be shown
+	if (peekPrefetchedFrame())
+		return false;
+
+	Common::StackLock lock(_prefetchMutex);
+	return !peekPrefetchedFrame() && endOfTracks();
+}
+
+bool VideoDecoder::endOfTracks() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		const Track *track = *it;
 
@@ -320,9 +482,13 @@ bool VideoDecoder::isRewindable() const {
 }
 
 bool VideoDecoder::rewind() {
+	Common::StackLock lock(_prefetchMutex);
+
 	if (!isRewindable())
 		return false;
 
+	flushPrefetchedFrames();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -354,9 +520,13 @@ bool VideoDecoder::isSeekable() const {
 }
 
 bool VideoDecoder::seek(const Audio::Timestamp &time) {
+	Common::StackLock lock(_prefetchMutex);
+
 	if (!isSeekable())
 		return false;
 
+	flushPrefetchedFrames();
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -420,6 +590,8 @@ void VideoDecoder::start() {
 }
 
 void VideoDecoder::stop() {
+	Common::StackLock lock(_prefetchMutex);
+
 	if (!isPlaying())
 		return;
 
@@ -447,6 +619,8 @@ void VideoDecoder::stop() {
 }
 
 void VideoDecoder::setRate(const Common::Rational &rate) {
+	Common::StackLock lock(_prefetchMutex);
+
 	if (!isVideoLoaded() || _playbackRate == rate)
 		return;
 
@@ -510,6 +684,8 @@ bool VideoDecoder::seekIntern(const Audio::Timestamp &time) {
 }
 
 bool VideoDecoder::setDitheringPalette(const byte *palette) {
+	Common::StackLock lock(_prefetchMutex);
+
 	// If a frame was already decoded, we can't set it now.
 	if (!_canSetDither)
 		return false;
@@ -756,6 +932,8 @@ void VideoDecoder::addTrack(Track *track, bool isExternal) {
 }
 
 bool VideoDecoder::addStreamFileTrack(const Common::String &baseName) {
+	Common::StackLock lock(_prefetchMutex);
+
 	// Only allow adding external tracks if a video is already loaded
 	if (!isVideoLoaded())
 		return false;
@@ -773,6 +951,8 @@ bool VideoDecoder::addStreamFileTrack(const Common::String &baseName) {
 }
 
 bool VideoDecoder::setAudioTrack(int index) {
+	Common::StackLock lock(_prefetchMutex);
+
 	if (!supportsAudioTrackSwitching())
 		return false;
 
@@ -801,6 +981,7 @@ uint VideoDecoder::getAudioTrackCount() const {
 }
 
 void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
+	Common::StackLock lock(_prefetchMutex);
 	Audio::Timestamp startTime = 0;
 
 	if (isPlaying()) {
@@ -811,6 +992,19 @@ void VideoDecoder::setEndTime(const Audio::Timestamp &endTime) {
 	_endTime = endTime;
 	_endTimeSet = true;
 
+	// Drop the frames decoded ahead which are past the new end
+	{
+		Common::StackLock queueLock(_prefetchQueueMutex);
+
+		while (!_prefetchQueue.empty() && _prefetchQueue.back().startTime >= (uint)_endTime.msecs()) {
+			if (_prefetchQueue.back().surface)
+				_prefetchFreeSurfaces.push_back(_prefetchQueue.back().surface);
+
+			_prefetchQueue.pop_back();
+			_prefetchStats.queueDepth--;
+		}
+	}
+
 	if (startTime > endTime)
 		return;
 
@@ -918,6 +1112,17 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is similar to endOfVideo(), except it doesn't take Audio into account (and returns true if not the end of the video)
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
+	if (!_prefetchLimit)
+		return hasTrackFramesLeft(isPlaying());
+
+	if (peekPrefetchedFrame())
+		return true;
+
+	Common::StackLock lock(_prefetchMutex);
+	return peekPrefetchedFrame() || hasTrackFramesLeft(isPlaying());
+}
+
+bool VideoDecoder::hasTrackFramesLeft(bool useEndTime) const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() != Track::kTrackTypeVideo)
 			continue;
@@ -925,7 +1130,7 @@ bool VideoDecoder::hasFramesLeft() const {
 		const VideoTrack *track = (const VideoTrack *)*it;
 
 		bool videoEndTimeReached = _endTimeSet && track->getNextFrameStartTime() >= (uint)_endTime.msecs();
-		bool endReached = track->endOfTrack() || (isPlaying() && videoEndTimeReached);
+		bool endReached = track->endOfTrack() || (useEndTime && videoEndTimeReached);
 		if (!endReached)
 			return true;
 	}
@@ -958,4 +1163,205 @@ void VideoDecoder::eraseTrack(Track *track) {
 	}
 }
 
+void VideoDecoder::setPrefetchFrames(uint frameCount) {
+	const bool wasEnabled = _prefetchEnabled;
+
+	{
+		Common::StackLock lock(_prefetchMutex);
+		_prefetchEnabled = frameCount != 0;
+		if (frameCount)
+			_prefetchLimit = frameCount;
+		else
+			updatePrefetchLimit();
+	}
+
+	// This must not hold the lock, see FramePrefetcher::addDecoder()
+	if (frameCount && !wasEnabled)
+		FramePrefetcher::instance().addDecoder(this);
+	else if (!frameCount && wasEnabled)
+		FramePrefetcher::instance().removeDecoder(this);
+}
+
+VideoDecoder::PrefetchStats VideoDecoder::getPrefetchStats() const {
+	Common::StackLock lock(_prefetchQueueMutex);
+	return _prefetchStats;
+}
+
+void VideoDecoder::prefetchFrames() {
+	// Only one frame is decoded per call, so that the lock is released
+	// between frames and the engine thread is held up by one frame at most
+	Common::StackLock lock(_prefetchMutex);
+
+	if (!_prefetchEnabled)
+		return;
+
+	{
+		Common::StackLock queueLock(_prefetchQueueMutex);
+		if (_prefetchStats.queueDepth >= _prefetchLimit)
+			return;
+	}
+
+	// Frames past the end time are only decoded on demand
+	if (hasTrackFramesLeft(true))
+		prefetchFrame(false);
+}
+
+const VideoDecoder::PrefetchedFrame *VideoDecoder::peekPrefetchedFrame() const {
+	// Only the engine thread removes frames, so it stays valid for the caller
+	Common::StackLock lock(_prefetchQueueMutex);
+	return _prefetchQueue.empty() ? 0 : &_prefetchQueue.front();
+}
+
+bool VideoDecoder::getNextFrameStart(uint32 &startTime, bool &reversed) const {
+	if (!_prefetchLimit)
+		return getTrackNextFrameStart(startTime, reversed);
+
+	const PrefetchedFrame *next = peekPrefetchedFrame();
+
+	if (!next) {
+		Common::StackLock lock(_prefetchMutex);
+		next = peekPrefetchedFrame();
+
+		if (!next)
+			return getTrackNextFrameStart(startTime, reversed);
+	}
+
+	startTime = next->startTime;
+	reversed = next->reversed;
+	return true;
+}
+
+bool VideoDecoder::getTrackNextFrameStart(uint32 &startTime, bool &reversed) const {
+	if (endOfTracks() || !_nextVideoTrack)
+		return false;
+
+	startTime = _nextVideoTrack->getNextFrameStartTime();
+	reversed = _nextVideoTrack->isReversed();
+	return true;
+}
+
+bool VideoDecoder::prefetchFrame(bool late) {
+	_canSetDither = false;
+
+	readNextPacket();
+
+	if (!_nextVideoTrack)
+		return false;
+
+	PrefetchedFrame frame;
+	frame.surface = 0;
+	frame.startTime = _nextVideoTrack->getNextFrameStartTime();
+	frame.reversed = _nextVideoTrack->isReversed();
+	frame.prevFrame = getTrackCurFrame();
+
+	const Graphics::Surface *surface = _nextVideoTrack->decodeNextFrame();
+
+	if (surface) {
+		{
+			Common::StackLock queueLock(_prefetchQueueMutex);
+
+			if (!_prefetchFreeSurfaces.empty()) {
+				frame.surface = _prefetchFreeSurfaces.back();
+				_prefetchFreeSurfaces.pop_back();
+			}
+		}
+
+		if (!frame.surface)
+			frame.surface = new Graphics::Surface();
+
+		copyFrame(*frame.surface, *surface);
+	}
+
+	frame.dirtyPalette = _nextVideoTrack->hasDirtyPalette();
+	if (frame.dirtyPalette)
+		memcpy(frame.palette, _nextVideoTrack->getPalette(), sizeof(frame.palette));
+
+	findNextVideoTrack();
+
+	Common::StackLock queueLock(_prefetchQueueMutex);
+	_prefetchQueue.push_back(frame);
+	_prefetchStats.queueDepth++;
+	_prefetchStats.maxQueueDepth = MAX(_prefetchStats.maxQueueDepth, _prefetchStats.queueDepth);
+
+	if (late)
+		_prefetchStats.lateFrames++;
+	else
+		_prefetchStats.prefetchedFrames++;
+
+	return true;
+}
+
+const Graphics::Surface *VideoDecoder::popPrefetchedFrame() {
+	PrefetchedFrame frame;
+
+	{
+		Common::StackLock queueLock(_prefetchQueueMutex);
+		frame = _prefetchQueue.front();
+		_prefetchQueue.pop_front();
+		_prefetchStats.queueDepth--;
+
+		// The previous frame is not shown anymore, so its surface is reused
+		if (frame.surface && _prefetchSurface)
+			_prefetchFreeSurfaces.push_back(_prefetchSurface);
+
+		updatePrefetchLimit();
+	}
+
+	if (frame.surface)
+		_prefetchSurface = frame.surface;
+
+	if (frame.dirtyPalette) {
+		memcpy(_prefetchPalette, frame.palette, sizeof(_prefetchPalette));
+		_palette = _prefetchPalette;
+		_dirtyPalette = true;
+	}
+
+	return frame.surface;
+}
+
+void VideoDecoder::flushPrefetchedFrames() {
+	Common::StackLock queueLock(_prefetchQueueMutex);
+
+	for (PrefetchQueue::iterator it = _prefetchQueue.begin(); it != _prefetchQueue.end(); it++) {
+		if (it->surface)
+			_prefetchFreeSurfaces.push_back(it->surface);
+
+		// The tracks keep using the palette of the discarded frames
+		if (it->dirtyPalette) {
+			memcpy(_prefetchPalette, it->palette, sizeof(_prefetchPalette));
+			_palette = _prefetchPalette;
+			_dirtyPalette = true;
+		}
+	}
+
+	_prefetchQueue.clear();
+	_prefetchStats.queueDepth = 0;
+	updatePrefetchLimit();
+}
+
+void VideoDecoder::updatePrefetchLimit() {
+	// Once disabled, the frames are decoded directly after the queued ones
+	Common::StackLock queueLock(_prefetchQueueMutex);
+	if (!_prefetchEnabled && _prefetchQueue.empty())
+		_prefetchLimit = 0;
+}
+
+void VideoDecoder::freePrefetchedFrames() {
+	Common::StackLock lock(_prefetchMutex);
+	flushPrefetchedFrames();
+
+	for (uint i = 0; i < _prefetchFreeSurfaces.size(); i++) {
+		_prefetchFreeSurfaces[i]->free();
+		delete _prefetchFreeSurfaces[i];
+	}
+
+	_prefetchFreeSurfaces.clear();
+
+	if (_prefetchSurface) {
+		_prefetchSurface->free();
+		delete _prefetchSurface;
+		_prefetchSurface = 0;
+	}
+}
+
 } // End of namespace Video
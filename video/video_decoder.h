@@ -26,6 +26,8 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/list.h"
+#include "common/mutex.h"
 #include "common/rational.h"
 #include "common/str.h"
 #include "graphics/pixelformat.h"
@@ -46,13 +48,15 @@ struct Surface;
 
 namespace Video {
 
+class FramePrefetcher;
+
 /**
  * Generic interface for video decoder classes.
  */
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -396,6 +400,59 @@ public:
 	 */
 	bool setDitheringPalette(const byte *palette);
 
+	/////////////////////////////////////////
+	// Frame Prefetching
+	/////////////////////////////////////////
+
+	/**
+	 * Statistics of the frame prefetching.
+	 */
+	struct PrefetchStats {
+		uint32 prefetchedFrames; ///< Frames decoded ahead of time
+		uint32 lateFrames;       ///< Frames which were not ready when decodeNextFrame() was called
+		uint queueDepth;         ///< Frames currently decoded ahead
+		uint maxQueueDepth;      ///< Most frames which were decoded ahead at once
+	};
+
+	/**
+	 * Decode frames ahead of time, from the timer thread.
+	 *
+	 * Up to the given number of frames are decoded in advance, one per
+	 * timer tick, and decodeNextFrame() then only has to return the next
+	 * one. This keeps frames which are expensive to decode from delaying
+	 * the playback. Passing 0 disables the prefetching, which is the
+	 * default.
+	 *
+	 * On ports which call DefaultTimerManager::checkTimers() from the main
+	 * thread instead of running a timer thread, the frames are still
+	 * decoded synchronously, only at another time. When no frame is
+	 * queued, decodeNextFrame() and the status queries such as
+	 * getCurFrame(), getTimeToNextFrame() or endOfVideo() may wait for the
+	 * frame which is being decoded.
+	 *
+	 * The frames decoded ahead are discarded when seeking, rewinding or
+	 * changing direction. Since the tracks are then decoded from another
+	 * thread, the subclass must not access them outside of the functions
+	 * called by VideoDecoder, and any state shared with the engine has to
+	 * be protected.
+	 *
+	 * This should be called after loadStream() and setDitheringPalette().
+	 * close() disables the prefetching.
+	 *
+	 * @param frameCount The maximum number of frames to decode ahead
+	 */
+	void setPrefetchFrames(uint frameCount);
+
+	/**
+	 * Get the maximum number of frames decoded ahead of time.
+	 */
+	uint getPrefetchFrames() const { return _prefetchEnabled ? _prefetchLimit : 0; }
+
+	/**
+	 * Get the statistics of the frame prefetching since the video was loaded.
+	 */
+	PrefetchStats getPrefetchStats() const;
+
 	/////////////////////////////////////////
 	// Audio Control
 	/////////////////////////////////////////
@@ -936,7 +993,32 @@ protected:
 	 */
 	virtual AudioTrack *getAudioTrack(int index) { return 0; }
 
+	/**
+	 * Decode the next frame ahead, unless enough are queued or the video
+	 * ends. This is called on every tick of the timer while the frame
+	 * prefetching is enabled.
+	 * @see setPrefetchFrames()
+	 */
+	void prefetchFrames();
+
 private:
+	friend class FramePrefetcher;
+
+	/**
+	 * A frame decoded ahead of time.
+	 */
+	struct PrefetchedFrame {
+		Graphics::Surface *surface; ///< Copy of the frame, or 0 if the track did not return one
+		uint32 startTime;           ///< The time the frame is shown, as returned by getNextFrameStartTime()
+		bool reversed;              ///< Whether the frame was decoded in reverse
+		int prevFrame;              ///< The value of getCurFrame() before the frame is shown
+		bool dirtyPalette;
+		byte palette[256 * 3];
+	};
+
+	typedef Common::List<PrefetchedFrame> PrefetchQueue;
+
+
 	// Tracks owned by this VideoDecoder
 	TrackList _tracks;
 	TrackList _internalTracks;
@@ -964,7 +1046,21 @@ private:
 	void startAudio();
 	void startAudioLimit(const Audio::Timestamp &limit);
 	bool hasFramesLeft() const;
+	bool hasTrackFramesLeft(bool useEndTime) const;
 	bool hasAudio() const;
+	int getTrackCurFrame() const;
+	bool endOfTracks() const;
+	bool getTrackNextFrameStart(uint32 &startTime, bool &reversed) const;
+	const Graphics::Surface *decodeTrackFrame();
+
+	// Frame prefetching helpers
+	const PrefetchedFrame *peekPrefetchedFrame() const;
+	bool getNextFrameStart(uint32 &startTime, bool &reversed) const;
+	bool prefetchFrame(bool late);
+	const Graphics::Surface *popPrefetchedFrame();
+	void flushPrefetchedFrames();
+	void freePrefetchedFrames();
+	void updatePrefetchLimit();
 
 	int32 _startTime;
 	uint32 _pauseLevel;
@@ -974,6 +1070,22 @@ private:
 	Audio::Mixer::SoundType _soundType;
 
 	AudioTrack *_mainAudioTrack;
+
+	// Frame prefetching. The tracks are locked by _prefetchMutex while
+	// prefetching is enabled, and the queue, the unused surfaces and the
+	// statistics by _prefetchQueueMutex. _prefetchLimit stays set after
+	// the prefetching is disabled until the queued frames are shown, so
+	// that it is only 0 when the frames are decoded directly. It is only
+	// changed by the engine thread, which reads it without locking.
+	uint _prefetchLimit;
+	bool _prefetchEnabled;
+	PrefetchQueue _prefetchQueue;
+	Common::Array<Graphics::Surface *> _prefetchFreeSurfaces;
+	Graphics::Surface *_prefetchSurface;
+	byte _prefetchPalette[256 * 3];
+	PrefetchStats _prefetchStats;
+	Common::Mutex _prefetchMutex;
+	Common::Mutex _prefetchQueueMutex;
 };
 
 } // End of namespace Video